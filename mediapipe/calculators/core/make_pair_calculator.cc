@@ -39,6 +39,7 @@ class MakePairCalculator : public CalculatorBase {
     cc->Inputs().Index(0).SetAny();
     cc->Inputs().Index(1).SetAny();
     cc->Outputs().Index(0).Set<std::pair<Packet, Packet>>();
+    cc->SetProcessInline(true);
     return ::mediapipe::OkStatus();
   }
 
@@ -0,0 +1,43 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Benchmarks MakePairCalculator. Run with:
+//   bazel run -c opt //mediapipe/calculators/core:make_pair_calculator_benchmark
+
+#include <vector>
+
+#include "mediapipe/framework/calculator_benchmark.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/port/benchmark.h"
+
+namespace mediapipe {
+namespace {
+
+void BM_MakePair(benchmark::State& state) {
+  CalculatorRunner runner(R"(
+      calculator: "MakePairCalculator"
+      input_stream: "packet_a"
+      input_stream: "packet_b"
+      output_stream: "output_pair_a_b"
+  )");
+  RunCalculatorBenchmark(state, &runner, [](int64 iteration) {
+    return std::vector<Packet>{MakePacket<int>(iteration),
+                               MakePacket<float>(iteration)};
+  });
+}
+BENCHMARK(BM_MakePair)->UseManualTime();
+
+}  // namespace
+}  // namespace mediapipe
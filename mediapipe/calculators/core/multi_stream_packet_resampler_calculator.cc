@@ -0,0 +1,357 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <vector>
+
+#include "Eigen/Core"
+#include "mediapipe/calculators/core/packet_resampler_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/deps/mathutil.h"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/formats/video_stream_header.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/tool/options_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Returns a TimestampDiff (assuming microseconds) corresponding to the
+// given time in seconds.
+TimestampDiff TimestampDiffFromSeconds(double seconds) {
+  return TimestampDiff(MathUtil::SafeRound<int64, double>(
+      seconds * Timestamp::kTimestampUnitsPerSecond));
+}
+
+// Returns a + (b - a) * weight for two equally sized float vectors.
+std::vector<float> InterpolateVectors(const std::vector<float>& a,
+                                      const std::vector<float>& b,
+                                      float weight) {
+  std::vector<float> result(a.size());
+  Eigen::Map<Eigen::VectorXf>(result.data(), result.size()) =
+      Eigen::Map<const Eigen::VectorXf>(a.data(), a.size()) +
+      (Eigen::Map<const Eigen::VectorXf>(b.data(), b.size()) -
+       Eigen::Map<const Eigen::VectorXf>(a.data(), a.size())) *
+          weight;
+  return result;
+}
+
+}  // namespace
+
+// Resamples several streams to one common frame rate in a single node.
+//
+// Each input stream is resampled as by PacketResamplerCalculator, with the
+// same PacketResamplerCalculatorOptions, and output on the output stream with
+// the same index. All streams share the grid of output timestamps, which is
+// aligned with the first input packet on any stream, or with base_timestamp
+// if given. A stream whose first packet arrives later starts at the grid
+// period of that packet.
+//
+// Replacing one PacketResamplerCalculator per stream with this calculator
+// saves the per-node scheduling cost, which dominates for cheap payloads such
+// as sensor samples.
+//
+// With the "interpolate" option, Matrix and std::vector<float> payloads are
+// linearly interpolated between the input packets before and after each
+// output timestamp. Packets without a neighbor on both sides, and packets
+// whose shapes differ from their neighbor, are resampled as usual.
+//
+// The jitter option and the VIDEO_HEADER streams are not supported.
+//
+// Example config:
+// node {
+//   calculator: "MultiStreamPacketResamplerCalculator"
+//   input_stream: "accelerometer"
+//   input_stream: "gyroscope"
+//   output_stream: "accelerometer_30hz"
+//   output_stream: "gyroscope_30hz"
+//   options {
+//     [mediapipe.PacketResamplerCalculatorOptions.ext] {
+//       frame_rate: 30.0
+//       interpolate: true
+//     }
+//   }
+// }
+class MultiStreamPacketResamplerCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc);
+
+  ::mediapipe::Status Open(CalculatorContext* cc) override;
+  ::mediapipe::Status Process(CalculatorContext* cc) override;
+  ::mediapipe::Status Close(CalculatorContext* cc) override;
+
+ private:
+  enum class PayloadType { kUnknown, kMatrix, kFloatVector, kOther };
+
+  struct StreamState {
+    // The last packet that was received.
+    Packet last_packet;
+    // Number of periods that have been output for this stream.
+    int64 period_count = 0;
+    // The payload type, determined from the first packet if interpolating.
+    PayloadType payload_type = PayloadType::kUnknown;
+  };
+
+  // Resamples stream "index" given its packet at the input timestamp, whose
+  // grid period is "received_index".
+  void ResampleStream(CalculatorContext* cc, int index, const Packet& packet,
+                      int64 received_index);
+
+  // Returns the output for "timestamp", which lies between the last packet of
+  // "state" and "next". Interpolates if enabled and possible, otherwise
+  // returns "fallback" at "timestamp".
+  Packet OutputAt(const StreamState& state, const Packet& next,
+                  const Packet& fallback, Timestamp timestamp) const;
+
+  // See PacketResamplerCalculator.
+  Timestamp PeriodIndexToTimestamp(int64 index) const;
+  int64 TimestampToPeriodIndex(Timestamp timestamp) const;
+  void OutputWithinLimits(CalculatorContext* cc, int index,
+                          const Packet& packet) const;
+
+  // The timestamp of the first packet received on any stream.
+  Timestamp first_timestamp_;
+  // Number of frames per second (desired output frequency).
+  double frame_rate_;
+  // Inverse of frame_rate_.
+  int64 frame_time_usec_;
+  bool flush_last_packet_;
+  bool interpolate_;
+  Timestamp base_timestamp_;
+  Timestamp start_time_;
+  Timestamp end_time_;
+  bool round_limits_;
+
+  std::vector<StreamState> streams_;
+};
+REGISTER_CALCULATOR(MultiStreamPacketResamplerCalculator);
+
+::mediapipe::Status MultiStreamPacketResamplerCalculator::GetContract(
+    CalculatorContract* cc) {
+  const auto& resampler_options =
+      cc->Options<PacketResamplerCalculatorOptions>();
+  if (cc->InputSidePackets().HasTag("OPTIONS")) {
+    cc->InputSidePackets().Tag("OPTIONS").Set<CalculatorOptions>();
+  }
+  RET_CHECK_EQ(resampler_options.jitter(), 0.0)
+      << "jitter is not supported by MultiStreamPacketResamplerCalculator";
+  RET_CHECK(!cc->Inputs().UsesTags() && !cc->Outputs().UsesTags())
+      << "Only untagged streams are supported.";
+  RET_CHECK_GT(cc->Inputs().NumEntries(), 0);
+  RET_CHECK_EQ(cc->Inputs().NumEntries(), cc->Outputs().NumEntries());
+  for (int i = 0; i < cc->Inputs().NumEntries(); ++i) {
+    cc->Inputs().Index(i).SetAny();
+    cc->Outputs().Index(i).SetSameAs(&cc->Inputs().Index(i));
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status MultiStreamPacketResamplerCalculator::Open(
+    CalculatorContext* cc) {
+  const auto resampler_options =
+      tool::RetrieveOptions(cc->Options<PacketResamplerCalculatorOptions>(),
+                            cc->InputSidePackets(), "OPTIONS");
+  RET_CHECK_EQ(resampler_options.jitter(), 0.0)
+      << "jitter is not supported by MultiStreamPacketResamplerCalculator";
+
+  flush_last_packet_ = resampler_options.flush_last_packet();
+  interpolate_ = resampler_options.interpolate();
+  frame_rate_ = resampler_options.frame_rate();
+  base_timestamp_ = resampler_options.has_base_timestamp()
+                        ? Timestamp(resampler_options.base_timestamp())
+                        : Timestamp::Unset();
+  start_time_ = resampler_options.has_start_time()
+                    ? Timestamp(resampler_options.start_time())
+                    : Timestamp::Min();
+  end_time_ = resampler_options.has_end_time()
+                  ? Timestamp(resampler_options.end_time())
+                  : Timestamp::Max();
+  round_limits_ = resampler_options.round_limits();
+  // The frame_rate has a default value of -1.0, so the user must set it!
+  RET_CHECK_LT(0, frame_rate_)
+      << "The output frame rate must be greater than zero";
+  RET_CHECK_LE(frame_rate_, Timestamp::kTimestampUnitsPerSecond)
+      << "The output frame rate must be smaller than "
+      << Timestamp::kTimestampUnitsPerSecond;
+  frame_time_usec_ = static_cast<int64>(1000000.0 / frame_rate_);
+
+  streams_.assign(cc->Inputs().NumEntries(), StreamState());
+  if (resampler_options.output_header() ==
+      PacketResamplerCalculatorOptions::NONE) {
+    return ::mediapipe::OkStatus();
+  }
+  for (int i = 0; i < cc->Inputs().NumEntries(); ++i) {
+    const Packet& header = cc->Inputs().Index(i).Header();
+    if (header.IsEmpty()) continue;
+    if (resampler_options.output_header() ==
+        PacketResamplerCalculatorOptions::UPDATE_VIDEO_HEADER) {
+      VideoHeader video_header = header.Get<VideoHeader>();
+      video_header.frame_rate = frame_rate_;
+      cc->Outputs().Index(i).SetHeader(Adopt(new VideoHeader(video_header)));
+    } else {
+      cc->Outputs().Index(i).SetHeader(header);
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status MultiStreamPacketResamplerCalculator::Process(
+    CalculatorContext* cc) {
+  RET_CHECK_GT(cc->InputTimestamp(), Timestamp::PreStream());
+  if (first_timestamp_ == Timestamp::Unset()) {
+    if (base_timestamp_ == Timestamp::Unset()) {
+      first_timestamp_ = cc->InputTimestamp();
+    } else {
+      int64 first_index = MathUtil::SafeRound<int64, double>(
+          (cc->InputTimestamp() - base_timestamp_).Seconds() * frame_rate_);
+      first_timestamp_ =
+          base_timestamp_ + TimestampDiffFromSeconds(first_index / frame_rate_);
+    }
+  }
+  // All packets in this call share the input timestamp and so the period.
+  const int64 received_index = TimestampToPeriodIndex(cc->InputTimestamp());
+  for (int i = 0; i < streams_.size(); ++i) {
+    const Packet& packet = cc->Inputs().Index(i).Value();
+    if (packet.IsEmpty()) continue;
+    ResampleStream(cc, i, packet, received_index);
+    streams_[i].last_packet = packet;
+  }
+  return ::mediapipe::OkStatus();
+}
+
+void MultiStreamPacketResamplerCalculator::ResampleStream(
+    CalculatorContext* cc, int index, const Packet& packet,
+    int64 received_index) {
+  StreamState& state = streams_[index];
+  if (state.last_packet.IsEmpty()) {
+    // Nothing to fill the earlier periods with.
+    state.period_count = std::max(state.period_count, received_index);
+    if (interpolate_) {
+      if (packet.ValidateAsType<Matrix>().ok()) {
+        state.payload_type = PayloadType::kMatrix;
+      } else if (packet.ValidateAsType<std::vector<float>>().ok()) {
+        state.payload_type = PayloadType::kFloatVector;
+      } else {
+        state.payload_type = PayloadType::kOther;
+      }
+    }
+  }
+  // Only consider the received packet if it belongs to the current period or
+  // to a newer one.
+  if (received_index < state.period_count) return;
+  // Fill the empty periods until we are in the period of the received packet.
+  while (received_index > state.period_count) {
+    OutputWithinLimits(
+        cc, index,
+        OutputAt(state, packet, state.last_packet,
+                 PeriodIndexToTimestamp(state.period_count)));
+    ++state.period_count;
+  }
+  // If the received packet is past the middle of the current period, output
+  // the packet closer to it without waiting.
+  const Timestamp received_timestamp = packet.Timestamp();
+  const Timestamp target_timestamp = PeriodIndexToTimestamp(state.period_count);
+  if (received_timestamp >= target_timestamp) {
+    const bool send_current =
+        state.last_packet.IsEmpty() ||
+        (received_timestamp - target_timestamp <=
+         target_timestamp - state.last_packet.Timestamp());
+    OutputWithinLimits(
+        cc, index,
+        OutputAt(state, packet, send_current ? packet : state.last_packet,
+                 target_timestamp));
+    ++state.period_count;
+  }
+  cc->Outputs().Index(index).SetNextTimestampBound(
+      PeriodIndexToTimestamp(state.period_count));
+}
+
+Packet MultiStreamPacketResamplerCalculator::OutputAt(
+    const StreamState& state, const Packet& next, const Packet& fallback,
+    Timestamp timestamp) const {
+  const Packet& last = state.last_packet;
+  if (!interpolate_ || last.IsEmpty() || timestamp <= last.Timestamp() ||
+      timestamp >= next.Timestamp()) {
+    return fallback.At(timestamp);
+  }
+  const float weight = (timestamp - last.Timestamp()).Seconds() /
+                       (next.Timestamp() - last.Timestamp()).Seconds();
+  switch (state.payload_type) {
+    case PayloadType::kMatrix: {
+      const Matrix& a = last.Get<Matrix>();
+      const Matrix& b = next.Get<Matrix>();
+      if (a.rows() != b.rows() || a.cols() != b.cols()) break;
+      return MakePacket<Matrix>(a + (b - a) * weight).At(timestamp);
+    }
+    case PayloadType::kFloatVector: {
+      const auto& a = last.Get<std::vector<float>>();
+      const auto& b = next.Get<std::vector<float>>();
+      if (a.size() != b.size()) break;
+      return MakePacket<std::vector<float>>(InterpolateVectors(a, b, weight))
+          .At(timestamp);
+    }
+    default:
+      break;
+  }
+  return fallback.At(timestamp);
+}
+
+::mediapipe::Status MultiStreamPacketResamplerCalculator::Close(
+    CalculatorContext* cc) {
+  if (!cc->GraphStatus().ok() || !flush_last_packet_ ||
+      first_timestamp_ == Timestamp::Unset()) {
+    return ::mediapipe::OkStatus();
+  }
+  // Emit the last packet of each stream that has not been output for its
+  // period yet.
+  for (int i = 0; i < streams_.size(); ++i) {
+    const StreamState& state = streams_[i];
+    if (!state.last_packet.IsEmpty() &&
+        TimestampToPeriodIndex(state.last_packet.Timestamp()) ==
+            state.period_count) {
+      OutputWithinLimits(
+          cc, i,
+          state.last_packet.At(PeriodIndexToTimestamp(state.period_count)));
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+Timestamp MultiStreamPacketResamplerCalculator::PeriodIndexToTimestamp(
+    int64 index) const {
+  CHECK_NE(first_timestamp_, Timestamp::Unset());
+  return first_timestamp_ + TimestampDiffFromSeconds(index / frame_rate_);
+}
+
+int64 MultiStreamPacketResamplerCalculator::TimestampToPeriodIndex(
+    Timestamp timestamp) const {
+  CHECK_NE(first_timestamp_, Timestamp::Unset());
+  return MathUtil::SafeRound<int64, double>(
+      (timestamp - first_timestamp_).Seconds() * frame_rate_);
+}
+
+void MultiStreamPacketResamplerCalculator::OutputWithinLimits(
+    CalculatorContext* cc, int index, const Packet& packet) const {
+  TimestampDiff margin((round_limits_) ? frame_time_usec_ / 2 : 0);
+  if (packet.Timestamp() >= start_time_ - margin &&
+      packet.Timestamp() < end_time_ + margin) {
+    cc->Outputs().Index(index).AddPacket(packet);
+  }
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,191 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/calculators/core/packet_resampler_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/matrix.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+CalculatorGraphConfig::Node MakeNodeConfig(int num_streams,
+                                           const std::string& options) {
+  CalculatorGraphConfig::Node node =
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(absl::StrCat(
+          R"(calculator: "MultiStreamPacketResamplerCalculator"
+             options { [mediapipe.PacketResamplerCalculatorOptions.ext] { )",
+          options, "} }"));
+  for (int i = 0; i < num_streams; ++i) {
+    node.add_input_stream(absl::StrCat("in", i));
+    node.add_output_stream(absl::StrCat("out", i));
+  }
+  return node;
+}
+
+void AddIntPackets(CalculatorRunner* runner, int index,
+                   const std::vector<int64>& timestamps) {
+  for (const int64 ts : timestamps) {
+    runner->MutableInputs()->Index(index).packets.push_back(
+        MakePacket<int64>(ts).At(Timestamp(ts)));
+  }
+}
+
+// Checks the payloads, which are the input timestamps, and the timestamps of
+// the output packets on stream "index".
+void CheckIntOutputs(const CalculatorRunner& runner, int index,
+                     const std::vector<int64>& expected_payloads,
+                     const std::vector<int64>& expected_timestamps) {
+  const auto& packets = runner.Outputs().Index(index).packets;
+  ASSERT_EQ(expected_payloads.size(), packets.size());
+  for (int i = 0; i < packets.size(); ++i) {
+    EXPECT_EQ(expected_payloads[i], packets[i].Get<int64>());
+    EXPECT_EQ(Timestamp(expected_timestamps[i]), packets[i].Timestamp());
+  }
+}
+
+TEST(MultiStreamPacketResamplerCalculatorTest, MatchesSingleStreamResampler) {
+  CalculatorRunner runner(MakeNodeConfig(2, "frame_rate: 30"));
+  AddIntPackets(&runner, 0, {0, 50000});
+  AddIntPackets(&runner, 1, {0, 16667, 49999});
+  MEDIAPIPE_ASSERT_OK(runner.Run());
+  // The same outputs as PacketResamplerCalculator on each stream alone.
+  CheckIntOutputs(runner, 0, {0, 0, 50000}, {0, 33333, 66667});
+  CheckIntOutputs(runner, 1, {0, 49999}, {0, 33333});
+}
+
+TEST(MultiStreamPacketResamplerCalculatorTest, SharesGridWithLateStream) {
+  CalculatorRunner runner(MakeNodeConfig(2, "frame_rate: 30"));
+  AddIntPackets(&runner, 0, {0, 33333, 66667, 100000});
+  AddIntPackets(&runner, 1, {70000, 100000});
+  MEDIAPIPE_ASSERT_OK(runner.Run());
+  CheckIntOutputs(runner, 0, {0, 33333, 66667, 100000},
+                  {0, 33333, 66667, 100000});
+  // The late stream starts on the grid of the first stream.
+  CheckIntOutputs(runner, 1, {70000, 100000}, {66667, 100000});
+}
+
+TEST(MultiStreamPacketResamplerCalculatorTest, RespectsLimits) {
+  CalculatorRunner runner(MakeNodeConfig(
+      1, "frame_rate: 30 start_time: 30000 end_time: 70000"));
+  AddIntPackets(&runner, 0, {0, 33333, 66667, 100000});
+  MEDIAPIPE_ASSERT_OK(runner.Run());
+  CheckIntOutputs(runner, 0, {33333, 66667}, {33333, 66667});
+}
+
+TEST(MultiStreamPacketResamplerCalculatorTest, InterpolatesNumericPayloads) {
+  CalculatorRunner runner(MakeNodeConfig(
+      3, "frame_rate: 10 interpolate: true flush_last_packet: false"));
+  for (const int64 ts : {0, 250000}) {
+    const float value = ts / 1000.0f;
+    runner.MutableInputs()->Index(0).packets.push_back(
+        MakePacket<std::vector<float>>(std::vector<float>{value, -value})
+            .At(Timestamp(ts)));
+    Matrix matrix(2, 1);
+    matrix << value, 2 * value;
+    runner.MutableInputs()->Index(1).packets.push_back(
+        MakePacket<Matrix>(matrix).At(Timestamp(ts)));
+    runner.MutableInputs()->Index(2).packets.push_back(
+        MakePacket<int64>(ts).At(Timestamp(ts)));
+  }
+  MEDIAPIPE_ASSERT_OK(runner.Run());
+
+  const std::vector<float> expected = {0.0f, 100.0f, 200.0f};
+  const auto& vectors = runner.Outputs().Index(0).packets;
+  const auto& matrices = runner.Outputs().Index(1).packets;
+  ASSERT_EQ(3, vectors.size());
+  ASSERT_EQ(3, matrices.size());
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(Timestamp(i * 100000), vectors[i].Timestamp());
+    const auto& vector = vectors[i].Get<std::vector<float>>();
+    ASSERT_EQ(2, vector.size());
+    EXPECT_FLOAT_EQ(expected[i], vector[0]);
+    EXPECT_FLOAT_EQ(-expected[i], vector[1]);
+    const Matrix& matrix = matrices[i].Get<Matrix>();
+    EXPECT_FLOAT_EQ(expected[i], matrix(0, 0));
+    EXPECT_FLOAT_EQ(2 * expected[i], matrix(1, 0));
+  }
+  // Other payload types are resampled as usual.
+  CheckIntOutputs(runner, 2, {0, 0, 0}, {0, 100000, 200000});
+}
+
+TEST(MultiStreamPacketResamplerCalculatorTest, RejectsMismatchedStreams) {
+  CalculatorGraphConfig::Node node = MakeNodeConfig(2, "frame_rate: 30");
+  node.add_input_stream("extra");
+  CalculatorRunner runner(node);
+  EXPECT_FALSE(runner.Run().ok());
+}
+
+// Resamples "num_streams" streams of 1 kHz samples to 30 Hz, either with one
+// PacketResamplerCalculator per stream or with a single
+// MultiStreamPacketResamplerCalculator. Reports input packets per second.
+void RunResamplerBenchmark(benchmark::State& state, bool multi_stream) {
+  const int num_streams = state.range(0);
+  constexpr int kNumSamples = 1000;
+  CalculatorGraphConfig config;
+  if (multi_stream) {
+    *config.add_node() = MakeNodeConfig(num_streams, "frame_rate: 30");
+  }
+  for (int i = 0; i < num_streams; ++i) {
+    config.add_input_stream(absl::StrCat("in", i));
+    if (!multi_stream) {
+      CalculatorGraphConfig::Node* node = config.add_node();
+      node->set_calculator("PacketResamplerCalculator");
+      node->add_input_stream(absl::StrCat("in", i));
+      node->add_output_stream(absl::StrCat("out", i));
+      node->mutable_options()
+          ->MutableExtension(PacketResamplerCalculatorOptions::ext)
+          ->set_frame_rate(30);
+    }
+  }
+  const Packet sample = MakePacket<std::vector<float>>(3, 0.5f);
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    CHECK(graph.Initialize(config).ok());
+    CHECK(graph.StartRun({}).ok());
+    for (int t = 0; t < kNumSamples; ++t) {
+      for (int i = 0; i < num_streams; ++i) {
+        CHECK(graph
+                  .AddPacketToInputStream(absl::StrCat("in", i),
+                                          sample.At(Timestamp(t * 1000)))
+                  .ok());
+      }
+    }
+    CHECK(graph.CloseAllInputStreams().ok());
+    CHECK(graph.WaitUntilDone().ok());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumSamples * num_streams);
+}
+
+void BM_SeparateResamplers(benchmark::State& state) {
+  RunResamplerBenchmark(state, false);
+}
+BENCHMARK(BM_SeparateResamplers)->Arg(1)->Arg(8)->Arg(30)->UseRealTime();
+
+void BM_MultiStreamResampler(benchmark::State& state) {
+  RunResamplerBenchmark(state, true);
+}
+BENCHMARK(BM_MultiStreamResampler)->Arg(1)->Arg(8)->Arg(30)->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
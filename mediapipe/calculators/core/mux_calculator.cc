@@ -42,6 +42,7 @@ class MuxCalculator : public CalculatorBase {
     cc->SetInputStreamHandler("MuxInputStreamHandler");
     MediaPipeOptions options;
     cc->SetInputStreamHandlerOptions(options);
+    cc->SetProcessInline(true);
 
     return ::mediapipe::OkStatus();
   }
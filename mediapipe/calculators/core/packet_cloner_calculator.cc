@@ -50,6 +50,7 @@ class PacketClonerCalculator : public CalculatorBase {
       cc->Outputs().Index(i).SetSameAs(&cc->Inputs().Index(i));
     }
     cc->Inputs().Index(tick_signal_index).SetAny();
+    cc->SetProcessInline(true);
     return ::mediapipe::OkStatus();
   }
 
@@ -187,6 +187,8 @@ TimestampDiff TimestampDiffFromSeconds(double seconds) {
     cc->Outputs().Tag("VIDEO_HEADER").Set<VideoHeader>();
   }
 
+  RET_CHECK(!resampler_options.interpolate())
+      << "interpolate is only supported by MultiStreamPacketResamplerCalculator";
   if (resampler_options.jitter() != 0.0) {
     RET_CHECK_GT(resampler_options.jitter(), 0.0);
     RET_CHECK_LE(resampler_options.jitter(), 1.0);
@@ -56,6 +56,8 @@ class PassThroughCalculator : public CalculatorBase {
             &cc->InputSidePackets().Get(id));
       }
     }
+    // Forwarding packets is cheaper than scheduling a task to do it.
+    cc->SetProcessInline(true);
     return ::mediapipe::OkStatus();
   }
 
@@ -1,27 +1,14 @@
+#include <memory>
+
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
-#include "mediapipe/framework/formats/image_frame_opencv.h"
-#include "mediapipe/framework/port/integral_types.h"
-#include "mediapipe/framework/port/logging.h"
-#include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/source_location.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/util/image_frame_util.h"
 
 namespace mediapipe {
 namespace {
-void SetColorChannel(int channel, uint8 value, cv::Mat* mat) {
-  CHECK(mat->depth() == CV_8U);
-  CHECK(channel < mat->channels());
-  const int step = mat->channels();
-  for (int r = 0; r < mat->rows; ++r) {
-    uint8* row_ptr = mat->ptr<uint8>(r);
-    for (int offset = channel; offset < mat->cols * step; offset += step) {
-      row_ptr[offset] = value;
-    }
-  }
-}
-
 constexpr char kRgbaInTag[] = "RGBA_IN";
 constexpr char kRgbInTag[] = "RGB_IN";
 constexpr char kGrayInTag[] = "GRAY_IN";
@@ -39,6 +26,12 @@ constexpr char kGrayOutTag[] = "GRAY_OUT";
 //   GRAY -> RGB
 //   RGB  -> GRAY
 //   RGB  -> RGBA
+//   GRAY -> RGBA
+//   RGBA -> GRAY
+//
+// The conversions are done by image_frame_util::ConvertImageFrame, which uses
+// vectorized kernels and sets the alpha channel of RGBA outputs to 255 in the
+// same pass.
 //
 // This calculator only supports a single input stream and output stream at a
 // time. If more than one input stream or output stream is present, the
@@ -63,13 +56,11 @@ class ColorConvertCalculator : public CalculatorBase {
 
  private:
   // Wrangles the appropriate inputs and outputs to perform the color
-  // conversion. The ImageFrame on input_tag is converted using the
-  // open_cv_convert_code provided and then output on the output_tag stream.
-  // Note that the output_format must match the destination conversion code.
+  // conversion. The ImageFrame on input_tag is converted to output_format and
+  // then output on the output_tag stream.
   ::mediapipe::Status ConvertAndOutput(const std::string& input_tag,
                                        const std::string& output_tag,
                                        ImageFormat::Format output_format,
-                                       int open_cv_convert_code,
                                        CalculatorContext* cc);
 };
 
@@ -111,20 +102,12 @@ REGISTER_CALCULATOR(ColorConvertCalculator);
 
 ::mediapipe::Status ColorConvertCalculator::ConvertAndOutput(
     const std::string& input_tag, const std::string& output_tag,
-    ImageFormat::Format output_format, int open_cv_convert_code,
-    CalculatorContext* cc) {
-  const cv::Mat& input_mat =
-      formats::MatView(&cc->Inputs().Tag(input_tag).Get<ImageFrame>());
-  std::unique_ptr<ImageFrame> output_frame(
-      new ImageFrame(output_format, input_mat.cols, input_mat.rows));
-  cv::Mat output_mat = formats::MatView(output_frame.get());
-  cv::cvtColor(input_mat, output_mat, open_cv_convert_code);
-
-  // cv::cvtColor will leave the alpha channel set to 0, which is a bizarre
-  // design choice. Instead, let's set alpha to 255.
-  if (open_cv_convert_code == cv::COLOR_RGB2RGBA) {
-    SetColorChannel(3, 255, &output_mat);
-  }
+    ImageFormat::Format output_format, CalculatorContext* cc) {
+  const ImageFrame& input_frame = cc->Inputs().Tag(input_tag).Get<ImageFrame>();
+  std::unique_ptr<ImageFrame> output_frame(new ImageFrame(
+      output_format, input_frame.Width(), input_frame.Height()));
+  RETURN_IF_ERROR(
+      image_frame_util::ConvertImageFrame(input_frame, output_frame.get()));
   cc->Outputs()
       .Tag(output_tag)
       .Add(output_frame.release(), cc->InputTimestamp());
@@ -134,23 +117,27 @@ REGISTER_CALCULATOR(ColorConvertCalculator);
 ::mediapipe::Status ColorConvertCalculator::Process(CalculatorContext* cc) {
   // RGBA -> RGB
   if (cc->Inputs().HasTag(kRgbaInTag) && cc->Outputs().HasTag(kRgbOutTag)) {
-    return ConvertAndOutput(kRgbaInTag, kRgbOutTag, ImageFormat::SRGB,
-                            cv::COLOR_RGBA2RGB, cc);
+    return ConvertAndOutput(kRgbaInTag, kRgbOutTag, ImageFormat::SRGB, cc);
   }
   // GRAY -> RGB
   if (cc->Inputs().HasTag(kGrayInTag) && cc->Outputs().HasTag(kRgbOutTag)) {
-    return ConvertAndOutput(kGrayInTag, kRgbOutTag, ImageFormat::SRGB,
-                            cv::COLOR_GRAY2RGB, cc);
+    return ConvertAndOutput(kGrayInTag, kRgbOutTag, ImageFormat::SRGB, cc);
   }
   // RGB -> GRAY
   if (cc->Inputs().HasTag(kRgbInTag) && cc->Outputs().HasTag(kGrayOutTag)) {
-    return ConvertAndOutput(kRgbInTag, kGrayOutTag, ImageFormat::GRAY8,
-                            cv::COLOR_RGB2GRAY, cc);
+    return ConvertAndOutput(kRgbInTag, kGrayOutTag, ImageFormat::GRAY8, cc);
   }
   // RGB -> RGBA
   if (cc->Inputs().HasTag(kRgbInTag) && cc->Outputs().HasTag(kRgbaOutTag)) {
-    return ConvertAndOutput(kRgbInTag, kRgbaOutTag, ImageFormat::SRGBA,
-                            cv::COLOR_RGB2RGBA, cc);
+    return ConvertAndOutput(kRgbInTag, kRgbaOutTag, ImageFormat::SRGBA, cc);
+  }
+  // GRAY -> RGBA
+  if (cc->Inputs().HasTag(kGrayInTag) && cc->Outputs().HasTag(kRgbaOutTag)) {
+    return ConvertAndOutput(kGrayInTag, kRgbaOutTag, ImageFormat::SRGBA, cc);
+  }
+  // RGBA -> GRAY
+  if (cc->Inputs().HasTag(kRgbaInTag) && cc->Outputs().HasTag(kGrayOutTag)) {
+    return ConvertAndOutput(kRgbaInTag, kGrayOutTag, ImageFormat::GRAY8, cc);
   }
 
   return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
@@ -12,19 +12,71 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "mediapipe/calculators/image/opencv_encoded_image_to_image_frame_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
 #include "mediapipe/framework/port/opencv_imgcodecs_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/util/ordered_task_queue.h"
 
 namespace mediapipe {
 
+namespace {
+
+// Decodes a grayscale or color image into a GRAY8 or SRGB ImageFrame.
+::mediapipe::StatusOr<std::unique_ptr<ImageFrame>> DecodeImage(
+    const std::string& contents) {
+  // Wrap the encoded bytes instead of copying them into a vector.
+  const cv::Mat contents_mat(1, contents.size(), CV_8UC1,
+                             const_cast<char*>(contents.data()));
+  cv::Mat decoded_mat =
+      cv::imdecode(contents_mat, -1 /* return the loaded image as-is */);
+  if (decoded_mat.empty()) {
+    return ::mediapipe::InvalidArgumentErrorBuilder(MEDIAPIPE_LOC)
+           << "Failed to decode the image.";
+  }
+
+  ImageFormat::Format image_format = ImageFormat::UNKNOWN;
+  switch (decoded_mat.channels()) {
+    case 1:
+      image_format = ImageFormat::GRAY8;
+      break;
+    case 3:
+      image_format = ImageFormat::SRGB;
+      break;
+    case 4:
+      return ::mediapipe::UnimplementedErrorBuilder(MEDIAPIPE_LOC)
+             << "4-channel image isn't supported yet";
+    default:
+      return ::mediapipe::FailedPreconditionErrorBuilder(MEDIAPIPE_LOC)
+             << "Unsupported number of channels: " << decoded_mat.channels();
+  }
+  std::unique_ptr<ImageFrame> output_frame = absl::make_unique<ImageFrame>(
+      image_format, decoded_mat.size().width, decoded_mat.size().height);
+  // Convert or copy straight into the output frame to avoid an intermediate
+  // image.
+  cv::Mat output_mat = formats::MatView(output_frame.get());
+  if (image_format == ImageFormat::SRGB) {
+    cv::cvtColor(decoded_mat, output_mat, cv::COLOR_BGR2RGB);
+  } else {
+    decoded_mat.copyTo(output_mat);
+  }
+  return std::move(output_frame);
+}
+
+}  // namespace
+
 // Takes in an encoded image std::string, decodes it by OpenCV, and converts to
 // an ImageFrame. Note that this calculator only supports grayscale and RGB
 // images for now.
 //
+// By default each image is decoded inside Process(). With num_threads > 1,
+// images are decoded concurrently on an internal worker pool and the frames
+// are output in input order, delayed until a later Process() or Close() call.
+//
 // Example config:
 // node {
 //   calculator: "OpenCvEncodedImageToImageFrameCalculator"
@@ -34,7 +86,13 @@ namespace mediapipe {
 class OpenCvEncodedImageToImageFrameCalculator : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc);
+  ::mediapipe::Status Open(CalculatorContext* cc) override;
   ::mediapipe::Status Process(CalculatorContext* cc) override;
+  ::mediapipe::Status Close(CalculatorContext* cc) override;
+
+ private:
+  // Only set when decoding on multiple threads.
+  std::unique_ptr<OrderedTaskQueue<ImageFrame>> queue_;
 };
 
 ::mediapipe::Status OpenCvEncodedImageToImageFrameCalculator::GetContract(
@@ -44,35 +102,46 @@ class OpenCvEncodedImageToImageFrameCalculator : public CalculatorBase {
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status OpenCvEncodedImageToImageFrameCalculator::Open(
+    CalculatorContext* cc) {
+  const auto& options =
+      cc->Options<OpenCvEncodedImageToImageFrameCalculatorOptions>();
+  if (options.num_threads() > 1) {
+    queue_ = absl::make_unique<OrderedTaskQueue<ImageFrame>>(
+        "image_decoder", options.num_threads(), 2 * options.num_threads());
+  }
+  return ::mediapipe::OkStatus();
+}
+
 ::mediapipe::Status OpenCvEncodedImageToImageFrameCalculator::Process(
     CalculatorContext* cc) {
-  const std::string& contents = cc->Inputs().Index(0).Get<std::string>();
-  const std::vector<char> contents_vector(contents.begin(), contents.end());
-  cv::Mat decoded_mat =
-      cv::imdecode(contents_vector, -1 /* return the loaded image as-is */);
+  if (!queue_) {
+    const std::string& contents = cc->Inputs().Index(0).Get<std::string>();
+    ASSIGN_OR_RETURN(std::unique_ptr<ImageFrame> output_frame,
+                     DecodeImage(contents));
+    cc->Outputs().Index(0).Add(output_frame.release(), cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
 
-  ImageFormat::Format image_format = ImageFormat::UNKNOWN;
-  cv::Mat output_mat;
-  switch (decoded_mat.channels()) {
-    case 1:
-      image_format = ImageFormat::GRAY8;
-      output_mat = decoded_mat;
-      break;
-    case 3:
-      image_format = ImageFormat::SRGB;
-      cv::cvtColor(decoded_mat, output_mat, cv::COLOR_BGR2RGB);
-      break;
-    case 4:
-      return ::mediapipe::UnimplementedErrorBuilder(MEDIAPIPE_LOC)
-             << "4-channel image isn't supported yet";
-    default:
-      return ::mediapipe::FailedPreconditionErrorBuilder(MEDIAPIPE_LOC)
-             << "Unsupported number of channels: " << decoded_mat.channels();
+  // The packet keeps the encoded bytes alive until the worker is done.
+  Packet input = cc->Inputs().Index(0).Value();
+  queue_->Submit(cc->InputTimestamp(), [input]() {
+    return DecodeImage(input.Get<std::string>());
+  });
+  return queue_->EmitReady(
+      [cc](std::unique_ptr<ImageFrame> frame, Timestamp timestamp) {
+        cc->Outputs().Index(0).Add(frame.release(), timestamp);
+      });
+}
+
+::mediapipe::Status OpenCvEncodedImageToImageFrameCalculator::Close(
+    CalculatorContext* cc) {
+  if (queue_) {
+    return queue_->EmitAll(
+        [cc](std::unique_ptr<ImageFrame> frame, Timestamp timestamp) {
+          cc->Outputs().Index(0).Add(frame.release(), timestamp);
+        });
   }
-  std::unique_ptr<ImageFrame> output_frame = absl::make_unique<ImageFrame>(
-      image_format, decoded_mat.size().width, decoded_mat.size().height);
-  output_mat.copyTo(formats::MatView(output_frame.get()));
-  cc->Outputs().Index(0).Add(output_frame.release(), cc->InputTimestamp());
   return ::mediapipe::OkStatus();
 }
 
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "mediapipe/calculators/image/opencv_encoded_image_to_image_frame_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/deps/file_path.h"
@@ -102,5 +103,53 @@ TEST(OpenCvEncodedImageToImageFrameCalculatorTest, TestGrayscaleJpeg) {
   EXPECT_LE(max_val, 10);
 }
 
+TEST(OpenCvEncodedImageToImageFrameCalculatorTest, MultiThreadedKeepsOrder) {
+  CalculatorGraphConfig::Node node_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+        calculator: "OpenCvEncodedImageToImageFrameCalculator"
+        input_stream: "encoded_image"
+        output_stream: "image_frame"
+        options {
+          [mediapipe.OpenCvEncodedImageToImageFrameCalculatorOptions.ext] {
+            num_threads: 4
+          }
+        }
+      )");
+  CalculatorRunner runner(node_config);
+  // Frames of increasing size identify the output order.
+  const int kNumFrames = 20;
+  for (int i = 0; i < kNumFrames; ++i) {
+    cv::Mat input_mat(8 + i, 16, CV_8UC1, cv::Scalar(i));
+    std::vector<uchar> encode_buffer;
+    ASSERT_TRUE(cv::imencode(".png", input_mat, encode_buffer));
+    runner.MutableInputs()->Index(0).packets.push_back(
+        MakePacket<std::string>(encode_buffer.begin(), encode_buffer.end())
+            .At(Timestamp(i)));
+  }
+  MEDIAPIPE_ASSERT_OK(runner.Run());
+  const std::vector<Packet>& packets = runner.Outputs().Index(0).packets;
+  ASSERT_EQ(kNumFrames, packets.size());
+  for (int i = 0; i < kNumFrames; ++i) {
+    EXPECT_EQ(Timestamp(i), packets[i].Timestamp());
+    const ImageFrame& output_frame = packets[i].Get<ImageFrame>();
+    EXPECT_EQ(ImageFormat::GRAY8, output_frame.Format());
+    EXPECT_EQ(8 + i, output_frame.Height());
+    EXPECT_EQ(i, output_frame.PixelData()[0]);
+  }
+}
+
+TEST(OpenCvEncodedImageToImageFrameCalculatorTest, FailsOnInvalidData) {
+  CalculatorGraphConfig::Node node_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+        calculator: "OpenCvEncodedImageToImageFrameCalculator"
+        input_stream: "encoded_image"
+        output_stream: "image_frame"
+      )");
+  CalculatorRunner runner(node_config);
+  runner.MutableInputs()->Index(0).packets.push_back(
+      MakePacket<std::string>("not an image").At(Timestamp(0)));
+  EXPECT_FALSE(runner.Run().ok());
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -19,12 +19,79 @@
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/status_builder.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/util/ordered_task_queue.h"
 
 namespace mediapipe {
 
+namespace {
+
+using EncodedImage = OpenCvImageEncoderCalculatorResults;
+
+// Encodes a GRAY8 or SRGB frame as JPEG. The color conversion and encoding
+// buffers are kept per thread so that repeated calls do not reallocate them.
+::mediapipe::StatusOr<std::unique_ptr<EncodedImage>> EncodeImage(
+    const ImageFrame& image_frame, int encoding_quality) {
+  thread_local cv::Mat bgr_scratch;
+  thread_local std::vector<uchar> encode_buffer;
+  CHECK_EQ(1, image_frame.ByteDepth());
+
+  std::unique_ptr<EncodedImage> encoded_result =
+      absl::make_unique<EncodedImage>();
+  encoded_result->set_width(image_frame.Width());
+  encoded_result->set_height(image_frame.Height());
+
+  cv::Mat original_mat = formats::MatView(&image_frame);
+  cv::Mat input_mat;
+  switch (original_mat.channels()) {
+    case 1:
+      input_mat = original_mat;
+      encoded_result->set_colorspace(EncodedImage::GRAYSCALE);
+      break;
+    case 3:
+      // OpenCV assumes the image to be BGR order. To use imencode(), do color
+      // conversion first.
+      cv::cvtColor(original_mat, bgr_scratch, cv::COLOR_RGB2BGR);
+      input_mat = bgr_scratch;
+      encoded_result->set_colorspace(EncodedImage::RGB);
+      break;
+    case 4:
+      return ::mediapipe::UnimplementedErrorBuilder(MEDIAPIPE_LOC)
+             << "4-channel image isn't supported yet";
+    default:
+      return ::mediapipe::FailedPreconditionErrorBuilder(MEDIAPIPE_LOC)
+             << "Unsupported number of channels: " << original_mat.channels();
+  }
+
+  std::vector<int> parameters;
+  parameters.push_back(cv::IMWRITE_JPEG_QUALITY);
+  parameters.push_back(encoding_quality);
+
+  // Note that imencode() will store the data in RGB order.
+  // Check its JpegEncoder::write() in "imgcodecs/src/grfmt_jpeg.cpp" for more
+  // info.
+  if (!cv::imencode(".jpg", input_mat, encode_buffer, parameters)) {
+    return ::mediapipe::InternalErrorBuilder(MEDIAPIPE_LOC)
+           << "Fail to encode the image to be jpeg format.";
+  }
+
+  encoded_result->set_encoded_image(
+      reinterpret_cast<const char*>(encode_buffer.data()),
+      encode_buffer.size());
+  return std::move(encoded_result);
+}
+
+}  // namespace
+
 // Calculator to encode raw image frames. This will result in considerable space
 // savings if the frames need to be stored on disk.
 //
+// By default each frame is encoded inside Process(). With num_threads > 1,
+// frames are encoded concurrently on an internal worker pool and the results
+// are output in input order, delayed until a later Process() or Close() call.
+// This speeds up graphs that encode every frame of a video, e.g. to pack a
+// MediaSequence, without raising the node's max_in_flight.
+//
 // Example config:
 // node {
 //   calculator: "OpenCvImageEncoderCalculator"
@@ -45,6 +112,8 @@ class OpenCvImageEncoderCalculator : public CalculatorBase {
 
  private:
   int encoding_quality_;
+  // Only set when encoding on multiple threads.
+  std::unique_ptr<OrderedTaskQueue<EncodedImage>> queue_;
 };
 
 ::mediapipe::Status OpenCvImageEncoderCalculator::GetContract(
@@ -57,62 +126,42 @@ class OpenCvImageEncoderCalculator : public CalculatorBase {
 ::mediapipe::Status OpenCvImageEncoderCalculator::Open(CalculatorContext* cc) {
   auto options = cc->Options<OpenCvImageEncoderCalculatorOptions>();
   encoding_quality_ = options.quality();
+  if (options.num_threads() > 1) {
+    queue_ = absl::make_unique<OrderedTaskQueue<EncodedImage>>(
+        "jpeg_encoder", options.num_threads(), 2 * options.num_threads());
+  }
   return ::mediapipe::OkStatus();
 }
 
 ::mediapipe::Status OpenCvImageEncoderCalculator::Process(
     CalculatorContext* cc) {
-  const ImageFrame& image_frame = cc->Inputs().Index(0).Get<ImageFrame>();
-  CHECK_EQ(1, image_frame.ByteDepth());
-
-  std::unique_ptr<OpenCvImageEncoderCalculatorResults> encoded_result =
-      absl::make_unique<OpenCvImageEncoderCalculatorResults>();
-  encoded_result->set_width(image_frame.Width());
-  encoded_result->set_height(image_frame.Height());
-
-  cv::Mat original_mat = formats::MatView(&image_frame);
-  cv::Mat input_mat;
-  switch (original_mat.channels()) {
-    case 1:
-      input_mat = original_mat;
-      encoded_result->set_colorspace(
-          OpenCvImageEncoderCalculatorResults::GRAYSCALE);
-      break;
-    case 3:
-      // OpenCV assumes the image to be BGR order. To use imencode(), do color
-      // conversion first.
-      cv::cvtColor(original_mat, input_mat, cv::COLOR_RGB2BGR);
-      encoded_result->set_colorspace(OpenCvImageEncoderCalculatorResults::RGB);
-      break;
-    case 4:
-      return ::mediapipe::UnimplementedErrorBuilder(MEDIAPIPE_LOC)
-             << "4-channel image isn't supported yet";
-    default:
-      return ::mediapipe::FailedPreconditionErrorBuilder(MEDIAPIPE_LOC)
-             << "Unsupported number of channels: " << original_mat.channels();
+  if (!queue_) {
+    const ImageFrame& image_frame = cc->Inputs().Index(0).Get<ImageFrame>();
+    ASSIGN_OR_RETURN(std::unique_ptr<EncodedImage> encoded_result,
+                     EncodeImage(image_frame, encoding_quality_));
+    cc->Outputs().Index(0).Add(encoded_result.release(), cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
   }
 
-  std::vector<int> parameters;
-  parameters.push_back(cv::IMWRITE_JPEG_QUALITY);
-  parameters.push_back(encoding_quality_);
-
-  std::vector<uchar> encode_buffer;
-  // Note that imencode() will store the data in RGB order.
-  // Check its JpegEncoder::write() in "imgcodecs/src/grfmt_jpeg.cpp" for more
-  // info.
-  if (!cv::imencode(".jpg", input_mat, encode_buffer, parameters)) {
-    return ::mediapipe::InternalErrorBuilder(MEDIAPIPE_LOC)
-           << "Fail to encode the image to be jpeg format.";
-  }
-
-  encoded_result->set_encoded_image(std::string(absl::string_view(
-      reinterpret_cast<const char*>(&encode_buffer[0]), encode_buffer.size())));
-
-  cc->Outputs().Index(0).Add(encoded_result.release(), cc->InputTimestamp());
-  return ::mediapipe::OkStatus();
+  // The packet keeps the frame alive until the worker is done with it.
+  Packet input = cc->Inputs().Index(0).Value();
+  const int encoding_quality = encoding_quality_;
+  queue_->Submit(cc->InputTimestamp(), [input, encoding_quality]() {
+    return EncodeImage(input.Get<ImageFrame>(), encoding_quality);
+  });
+  return queue_->EmitReady(
+      [cc](std::unique_ptr<EncodedImage> result, Timestamp timestamp) {
+        cc->Outputs().Index(0).Add(result.release(), timestamp);
+      });
 }
 
 ::mediapipe::Status OpenCvImageEncoderCalculator::Close(CalculatorContext* cc) {
+  if (queue_) {
+    return queue_->EmitAll(
+        [cc](std::unique_ptr<EncodedImage> result, Timestamp timestamp) {
+          cc->Outputs().Index(0).Add(result.release(), timestamp);
+        });
+  }
   return ::mediapipe::OkStatus();
 }
 
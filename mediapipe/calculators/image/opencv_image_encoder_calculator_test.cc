@@ -17,6 +17,7 @@
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/deps/file_path.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/opencv_imgcodecs_inc.h"
@@ -83,5 +84,65 @@ TEST(OpenCvImageEncoderCalculatorTest, TestJpegWithQualities) {
   }
 }
 
+TEST(OpenCvImageEncoderCalculatorTest, MultiThreadedKeepsOrder) {
+  CalculatorGraphConfig::Node node_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+        calculator: "OpenCvImageEncoderCalculator"
+        input_stream: "image_frames"
+        output_stream: "encoded_images"
+        node_options {
+          [type.googleapis.com/mediapipe.OpenCvImageEncoderCalculatorOptions]: {
+            quality: 90
+            num_threads: 4
+          }
+        })");
+  CalculatorRunner runner(node_config);
+  // Frames of increasing size identify the output order.
+  const int kNumFrames = 20;
+  for (int i = 0; i < kNumFrames; ++i) {
+    Packet input_packet = MakePacket<ImageFrame>(ImageFormat::SRGB, 16, 8 + i);
+    formats::MatView(&(input_packet.Get<ImageFrame>())) = cv::Scalar(i, i, i);
+    runner.MutableInputs()->Index(0).packets.push_back(
+        input_packet.At(Timestamp(i)));
+  }
+  MEDIAPIPE_ASSERT_OK(runner.Run());
+  const std::vector<Packet>& packets = runner.Outputs().Index(0).packets;
+  ASSERT_EQ(kNumFrames, packets.size());
+  for (int i = 0; i < kNumFrames; ++i) {
+    EXPECT_EQ(Timestamp(i), packets[i].Timestamp());
+    const auto& result = packets[i].Get<OpenCvImageEncoderCalculatorResults>();
+    EXPECT_EQ(8 + i, result.height());
+    EXPECT_EQ(16, result.width());
+  }
+}
+
+// Encodes 720p frames with the given number of threads.
+void BM_EncodeFrames(benchmark::State& state) {
+  const int kNumFrames = 32;
+  CalculatorGraphConfig::Node node_config =
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+        calculator: "OpenCvImageEncoderCalculator"
+        input_stream: "image_frames"
+        output_stream: "encoded_images"
+      )");
+  OpenCvImageEncoderCalculatorOptions options;
+  options.set_quality(80);
+  options.set_num_threads(state.range(0));
+  node_config.add_node_options()->PackFrom(options);
+  Packet input_packet = MakePacket<ImageFrame>(ImageFormat::SRGB, 1280, 720);
+  cv::Mat input_mat = formats::MatView(&(input_packet.Get<ImageFrame>()));
+  cv::randu(input_mat, cv::Scalar::all(0), cv::Scalar::all(255));
+  for (auto _ : state) {
+    CalculatorRunner runner(node_config);
+    for (int i = 0; i < kNumFrames; ++i) {
+      runner.MutableInputs()->Index(0).packets.push_back(
+          input_packet.At(Timestamp(i)));
+    }
+    CHECK(runner.Run().ok());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumFrames);
+}
+BENCHMARK(BM_EncodeFrames)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
 }  // namespace
 }  // namespace mediapipe
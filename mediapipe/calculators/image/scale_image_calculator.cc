@@ -556,7 +556,8 @@ ScaleImageCalculator::~ScaleImageCalculator() {}
       // make color space conversion more efficient when cropping or scaling is
       // also needed.
       image_frame_util::YUVImageToImageFrame(*yuv_image, &converted_image_frame,
-                                             options_.use_bt709());
+                                             options_.use_bt709(),
+                                             cc->GetExecutor());
       image_frame = &converted_image_frame;
     } else if (output_format_ == ImageFormat::YCBCR420P) {
       RET_CHECK(row_start_ == 0 && col_start_ == 0 &&
@@ -666,13 +667,19 @@ ScaleImageCalculator::~ScaleImageCalculator() {}
     output_frame->Reset(image_frame->Format(), output_width_, output_height_,
                         alignment_boundary_);
     cv::Mat output_mat = ::mediapipe::formats::MatView(output_frame.get());
-    downscaler_->Resize(input_mat, &output_mat);
+    if (options_.post_sharpening_coefficient() != 0.0) {
+      // The sharpening pass of ImageResizer works on the whole frame.
+      downscaler_->Resize(input_mat, &output_mat);
+    } else {
+      image_frame_util::ResizeImage(input_mat, cv::INTER_AREA, &output_mat,
+                                    cc->GetExecutor());
+    }
   } else {
     // Upscale. If upscaling is disallowed, output_width_ and output_height_ are
     // the same as the input/crop width and height.
     image_frame_util::RescaleImageFrame(
         *image_frame, output_width_, output_height_, alignment_boundary_,
-        interpolation_algorithm_, output_frame.get());
+        interpolation_algorithm_, output_frame.get(), cc->GetExecutor());
     if (interpolation_algorithm_ != -1) {
       cc->GetCounter("Upscales")->Increment();
     }
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
 #include <vector>
 
 #include "absl/memory/memory.h"
@@ -46,6 +47,15 @@ namespace tf = tensorflow;
 // output tensor will have the timestamp of the first input.). This behavior can
 // be adjusted by the timestamp_offset option.
 //
+// By default every output window is built by concatenating the buffered
+// tensors, so each input is copied buffer_size / (buffer_size - overlap) times.
+// When use_window_views is set, inputs are instead written once into a
+// preallocated contiguous chunk and each output is a dim-0 slice of that chunk
+// which shares its memory. Chunks are never written behind an emitted window,
+// so output tensors stay immutable; when a chunk is full a new one is allocated
+// and only the overlapping inputs are carried over. This mode requires all
+// inputs to have the same shape and a memcpy-able dtype.
+//
 // Example config:
 // node {
 //   calculator: "LappedTensorBufferCalculator"
@@ -71,10 +81,22 @@ class LappedTensorBufferCalculator : public CalculatorBase {
   // options.
   ::mediapipe::Status AddBatchDimension(tf::Tensor* input_tensor);
 
+  // Appends the input tensor to chunk_, starting a new chunk if needed.
+  ::mediapipe::Status AppendToChunk(const tf::Tensor& input_tensor);
+  // Returns the current window as a slice of chunk_ and advances the window.
+  tf::Tensor NextWindowView();
+
   int steps_until_output_;
   std::unique_ptr<CircularBuffer<Timestamp>> timestamp_buffer_;
   std::unique_ptr<CircularBuffer<tf::Tensor>> buffer_;
   LappedTensorBufferCalculatorOptions options_;
+
+  // State used when use_window_views is set.
+  tf::Tensor chunk_;
+  tf::TensorShape input_shape_;
+  int64 chunk_capacity_ = 0;
+  int64 chunk_size_ = 0;
+  int64 window_start_ = 0;
 };
 REGISTER_CALCULATOR(LappedTensorBufferCalculator);
 
@@ -105,6 +127,12 @@ REGISTER_CALCULATOR(LappedTensorBufferCalculator);
   buffer_ =
       absl::make_unique<CircularBuffer<tf::Tensor>>(options_.buffer_size());
   steps_until_output_ = options_.buffer_size();
+  if (options_.use_window_views()) {
+    RET_CHECK_GT(options_.windows_per_chunk(), 0);
+    const int hop = options_.buffer_size() - options_.overlap();
+    chunk_capacity_ =
+        options_.buffer_size() + (options_.windows_per_chunk() - 1) * hop;
+  }
   return ::mediapipe::OkStatus();
 }
 
@@ -116,17 +144,25 @@ REGISTER_CALCULATOR(LappedTensorBufferCalculator);
   if (options_.add_batch_dim_to_tensors()) {
     RET_CHECK_OK(AddBatchDimension(&input_tensor));
   }
-  buffer_->push_back(input_tensor);
+  if (options_.use_window_views()) {
+    RET_CHECK_OK(AppendToChunk(input_tensor));
+  } else {
+    buffer_->push_back(input_tensor);
+  }
   timestamp_buffer_->push_back(cc->InputTimestamp());
   --steps_until_output_;
 
   if (steps_until_output_ <= 0) {
     auto concatenated = ::absl::make_unique<tf::Tensor>();
 
-    const tf::Status concat_status = tf::tensor::Concat(
-        std::vector<tf::Tensor>(buffer_->begin(), buffer_->end()),
-        concatenated.get());
-    RET_CHECK(concat_status.ok()) << concat_status.ToString();
+    if (options_.use_window_views()) {
+      *concatenated = NextWindowView();
+    } else {
+      const tf::Status concat_status = tf::tensor::Concat(
+          std::vector<tf::Tensor>(buffer_->begin(), buffer_->end()),
+          concatenated.get());
+      RET_CHECK(concat_status.ok()) << concat_status.ToString();
+    }
 
     cc->Outputs().Index(0).Add(
         concatenated.release(),
@@ -151,4 +187,60 @@ REGISTER_CALCULATOR(LappedTensorBufferCalculator);
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status LappedTensorBufferCalculator::AppendToChunk(
+    const tf::Tensor& input_tensor) {
+  if (!chunk_.IsInitialized()) {
+    RET_CHECK_GE(input_tensor.dims(), 1)
+        << "Input tensors must have at least one dimension.";
+    RET_CHECK(tf::DataTypeCanUseMemcpy(input_tensor.dtype()))
+        << "use_window_views does not support "
+        << tf::DataTypeString(input_tensor.dtype()) << " tensors.";
+    input_shape_ = input_tensor.shape();
+  } else {
+    RET_CHECK(input_tensor.dtype() == chunk_.dtype() &&
+              input_tensor.shape() == input_shape_)
+        << "use_window_views requires inputs of identical type and shape."
+        << " Expected: " << input_shape_.DebugString()
+        << " got: " << input_tensor.shape().DebugString();
+  }
+  const int64 input_bytes = input_tensor.TotalBytes();
+
+  if (!chunk_.IsInitialized() || chunk_size_ == chunk_capacity_) {
+    // Emitted windows may still reference the current chunk, so it is never
+    // overwritten. Start a new one and carry over the pending inputs only.
+    tf::TensorShape chunk_shape(input_shape_);
+    chunk_shape.set_dim(0, input_shape_.dim_size(0) * chunk_capacity_);
+    tf::Tensor new_chunk(input_tensor.dtype(), chunk_shape);
+    const int64 carried = chunk_size_ - window_start_;
+    if (carried > 0) {
+      std::memcpy(const_cast<char*>(new_chunk.tensor_data().data()),
+                  chunk_.tensor_data().data() + window_start_ * input_bytes,
+                  carried * input_bytes);
+    }
+    chunk_ = new_chunk;
+    chunk_size_ = carried;
+    window_start_ = 0;
+  }
+
+  std::memcpy(const_cast<char*>(chunk_.tensor_data().data()) +
+                  chunk_size_ * input_bytes,
+              input_tensor.tensor_data().data(), input_bytes);
+  ++chunk_size_;
+  return ::mediapipe::OkStatus();
+}
+
+tf::Tensor LappedTensorBufferCalculator::NextWindowView() {
+  const int64 rows_per_input = input_shape_.dim_size(0);
+  tf::Tensor window =
+      chunk_.Slice(window_start_ * rows_per_input,
+                   (window_start_ + options_.buffer_size()) * rows_per_input);
+  window_start_ += options_.buffer_size() - options_.overlap();
+  // Eigen-mapped access requires aligned buffers; fall back to a single copy
+  // when the window does not start on an aligned boundary.
+  if (!window.IsAligned()) {
+    return tf::tensor::DeepCopy(window);
+  }
+  return window;
+}
+
 }  // namespace mediapipe
@@ -16,6 +16,7 @@
 #include "mediapipe/calculators/tensorflow/lapped_tensor_buffer_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -31,7 +32,8 @@ namespace tf = ::tensorflow;
 class LappedTensorBufferCalculatorTest : public ::testing::Test {
  protected:
   void SetUpCalculator(int buffer_size, int overlap, bool add_dim,
-                       int timestamp_offset) {
+                       int timestamp_offset, bool use_window_views = false,
+                       int windows_per_chunk = 16) {
     CalculatorGraphConfig::Node config;
     config.set_calculator("LappedTensorBufferCalculator");
     config.add_input_stream("input_tensor");
@@ -44,6 +46,10 @@ class LappedTensorBufferCalculatorTest : public ::testing::Test {
       options->set_add_batch_dim_to_tensors(true);
     }
     options->set_timestamp_offset(timestamp_offset);
+    if (use_window_views) {
+      options->set_use_window_views(true);
+      options->set_windows_per_chunk(windows_per_chunk);
+    }
     runner_ = ::absl::make_unique<CalculatorRunner>(config);
   }
   std::unique_ptr<CalculatorRunner> runner_;
@@ -236,5 +242,84 @@ TEST_F(LappedTensorBufferCalculatorTest, OneToThreeBatchTimestampOffset) {
   }
 }
 
+TEST_F(LappedTensorBufferCalculatorTest, WindowViewsMatchConcatenation) {
+  int buffer_size = 5;
+  int overlap = 3;
+  bool add_dim = true;
+  // Two windows per chunk forces several chunk switches over the run.
+  SetUpCalculator(buffer_size, overlap, add_dim, 0, true, 2);
+  int num_timesteps = 20;
+  for (int i = 0; i < num_timesteps; ++i) {
+    auto input = ::absl::make_unique<tensorflow::Tensor>(
+        tensorflow::DT_FLOAT, tensorflow::TensorShape({4}));
+    for (int k = 0; k < 4; ++k) {
+      input->tensor<float, 1>()(k) = i * 10 + k;
+    }
+    runner_->MutableInputs()->Index(0).packets.push_back(
+        Adopt(input.release()).At(Timestamp(i)));
+  }
+  ASSERT_TRUE(runner_->Run().ok());
+
+  const std::vector<Packet>& output_packets =
+      runner_->Outputs().Index(0).packets;
+  int hop = buffer_size - overlap;
+  ASSERT_EQ((num_timesteps - buffer_size) / hop + 1, output_packets.size());
+  for (int i = 0; i < output_packets.size(); ++i) {
+    const tf::Tensor& output = output_packets[i].Get<tf::Tensor>();
+    ASSERT_EQ(2, output.dims());
+    ASSERT_EQ(buffer_size, output.dim_size(0));
+    ASSERT_EQ(4, output.dim_size(1));
+    EXPECT_EQ(i * hop, output_packets[i].Timestamp().Value());
+    for (int j = 0; j < buffer_size; ++j) {
+      for (int k = 0; k < 4; ++k) {
+        float value = output.flat<float>()(j * 4 + k);
+        ASSERT_NEAR((i * hop + j) * 10 + k, value, 0.0001);
+      }
+    }
+  }
+}
+
+TEST_F(LappedTensorBufferCalculatorTest, WindowViewsRejectShapeChange) {
+  SetUpCalculator(2, 1, false, 0, true);
+  for (int i = 0; i < 3; ++i) {
+    auto input = ::absl::make_unique<tensorflow::Tensor>(
+        tensorflow::DT_FLOAT, tensorflow::TensorShape({i + 1}));
+    runner_->MutableInputs()->Index(0).packets.push_back(
+        Adopt(input.release()).At(Timestamp(i)));
+  }
+  ASSERT_FALSE(runner_->Run().ok());
+}
+
+// Audio-style windows: 1000 frames of 64 float features with a hop of 10.
+void BM_LappedTensorBuffer(benchmark::State& state) {
+  const int kBufferSize = 1000;
+  const int kOverlap = 990;
+  const int kNumFeatures = 64;
+  const int kNumTimesteps = 2000;
+  CalculatorGraphConfig::Node config;
+  config.set_calculator("LappedTensorBufferCalculator");
+  config.add_input_stream("input_tensor");
+  config.add_output_stream("output_tensor");
+  auto options = config.mutable_options()->MutableExtension(
+      LappedTensorBufferCalculatorOptions::ext);
+  options->set_buffer_size(kBufferSize);
+  options->set_overlap(kOverlap);
+  options->set_add_batch_dim_to_tensors(true);
+  options->set_use_window_views(state.range(0));
+  std::vector<Packet> inputs;
+  for (int i = 0; i < kNumTimesteps; ++i) {
+    tf::Tensor input(tf::DT_FLOAT, tf::TensorShape({kNumFeatures}));
+    input.flat<float>().setConstant(i);
+    inputs.push_back(MakePacket<tf::Tensor>(input).At(Timestamp(i)));
+  }
+  for (auto _ : state) {
+    CalculatorRunner runner(config);
+    runner.MutableInputs()->Index(0).packets = inputs;
+    CHECK(runner.Run().ok());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumTimesteps);
+}
+BENCHMARK(BM_LappedTensorBuffer)->Arg(0)->Arg(1);
+
 }  // namespace
 }  // namespace mediapipe
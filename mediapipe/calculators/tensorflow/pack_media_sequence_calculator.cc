@@ -26,6 +26,7 @@
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/util/sequence/media_sequence.h"
+#include "mediapipe/util/sequence/media_sequence_stream.h"
 #include "mediapipe/util/sequence/media_sequence_util.h"
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
@@ -65,6 +66,12 @@ namespace mpms = ::mediapipe::mediasequence;
 // timestamp zero, the "ENCODED_MEDIA_START_TIMESTAMP" should be recorded as
 // well. Use the FirstTimestampCalculator to determine this value.
 //
+// For long clips, set streaming_output_path to write the SequenceExample to a
+// TFRecord file in chunks instead of holding all of it in memory. The output
+// stream and side packet are not used in that mode, and reconcile_metadata
+// must be set to false. If output_only_if_all_present is set and a stream is
+// missing, the file is deleted when the calculator closes.
+//
 // Example config:
 // node {
 //   calculator: "PackMediaSequenceCalculator"
@@ -139,10 +146,25 @@ class PackMediaSequenceCalculator : public CalculatorBase {
       }
     }
 
-    CHECK(cc->Outputs().HasTag(kSequenceExampleTag) ||
-          cc->OutputSidePackets().HasTag(kSequenceExampleTag))
-        << "Neither the output stream nor the output side packet is set to "
-           "output the sequence example.";
+    const auto& options = cc->Options<PackMediaSequenceCalculatorOptions>();
+    if (options.has_streaming_output_path()) {
+      RET_CHECK(!cc->Outputs().HasTag(kSequenceExampleTag) &&
+                !cc->OutputSidePackets().HasTag(kSequenceExampleTag))
+          << "The sequence example outputs cannot be used with "
+             "streaming_output_path.";
+      // reconcile_metadata defaults to true, so it must be turned off
+      // explicitly to acknowledge that the streamed metadata is not
+      // reconciled.
+      RET_CHECK(options.has_reconcile_metadata() &&
+                !options.reconcile_metadata())
+          << "reconcile_metadata must be set to false with "
+             "streaming_output_path.";
+    } else {
+      CHECK(cc->Outputs().HasTag(kSequenceExampleTag) ||
+            cc->OutputSidePackets().HasTag(kSequenceExampleTag))
+          << "Neither the output stream nor the output side packet is set to "
+             "output the sequence example.";
+    }
     if (cc->Outputs().HasTag(kSequenceExampleTag)) {
       cc->Outputs().Tag(kSequenceExampleTag).Set<tf::SequenceExample>();
     }
@@ -203,6 +225,16 @@ class PackMediaSequenceCalculator : public CalculatorBase {
       }
     }
 
+    const auto& options = cc->Options<PackMediaSequenceCalculatorOptions>();
+    if (options.has_streaming_output_path()) {
+      RET_CHECK_GT(options.streaming_flush_interval(), 0);
+      ASSIGN_OR_RETURN(
+          auto sink, mpms::CreateTfRecordSink(options.streaming_output_path()));
+      stream_writer_ =
+          absl::make_unique<mpms::SequenceExampleStreamWriter>(std::move(sink));
+      steps_until_flush_ = options.streaming_flush_interval();
+    }
+
     if (cc->Outputs().HasTag(kSequenceExampleTag)) {
       cc->Outputs()
           .Tag(kSequenceExampleTag)
@@ -230,6 +262,25 @@ class PackMediaSequenceCalculator : public CalculatorBase {
   ::mediapipe::Status Close(CalculatorContext* cc) override {
     auto& options =
         cc->Options().GetExtension(PackMediaSequenceCalculatorOptions::ext);
+    if (stream_writer_) {
+      if (options.output_only_if_all_present()) {
+        ::mediapipe::Status status = VerifySequence();
+        if (!status.ok()) {
+          cc->GetCounter(status.error_message())->Increment();
+          // Records were already flushed during the run, so the incomplete
+          // sequence is removed rather than left on disk.
+          stream_writer_.reset();
+          RETURN_IF_ERROR(mpms::DeleteSequenceExampleRecords(
+              options.streaming_output_path()));
+          return status;
+        }
+      }
+      RETURN_IF_ERROR(stream_writer_->Close(sequence_.get()));
+      stream_writer_.reset();
+      sequence_.reset();
+      return ::mediapipe::OkStatus();
+    }
+
     if (options.reconcile_metadata()) {
       RET_CHECK_OK(mpms::ReconcileMetadata(options.reconcile_bbox_annotations(),
                                            sequence_.get()));
@@ -243,17 +294,17 @@ class PackMediaSequenceCalculator : public CalculatorBase {
       }
     }
 
+    // The side packet and the stream share one immutable packet, so the
+    // SequenceExample is never copied.
+    Packet sequence_packet = Adopt(sequence_.release());
     if (cc->OutputSidePackets().HasTag(kSequenceExampleTag)) {
-      cc->OutputSidePackets()
-          .Tag(kSequenceExampleTag)
-          .Set(MakePacket<tensorflow::SequenceExample>(*sequence_));
+      cc->OutputSidePackets().Tag(kSequenceExampleTag).Set(sequence_packet);
     }
     if (cc->Outputs().HasTag(kSequenceExampleTag)) {
       cc->Outputs()
           .Tag(kSequenceExampleTag)
-          .Add(sequence_.release(), Timestamp::PostStream());
+          .AddPacket(sequence_packet.At(Timestamp::PostStream()));
     }
-    sequence_.reset();
 
     return ::mediapipe::OkStatus();
   }
@@ -392,11 +443,20 @@ class PackMediaSequenceCalculator : public CalculatorBase {
         features_present_[tag] = true;
       }
     }
+    if (stream_writer_ && --steps_until_flush_ <= 0) {
+      RETURN_IF_ERROR(
+          stream_writer_->WriteAndClearFeatureLists(sequence_.get()));
+      steps_until_flush_ = cc->Options<PackMediaSequenceCalculatorOptions>()
+                               .streaming_flush_interval();
+    }
     return ::mediapipe::OkStatus();
   }
 
   std::unique_ptr<tf::SequenceExample> sequence_;
   std::map<std::string, bool> features_present_;
+  // Only set when streaming_output_path is set.
+  std::unique_ptr<mpms::SequenceExampleStreamWriter> stream_writer_;
+  int steps_until_flush_ = 0;
 };
 REGISTER_CALCULATOR(PackMediaSequenceCalculator);
 
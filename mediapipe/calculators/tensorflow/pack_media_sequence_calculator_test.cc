@@ -16,6 +16,7 @@
 
 #include "absl/memory/memory.h"
 #include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "mediapipe/calculators/image/opencv_image_encoder_calculator.pb.h"
 #include "mediapipe/calculators/tensorflow/pack_media_sequence_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
@@ -27,8 +28,10 @@
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
 #include "mediapipe/framework/port/opencv_imgcodecs_inc.h"
+#include "mediapipe/framework/port/status_macros.h"
 #include "mediapipe/framework/port/status_matchers.h"
 #include "mediapipe/util/sequence/media_sequence.h"
+#include "mediapipe/util/sequence/media_sequence_stream.h"
 #include "tensorflow/core/example/example.pb.h"
 #include "tensorflow/core/example/feature.pb.h"
 
@@ -619,5 +622,109 @@ TEST_F(PackMediaSequenceCalculatorTest, TestReconcilingAnnotations) {
   ASSERT_EQ(mpms::GetBBoxTimestampAt(output_sequence, 4), 50);
 }
 
+TEST(PackMediaSequenceCalculatorStreamingTest, StreamsFloatFeatures) {
+  const std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/streamed_sequence.tfrecord");
+  CalculatorGraphConfig::Node config;
+  config.set_calculator("PackMediaSequenceCalculator");
+  config.add_input_side_packet("SEQUENCE_EXAMPLE:input_sequence");
+  config.add_input_stream("FLOAT_FEATURE_TEST:test");
+  auto options = config.mutable_options()->MutableExtension(
+      PackMediaSequenceCalculatorOptions::ext);
+  options->set_streaming_output_path(path);
+  options->set_streaming_flush_interval(3);
+  options->set_reconcile_metadata(false);
+  CalculatorRunner runner(config);
+
+  auto input_sequence = ::absl::make_unique<tf::SequenceExample>();
+  mpms::SetClipMediaId("test_video_id", input_sequence.get());
+  runner.MutableSidePackets()->Tag("SEQUENCE_EXAMPLE") =
+      Adopt(input_sequence.release());
+  int num_timesteps = 7;
+  for (int i = 0; i < num_timesteps; ++i) {
+    runner.MutableInputs()
+        ->Tag("FLOAT_FEATURE_TEST")
+        .packets.push_back(
+            MakePacket<std::vector<float>>(2, i).At(Timestamp(i)));
+  }
+  MEDIAPIPE_ASSERT_OK(runner.Run());
+
+  int num_records = 0;
+  tf::SequenceExample output_sequence;
+  MEDIAPIPE_ASSERT_OK(mpms::ForEachSequenceExampleRecord(
+      path, [&](absl::string_view record) -> ::mediapipe::Status {
+        ++num_records;
+        RETURN_IF_ERROR(mpms::ParseContext(record, &output_sequence));
+        return mpms::ParseFeatureLists(record,
+                                       {mpms::GetFeatureTimestampKey("TEST"),
+                                        mpms::GetFeatureFloatsKey("TEST")},
+                                       &output_sequence);
+      }));
+  ASSERT_EQ(3, num_records);
+  ASSERT_EQ("test_video_id", mpms::GetClipMediaId(output_sequence));
+  ASSERT_EQ(num_timesteps,
+            mpms::GetFeatureTimestampSize("TEST", output_sequence));
+  ASSERT_EQ(num_timesteps, mpms::GetFeatureFloatsSize("TEST", output_sequence));
+  for (int i = 0; i < num_timesteps; ++i) {
+    ASSERT_EQ(i, mpms::GetFeatureTimestampAt("TEST", output_sequence, i));
+    ASSERT_THAT(mpms::GetFeatureFloatsAt("TEST", output_sequence, i),
+                ::testing::ElementsAreArray(std::vector<float>(2, i)));
+  }
+}
+
+TEST(PackMediaSequenceCalculatorStreamingTest, DeletesIncompleteSequence) {
+  const std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/incomplete_sequence.tfrecord");
+  CalculatorGraphConfig::Node config;
+  config.set_calculator("PackMediaSequenceCalculator");
+  config.add_input_side_packet("SEQUENCE_EXAMPLE:input_sequence");
+  config.add_input_stream("FLOAT_FEATURE_TEST:test");
+  config.add_input_stream("FLOAT_FEATURE_MISSING:missing");
+  auto options = config.mutable_options()->MutableExtension(
+      PackMediaSequenceCalculatorOptions::ext);
+  options->set_streaming_output_path(path);
+  options->set_streaming_flush_interval(1);
+  options->set_reconcile_metadata(false);
+  options->set_output_only_if_all_present(true);
+  CalculatorRunner runner(config);
+
+  runner.MutableSidePackets()->Tag("SEQUENCE_EXAMPLE") =
+      Adopt(new tf::SequenceExample());
+  for (int i = 0; i < 3; ++i) {
+    runner.MutableInputs()
+        ->Tag("FLOAT_FEATURE_TEST")
+        .packets.push_back(
+            MakePacket<std::vector<float>>(2, i).At(Timestamp(i)));
+  }
+  EXPECT_FALSE(runner.Run().ok());
+  auto ignore_record = [](absl::string_view record) {
+    return ::mediapipe::OkStatus();
+  };
+  EXPECT_FALSE(mpms::ForEachSequenceExampleRecord(path, ignore_record).ok());
+}
+
+TEST(PackMediaSequenceCalculatorStreamingTest,
+     RequiresReconcileMetadataDisabled) {
+  CalculatorGraphConfig::Node config;
+  config.set_calculator("PackMediaSequenceCalculator");
+  config.add_input_side_packet("SEQUENCE_EXAMPLE:input_sequence");
+  config.add_input_stream("FLOAT_FEATURE_TEST:test");
+  auto options = config.mutable_options()->MutableExtension(
+      PackMediaSequenceCalculatorOptions::ext);
+  options->set_streaming_output_path(
+      absl::StrCat(getenv("TEST_TMPDIR"), "/reconciled_sequence.tfrecord"));
+
+  // Both the default and an explicit reconcile_metadata: true are rejected.
+  for (bool set_reconcile_metadata : {false, true}) {
+    if (set_reconcile_metadata) {
+      options->set_reconcile_metadata(true);
+    }
+    CalculatorRunner runner(config);
+    runner.MutableSidePackets()->Tag("SEQUENCE_EXAMPLE") =
+        Adopt(new tf::SequenceExample());
+    EXPECT_FALSE(runner.Run().ok());
+  }
+}
+
 }  // namespace
 }  // namespace mediapipe
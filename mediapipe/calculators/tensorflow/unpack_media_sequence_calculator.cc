@@ -195,9 +195,14 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
         LOG(INFO) << "Found feature timestamps: " << map_kv.first
                   << " with size: " << map_kv.second.feature_size();
         int64 recent_timestamp = Timestamp::PreStream().Value();
-        for (int i = 0; i < map_kv.second.feature_size(); ++i) {
-          int64 next_timestamp =
-              mpms::GetInt64sAt(*sequence_, map_kv.first, i).Get(0);
+        // Read the feature list directly instead of looking up the key for
+        // every element.
+        const tf::FeatureList& timestamp_list = map_kv.second;
+        timestamps_[map_kv.first].reserve(timestamp_list.feature_size());
+        for (const tf::Feature& feature : timestamp_list.feature()) {
+          RET_CHECK_GT(feature.int64_list().value_size(), 0)
+              << "Missing timestamp value. Key: " << map_kv.first;
+          int64 next_timestamp = feature.int64_list().value(0);
           RET_CHECK_GT(next_timestamp, recent_timestamp)
               << "Timestamps must be sequential. If you're seeing this message "
               << "you may have added images to the same SequenceExample twice. "
@@ -230,6 +235,10 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
           << sequence_->DebugString();
     }
     current_timestamp_index_ = 0;
+    next_indices_.clear();
+    for (const auto& map_kv : timestamps_) {
+      next_indices_[map_kv.first] = 0;
+    }
 
     // Determine the data path and output it.
     const auto& options =
@@ -330,9 +339,14 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
     }
 
     for (const auto& map_kv : timestamps_) {
-      for (int i = 0; i < map_kv.second.size(); ++i) {
-        if (map_kv.second[i] >= start_timestamp &&
-            map_kv.second[i] < end_timestamp) {
+      // Timestamps are sorted and the windows are contiguous, so each key only
+      // needs to resume from where the previous window stopped.
+      int& next_index = next_indices_[map_kv.first];
+      for (; next_index < map_kv.second.size() &&
+             map_kv.second[next_index] < end_timestamp;
+           ++next_index) {
+        const int i = next_index;
+        if (map_kv.second[i] >= start_timestamp) {
           const Timestamp current_timestamp =
               map_kv.second[i] == Timestamp::PostStream().Value()
                   ? Timestamp::PostStream()
@@ -419,6 +433,9 @@ class UnpackMediaSequenceCalculator : public CalculatorBase {
   // key. This allows us to identify which packets to output for each stream
   // for timestamps within a given time window.
   std::map<std::string, std::vector<int64>> timestamps_;
+  // Store the index of the next timestamp to output for each key in
+  // timestamps_.
+  std::map<std::string, int> next_indices_;
   // Store the stream with the latest timestamp in the SequenceExample.
   std::string last_timestamp_key_;
   // Store the index of the current timestamp. Will be less than
@@ -13,11 +13,16 @@
 // limitations under the License.
 
 #include <cmath>
+#include <map>
+#include <string>
 #include <vector>
 
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/calculators/tflite/ssd_anchors_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/object_detection/anchor.pb.h"
+#include "mediapipe/framework/formats/object_detection/anchor_set.h"
 #include "mediapipe/framework/port/ret_check.h"
 
 namespace mediapipe {
@@ -30,12 +35,24 @@ float CalculateScale(float min_scale, float max_scale, int stride_index,
          (max_scale - min_scale) * 1.0 * stride_index / (num_strides - 1.0f);
 }
 
+// The anchors generated for one set of options, in both output formats.
+struct CachedAnchors {
+  Packet anchors;
+  Packet anchor_set;
+};
+
 }  // namespace
 
 // Generate anchors for SSD object detection model.
 // Output:
 //   ANCHORS: A list of anchors. Model generates predictions based on the
-//   offsets of these anchors.
+//   offsets of these anchors. This is the untagged output side packet.
+//   ANCHOR_SET: The same anchors as an AnchorSet, which
+//   TfLiteTensorsToDetectionsCalculator decodes boxes against without
+//   converting them first.
+//
+// The anchors depend only on the options, so they are generated once per
+// process for each distinct set of options and shared by later graph runs.
 //
 // Usage example:
 // node {
@@ -68,7 +85,12 @@ float CalculateScale(float min_scale, float max_scale, int stride_index,
 class SsdAnchorsCalculator : public CalculatorBase {
  public:
   static ::mediapipe::Status GetContract(CalculatorContract* cc) {
-    cc->OutputSidePackets().Index(0).Set<std::vector<Anchor>>();
+    if (cc->OutputSidePackets().GetId("", 0).IsValid()) {
+      cc->OutputSidePackets().Index(0).Set<std::vector<Anchor>>();
+    }
+    if (cc->OutputSidePackets().HasTag("ANCHOR_SET")) {
+      cc->OutputSidePackets().Tag("ANCHOR_SET").Set<AnchorSet>();
+    }
     return ::mediapipe::OkStatus();
   }
 
@@ -76,9 +98,14 @@ class SsdAnchorsCalculator : public CalculatorBase {
     const SsdAnchorsCalculatorOptions& options =
         cc->Options<SsdAnchorsCalculatorOptions>();
 
-    auto anchors = absl::make_unique<std::vector<Anchor>>();
-    RETURN_IF_ERROR(GenerateAnchors(anchors.get(), options));
-    cc->OutputSidePackets().Index(0).Set(Adopt(anchors.release()));
+    CachedAnchors cached;
+    RETURN_IF_ERROR(GetCachedAnchors(options, &cached));
+    if (cc->OutputSidePackets().GetId("", 0).IsValid()) {
+      cc->OutputSidePackets().Index(0).Set(cached.anchors);
+    }
+    if (cc->OutputSidePackets().HasTag("ANCHOR_SET")) {
+      cc->OutputSidePackets().Tag("ANCHOR_SET").Set(cached.anchor_set);
+    }
     return ::mediapipe::OkStatus();
   }
 
@@ -87,13 +114,38 @@ class SsdAnchorsCalculator : public CalculatorBase {
   }
 
  private:
+  // Returns the anchors for "options", generating them on the first request
+  // for these options in this process.
+  static ::mediapipe::Status GetCachedAnchors(
+      const SsdAnchorsCalculatorOptions& options, CachedAnchors* cached);
+
   static ::mediapipe::Status GenerateAnchors(
-      std::vector<Anchor>* anchors, const SsdAnchorsCalculatorOptions& options);
+      AnchorSet* anchors, const SsdAnchorsCalculatorOptions& options);
 };
 REGISTER_CALCULATOR(SsdAnchorsCalculator);
 
+::mediapipe::Status SsdAnchorsCalculator::GetCachedAnchors(
+    const SsdAnchorsCalculatorOptions& options, CachedAnchors* cached) {
+  static absl::Mutex* mutex = new absl::Mutex;
+  static auto* cache = new std::map<std::string, CachedAnchors>();
+  const std::string key = options.SerializeAsString();
+  absl::MutexLock lock(mutex);
+  auto it = cache->find(key);
+  if (it == cache->end()) {
+    auto anchor_set = absl::make_unique<AnchorSet>();
+    RETURN_IF_ERROR(GenerateAnchors(anchor_set.get(), options));
+    CachedAnchors generated;
+    generated.anchors = MakePacket<std::vector<Anchor>>(
+        AnchorsFromAnchorSet(*anchor_set));
+    generated.anchor_set = Adopt(anchor_set.release());
+    it = cache->emplace(key, generated).first;
+  }
+  *cached = it->second;
+  return ::mediapipe::OkStatus();
+}
+
 ::mediapipe::Status SsdAnchorsCalculator::GenerateAnchors(
-    std::vector<Anchor>* anchors, const SsdAnchorsCalculatorOptions& options) {
+    AnchorSet* anchors, const SsdAnchorsCalculatorOptions& options) {
   // Verify the options.
   if (!options.feature_map_height_size() && !options.strides_size()) {
     return ::mediapipe::InvalidArgumentError(
@@ -183,18 +235,12 @@ REGISTER_CALCULATOR(SsdAnchorsCalculator);
           const float y_center =
               (y + options.anchor_offset_y()) * 1.0f / feature_map_height;
 
-          Anchor new_anchor;
-          new_anchor.set_x_center(x_center);
-          new_anchor.set_y_center(y_center);
-
           if (options.fixed_anchor_size()) {
-            new_anchor.set_w(1.0f);
-            new_anchor.set_h(1.0f);
+            anchors->Add(x_center, y_center, 1.0f, 1.0f);
           } else {
-            new_anchor.set_w(anchor_width[anchor_id]);
-            new_anchor.set_h(anchor_height[anchor_id]);
+            anchors->Add(x_center, y_center, anchor_height[anchor_id],
+                         anchor_width[anchor_id]);
           }
-          anchors->push_back(new_anchor);
         }
       }
     }
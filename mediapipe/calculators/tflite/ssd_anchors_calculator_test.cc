@@ -16,6 +16,7 @@
 #include "mediapipe/framework/calculator_runner.h"
 #include "mediapipe/framework/deps/file_path.h"
 #include "mediapipe/framework/formats/object_detection/anchor.pb.h"
+#include "mediapipe/framework/formats/object_detection/anchor_set.h"
 #include "mediapipe/framework/port/file_helpers.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -147,4 +148,45 @@ TEST(SsdAnchorCalculatorTest, MobileSSDConfig) {
   CompareAnchors(anchors, anchors_golden);
 }
 
+TEST(SsdAnchorCalculatorTest, OutputsCachedAnchorSet) {
+  const auto node_config = ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "SsdAnchorsCalculator"
+    output_side_packet: "anchors"
+    output_side_packet: "ANCHOR_SET:anchor_set"
+    options {
+      [mediapipe.SsdAnchorsCalculatorOptions.ext] {
+        num_layers: 4
+        min_scale: 0.1484375
+        max_scale: 0.75
+        input_size_height: 128
+        input_size_width: 128
+        anchor_offset_x: 0.5
+        anchor_offset_y: 0.5
+        strides: 8
+        strides: 16
+        strides: 16
+        strides: 16
+        aspect_ratios: 1.0
+        fixed_anchor_size: true
+      }
+    }
+  )");
+  CalculatorRunner runner(node_config);
+  MEDIAPIPE_ASSERT_OK(runner.Run()) << "Calculator execution failed.";
+  const auto& anchors =
+      runner.OutputSidePackets().Index(0).Get<std::vector<Anchor>>();
+  const auto& anchor_set =
+      runner.OutputSidePackets().Tag("ANCHOR_SET").Get<AnchorSet>();
+  ASSERT_EQ(896, anchors.size());
+  CompareAnchors(AnchorsFromAnchorSet(anchor_set), anchors);
+
+  // A second run with the same options gets the same anchors without
+  // generating them again.
+  CalculatorRunner second_runner(node_config);
+  MEDIAPIPE_ASSERT_OK(second_runner.Run()) << "Calculator execution failed.";
+  const AnchorSet& cached_anchor_set =
+      second_runner.OutputSidePackets().Tag("ANCHOR_SET").Get<AnchorSet>();
+  EXPECT_EQ(&anchor_set, &cached_anchor_set);
+}
+
 }  // namespace mediapipe
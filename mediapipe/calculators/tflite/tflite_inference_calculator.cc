@@ -20,6 +20,7 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/util/resource_util.h"
+#include "mediapipe/util/tflite/tflite_model_cache.h"
 #include "tensorflow/lite/error_reporter.h"
 #include "tensorflow/lite/interpreter.h"
 #include "tensorflow/lite/kernels/register.h"
@@ -89,6 +90,12 @@ struct GPUData {
 //  CUSTOM_OP_RESOLVER (optional) - Use a custom op resolver,
 //                                  instead of the builtin one.
 //
+// Graph service:
+//  kTfLiteModelCacheService (optional) - Shares the model, and the builtin op
+//                                        resolver, with the other nodes and
+//                                        graphs using the same cache. Counts
+//                                        "ModelLoads" and "ModelCacheHits".
+//
 // Example use:
 // node {
 //   calculator: "TfLiteInferenceCalculator"
@@ -123,8 +130,10 @@ class TfLiteInferenceCalculator : public CalculatorBase {
   ::mediapipe::Status LoadModel(CalculatorContext* cc);
   ::mediapipe::Status LoadDelegate(CalculatorContext* cc);
 
+  // Owned by this calculator, or shared through the TfLiteModelCache. Declared
+  // first, since the interpreter must be destroyed before the model.
+  std::shared_ptr<const tflite::FlatBufferModel> model_;
   std::unique_ptr<tflite::Interpreter> interpreter_;
-  std::unique_ptr<tflite::FlatBufferModel> model_;
   TfLiteDelegate* delegate_ = nullptr;
 
 #if defined(__ANDROID__)
@@ -179,6 +188,9 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
   RETURN_IF_ERROR([MediaPipeMetalHelper updateContract:cc]);
 #endif
 
+  // Models are shared with other nodes and graphs if a cache is provided.
+  cc->UseService(kTfLiteModelCacheService).Optional();
+
   // Assign this calculator's default InputStreamHandler.
   cc->SetInputStreamHandler("FixedSizeInputStreamHandler");
 
@@ -357,8 +369,15 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
 
 ::mediapipe::Status TfLiteInferenceCalculator::LoadModel(
     CalculatorContext* cc) {
-  model_ = tflite::FlatBufferModel::BuildFromFile(model_path_.c_str());
-  RET_CHECK(model_);
+  TfLiteModelCache* model_cache = nullptr;
+  if (cc->Service(kTfLiteModelCacheService).IsAvailable()) {
+    model_cache = &cc->Service(kTfLiteModelCacheService).GetObject();
+    bool cache_hit = false;
+    ASSIGN_OR_RETURN(model_, model_cache->GetModel(model_path_, &cache_hit));
+    cc->GetCounter(cache_hit ? "ModelCacheHits" : "ModelLoads")->Increment();
+  } else {
+    ASSIGN_OR_RETURN(model_, LoadTfLiteModel(model_path_));
+  }
 
 #if !defined(__ANDROID__) && !(defined(__APPLE__) && !TARGET_OS_OSX)
   LOG(WARNING) << "GPU only supported on mobile platforms. Using CPU fallback.";
@@ -371,6 +390,9 @@ REGISTER_CALCULATOR(TfLiteInferenceCalculator);
             .Tag("CUSTOM_OP_RESOLVER")
             .Get<tflite::ops::builtin::BuiltinOpResolver>();
     tflite::InterpreterBuilder(*model_, op_resolver)(&interpreter_);
+  } else if (model_cache) {
+    tflite::InterpreterBuilder(*model_, model_cache->BuiltinOpResolver())(
+        &interpreter_);
   } else {
     const tflite::ops::builtin::BuiltinOpResolver op_resolver;
     tflite::InterpreterBuilder(*model_, op_resolver)(&interpreter_);
@@ -26,6 +26,7 @@
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"  // NOLINT
 #include "mediapipe/framework/tool/validate_type.h"
+#include "mediapipe/util/tflite/tflite_model_cache.h"
 #include "tensorflow/lite/error_reporter.h"
 #include "tensorflow/lite/interpreter.h"
 #include "tensorflow/lite/kernels/register.h"
@@ -120,4 +121,57 @@ TEST_F(TfLiteInferenceCalculatorTest, SmokeTest) {
   MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
 }
 
+// Tests that graphs using the same TfLiteModelCache load the model once, and
+// that the model is unloaded when no graph uses it anymore.
+TEST_F(TfLiteInferenceCalculatorTest, SharesModelThroughCache) {
+  CalculatorGraphConfig graph_config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(
+          R"(
+            input_stream: "tensor_in"
+            node {
+              calculator: "TfLiteInferenceCalculator"
+              input_stream: "TENSORS:tensor_in"
+              output_stream: "TENSORS:tensor_out"
+              options {
+                [mediapipe.TfLiteInferenceCalculatorOptions.ext] {
+                  use_gpu: false
+                  model_path: "mediapipe/calculators/tflite/testdata/add.bin"
+                }
+              }
+            }
+          )");
+  auto model_cache = std::make_shared<TfLiteModelCache>();
+  {
+    CalculatorGraph graph_1;
+    CalculatorGraph graph_2;
+    for (CalculatorGraph* graph : {&graph_1, &graph_2}) {
+      MEDIAPIPE_ASSERT_OK(graph->Initialize(graph_config));
+      MEDIAPIPE_ASSERT_OK(
+          graph->SetServiceObject(kTfLiteModelCacheService, model_cache));
+      MEDIAPIPE_ASSERT_OK(graph->StartRun({}));
+      MEDIAPIPE_ASSERT_OK(graph->WaitUntilIdle());
+    }
+    EXPECT_EQ(1, model_cache->num_loads());
+    EXPECT_EQ(1, model_cache->num_cache_hits());
+    EXPECT_EQ(1, graph_1.GetCounterFactory()
+                     ->GetCounter("TfLiteInferenceCalculator-ModelLoads")
+                     ->Get());
+    EXPECT_EQ(1, graph_2.GetCounterFactory()
+                     ->GetCounter("TfLiteInferenceCalculator-ModelCacheHits")
+                     ->Get());
+    for (CalculatorGraph* graph : {&graph_1, &graph_2}) {
+      MEDIAPIPE_ASSERT_OK(graph->CloseAllInputStreams());
+      MEDIAPIPE_ASSERT_OK(graph->WaitUntilDone());
+    }
+  }
+
+  // The calculators have been destroyed with the graphs, so the model is
+  // loaded again.
+  bool cache_hit = true;
+  MEDIAPIPE_ASSERT_OK(model_cache->GetModel(
+      "mediapipe/calculators/tflite/testdata/add.bin", &cache_hit));
+  EXPECT_FALSE(cache_hit);
+  EXPECT_EQ(2, model_cache->num_loads());
+}
+
 }  // namespace mediapipe
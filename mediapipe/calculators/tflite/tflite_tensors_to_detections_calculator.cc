@@ -12,9 +12,14 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
 #include <unordered_map>
 #include <vector>
 
+#include "Eigen/Core"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "mediapipe/calculators/tflite/tflite_tensors_to_detections_calculator.pb.h"
@@ -23,6 +28,7 @@
 #include "mediapipe/framework/formats/detection.pb.h"
 #include "mediapipe/framework/formats/location.h"
 #include "mediapipe/framework/formats/object_detection/anchor.pb.h"
+#include "mediapipe/framework/formats/object_detection/anchor_set.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "tensorflow/lite/interpreter.h"
 
@@ -48,29 +54,30 @@ namespace {
 constexpr int kNumInputTensorsWithAnchors = 3;
 constexpr int kNumCoordsPerBox = 4;
 
+// A row-major view of a tensor with one row per box.
+using BoxArray =
+    Eigen::Array<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
 void ConvertRawValuesToAnchors(const float* raw_anchors, int num_boxes,
-                               std::vector<Anchor>* anchors) {
-  anchors->clear();
+                               AnchorSet* anchors) {
+  *anchors = AnchorSet();
+  anchors->Reserve(num_boxes);
   for (int i = 0; i < num_boxes; ++i) {
-    Anchor new_anchor;
-    new_anchor.set_y_center(raw_anchors[i * kNumCoordsPerBox + 0]);
-    new_anchor.set_x_center(raw_anchors[i * kNumCoordsPerBox + 1]);
-    new_anchor.set_h(raw_anchors[i * kNumCoordsPerBox + 2]);
-    new_anchor.set_w(raw_anchors[i * kNumCoordsPerBox + 3]);
-    anchors->push_back(new_anchor);
+    anchors->Add(raw_anchors[i * kNumCoordsPerBox + 1],
+                 raw_anchors[i * kNumCoordsPerBox + 0],
+                 raw_anchors[i * kNumCoordsPerBox + 2],
+                 raw_anchors[i * kNumCoordsPerBox + 3]);
   }
 }
 
-void ConvertAnchorsToRawValues(const std::vector<Anchor>& anchors,
-                               int num_boxes, float* raw_anchors) {
+void ConvertAnchorsToRawValues(const AnchorSet& anchors, int num_boxes,
+                               float* raw_anchors) {
   CHECK_EQ(anchors.size(), num_boxes);
-  int box = 0;
-  for (auto anchor : anchors) {
-    raw_anchors[box * kNumCoordsPerBox + 0] = anchor.y_center();
-    raw_anchors[box * kNumCoordsPerBox + 1] = anchor.x_center();
-    raw_anchors[box * kNumCoordsPerBox + 2] = anchor.h();
-    raw_anchors[box * kNumCoordsPerBox + 3] = anchor.w();
-    ++box;
+  for (int box = 0; box < num_boxes; ++box) {
+    raw_anchors[box * kNumCoordsPerBox + 0] = anchors.y_center[box];
+    raw_anchors[box * kNumCoordsPerBox + 1] = anchors.x_center[box];
+    raw_anchors[box * kNumCoordsPerBox + 2] = anchors.h[box];
+    raw_anchors[box * kNumCoordsPerBox + 3] = anchors.w[box];
   }
 }
 
@@ -89,6 +96,10 @@ void ConvertAnchorsToRawValues(const std::vector<Anchor>& anchors,
 //               models) depend on the outputs of the detection model. The size
 //               of anchor tensor must be (num_boxes * 4).
 //  TENSORS_GPU - vector of GlBuffer.
+// Input side packets:
+//  ANCHORS - Optional std::vector<Anchor>, used if there is no anchor tensor.
+//  ANCHOR_SET - Optional AnchorSet, e.g. from SsdAnchorsCalculator, used
+//               instead of ANCHORS without a conversion.
 // Output:
 //  DETECTIONS - Result MediaPipe detections.
 //
@@ -122,9 +133,23 @@ class TfLiteTensorsToDetectionsCalculator : public CalculatorBase {
  private:
   ::mediapipe::Status LoadOptions(CalculatorContext* cc);
   ::mediapipe::Status GlSetup(CalculatorContext* cc);
-  ::mediapipe::Status DecodeBoxes(const float* raw_boxes,
-                                  const std::vector<Anchor>& anchors,
-                                  std::vector<float>* boxes);
+  // Loads the anchors from the ANCHORS or ANCHOR_SET side packet. Returns
+  // false if neither is available.
+  bool LoadSidePacketAnchors(CalculatorContext* cc);
+  // Decodes one box per anchor in "anchors" from the first rows of
+  // "raw_boxes" into "boxes".
+  void DecodeBoxes(const float* raw_boxes, const AnchorSet& anchors,
+                   float* boxes);
+  // Finds the top score and its class for each box. Writes the pairs to
+  // "score_class_id_pairs".
+  void ScoreBoxes(const float* raw_scores,
+                  std::vector<float>* score_class_id_pairs);
+  // Returns the indices of the boxes to output, in increasing order.
+  std::vector<int> SelectBoxes(const std::vector<float>& score_class_id_pairs);
+  // Copies the raw boxes and the anchors of "box_indices" to contiguous rows.
+  void GatherBoxes(const float* raw_boxes, const std::vector<int>& box_indices,
+                   std::vector<float>* selected_raw_boxes,
+                   AnchorSet* selected_anchors);
   Detection ConvertToDetection(float box_ymin, float box_xmin, float box_ymax,
                                float box_xmax, float score, int class_id,
                                bool flip_vertically);
@@ -133,9 +158,11 @@ class TfLiteTensorsToDetectionsCalculator : public CalculatorBase {
   int num_boxes_ = 0;
   int num_coords_ = 0;
   std::set<int> ignore_classes_;
+  // The classes that are not ignored, in increasing order.
+  std::vector<int> scored_classes_;
 
   ::mediapipe::TfLiteTensorsToDetectionsCalculatorOptions options_;
-  std::vector<Anchor> anchors_;
+  AnchorSet anchors_;
 
 #if defined(__ANDROID__)
   mediapipe::GlCalculatorHelper gpu_helper_;
@@ -176,6 +203,9 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
     if (cc->InputSidePackets().HasTag("ANCHORS")) {
       cc->InputSidePackets().Tag("ANCHORS").Set<std::vector<Anchor>>();
     }
+    if (cc->InputSidePackets().HasTag("ANCHOR_SET")) {
+      cc->InputSidePackets().Tag("ANCHOR_SET").Set<AnchorSet>();
+    }
   }
 
 #if defined(__ANDROID__)
@@ -210,13 +240,14 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
     return ::mediapipe::OkStatus();
   }
 
-  const bool side_packet_anchors =
-      cc->InputSidePackets().HasTag("ANCHORS") &&
-      !cc->InputSidePackets().Tag("ANCHORS").IsEmpty();
   auto output_detections = absl::make_unique<std::vector<Detection>>();
 
   std::vector<float> boxes(num_boxes_ * num_coords_);
   std::vector<float> score_class_id_pairs(num_boxes_ * 2);
+  // The boxes to output. Row j of "boxes" holds box box_indices[j] if
+  // "boxes_selected", and box j otherwise.
+  std::vector<int> box_indices;
+  bool boxes_selected = false;
 
   if (gpu_input_) {
 #if defined(__ANDROID__)
@@ -227,11 +258,9 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
     tflite::gpu::gl::CopyBuffer(input_tensors[0], *raw_boxes_buffer_.get());
     tflite::gpu::gl::CopyBuffer(input_tensors[1], *raw_scores_buffer_.get());
     if (!anchors_init_) {
-      if (side_packet_anchors) {
-        const auto& anchors =
-            cc->InputSidePackets().Tag("ANCHORS").Get<std::vector<Anchor>>();
+      if (LoadSidePacketAnchors(cc)) {
         std::vector<float> raw_anchors(num_boxes_ * kNumCoordsPerBox);
-        ConvertAnchorsToRawValues(anchors, num_boxes_, raw_anchors.data());
+        ConvertAnchorsToRawValues(anchors_, num_boxes_, raw_anchors.data());
         raw_anchors_buffer_->Write<float>(absl::MakeSpan(raw_anchors));
       } else {
         CHECK_EQ(input_tensors.size(), 3);
@@ -269,6 +298,7 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
     if (!status.ok()) {
       return ::mediapipe::InternalError(status.error_message());
     }
+    box_indices = SelectBoxes(score_class_id_pairs);
 #else
     LOG(ERROR) << "GPU input on non-Android not supported yet.";
 #endif  // defined(__ANDROID__)
@@ -300,51 +330,34 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
         CHECK_EQ(anchor_tensor->dims->data[1], kNumCoordsPerBox);
         const float* raw_anchors = anchor_tensor->data.f;
         ConvertRawValuesToAnchors(raw_anchors, num_boxes_, &anchors_);
-      } else if (side_packet_anchors) {
-        anchors_ =
-            cc->InputSidePackets().Tag("ANCHORS").Get<std::vector<Anchor>>();
-      } else {
+      } else if (!LoadSidePacketAnchors(cc)) {
         return ::mediapipe::UnavailableError("No anchor data available.");
       }
       anchors_init_ = true;
     }
-    RETURN_IF_ERROR(DecodeBoxes(raw_boxes, anchors_, &boxes));
-
-    // Filter classes by scores.
-    for (int i = 0; i < num_boxes_; ++i) {
-      int class_id = -1;
-      float max_score = -std::numeric_limits<float>::max();
-      // Find the top score for box i.
-      for (int score_idx = 0; score_idx < num_classes_; ++score_idx) {
-        if (ignore_classes_.find(score_idx) == ignore_classes_.end()) {
-          auto score = raw_scores[i * num_classes_ + score_idx];
-          if (options_.sigmoid_score()) {
-            if (options_.has_score_clipping_thresh()) {
-              score = score < -options_.score_clipping_thresh()
-                          ? -options_.score_clipping_thresh()
-                          : score;
-              score = score > options_.score_clipping_thresh()
-                          ? options_.score_clipping_thresh()
-                          : score;
-            }
-            score = 1.0f / (1.0f + std::exp(-score));
-          }
-          if (max_score < score) {
-            max_score = score;
-            class_id = score_idx;
-          }
-        }
-      }
-      score_class_id_pairs[i * 2 + 0] = max_score;
-      score_class_id_pairs[i * 2 + 1] = class_id;
+    RET_CHECK_EQ(anchors_.size(), num_boxes_);
+    ScoreBoxes(raw_scores, &score_class_id_pairs);
+    box_indices = SelectBoxes(score_class_id_pairs);
+    if (box_indices.size() < num_boxes_) {
+      // Only the selected boxes are decoded.
+      std::vector<float> selected_raw_boxes;
+      AnchorSet selected_anchors;
+      GatherBoxes(raw_boxes, box_indices, &selected_raw_boxes,
+                  &selected_anchors);
+      DecodeBoxes(selected_raw_boxes.data(), selected_anchors, boxes.data());
+      boxes_selected = true;
+    } else {
+      DecodeBoxes(raw_boxes, anchors_, boxes.data());
     }
   }  // if gpu_input_
 
   // Convert to Detection.
-  for (int i = 0; i < num_boxes_; ++i) {
+  output_detections->reserve(box_indices.size());
+  for (int j = 0; j < box_indices.size(); ++j) {
+    const int i = box_indices[j];
     const float score = score_class_id_pairs[i * 2 + 0];
     const int class_id = score_class_id_pairs[i * 2 + 1];
-    const int box_offset = i * num_coords_;
+    const int box_offset = (boxes_selected ? j : i) * num_coords_;
     Detection detection = ConvertToDetection(
         boxes[box_offset + 0], boxes[box_offset + 1], boxes[box_offset + 2],
         boxes[box_offset + 3], score, class_id, options_.flip_vertically());
@@ -414,71 +427,149 @@ REGISTER_CALCULATOR(TfLiteTensorsToDetectionsCalculator);
   for (int i = 0; i < options_.ignore_classes_size(); ++i) {
     ignore_classes_.insert(options_.ignore_classes(i));
   }
+  for (int i = 0; i < num_classes_; ++i) {
+    if (ignore_classes_.find(i) == ignore_classes_.end()) {
+      scored_classes_.push_back(i);
+    }
+  }
 
   return ::mediapipe::OkStatus();
 }
 
-::mediapipe::Status TfLiteTensorsToDetectionsCalculator::DecodeBoxes(
-    const float* raw_boxes, const std::vector<Anchor>& anchors,
-    std::vector<float>* boxes) {
-  for (int i = 0; i < num_boxes_; ++i) {
-    const int box_offset = i * num_coords_ + options_.box_coord_offset();
-
-    float y_center = raw_boxes[box_offset];
-    float x_center = raw_boxes[box_offset + 1];
-    float h = raw_boxes[box_offset + 2];
-    float w = raw_boxes[box_offset + 3];
-    if (options_.reverse_output_order()) {
-      x_center = raw_boxes[box_offset];
-      y_center = raw_boxes[box_offset + 1];
-      w = raw_boxes[box_offset + 2];
-      h = raw_boxes[box_offset + 3];
-    }
+bool TfLiteTensorsToDetectionsCalculator::LoadSidePacketAnchors(
+    CalculatorContext* cc) {
+  if (cc->InputSidePackets().HasTag("ANCHOR_SET") &&
+      !cc->InputSidePackets().Tag("ANCHOR_SET").IsEmpty()) {
+    anchors_ = cc->InputSidePackets().Tag("ANCHOR_SET").Get<AnchorSet>();
+    return true;
+  }
+  if (cc->InputSidePackets().HasTag("ANCHORS") &&
+      !cc->InputSidePackets().Tag("ANCHORS").IsEmpty()) {
+    anchors_ = AnchorSetFromAnchors(
+        cc->InputSidePackets().Tag("ANCHORS").Get<std::vector<Anchor>>());
+    return true;
+  }
+  return false;
+}
 
-    x_center =
-        x_center / options_.x_scale() * anchors[i].w() + anchors[i].x_center();
-    y_center =
-        y_center / options_.y_scale() * anchors[i].h() + anchors[i].y_center();
+// Decodes all boxes at once, one coordinate at a time, so that every step is
+// an elementwise operation over contiguous arrays that Eigen vectorizes.
+void TfLiteTensorsToDetectionsCalculator::DecodeBoxes(const float* raw_boxes,
+                                                      const AnchorSet& anchors,
+                                                      float* boxes) {
+  const int num_boxes = anchors.size();
+  const Eigen::Map<const BoxArray> raw(raw_boxes, num_boxes, num_coords_);
+  Eigen::Map<BoxArray> decoded(boxes, num_boxes, num_coords_);
+  const Eigen::Map<const Eigen::ArrayXf> anchor_x(anchors.x_center.data(),
+                                                  num_boxes);
+  const Eigen::Map<const Eigen::ArrayXf> anchor_y(anchors.y_center.data(),
+                                                  num_boxes);
+  const Eigen::Map<const Eigen::ArrayXf> anchor_h(anchors.h.data(), num_boxes);
+  const Eigen::Map<const Eigen::ArrayXf> anchor_w(anchors.w.data(), num_boxes);
+
+  // The raw order is [y_center, x_center, h, w], or [x_center, y_center, w,
+  // h] if reversed.
+  const int box_offset = options_.box_coord_offset();
+  const bool reverse = options_.reverse_output_order();
+  const int x_index = box_offset + (reverse ? 0 : 1);
+  const int y_index = box_offset + (reverse ? 1 : 0);
+  const int h_index = box_offset + (reverse ? 3 : 2);
+  const int w_index = box_offset + (reverse ? 2 : 3);
+
+  // The strided columns are copied into contiguous arrays first.
+  Eigen::ArrayXf x_center = raw.col(x_index);
+  Eigen::ArrayXf y_center = raw.col(y_index);
+  Eigen::ArrayXf h = raw.col(h_index);
+  Eigen::ArrayXf w = raw.col(w_index);
+  x_center = x_center / options_.x_scale() * anchor_w + anchor_x;
+  y_center = y_center / options_.y_scale() * anchor_h + anchor_y;
+  if (options_.apply_exponential_on_box_size()) {
+    h = (h / options_.h_scale()).exp() * anchor_h;
+    w = (w / options_.w_scale()).exp() * anchor_w;
+  } else {
+    h = h / options_.h_scale() * anchor_h;
+    w = w / options_.w_scale() * anchor_w;
+  }
 
-    if (options_.apply_exponential_on_box_size()) {
-      h = std::exp(h / options_.h_scale()) * anchors[i].h();
-      w = std::exp(w / options_.w_scale()) * anchors[i].w();
-    } else {
-      h = h / options_.h_scale() * anchors[i].h();
-      w = w / options_.w_scale() * anchors[i].w();
-    }
+  decoded.col(0) = y_center - h / 2.f;
+  decoded.col(1) = x_center - w / 2.f;
+  decoded.col(2) = y_center + h / 2.f;
+  decoded.col(3) = x_center + w / 2.f;
+
+  for (int k = 0; k < options_.num_keypoints(); ++k) {
+    const int offset = options_.keypoint_coord_offset() +
+                       k * options_.num_values_per_keypoint();
+    const int keypoint_x_index = offset + (reverse ? 0 : 1);
+    const int keypoint_y_index = offset + (reverse ? 1 : 0);
+    x_center = raw.col(keypoint_x_index);
+    y_center = raw.col(keypoint_y_index);
+    decoded.col(offset) = x_center / options_.x_scale() * anchor_w + anchor_x;
+    decoded.col(offset + 1) =
+        y_center / options_.y_scale() * anchor_h + anchor_y;
+  }
+}
 
-    const float ymin = y_center - h / 2.f;
-    const float xmin = x_center - w / 2.f;
-    const float ymax = y_center + h / 2.f;
-    const float xmax = x_center + w / 2.f;
-
-    (*boxes)[i * num_coords_ + 0] = ymin;
-    (*boxes)[i * num_coords_ + 1] = xmin;
-    (*boxes)[i * num_coords_ + 2] = ymax;
-    (*boxes)[i * num_coords_ + 3] = xmax;
-
-    if (options_.num_keypoints()) {
-      for (int k = 0; k < options_.num_keypoints(); ++k) {
-        const int offset = i * num_coords_ + options_.keypoint_coord_offset() +
-                           k * options_.num_values_per_keypoint();
-
-        float keypoint_y = raw_boxes[offset];
-        float keypoint_x = raw_boxes[offset + 1];
-        if (options_.reverse_output_order()) {
-          keypoint_x = raw_boxes[offset];
-          keypoint_y = raw_boxes[offset + 1];
-        }
-
-        (*boxes)[offset] = keypoint_x / options_.x_scale() * anchors[i].w() +
-                           anchors[i].x_center();
-        (*boxes)[offset + 1] =
-            keypoint_y / options_.y_scale() * anchors[i].h() +
-            anchors[i].y_center();
+void TfLiteTensorsToDetectionsCalculator::ScoreBoxes(
+    const float* raw_scores, std::vector<float>* score_class_id_pairs) {
+  // Clipping and the sigmoid are monotonic, so the top class is found on the
+  // raw scores and only its score is transformed.
+  const bool clip =
+      options_.sigmoid_score() && options_.has_score_clipping_thresh();
+  const float clip_thresh = options_.score_clipping_thresh();
+  for (int i = 0; i < num_boxes_; ++i) {
+    const float* box_scores = raw_scores + i * num_classes_;
+    int class_id = -1;
+    float max_score = -std::numeric_limits<float>::max();
+    for (const int score_idx : scored_classes_) {
+      float score = box_scores[score_idx];
+      if (clip) {
+        // Clipped scores tie, and the first class among them wins.
+        score = std::min(std::max(score, -clip_thresh), clip_thresh);
       }
+      if (max_score < score) {
+        max_score = score;
+        class_id = score_idx;
+      }
+    }
+    if (options_.sigmoid_score() && class_id >= 0) {
+      max_score = 1.0f / (1.0f + std::exp(-max_score));
     }
+    (*score_class_id_pairs)[i * 2 + 0] = max_score;
+    (*score_class_id_pairs)[i * 2 + 1] = class_id;
+  }
+}
+
+std::vector<int> TfLiteTensorsToDetectionsCalculator::SelectBoxes(
+    const std::vector<float>& score_class_id_pairs) {
+  std::vector<int> box_indices;
+  if (!options_.has_min_score_thresh()) {
+    box_indices.resize(num_boxes_);
+    std::iota(box_indices.begin(), box_indices.end(), 0);
+    return box_indices;
+  }
+  const float min_score = options_.min_score_thresh();
+  for (int i = 0; i < num_boxes_; ++i) {
+    if (score_class_id_pairs[i * 2 + 1] >= 0 &&
+        score_class_id_pairs[i * 2 + 0] >= min_score) {
+      box_indices.push_back(i);
+    }
+  }
+  return box_indices;
+}
+
+void TfLiteTensorsToDetectionsCalculator::GatherBoxes(
+    const float* raw_boxes, const std::vector<int>& box_indices,
+    std::vector<float>* selected_raw_boxes, AnchorSet* selected_anchors) {
+  selected_raw_boxes->resize(box_indices.size() * num_coords_);
+  selected_anchors->Reserve(box_indices.size());
+  float* row = selected_raw_boxes->data();
+  for (const int i : box_indices) {
+    std::copy(raw_boxes + i * num_coords_, raw_boxes + (i + 1) * num_coords_,
+              row);
+    row += num_coords_;
+    selected_anchors->Add(anchors_.x_center[i], anchors_.y_center[i],
+                          anchors_.h[i], anchors_.w[i]);
   }
-  return ::mediapipe::OkStatus();
 }
 
 Detection TfLiteTensorsToDetectionsCalculator::ConvertToDetection(
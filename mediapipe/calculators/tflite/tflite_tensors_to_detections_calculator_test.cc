@@ -0,0 +1,329 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
+#include "mediapipe/calculators/tflite/tflite_tensors_to_detections_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/detection.pb.h"
+#include "mediapipe/framework/formats/object_detection/anchor.pb.h"
+#include "mediapipe/framework/formats/object_detection/anchor_set.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "tensorflow/lite/interpreter.h"
+
+namespace mediapipe {
+namespace {
+
+using ::tflite::Interpreter;
+
+// Holds the raw box tensor [1, num_boxes, num_coords] and the raw score tensor
+// [1, num_boxes, num_classes] of a detection model.
+class DetectionTensors {
+ public:
+  DetectionTensors(int num_boxes, int num_coords, int num_classes)
+      : interpreter_(absl::make_unique<Interpreter>()) {
+    interpreter_->AddTensors(2);
+    interpreter_->SetInputs({0, 1});
+    interpreter_->SetOutputs({0, 1});
+    for (int i = 0; i < 2; ++i) {
+      interpreter_->SetTensorParametersReadWrite(i, kTfLiteFloat32, "", {3},
+                                                 TfLiteQuantization());
+    }
+    interpreter_->ResizeInputTensor(0, {1, num_boxes, num_coords});
+    interpreter_->ResizeInputTensor(1, {1, num_boxes, num_classes});
+    interpreter_->AllocateTensors();
+  }
+
+  float* boxes() { return interpreter_->tensor(0)->data.f; }
+  float* scores() { return interpreter_->tensor(1)->data.f; }
+
+  Packet MakePacket() const {
+    return ::mediapipe::MakePacket<std::vector<TfLiteTensor>>(
+        std::vector<TfLiteTensor>{*interpreter_->tensor(0),
+                                  *interpreter_->tensor(1)});
+  }
+
+ private:
+  std::unique_ptr<Interpreter> interpreter_;
+};
+
+// Returns "num_boxes" anchors of size 0.2 centered on a diagonal.
+AnchorSet MakeAnchorSet(int num_boxes) {
+  AnchorSet anchors;
+  for (int i = 0; i < num_boxes; ++i) {
+    const float center = (i + 0.5f) / num_boxes;
+    anchors.Add(center, center, 0.2f, 0.2f);
+  }
+  return anchors;
+}
+
+CalculatorGraphConfig::Node MakeNodeConfig(const std::string& anchors_tag,
+                                           const std::string& options) {
+  return ParseTextProtoOrDie<CalculatorGraphConfig::Node>(absl::Substitute(
+      R"(
+        calculator: "TfLiteTensorsToDetectionsCalculator"
+        input_stream: "TENSORS:tensors"
+        input_side_packet: "$0:anchors"
+        output_stream: "DETECTIONS:detections"
+        options {
+          [mediapipe.TfLiteTensorsToDetectionsCalculatorOptions.ext] { $1 }
+        }
+      )",
+      anchors_tag, options));
+}
+
+// Options of the SSD object detection graph, with "num_boxes" boxes.
+std::string SsdOptions(int num_boxes) {
+  return absl::Substitute(R"(
+    num_classes: 91
+    num_boxes: $0
+    num_coords: 4
+    ignore_classes: 0
+    sigmoid_score: true
+    apply_exponential_on_box_size: true
+    x_scale: 10.0
+    y_scale: 10.0
+    h_scale: 5.0
+    w_scale: 5.0
+  )",
+                          num_boxes);
+}
+
+// Options of the face detection graph, with "num_boxes" boxes.
+std::string FaceOptions(int num_boxes) {
+  return absl::Substitute(R"(
+    num_classes: 1
+    num_boxes: $0
+    num_coords: 16
+    box_coord_offset: 0
+    keypoint_coord_offset: 4
+    num_keypoints: 6
+    num_values_per_keypoint: 2
+    sigmoid_score: true
+    score_clipping_thresh: 100.0
+    reverse_output_order: true
+    x_scale: 128.0
+    y_scale: 128.0
+    h_scale: 128.0
+    w_scale: 128.0
+  )",
+                          num_boxes);
+}
+
+std::vector<Detection> RunCalculator(const std::string& anchors_tag,
+                                     const std::string& options,
+                                     const AnchorSet& anchors,
+                                     const DetectionTensors& tensors) {
+  CalculatorRunner runner(MakeNodeConfig(anchors_tag, options));
+  if (anchors_tag == "ANCHOR_SET") {
+    runner.MutableSidePackets()->Tag("ANCHOR_SET") =
+        MakePacket<AnchorSet>(anchors);
+  } else {
+    runner.MutableSidePackets()->Tag("ANCHORS") =
+        MakePacket<std::vector<Anchor>>(AnchorsFromAnchorSet(anchors));
+  }
+  runner.MutableInputs()->Tag("TENSORS").packets.push_back(
+      tensors.MakePacket().At(Timestamp(0)));
+  MEDIAPIPE_CHECK_OK(runner.Run());
+  CHECK_EQ(1, runner.Outputs().Tag("DETECTIONS").packets.size());
+  return runner.Outputs()
+      .Tag("DETECTIONS")
+      .packets[0]
+      .Get<std::vector<Detection>>();
+}
+
+TEST(TfLiteTensorsToDetectionsCalculatorTest, DecodesBoxesAndScores) {
+  constexpr int kNumBoxes = 4;
+  DetectionTensors tensors(kNumBoxes, 4, 91);
+  std::fill(tensors.boxes(), tensors.boxes() + kNumBoxes * 4, 0.0f);
+  std::fill(tensors.scores(), tensors.scores() + kNumBoxes * 91, -10.0f);
+  // Box 1 is shifted right by half its width and is twice as tall.
+  tensors.boxes()[1 * 4 + 1] = 10.0f * 0.5f;
+  tensors.boxes()[1 * 4 + 2] = 5.0f * std::log(2.0f);
+  tensors.scores()[1 * 91 + 0] = 5.0f;  // Ignored class.
+  tensors.scores()[1 * 91 + 7] = 2.0f;
+  const AnchorSet anchors = MakeAnchorSet(kNumBoxes);
+
+  for (const std::string tag : {"ANCHORS", "ANCHOR_SET"}) {
+    const std::vector<Detection> detections =
+        RunCalculator(tag, SsdOptions(kNumBoxes), anchors, tensors);
+    ASSERT_EQ(kNumBoxes, detections.size());
+    const Detection& detection = detections[1];
+    EXPECT_EQ(7, detection.label_id(0));
+    EXPECT_FLOAT_EQ(1.0f / (1.0f + std::exp(-2.0f)), detection.score(0));
+    const auto& box = detection.location_data().relative_bounding_box();
+    // x_center is 0.375 + 0.5 * 0.2.
+    EXPECT_NEAR(0.375f, box.xmin(), 1e-5);
+    EXPECT_NEAR(0.2f, box.width(), 1e-5);
+    EXPECT_NEAR(0.375f - 0.2f, box.ymin(), 1e-5);
+    EXPECT_NEAR(0.4f, box.height(), 1e-5);
+  }
+}
+
+TEST(TfLiteTensorsToDetectionsCalculatorTest, DecodesKeypoints) {
+  constexpr int kNumBoxes = 2;
+  DetectionTensors tensors(kNumBoxes, 16, 1);
+  std::fill(tensors.boxes(), tensors.boxes() + kNumBoxes * 16, 0.0f);
+  std::fill(tensors.scores(), tensors.scores() + kNumBoxes, 0.0f);
+  // Keypoint 2 of box 0 is offset by (64, -32) pixels, in x, y order.
+  tensors.boxes()[4 + 2 * 2 + 0] = 64.0f;
+  tensors.boxes()[4 + 2 * 2 + 1] = -32.0f;
+  const std::vector<Detection> detections = RunCalculator(
+      "ANCHOR_SET", FaceOptions(kNumBoxes), MakeAnchorSet(kNumBoxes), tensors);
+  ASSERT_EQ(kNumBoxes, detections.size());
+  const auto& keypoints = detections[0].location_data().relative_keypoints();
+  ASSERT_EQ(6, keypoints.size());
+  EXPECT_NEAR(0.25f + 0.5f * 0.2f, keypoints.Get(2).x(), 1e-5);
+  EXPECT_NEAR(0.25f - 0.25f * 0.2f, keypoints.Get(2).y(), 1e-5);
+  EXPECT_NEAR(0.25f, keypoints.Get(0).x(), 1e-5);
+  EXPECT_FLOAT_EQ(0.5f, detections[0].score(0));
+}
+
+TEST(TfLiteTensorsToDetectionsCalculatorTest, DecodesOnlyBoxesAboveMinScore) {
+  constexpr int kNumBoxes = 4;
+  DetectionTensors tensors(kNumBoxes, 4, 91);
+  std::fill(tensors.boxes(), tensors.boxes() + kNumBoxes * 4, 0.0f);
+  std::fill(tensors.scores(), tensors.scores() + kNumBoxes * 91, -10.0f);
+  tensors.boxes()[2 * 4 + 1] = 10.0f * 0.5f;
+  tensors.scores()[0 * 91 + 0] = 5.0f;  // Ignored class.
+  tensors.scores()[2 * 91 + 3] = 2.0f;
+  tensors.scores()[3 * 91 + 5] = 0.0f;
+  const std::vector<Detection> detections =
+      RunCalculator("ANCHOR_SET",
+                    SsdOptions(kNumBoxes) + "min_score_thresh: 0.6",
+                    MakeAnchorSet(kNumBoxes), tensors);
+  ASSERT_EQ(1, detections.size());
+  EXPECT_EQ(3, detections[0].label_id(0));
+  EXPECT_FLOAT_EQ(1.0f / (1.0f + std::exp(-2.0f)), detections[0].score(0));
+  const auto& box = detections[0].location_data().relative_bounding_box();
+  // x_center is 0.625 + 0.5 * 0.2.
+  EXPECT_NEAR(0.625f, box.xmin(), 1e-5);
+  EXPECT_NEAR(0.625f - 0.1f, box.ymin(), 1e-5);
+  EXPECT_NEAR(0.2f, box.width(), 1e-5);
+}
+
+TEST(TfLiteTensorsToDetectionsCalculatorTest, DecodesKeypointsAboveMinScore) {
+  constexpr int kNumBoxes = 4;
+  DetectionTensors tensors(kNumBoxes, 16, 1);
+  std::fill(tensors.boxes(), tensors.boxes() + kNumBoxes * 16, 0.0f);
+  std::fill(tensors.scores(), tensors.scores() + kNumBoxes, -1.0f);
+  tensors.scores()[1] = 200.0f;  // Clipped to 100.
+  tensors.scores()[3] = 1.0f;
+  tensors.boxes()[3 * 16 + 4 + 0] = 64.0f;
+  const std::vector<Detection> detections =
+      RunCalculator("ANCHOR_SET",
+                    FaceOptions(kNumBoxes) + "min_score_thresh: 0.5",
+                    MakeAnchorSet(kNumBoxes), tensors);
+  ASSERT_EQ(2, detections.size());
+  EXPECT_FLOAT_EQ(1.0f, detections[0].score(0));
+  EXPECT_NEAR(0.375f, detections[0].location_data().relative_keypoints(0).x(),
+              1e-5);
+  EXPECT_FLOAT_EQ(1.0f / (1.0f + std::exp(-1.0f)), detections[1].score(0));
+  EXPECT_NEAR(0.875f + 0.5f * 0.2f,
+              detections[1].location_data().relative_keypoints(0).x(), 1e-5);
+}
+
+// Decodes one frame with the given options and number of boxes.
+void RunDecodeBenchmark(benchmark::State& state, const std::string& options,
+                        int num_coords, int num_classes) {
+  const int num_boxes = state.range(0);
+  DetectionTensors tensors(num_boxes, num_coords, num_classes);
+  for (int i = 0; i < num_boxes * num_coords; ++i) {
+    tensors.boxes()[i] = (i % 7) * 0.1f;
+  }
+  for (int i = 0; i < num_boxes * num_classes; ++i) {
+    tensors.scores()[i] = (i % 13) * 0.5f - 3.0f;
+  }
+  const CalculatorGraphConfig::Node node_config =
+      MakeNodeConfig("ANCHOR_SET", options);
+  const Packet anchors = MakePacket<AnchorSet>(MakeAnchorSet(num_boxes));
+  constexpr int kNumFrames = 30;
+  for (auto _ : state) {
+    CalculatorRunner runner(node_config);
+    runner.MutableSidePackets()->Tag("ANCHOR_SET") = anchors;
+    for (int i = 0; i < kNumFrames; ++i) {
+      runner.MutableInputs()->Tag("TENSORS").packets.push_back(
+          tensors.MakePacket().At(Timestamp(i)));
+    }
+    CHECK(runner.Run().ok());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumFrames);
+}
+
+// The SSD object detection graph, and the 1917 anchors of the MobileSSD config.
+void BM_DecodeSsd(benchmark::State& state) {
+  RunDecodeBenchmark(state, SsdOptions(state.range(0)), 4, 91);
+}
+BENCHMARK(BM_DecodeSsd)->Arg(1917)->Arg(2034);
+
+// The face detection graph, and a 2944 anchor variant.
+void BM_DecodeFace(benchmark::State& state) {
+  RunDecodeBenchmark(state, FaceOptions(state.range(0)), 16, 1);
+}
+BENCHMARK(BM_DecodeFace)->Arg(896)->Arg(2944);
+
+// Decodes 2034 SSD boxes of which the first state.range(0) score above
+// min_score_thresh, to show the per-frame cost against the detection count.
+void BM_DecodeSsdWithMinScore(benchmark::State& state) {
+  constexpr int kNumBoxes = 2034;
+  const int num_detections = state.range(0);
+  DetectionTensors tensors(kNumBoxes, 4, 91);
+  for (int i = 0; i < kNumBoxes * 4; ++i) {
+    tensors.boxes()[i] = (i % 7) * 0.1f;
+  }
+  for (int i = 0; i < kNumBoxes * 91; ++i) {
+    tensors.scores()[i] = (i % 13) * 0.5f - 6.0f;
+  }
+  for (int i = 0; i < num_detections; ++i) {
+    tensors.scores()[i * 91 + 1 + i % 90] = 3.0f;
+  }
+  const CalculatorGraphConfig::Node node_config = MakeNodeConfig(
+      "ANCHOR_SET", SsdOptions(kNumBoxes) + "min_score_thresh: 0.9");
+  const Packet anchors = MakePacket<AnchorSet>(MakeAnchorSet(kNumBoxes));
+  constexpr int kNumFrames = 30;
+  for (auto _ : state) {
+    CalculatorRunner runner(node_config);
+    runner.MutableSidePackets()->Tag("ANCHOR_SET") = anchors;
+    for (int i = 0; i < kNumFrames; ++i) {
+      runner.MutableInputs()->Tag("TENSORS").packets.push_back(
+          tensors.MakePacket().At(Timestamp(i)));
+    }
+    CHECK(runner.Run().ok());
+    CHECK_EQ(num_detections, runner.Outputs()
+                                 .Tag("DETECTIONS")
+                                 .packets[0]
+                                 .Get<std::vector<Detection>>()
+                                 .size());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumFrames);
+}
+BENCHMARK(BM_DecodeSsdWithMinScore)
+    ->Arg(0)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->Arg(2034);
+
+}  // namespace
+}  // namespace mediapipe
@@ -12,15 +12,23 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
+#include "Eigen/Core"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "mediapipe/calculators/tflite/tflite_tensors_to_segmentation_calculator.pb.h"
 #include "mediapipe/framework/calculator_context.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/util/parallel_for.h"
 #include "mediapipe/util/resource_util.h"
 #include "tensorflow/lite/interpreter.h"
 
@@ -42,6 +50,55 @@ enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
 int RoundUp(const int size, const int multiple) {
   return (size + multiple - 1) / multiple;
 }
+
+// Minimum number of rows per stripe when splitting the CPU kernels across the
+// graph's executor.
+constexpr int kMinRowsPerStripe = 16;
+
+// Computes num_pixels values of the small mask from the 2-channel segmentation
+// tensor, with Eigen array expressions that vectorize the exp and log. The
+// softmax over two channels reduces to a logistic function of their
+// difference. If prev_mask is not null, the result is blended with the
+// previous mask like the GPU shader.
+void ComputeMask(const float* tensor, const uint8* prev_mask, int num_pixels,
+                 int output_layer_index, float combine_with_previous_ratio,
+                 uint8* mask) {
+  typedef Eigen::Array<float, 1, Eigen::Dynamic> RowArrayXf;
+  const Eigen::Map<const Eigen::Array<float, 2, Eigen::Dynamic>> logits(
+      tensor, 2, num_pixels);
+  RowArrayXf new_mask_value =
+      (1.0f + (logits.row(1 - output_layer_index) -
+               logits.row(output_layer_index))
+                  .exp())
+          .inverse();
+  if (prev_mask) {
+    // Combine previous value with current using uncertainty^2 as mixing
+    // parameter.
+    const RowArrayXf prev_mask_value =
+        Eigen::Map<const Eigen::Array<uint8, 1, Eigen::Dynamic>>(prev_mask,
+                                                                num_pixels)
+            .cast<float>() *
+        (1.0f / 255.0f);
+    constexpr float kEps = 0.001f;
+    RowArrayXf uncertainty_alpha =
+        (1.0f + (new_mask_value * (new_mask_value + kEps).log() +
+                 (1.0f - new_mask_value) *
+                     (1.0f - new_mask_value + kEps).log()) /
+                    std::log(2.0f))
+            .max(0.0f)
+            .min(1.0f);
+    // Equivalent to a = 1 - (1 - a) * (1 - a) (squaring the uncertainty).
+    uncertainty_alpha *= 2.0f - uncertainty_alpha;
+    const RowArrayXf mixed_mask_value =
+        new_mask_value * uncertainty_alpha +
+        prev_mask_value * (1.0f - uncertainty_alpha);
+    // Mix the raw value and the value mixed with the previous mask.
+    new_mask_value = mixed_mask_value * combine_with_previous_ratio +
+                     (1.0f - combine_with_previous_ratio) * new_mask_value;
+  }
+  Eigen::Map<Eigen::Array<uint8, 1, Eigen::Dynamic>>(mask, num_pixels) =
+      (new_mask_value * 255.0f + 0.5f).cast<uint8>();
+}
 }  // namespace
 
 namespace mediapipe {
@@ -58,7 +115,8 @@ using ::tflite::gpu::gl::GlShader;
 // Performs optional upscale to REFERENCE_IMAGE dimensions if provided,
 // otherwise the mask is the same size as input tensor.
 //
-// Note: This calculator is currently GPU only, so only *_GPU tags can be used.
+// On CPU, the softmax and blending run on the tensor rows and the upsampling
+// is bilinear. Both are split into row stripes across the graph's executor.
 //
 // Inputs:
 //   One of the following TENSORS tags:
@@ -75,7 +133,8 @@ using ::tflite::gpu::gl::GlShader;
 //   PREV_MASK_GPU (optional): A GpuBuffer input mask, RGBA.
 // Output:
 //   One of the following MASK tags:
-//   MASK: An ImageFrame output mask, Gray, RGB or RGBA.
+//   MASK: An ImageFrame output mask, RGBA. Like MASK_GPU, the mask value is
+//         stored in both the R and A channels.
 //   MASK_GPU: A GpuBuffer output mask, RGBA.
 //
 // Options:
@@ -236,9 +295,91 @@ REGISTER_CALCULATOR(TfLiteTensorsToSegmentationCalculator);
   return ::mediapipe::OkStatus();
 }
 
+// Same steps as ProcessGpu() below.
 ::mediapipe::Status TfLiteTensorsToSegmentationCalculator::ProcessCpu(
     CalculatorContext* cc) {
-  return ::mediapipe::UnimplementedError("CPU support is not implemented yet.");
+  if (cc->Inputs().Tag("TENSORS").IsEmpty()) {
+    return ::mediapipe::OkStatus();
+  }
+  // Get input streams.
+  const auto& input_tensors =
+      cc->Inputs().Tag("TENSORS").Get<std::vector<TfLiteTensor>>();
+  RET_CHECK_EQ(input_tensors.size(), 1);
+  const TfLiteTensor& tensor = input_tensors[0];
+  RET_CHECK_EQ(tensor.type, kTfLiteFloat32);
+  RET_CHECK_EQ(tensor.bytes, tensor_width_ * tensor_height_ *
+                                 tensor_channels_ * sizeof(float));
+  const float* tensor_data = tensor.data.f;
+
+  int output_width = tensor_width_, output_height = tensor_height_;
+  if (cc->Inputs().HasTag("REFERENCE_IMAGE")) {
+    const auto& input_image =
+        cc->Inputs().Tag("REFERENCE_IMAGE").Get<ImageFrame>();
+    output_width = input_image.Width();
+    output_height = input_image.Height();
+  }
+
+  // The previous mask is sampled from its first channel at the tensor size.
+  cv::Mat prev_mask;
+  if (cc->Inputs().HasTag("PREV_MASK") &&
+      !cc->Inputs().Tag("PREV_MASK").IsEmpty()) {
+    const auto& input_mask = cc->Inputs().Tag("PREV_MASK").Get<ImageFrame>();
+    RET_CHECK_EQ(input_mask.ByteDepth(), 1);
+    cv::Mat prev_mask_channel;
+    cv::extractChannel(formats::MatView(&input_mask), prev_mask_channel, 0);
+    if (prev_mask_channel.cols == tensor_width_ &&
+        prev_mask_channel.rows == tensor_height_) {
+      prev_mask = prev_mask_channel;
+    } else {
+      cv::resize(prev_mask_channel, prev_mask,
+                 cv::Size(tensor_width_, tensor_height_), 0, 0,
+                 cv::INTER_LINEAR);
+    }
+  }
+
+  // Process the segmentation tensor into a small mask.
+  cv::Mat small_mask(tensor_height_, tensor_width_, CV_8UC1);
+  const int output_layer_index = options_.output_layer_index();
+  const float combine_with_previous_ratio =
+      options_.combine_with_previous_ratio();
+  // The tensor and both masks are continuous, so each stripe of rows is
+  // processed as one run of pixels.
+  ParallelFor(cc->GetExecutor(), tensor_height_, kMinRowsPerStripe,
+              [&](int begin, int end) {
+                ComputeMask(
+                    tensor_data + begin * tensor_width_ * tensor_channels_,
+                    prev_mask.empty() ? nullptr : prev_mask.ptr<uint8>(begin),
+                    (end - begin) * tensor_width_, output_layer_index,
+                    combine_with_previous_ratio, small_mask.ptr<uint8>(begin));
+              });
+
+  // Upsample the small mask, then store it in the R and A channels.
+  cv::Mat mask;
+  if (output_width == tensor_width_ && output_height == tensor_height_) {
+    mask = small_mask;
+  } else {
+    cv::resize(small_mask, mask, cv::Size(output_width, output_height), 0, 0,
+               cv::INTER_LINEAR);
+  }
+  auto output_mask = absl::make_unique<ImageFrame>(
+      ImageFormat::SRGBA, output_width, output_height);
+  cv::Mat output_mat = formats::MatView(output_mask.get());
+  ParallelFor(cc->GetExecutor(), output_height, kMinRowsPerStripe,
+              [&](int begin, int end) {
+                for (int y = begin; y < end; ++y) {
+                  const uint8* mask_row = mask.ptr<uint8>(y);
+                  uint8* output_row = output_mat.ptr<uint8>(y);
+                  for (int x = 0; x < output_width; ++x) {
+                    output_row[4 * x] = mask_row[x];
+                    output_row[4 * x + 1] = 0;
+                    output_row[4 * x + 2] = 0;
+                    output_row[4 * x + 3] = mask_row[x];
+                  }
+                }
+              });
+  cc->Outputs().Tag("MASK").Add(output_mask.release(), cc->InputTimestamp());
+
+  return ::mediapipe::OkStatus();
 }
 
 // Steps:
@@ -402,6 +543,9 @@ void TfLiteTensorsToSegmentationCalculator::GlRender() {
   tensor_channels_ = options_.tensor_channels();
   RET_CHECK_EQ(tensor_channels_, 2)
       << "Only 2 channel segmentation tensor currently supported";
+  RET_CHECK(options_.output_layer_index() == 0 ||
+            options_.output_layer_index() == 1)
+      << "output_layer_index must be 0 or 1.";
 
   return ::mediapipe::OkStatus();
 }
@@ -0,0 +1,185 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/substitute.h"
+#include "mediapipe/calculators/tflite/tflite_tensors_to_segmentation_calculator.pb.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"  // NOLINT
+#include "tensorflow/lite/interpreter.h"
+
+namespace mediapipe {
+namespace {
+
+using ::tflite::Interpreter;
+
+// Holds a 2-channel float tensor with every pixel set to the given logits.
+class SegmentationTensor {
+ public:
+  SegmentationTensor(int width, int height, float background, float foreground)
+      : interpreter_(absl::make_unique<Interpreter>()) {
+    interpreter_->AddTensors(1);
+    interpreter_->SetInputs({0});
+    interpreter_->SetOutputs({0});
+    interpreter_->SetTensorParametersReadWrite(0, kTfLiteFloat32, "", {3},
+                                               TfLiteQuantization());
+    interpreter_->ResizeInputTensor(0, {height, width, 2});
+    interpreter_->AllocateTensors();
+    float* data = interpreter_->tensor(0)->data.f;
+    for (int i = 0; i < width * height; ++i) {
+      data[2 * i] = background;
+      data[2 * i + 1] = foreground;
+    }
+  }
+
+  Packet MakePacket() const {
+    return ::mediapipe::MakePacket<std::vector<TfLiteTensor>>(
+        std::vector<TfLiteTensor>{*interpreter_->tensor(0)});
+  }
+
+ private:
+  std::unique_ptr<Interpreter> interpreter_;
+};
+
+CalculatorGraphConfig::Node MakeNodeConfig(int width, int height,
+                                           const std::string& extra_inputs) {
+  return ParseTextProtoOrDie<CalculatorGraphConfig::Node>(absl::Substitute(
+      R"(
+        calculator: "TfLiteTensorsToSegmentationCalculator"
+        input_stream: "TENSORS:tensors"
+        $2
+        output_stream: "MASK:mask"
+        options {
+          [mediapipe.TfLiteTensorsToSegmentationCalculatorOptions.ext] {
+            tensor_width: $0
+            tensor_height: $1
+            tensor_channels: 2
+            combine_with_previous_ratio: 1.0
+            output_layer_index: 1
+          }
+        }
+      )",
+      width, height, extra_inputs));
+}
+
+Packet MakeImagePacket(ImageFormat::Format format, int width, int height,
+                       uint8 value) {
+  auto image = absl::make_unique<ImageFrame>(format, width, height);
+  std::memset(image->MutablePixelData(), value, image->PixelDataSize());
+  return Adopt(image.release());
+}
+
+// Expects all pixels of an RGBA mask to hold `value` in R and A.
+void ExpectUniformMask(const ImageFrame& mask, int value, int tolerance) {
+  ASSERT_EQ(ImageFormat::SRGBA, mask.Format());
+  for (int y = 0; y < mask.Height(); ++y) {
+    const uint8* row = mask.PixelData() + y * mask.WidthStep();
+    for (int x = 0; x < mask.Width(); ++x) {
+      ASSERT_NEAR(value, row[4 * x], tolerance) << x << "," << y;
+      ASSERT_EQ(0, row[4 * x + 1]);
+      ASSERT_EQ(0, row[4 * x + 2]);
+      ASSERT_NEAR(value, row[4 * x + 3], tolerance);
+    }
+  }
+}
+
+TEST(TfLiteTensorsToSegmentationCalculatorTest, ComputesSoftmaxOnCpu) {
+  const SegmentationTensor tensor(16, 8, 0.0f, 2.0f);
+  CalculatorRunner runner(MakeNodeConfig(16, 8, ""));
+  runner.MutableInputs()->Tag("TENSORS").packets.push_back(
+      tensor.MakePacket().At(Timestamp(0)));
+  MEDIAPIPE_ASSERT_OK(runner.Run());
+  const auto& packets = runner.Outputs().Tag("MASK").packets;
+  ASSERT_EQ(1, packets.size());
+  const ImageFrame& mask = packets[0].Get<ImageFrame>();
+  EXPECT_EQ(16, mask.Width());
+  EXPECT_EQ(8, mask.Height());
+  // softmax([0, 2])[1] = 0.881.
+  ExpectUniformMask(mask, 225, 1);
+}
+
+TEST(TfLiteTensorsToSegmentationCalculatorTest, UpsamplesToReferenceImage) {
+  const SegmentationTensor tensor(16, 8, 2.0f, 0.0f);
+  CalculatorRunner runner(
+      MakeNodeConfig(16, 8, R"(input_stream: "REFERENCE_IMAGE:image")"));
+  runner.MutableInputs()->Tag("TENSORS").packets.push_back(
+      tensor.MakePacket().At(Timestamp(0)));
+  runner.MutableInputs()->Tag("REFERENCE_IMAGE").packets.push_back(
+      MakeImagePacket(ImageFormat::SRGB, 100, 60, 0).At(Timestamp(0)));
+  MEDIAPIPE_ASSERT_OK(runner.Run());
+  const auto& packets = runner.Outputs().Tag("MASK").packets;
+  ASSERT_EQ(1, packets.size());
+  const ImageFrame& mask = packets[0].Get<ImageFrame>();
+  EXPECT_EQ(100, mask.Width());
+  EXPECT_EQ(60, mask.Height());
+  // softmax([2, 0])[1] = 0.119.
+  ExpectUniformMask(mask, 30, 1);
+}
+
+TEST(TfLiteTensorsToSegmentationCalculatorTest, KeepsPrevMaskWhenUncertain) {
+  // Equal logits give a fully uncertain new value, so the previous mask wins.
+  const SegmentationTensor tensor(16, 8, 1.0f, 1.0f);
+  CalculatorRunner runner(
+      MakeNodeConfig(16, 8, R"(input_stream: "PREV_MASK:prev_mask")"));
+  runner.MutableInputs()->Tag("TENSORS").packets.push_back(
+      tensor.MakePacket().At(Timestamp(0)));
+  runner.MutableInputs()->Tag("PREV_MASK").packets.push_back(
+      MakeImagePacket(ImageFormat::GRAY8, 32, 16, 200).At(Timestamp(0)));
+  MEDIAPIPE_ASSERT_OK(runner.Run());
+  const auto& packets = runner.Outputs().Tag("MASK").packets;
+  ASSERT_EQ(1, packets.size());
+  ExpectUniformMask(packets[0].Get<ImageFrame>(), 200, 2);
+}
+
+// Processes a 512x512 tensor with a previous mask into a 512x512 mask.
+void BM_SegmentationCpu(benchmark::State& state) {
+  constexpr int kSize = 512;
+  constexpr int kNumFrames = 30;
+  const SegmentationTensor tensor(kSize, kSize, 0.5f, 1.5f);
+  const Packet prev_mask =
+      MakeImagePacket(ImageFormat::SRGBA, kSize, kSize, 128);
+  const Packet image = MakeImagePacket(ImageFormat::SRGB, kSize, kSize, 0);
+  const CalculatorGraphConfig::Node node_config =
+      MakeNodeConfig(kSize, kSize, R"(
+        input_stream: "PREV_MASK:prev_mask"
+        input_stream: "REFERENCE_IMAGE:image"
+      )");
+  for (auto _ : state) {
+    CalculatorRunner runner(node_config);
+    for (int i = 0; i < kNumFrames; ++i) {
+      runner.MutableInputs()->Tag("TENSORS").packets.push_back(
+          tensor.MakePacket().At(Timestamp(i)));
+      runner.MutableInputs()->Tag("PREV_MASK").packets.push_back(
+          prev_mask.At(Timestamp(i)));
+      runner.MutableInputs()->Tag("REFERENCE_IMAGE").packets.push_back(
+          image.At(Timestamp(i)));
+    }
+    CHECK(runner.Run().ok());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumFrames);
+}
+BENCHMARK(BM_SegmentationCpu)->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -12,20 +12,27 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <cstring>
 #include <memory>
+#include <vector>
 
+#include "absl/synchronization/mutex.h"
 #include "mediapipe/calculators/util/annotation_overlay_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/calculator_options.pb.h"
 #include "mediapipe/framework/formats/image_format.pb.h"
 #include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
 #include "mediapipe/framework/formats/video_stream_header.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
 #include "mediapipe/framework/port/vector.h"
 #include "mediapipe/util/annotation_renderer.h"
 #include "mediapipe/util/color.pb.h"
+#include "mediapipe/util/parallel_for.h"
+#include "mediapipe/util/render_commands.h"
 
 #if defined(__ANDROID__)
 #include "mediapipe/gpu/gl_calculator_helper.h"
@@ -43,6 +50,12 @@ constexpr char kOutputFrameTag[] = "OUTPUT_FRAME";
 constexpr char kInputFrameTagGpu[] = "INPUT_FRAME_GPU";
 constexpr char kOutputFrameTagGpu[] = "OUTPUT_FRAME_GPU";
 
+constexpr char kRenderCommandsTag[] = "RENDER_COMMANDS";
+
+// Every stripe of the render target goes through all the annotations, so the
+// stripes are kept tall enough for the drawing to dominate.
+constexpr int kMinRenderStripeRows = 64;
+
 enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
 }  // namespace
 
@@ -56,6 +69,9 @@ enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
 //  2. RenderData proto on variable number of input streams. All the RenderData
 //     at a particular timestamp is drawn on the image in the order of their
 //     input streams. No tags required.
+//  3. RenderCommandBuffer on any number of RENDER_COMMANDS input streams, e.g.
+//     from DetectionsToRenderDataCalculator. These are drawn after all the
+//     RenderData, in the order of their input streams.
 //
 // Output:
 //  1. OUTPUT_FRAME or OUTPUT_FRAME_GPU: A rendered ImageFrame (or GpuBuffer).
@@ -64,6 +80,12 @@ enum { ATTRIB_VERTEX, ATTRIB_TEXTURE_POSITION, NUM_ATTRIBUTES };
 // output format is the same as input except for GRAY8 where the output is in
 // SRGB to support annotations in color.
 //
+// On CPU, annotations are drawn directly into the output frame, so only the
+// pixels they cover are written after the frame is set up. If this calculator
+// holds the only reference to the SRGB or SRGBA input frame, that frame is
+// used as the output with no copy. Otherwise the input is copied once. If
+// there is nothing to draw, the input packet is forwarded as is.
+//
 // For GPU input frames, only 4-channel images are supported.
 //
 // Note: When using GPU, drawing with black color is not supported.
@@ -109,15 +131,24 @@ class AnnotationOverlayCalculator : public CalculatorBase {
   ::mediapipe::Status Close(CalculatorContext* cc) override;
 
  private:
-  ::mediapipe::Status CreateRenderTargetCpu(CalculatorContext* cc,
-                                            std::unique_ptr<cv::Mat>& image_mat,
-                                            ImageFormat::Format* target_format);
+  ::mediapipe::Status ProcessCpu(CalculatorContext* cc);
+  // Returns the frame to draw on for the CPU input frame: the input frame
+  // itself if no one else holds it, and a copy otherwise.
+  ::mediapipe::StatusOr<std::unique_ptr<ImageFrame>> CreateRenderTargetCpu(
+      CalculatorContext* cc);
+  // Returns true if any render stream has an annotation at this timestamp.
+  bool HasAnnotations(CalculatorContext* cc);
+  // Draws all render streams on "image".
+  void RenderStreams(CalculatorContext* cc, cv::Mat* image);
+  // Draws all render streams with "renderer", which has adopted the image.
+  void RenderStreams(CalculatorContext* cc, AnnotationRenderer* renderer);
+  // Returns an unused renderer, creating one if needed.
+  std::unique_ptr<AnnotationRenderer> AcquireRenderer();
+  // Keeps "renderer" for a later AcquireRenderer().
+  void ReleaseRenderer(std::unique_ptr<AnnotationRenderer> renderer);
   ::mediapipe::Status CreateRenderTargetGpu(
       CalculatorContext* cc, std::unique_ptr<cv::Mat>& image_mat);
   ::mediapipe::Status RenderToGpu(CalculatorContext* cc, uchar* overlay_image);
-  ::mediapipe::Status RenderToCpu(CalculatorContext* cc,
-                                  const ImageFormat::Format& target_format,
-                                  uchar* data_image);
 
   ::mediapipe::Status GlRender(CalculatorContext* cc);
   ::mediapipe::Status GlSetup(CalculatorContext* cc);
@@ -125,10 +156,13 @@ class AnnotationOverlayCalculator : public CalculatorBase {
   // Options for the calculator.
   AnnotationOverlayCalculatorOptions options_;
 
-  // Underlying helper renderer library.
-  std::unique_ptr<AnnotationRenderer> renderer_;
+  // Underlying helper renderer library. Each stripe of the render target is
+  // drawn by its own renderer, and the renderers are kept across frames.
+  absl::Mutex renderers_mutex_;
+  std::vector<std::unique_ptr<AnnotationRenderer>> renderers_
+      GUARDED_BY(renderers_mutex_);
 
-  // Number of input streams with render data.
+  // Number of untagged input streams with render data.
   int num_render_streams_;
 
   // Indicates if image frame is available as input.
@@ -157,25 +191,24 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
     return ::mediapipe::InternalError("GPU output must have GPU input.");
   }
 
-  // Assume all inputs are render streams; adjust below.
-  int num_render_streams = cc->Inputs().NumEntries();
-
   // Input image to render onto copy of.
 #if defined(__ANDROID__)
   if (cc->Inputs().HasTag(kInputFrameTagGpu)) {
     cc->Inputs().Tag(kInputFrameTagGpu).Set<mediapipe::GpuBuffer>();
-    num_render_streams = cc->Inputs().NumEntries() - 1;
   }
 #endif  // __ANDROID__
   if (cc->Inputs().HasTag(kInputFrameTag)) {
     cc->Inputs().Tag(kInputFrameTag).Set<ImageFrame>();
-    num_render_streams = cc->Inputs().NumEntries() - 1;
   }
 
   // Data streams to render.
-  for (int i = 0; i < num_render_streams; ++i) {
+  for (int i = 0; i < cc->Inputs().NumEntries(""); ++i) {
     cc->Inputs().Index(i).Set<RenderData>();
   }
+  for (CollectionItemId id = cc->Inputs().BeginId(kRenderCommandsTag);
+       id < cc->Inputs().EndId(kRenderCommandsTag); ++id) {
+    cc->Inputs().Get(id).Set<RenderCommandBuffer>();
+  }
 
   // Rendered image.
 #if defined(__ANDROID__)
@@ -209,17 +242,12 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
   if (cc->Inputs().HasTag(kInputFrameTagGpu) ||
       cc->Inputs().HasTag(kInputFrameTag)) {
     image_frame_available_ = true;
-    num_render_streams_ = cc->Inputs().NumEntries() - 1;
   } else {
     image_frame_available_ = false;
     RET_CHECK(options_.has_canvas_width_px());
     RET_CHECK(options_.has_canvas_height_px());
-    num_render_streams_ = cc->Inputs().NumEntries();
   }
-
-  // Initialize the helper renderer library.
-  renderer_ = absl::make_unique<AnnotationRenderer>();
-  renderer_->SetFlipTextVertically(options_.flip_text_vertically());
+  num_render_streams_ = cc->Inputs().NumEntries("");
 
   // Set the output header based on the input header (if present).
   const char* input_tag = use_gpu_ ? kInputFrameTagGpu : kInputFrameTag;
@@ -243,50 +271,140 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
 
 ::mediapipe::Status AnnotationOverlayCalculator::Process(
     CalculatorContext* cc) {
+  if (!use_gpu_) {
+    return ProcessCpu(cc);
+  }
+
   // Initialize render target, drawn with OpenCV.
   std::unique_ptr<cv::Mat> image_mat;
-  ImageFormat::Format target_format;
-  if (use_gpu_) {
-    RETURN_IF_ERROR(CreateRenderTargetGpu(cc, image_mat));
+  RETURN_IF_ERROR(CreateRenderTargetGpu(cc, image_mat));
+  RenderStreams(cc, image_mat.get());
+
+#if defined(__ANDROID__)
+  // Overlay rendered image in OpenGL, onto a copy of input.
+  uchar* image_mat_ptr = image_mat->data;
+  RETURN_IF_ERROR(gpu_helper_.RunInGlContext(
+      [this, cc, image_mat_ptr]() -> ::mediapipe::Status {
+        if (!gpu_initialized_) {
+          RETURN_IF_ERROR(GlSetup(cc));
+          gpu_initialized_ = true;
+        }
+
+        RETURN_IF_ERROR(RenderToGpu(cc, image_mat_ptr));
+
+        return ::mediapipe::OkStatus();
+      }));
+#endif  // __ANDROID__
+
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status AnnotationOverlayCalculator::ProcessCpu(
+    CalculatorContext* cc) {
+  std::unique_ptr<ImageFrame> output_frame;
+  if (image_frame_available_) {
+    const Packet& input_packet = cc->Inputs().Tag(kInputFrameTag).Value();
+    const ImageFormat::Format format = input_packet.Get<ImageFrame>().Format();
+    if ((format == ImageFormat::SRGB || format == ImageFormat::SRGBA) &&
+        !HasAnnotations(cc)) {
+      cc->Outputs().Tag(kOutputFrameTag).AddPacket(input_packet);
+      return ::mediapipe::OkStatus();
+    }
+    ASSIGN_OR_RETURN(output_frame, CreateRenderTargetCpu(cc));
   } else {
-    RETURN_IF_ERROR(CreateRenderTargetCpu(cc, image_mat, &target_format));
+#if defined(__ANDROID__)
+    const uint32 alignment_boundary = ImageFrame::kGlDefaultAlignmentBoundary;
+#else
+    const uint32 alignment_boundary = ImageFrame::kDefaultAlignmentBoundary;
+#endif  // __ANDROID__
+    output_frame = absl::make_unique<ImageFrame>(
+        ImageFormat::SRGB, options_.canvas_width_px(),
+        options_.canvas_height_px(), alignment_boundary);
+    formats::MatView(output_frame.get())
+        .setTo(cv::Scalar(options_.canvas_color().r(),
+                          options_.canvas_color().g(),
+                          options_.canvas_color().b()));
+  }
+
+  cv::Mat image_mat = formats::MatView(output_frame.get());
+  RenderStreams(cc, &image_mat);
+  cc->Outputs()
+      .Tag(kOutputFrameTag)
+      .Add(output_frame.release(), cc->InputTimestamp());
+  return ::mediapipe::OkStatus();
+}
+
+bool AnnotationOverlayCalculator::HasAnnotations(CalculatorContext* cc) {
+  for (int i = 0; i < num_render_streams_; ++i) {
+    if (!cc->Inputs().Index(i).IsEmpty() &&
+        cc->Inputs().Index(i).Get<RenderData>().render_annotations_size() > 0) {
+      return true;
+    }
   }
+  for (CollectionItemId id = cc->Inputs().BeginId(kRenderCommandsTag);
+       id < cc->Inputs().EndId(kRenderCommandsTag); ++id) {
+    if (!cc->Inputs().Get(id).IsEmpty() &&
+        !cc->Inputs().Get(id).Get<RenderCommandBuffer>().empty()) {
+      return true;
+    }
+  }
+  return false;
+}
 
-  // Reset the renderer with the image_mat. No copy here.
-  renderer_->AdoptImage(image_mat.get());
+void AnnotationOverlayCalculator::RenderStreams(CalculatorContext* cc,
+                                                cv::Mat* image) {
+  // Large render targets are drawn in stripes across the graph's executor.
+  ParallelFor(cc->GetExecutor(), image->rows, kMinRenderStripeRows,
+              [this, cc, image](int begin, int end) {
+                std::unique_ptr<AnnotationRenderer> renderer =
+                    AcquireRenderer();
+                // Reset the renderer with the stripe. No copy here.
+                renderer->AdoptImageStripe(image, begin, end);
+                RenderStreams(cc, renderer.get());
+                ReleaseRenderer(std::move(renderer));
+              });
+}
 
+void AnnotationOverlayCalculator::RenderStreams(CalculatorContext* cc,
+                                                AnnotationRenderer* renderer) {
   // Render streams onto render target.
   for (int i = 0; i < num_render_streams_; ++i) {
     if (cc->Inputs().Index(i).IsEmpty()) {
       continue;
     }
     const RenderData& render_data = cc->Inputs().Index(i).Get<RenderData>();
-    renderer_->RenderDataOnImage(render_data);
+    renderer->RenderDataOnImage(render_data);
   }
+  for (CollectionItemId id = cc->Inputs().BeginId(kRenderCommandsTag);
+       id < cc->Inputs().EndId(kRenderCommandsTag); ++id) {
+    if (cc->Inputs().Get(id).IsEmpty()) {
+      continue;
+    }
+    renderer->RenderCommandsOnImage(
+        cc->Inputs().Get(id).Get<RenderCommandBuffer>());
+  }
+}
 
-  if (use_gpu_) {
-#if defined(__ANDROID__)
-    // Overlay rendered image in OpenGL, onto a copy of input.
-    uchar* image_mat_ptr = image_mat->data;
-    RETURN_IF_ERROR(gpu_helper_.RunInGlContext(
-        [this, cc, image_mat_ptr]() -> ::mediapipe::Status {
-          if (!gpu_initialized_) {
-            RETURN_IF_ERROR(GlSetup(cc));
-            gpu_initialized_ = true;
-          }
-
-          RETURN_IF_ERROR(RenderToGpu(cc, image_mat_ptr));
-
-          return ::mediapipe::OkStatus();
-        }));
-#endif  // __ANDROID__
-  } else {
-    // Copy the rendered image to output.
-    uchar* image_mat_ptr = image_mat->data;
-    RETURN_IF_ERROR(RenderToCpu(cc, target_format, image_mat_ptr));
+std::unique_ptr<AnnotationRenderer>
+AnnotationOverlayCalculator::AcquireRenderer() {
+  {
+    absl::MutexLock lock(&renderers_mutex_);
+    if (!renderers_.empty()) {
+      std::unique_ptr<AnnotationRenderer> renderer =
+          std::move(renderers_.back());
+      renderers_.pop_back();
+      return renderer;
+    }
   }
+  auto renderer = absl::make_unique<AnnotationRenderer>();
+  renderer->SetFlipTextVertically(options_.flip_text_vertically());
+  return renderer;
+}
 
-  return ::mediapipe::OkStatus();
+void AnnotationOverlayCalculator::ReleaseRenderer(
+    std::unique_ptr<AnnotationRenderer> renderer) {
+  absl::MutexLock lock(&renderers_mutex_);
+  renderers_.push_back(std::move(renderer));
 }
 
 ::mediapipe::Status AnnotationOverlayCalculator::Close(CalculatorContext* cc) {
@@ -302,30 +420,6 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
   return ::mediapipe::OkStatus();
 }
 
-::mediapipe::Status AnnotationOverlayCalculator::RenderToCpu(
-
-    CalculatorContext* cc, const ImageFormat::Format& target_format,
-    uchar* data_image) {
-  auto output_frame = absl::make_unique<ImageFrame>(
-      target_format, renderer_->GetImageWidth(), renderer_->GetImageHeight());
-
-#if defined(__ANDROID__)
-  output_frame->CopyPixelData(target_format, renderer_->GetImageWidth(),
-                              renderer_->GetImageHeight(), data_image,
-                              ImageFrame::kGlDefaultAlignmentBoundary);
-#else
-  output_frame->CopyPixelData(target_format, renderer_->GetImageWidth(),
-                              renderer_->GetImageHeight(), data_image,
-                              ImageFrame::kDefaultAlignmentBoundary);
-#endif  // __ANDROID__
-
-  cc->Outputs()
-      .Tag(kOutputFrameTag)
-      .Add(output_frame.release(), cc->InputTimestamp());
-
-  return ::mediapipe::OkStatus();
-}
-
 ::mediapipe::Status AnnotationOverlayCalculator::RenderToGpu(
     CalculatorContext* cc, uchar* overlay_image) {
 #if defined(__ANDROID__)
@@ -380,58 +474,60 @@ REGISTER_CALCULATOR(AnnotationOverlayCalculator);
   return ::mediapipe::OkStatus();
 }
 
-::mediapipe::Status AnnotationOverlayCalculator::CreateRenderTargetCpu(
-    CalculatorContext* cc, std::unique_ptr<cv::Mat>& image_mat,
-    ImageFormat::Format* target_format) {
-  if (image_frame_available_) {
-    const auto& input_frame =
-        cc->Inputs().Tag(kInputFrameTag).Get<ImageFrame>();
-
-    int target_mat_type;
-    switch (input_frame.Format()) {
-      case ImageFormat::SRGBA:
-        *target_format = ImageFormat::SRGBA;
-        target_mat_type = CV_8UC4;
-        break;
-      case ImageFormat::SRGB:
-        *target_format = ImageFormat::SRGB;
-        target_mat_type = CV_8UC3;
-        break;
-      case ImageFormat::GRAY8:
-        *target_format = ImageFormat::SRGB;
-        target_mat_type = CV_8UC3;
-        break;
-      default:
-        return ::mediapipe::UnknownError("Unexpected image frame format.");
-        break;
-    }
+::mediapipe::StatusOr<std::unique_ptr<ImageFrame>>
+AnnotationOverlayCalculator::CreateRenderTargetCpu(CalculatorContext* cc) {
+  Packet& input_packet = cc->Inputs().Tag(kInputFrameTag).Value();
+  const ImageFrame& input_frame = input_packet.Get<ImageFrame>();
 
-    image_mat = absl::make_unique<cv::Mat>(
-        input_frame.Height(), input_frame.Width(), target_mat_type);
-    if (input_frame.Format() == ImageFormat::GRAY8) {
-      const int target_num_channels =
-          ImageFrame::NumberOfChannelsForFormat(*target_format);
-      for (int i = 0; i < input_frame.PixelDataSize(); i++) {
-        const auto& pix = input_frame.PixelData()[i];
-        for (int c = 0; c < target_num_channels; c++) {
-          image_mat->data[i * target_num_channels + c] = pix;
-        }
+  ImageFormat::Format target_format;
+  switch (input_frame.Format()) {
+    case ImageFormat::SRGBA:
+    case ImageFormat::SRGB: {
+      // Draw on the input frame itself if no other node or caller can see it.
+      auto consumed = input_packet.Consume<ImageFrame>();
+      if (consumed.ok()) {
+        return std::move(consumed).ValueOrDie();
       }
-    } else {
-      // Make of a copy since the input frame may be consumed by other nodes.
-      const int buffer_size =
-          input_frame.Height() * input_frame.Width() *
-          ImageFrame::NumberOfChannelsForFormat(*target_format);
-      input_frame.CopyToBuffer(image_mat->data, buffer_size);
+      target_format = input_frame.Format();
+      break;
     }
-  } else {
-    image_mat = absl::make_unique<cv::Mat>(
-        options_.canvas_height_px(), options_.canvas_width_px(), CV_8UC3,
-        cv::Scalar(options_.canvas_color().r(), options_.canvas_color().g(),
-                   options_.canvas_color().b()));
+    case ImageFormat::GRAY8:
+      target_format = ImageFormat::SRGB;
+      break;
+    default:
+      return ::mediapipe::UnknownError("Unexpected image frame format.");
   }
 
-  return ::mediapipe::OkStatus();
+#if defined(__ANDROID__)
+  const uint32 alignment_boundary = ImageFrame::kGlDefaultAlignmentBoundary;
+#else
+  const uint32 alignment_boundary = ImageFrame::kDefaultAlignmentBoundary;
+#endif  // __ANDROID__
+  auto output_frame = absl::make_unique<ImageFrame>(
+      target_format, input_frame.Width(), input_frame.Height(),
+      alignment_boundary);
+  // Make a copy since the input frame may be consumed by other nodes.
+  // Large frames are copied in stripes across the graph's executor.
+  const bool expand_gray = input_frame.Format() == ImageFormat::GRAY8;
+  const int row_size =
+      input_frame.Width() * output_frame->NumberOfChannels();
+  ImageFrame* output = output_frame.get();
+  ParallelFor(
+      cc->GetExecutor(), input_frame.Height(), 16, [&](int begin, int end) {
+        for (int row = begin; row < end; ++row) {
+          const uint8* src =
+              input_frame.PixelData() + row * input_frame.WidthStep();
+          uint8* dst = output->MutablePixelData() + row * output->WidthStep();
+          if (expand_gray) {
+            for (int col = 0; col < input_frame.Width(); ++col) {
+              dst[col * 3] = dst[col * 3 + 1] = dst[col * 3 + 2] = src[col];
+            }
+          } else {
+            std::memcpy(dst, src, row_size);
+          }
+        }
+      });
+  return std::move(output_frame);
 }
 
 ::mediapipe::Status AnnotationOverlayCalculator::CreateRenderTargetGpu(
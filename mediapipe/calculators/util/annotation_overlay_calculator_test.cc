@@ -0,0 +1,197 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/render_commands.h"
+#include "mediapipe/util/render_data.pb.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr char kNodeConfig[] = R"(
+  calculator: "AnnotationOverlayCalculator"
+  input_stream: "INPUT_FRAME:image"
+  input_stream: "RENDER_COMMANDS:commands"
+  output_stream: "OUTPUT_FRAME:annotated_image"
+)";
+
+Packet MakeFrame(int width, int height) {
+  auto frame = absl::make_unique<ImageFrame>(ImageFormat::SRGB, width, height);
+  formats::MatView(frame.get()).setTo(cv::Scalar(50, 50, 50));
+  return Adopt(frame.release());
+}
+
+// Returns "num_boxes" filled boxes of 16x16 pixels, spread over a frame of at
+// least 640x480 pixels.
+RenderCommandBuffer MakeBoxes(int num_boxes) {
+  RenderCommandBuffer commands;
+  for (int i = 0; i < num_boxes; ++i) {
+    RenderCommand* box = commands.Add(RenderCommand::FILLED_RECTANGLE);
+    box->x0 = (i % 32) * 20;
+    box->y0 = (i / 32 % 24) * 20;
+    box->x1 = box->x0 + 16;
+    box->y1 = box->y0 + 16;
+    box->color_r = 1;
+  }
+  return commands;
+}
+
+TEST(AnnotationOverlayCalculatorTest, DrawsOnlyAnnotatedPixels) {
+  CalculatorRunner runner(
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(kNodeConfig));
+  runner.MutableInputs()->Tag("INPUT_FRAME").packets.push_back(
+      MakeFrame(64, 48).At(Timestamp(0)));
+  runner.MutableInputs()->Tag("RENDER_COMMANDS").packets.push_back(
+      MakePacket<RenderCommandBuffer>(MakeBoxes(1)).At(Timestamp(0)));
+  MEDIAPIPE_ASSERT_OK(runner.Run());
+
+  const auto& input = runner.MutableInputs()->Tag("INPUT_FRAME").packets;
+  const auto& outputs = runner.Outputs().Tag("OUTPUT_FRAME").packets;
+  ASSERT_EQ(1, outputs.size());
+  const ImageFrame& output = outputs[0].Get<ImageFrame>();
+  // The runner still holds the input, so the calculator draws on a copy.
+  EXPECT_NE(input[0].Get<ImageFrame>().PixelData(), output.PixelData());
+  EXPECT_EQ(cv::Vec3b(50, 50, 50),
+            formats::MatView(&input[0].Get<ImageFrame>()).at<cv::Vec3b>(8, 8));
+
+  const cv::Mat image = formats::MatView(&output);
+  for (int y = 0; y < image.rows; ++y) {
+    for (int x = 0; x < image.cols; ++x) {
+      const cv::Vec3b expected =
+          x < 16 && y < 16 ? cv::Vec3b(255, 0, 0) : cv::Vec3b(50, 50, 50);
+      ASSERT_EQ(expected, image.at<cv::Vec3b>(y, x)) << x << "," << y;
+    }
+  }
+}
+
+TEST(AnnotationOverlayCalculatorTest, ForwardsFrameWithoutAnnotations) {
+  CalculatorRunner runner(
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+        calculator: "AnnotationOverlayCalculator"
+        input_stream: "INPUT_FRAME:image"
+        input_stream: "render_data"
+        input_stream: "RENDER_COMMANDS:commands"
+        output_stream: "OUTPUT_FRAME:annotated_image"
+      )"));
+  runner.MutableInputs()->Tag("INPUT_FRAME").packets.push_back(
+      MakeFrame(64, 48).At(Timestamp(0)));
+  runner.MutableInputs()->Index(0).packets.push_back(
+      MakePacket<RenderData>().At(Timestamp(0)));
+  runner.MutableInputs()->Tag("RENDER_COMMANDS").packets.push_back(
+      MakePacket<RenderCommandBuffer>().At(Timestamp(0)));
+  MEDIAPIPE_ASSERT_OK(runner.Run());
+
+  const auto& outputs = runner.Outputs().Tag("OUTPUT_FRAME").packets;
+  ASSERT_EQ(1, outputs.size());
+  EXPECT_EQ(
+      runner.MutableInputs()->Tag("INPUT_FRAME").packets[0]
+          .Get<ImageFrame>()
+          .PixelData(),
+      outputs[0].Get<ImageFrame>().PixelData());
+}
+
+TEST(AnnotationOverlayCalculatorTest, DrawsOnUnsharedInputFrame) {
+  CalculatorGraphConfig config;
+  *config.add_node() =
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(kNodeConfig);
+  config.add_input_stream("image");
+  config.add_input_stream("commands");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  std::vector<Packet> outputs;
+  MEDIAPIPE_ASSERT_OK(graph.ObserveOutputStream(
+      "annotated_image", [&outputs](const Packet& packet) {
+        outputs.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+
+  Packet frame = MakeFrame(64, 48).At(Timestamp(0));
+  const uint8* pixels = frame.Get<ImageFrame>().PixelData();
+  MEDIAPIPE_ASSERT_OK(
+      graph.AddPacketToInputStream("image", std::move(frame)));
+  MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+      "commands",
+      MakePacket<RenderCommandBuffer>(MakeBoxes(1)).At(Timestamp(0))));
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(1, outputs.size());
+  const ImageFrame& output = outputs[0].Get<ImageFrame>();
+  EXPECT_EQ(pixels, output.PixelData());
+  EXPECT_EQ(cv::Vec3b(255, 0, 0),
+            formats::MatView(&output).at<cv::Vec3b>(8, 8));
+  EXPECT_EQ(cv::Vec3b(50, 50, 50),
+            formats::MatView(&output).at<cv::Vec3b>(40, 40));
+}
+
+// Annotates 720p frames with "state.range(0)" boxes. If "shared_input" is
+// true, the caller keeps a reference to each frame, so that the calculator
+// has to copy it before drawing.
+void RunOverlayBenchmark(benchmark::State& state, bool shared_input) {
+  constexpr int kNumFrames = 100;
+  CalculatorGraphConfig config;
+  *config.add_node() =
+      ParseTextProtoOrDie<CalculatorGraphConfig::Node>(kNodeConfig);
+  config.add_input_stream("image");
+  config.add_input_stream("commands");
+  const Packet commands = MakePacket<RenderCommandBuffer>(
+      MakeBoxes(state.range(0)));
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<Packet> frames;
+    for (int i = 0; i < kNumFrames; ++i) {
+      frames.push_back(MakeFrame(1280, 720).At(Timestamp(i)));
+    }
+    CalculatorGraph graph;
+    CHECK(graph.Initialize(config).ok());
+    CHECK(graph.StartRun({}).ok());
+    state.ResumeTiming();
+    for (int i = 0; i < kNumFrames; ++i) {
+      Packet frame = shared_input ? frames[i] : std::move(frames[i]);
+      CHECK(graph.AddPacketToInputStream("image", std::move(frame)).ok());
+      CHECK(graph.AddPacketToInputStream("commands", commands.At(Timestamp(i)))
+                .ok());
+    }
+    CHECK(graph.CloseAllInputStreams().ok());
+    CHECK(graph.WaitUntilDone().ok());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumFrames);
+}
+
+void BM_OverlayUnsharedFrame(benchmark::State& state) {
+  RunOverlayBenchmark(state, false);
+}
+BENCHMARK(BM_OverlayUnsharedFrame)->Arg(0)->Arg(1)->Arg(10)->Arg(100);
+
+void BM_OverlaySharedFrame(benchmark::State& state) {
+  RunOverlayBenchmark(state, true);
+}
+BENCHMARK(BM_OverlaySharedFrame)->Arg(0)->Arg(1)->Arg(10)->Arg(100);
+
+}  // namespace
+}  // namespace mediapipe
@@ -12,6 +12,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "absl/strings/str_split.h"
 #include "mediapipe//framework/packet.h"
 #include "mediapipe/calculators/util/detection_label_id_to_text_calculator.pb.h"
 #include "mediapipe/framework/calculator_framework.h"
@@ -19,14 +20,6 @@
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/util/resource_util.h"
 
-#if defined(MEDIAPIPE_LITE) || defined(__ANDROID__) || \
-    (defined(__APPLE__) && !TARGET_OS_OSX)
-#include "mediapipe/util/android/file/base/file.h"
-#include "mediapipe/util/android/file/base/helpers.h"
-#else
-#include "mediapipe/framework/port/file_helpers.h"
-#endif
-
 namespace mediapipe {
 
 // Takes a label map (from label IDs to names), and replaces the label IDs
@@ -61,6 +54,7 @@ REGISTER_CALCULATOR(DetectionLabelIdToTextCalculator);
     CalculatorContract* cc) {
   cc->Inputs().Index(0).Set<std::vector<Detection>>();
   cc->Outputs().Index(0).Set<std::vector<Detection>>();
+  cc->SetProcessInline(true);
 
   return ::mediapipe::OkStatus();
 }
@@ -70,16 +64,19 @@ REGISTER_CALCULATOR(DetectionLabelIdToTextCalculator);
   const auto& options =
       cc->Options<::mediapipe::DetectionLabelIdToTextCalculatorOptions>();
 
-  std::string string_path;
-  ASSIGN_OR_RETURN(string_path, PathToResourceAsFile(options.label_map_path()));
-  std::string label_map_string;
-  RETURN_IF_ERROR(file::GetContents(string_path, &label_map_string));
+  // The label map is read in place from the mapped file, without copying the
+  // whole file into a string first.
+  std::shared_ptr<const ResourceView> label_map;
+  ASSIGN_OR_RETURN(label_map, GetResourceView(options.label_map_path()));
 
-  std::istringstream stream(label_map_string);
-  std::string line;
-  int i = 0;
-  while (std::getline(stream, line)) {
-    label_map_[i++] = line;
+  std::vector<absl::string_view> lines =
+      absl::StrSplit(label_map->contents(), '\n');
+  // A final newline does not start another label.
+  if (!lines.empty() && lines.back().empty()) {
+    lines.pop_back();
+  }
+  for (int i = 0; i < static_cast<int>(lines.size()); ++i) {
+    label_map_[i] = std::string(lines[i]);
   }
   return ::mediapipe::OkStatus();
 }
@@ -22,6 +22,7 @@
 #include "mediapipe/framework/formats/location_data.pb.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/util/color.pb.h"
+#include "mediapipe/util/render_commands.h"
 #include "mediapipe/util/render_data.pb.h"
 namespace mediapipe {
 
@@ -30,6 +31,7 @@ namespace {
 constexpr char kDetectionListTag[] = "DETECTION_LIST";
 constexpr char kDetectionVectorTag[] = "DETECTION_VECTOR";
 constexpr char kRenderDataTag[] = "RENDER_DATA";
+constexpr char kRenderCommandsTag[] = "RENDER_COMMANDS";
 
 constexpr char kSceneLabelLabel[] = "LABEL";
 constexpr char kSceneFeatureLabel[] = "FEATURE";
@@ -48,6 +50,10 @@ constexpr double kLabelToBoundingBoxRatio = 0.1;
 // Detection is the format for encoding one or more detections in an image.
 // The input can be std::vector<Detection> or DetectionList.
 //
+// The output is RenderData on RENDER_DATA, or the same annotations as a
+// RenderCommandBuffer on RENDER_COMMANDS, which AnnotationOverlayCalculator
+// draws without building a proto per annotation. Either or both can be used.
+//
 // Please note that only Location Data formats of BOUNDING_BOX and
 // RELATIVE_BOUNDING_BOX are supported. Normalized coordinates for
 // RELATIVE_BOUNDING_BOX must be between 0.0 and 1.0. Any incremental normalized
@@ -89,30 +95,33 @@ class DetectionsToRenderDataCalculator : public CalculatorBase {
   // as private static methods.
   static void SetRenderAnnotationColorThickness(
       const DetectionsToRenderDataCalculatorOptions& options,
-      RenderAnnotation* render_annotation);
+      RenderCommand* render_annotation);
+
+  static void SetTextOptions(const RenderAnnotation::Text& text_options,
+                             RenderCommand* text);
 
   static void SetTextCoordinate(bool normalized, double left, double baseline,
-                                RenderAnnotation::Text* text);
+                                RenderCommand* text);
 
   static void SetRectCoordinate(bool normalized, double xmin, double ymin,
                                 double width, double height,
-                                RenderAnnotation::Rectangle* rect);
+                                RenderCommand* rect);
 
   static void AddLabels(const Detection& detection,
                         const DetectionsToRenderDataCalculatorOptions& options,
-                        float text_line_height, RenderData* render_data);
+                        float text_line_height, RenderCommandBuffer* commands);
   static void AddFeatureTag(
       const Detection& detection,
       const DetectionsToRenderDataCalculatorOptions& options,
-      float text_line_height, RenderData* render_data);
+      float text_line_height, RenderCommandBuffer* commands);
   static void AddLocationData(
       const Detection& detection,
       const DetectionsToRenderDataCalculatorOptions& options,
-      RenderData* render_data);
+      RenderCommandBuffer* commands);
   static void AddDetectionToRenderData(
       const Detection& detection,
       const DetectionsToRenderDataCalculatorOptions& options,
-      RenderData* render_data);
+      RenderCommandBuffer* commands);
 };
 REGISTER_CALCULATOR(DetectionsToRenderDataCalculator);
 
@@ -128,7 +137,15 @@ REGISTER_CALCULATOR(DetectionsToRenderDataCalculator);
   if (cc->Inputs().HasTag(kDetectionVectorTag)) {
     cc->Inputs().Tag(kDetectionVectorTag).Set<std::vector<Detection>>();
   }
-  cc->Outputs().Tag(kRenderDataTag).Set<RenderData>();
+  RET_CHECK(cc->Outputs().HasTag(kRenderDataTag) ||
+            cc->Outputs().HasTag(kRenderCommandsTag))
+      << "None of the output streams are provided.";
+  if (cc->Outputs().HasTag(kRenderDataTag)) {
+    cc->Outputs().Tag(kRenderDataTag).Set<RenderData>();
+  }
+  if (cc->Outputs().HasTag(kRenderCommandsTag)) {
+    cc->Outputs().Tag(kRenderCommandsTag).Set<RenderCommandBuffer>();
+  }
   return ::mediapipe::OkStatus();
 }
 
@@ -154,67 +171,83 @@ REGISTER_CALCULATOR(DetectionsToRenderDataCalculator);
 
   // TODO: Add score threshold to
   // DetectionsToRenderDataCalculatorOptions.
-  auto render_data = absl::make_unique<RenderData>();
-  render_data->set_scene_class(options.scene_class());
+  auto commands = absl::make_unique<RenderCommandBuffer>();
+  commands->set_scene_class(options.scene_class());
   if (has_detection_from_list) {
     for (const auto& detection :
          cc->Inputs().Tag(kDetectionListTag).Get<DetectionList>().detection()) {
-      AddDetectionToRenderData(detection, options, render_data.get());
+      AddDetectionToRenderData(detection, options, commands.get());
     }
   }
   if (has_detection_from_vector) {
     for (const auto& detection :
          cc->Inputs().Tag(kDetectionVectorTag).Get<std::vector<Detection>>()) {
-      AddDetectionToRenderData(detection, options, render_data.get());
+      AddDetectionToRenderData(detection, options, commands.get());
     }
   }
-  cc->Outputs()
-      .Tag(kRenderDataTag)
-      .Add(render_data.release(), cc->InputTimestamp());
+  if (cc->Outputs().HasTag(kRenderDataTag)) {
+    cc->Outputs()
+        .Tag(kRenderDataTag)
+        .Add(new RenderData(RenderCommandsToRenderData(*commands)),
+             cc->InputTimestamp());
+  }
+  if (cc->Outputs().HasTag(kRenderCommandsTag)) {
+    cc->Outputs()
+        .Tag(kRenderCommandsTag)
+        .Add(commands.release(), cc->InputTimestamp());
+  }
   return ::mediapipe::OkStatus();
 }
 
 void DetectionsToRenderDataCalculator::SetRenderAnnotationColorThickness(
     const DetectionsToRenderDataCalculatorOptions& options,
-    RenderAnnotation* render_annotation) {
-  render_annotation->mutable_color()->set_r(options.color().r());
-  render_annotation->mutable_color()->set_g(options.color().g());
-  render_annotation->mutable_color()->set_b(options.color().b());
-  render_annotation->set_thickness(options.thickness());
+    RenderCommand* render_annotation) {
+  render_annotation->color_r = options.color().r();
+  render_annotation->color_g = options.color().g();
+  render_annotation->color_b = options.color().b();
+  render_annotation->thickness = options.thickness();
+}
+
+void DetectionsToRenderDataCalculator::SetTextOptions(
+    const RenderAnnotation::Text& text_options, RenderCommand* text) {
+  text->normalized = text_options.normalized();
+  text->x0 = text_options.left();
+  text->y0 = text_options.baseline();
+  text->font_height = text_options.font_height();
+  text->font_face = text_options.font_face();
 }
 
 void DetectionsToRenderDataCalculator::SetTextCoordinate(
-    bool normalized, double left, double baseline,
-    RenderAnnotation::Text* text) {
-  text->set_normalized(normalized);
-  text->set_left(normalized ? std::max(left, 0.0) : left);
+    bool normalized, double left, double baseline, RenderCommand* text) {
+  text->normalized = normalized;
+  text->x0 = normalized ? std::max(left, 0.0) : left;
   // Normalized coordinates must be between 0.0 and 1.0, if they are used.
-  text->set_baseline(normalized ? std::min(baseline, 1.0) : baseline);
+  text->y0 = normalized ? std::min(baseline, 1.0) : baseline;
 }
 
 void DetectionsToRenderDataCalculator::SetRectCoordinate(
     bool normalized, double xmin, double ymin, double width, double height,
-    RenderAnnotation::Rectangle* rect) {
+    RenderCommand* rect) {
   if (xmin + width < 0.0 || ymin + height < 0.0) return;
   if (normalized) {
     if (xmin > 1.0 || ymin > 1.0) return;
   }
-  rect->set_normalized(normalized);
-  rect->set_left(normalized ? std::max(xmin, 0.0) : xmin);
-  rect->set_top(normalized ? std::max(ymin, 0.0) : ymin);
+  rect->normalized = normalized;
+  rect->x0 = normalized ? std::max(xmin, 0.0) : xmin;
+  rect->y0 = normalized ? std::max(ymin, 0.0) : ymin;
   // No "xmin + width -1" because the coordinates can be relative, i.e. [0,1],
   // and we don't know what 1 pixel means in term of double [0,1].
   // For consistency decided to not decrease by 1 also when it is not relative.
   // However, when the coordinate is normalized it has to be between 0.0 and
   // 1.0.
-  rect->set_right(normalized ? std::min(xmin + width, 1.0) : xmin + width);
-  rect->set_bottom(normalized ? std::min(ymin + height, 1.0) : ymin + height);
+  rect->x1 = normalized ? std::min(xmin + width, 1.0) : xmin + width;
+  rect->y1 = normalized ? std::min(ymin + height, 1.0) : ymin + height;
 }
 
 void DetectionsToRenderDataCalculator::AddLabels(
     const Detection& detection,
     const DetectionsToRenderDataCalculatorOptions& options,
-    float text_line_height, RenderData* render_data) {
+    float text_line_height, RenderCommandBuffer* commands) {
   CHECK(detection.label().empty() || detection.label_id().empty())
       << "Either std::string or integer labels must be used for detection "
          "but not both at the same time.";
@@ -243,20 +276,18 @@ void DetectionsToRenderDataCalculator::AddLabels(
 
   // Add the render annotations for "label(_id),score".
   for (int i = 0; i < labels.size(); ++i) {
-    auto label = labels.at(i);
-    auto* label_annotation = render_data->add_render_annotations();
-    label_annotation->set_scene_tag(kSceneLabelLabel);
-    SetRenderAnnotationColorThickness(options, label_annotation);
-    auto* text = label_annotation->mutable_text();
-    *text = options.text();
-    text->set_display_text(label);
+    auto* text = commands->Add(RenderCommand::TEXT);
+    commands->SetSceneTag(text, kSceneLabelLabel);
+    SetRenderAnnotationColorThickness(options, text);
+    SetTextOptions(options.text(), text);
+    commands->SetText(text, labels.at(i));
     if (detection.location_data().format() == LocationData::BOUNDING_BOX) {
       SetTextCoordinate(false, detection.location_data().bounding_box().xmin(),
                         detection.location_data().bounding_box().ymin() +
                             (i + 1) * text_line_height,
                         text);
     } else {
-      text->set_font_height(text_line_height * 0.9);
+      text->font_height = text_line_height * 0.9;
       SetTextCoordinate(
           true, detection.location_data().relative_bounding_box().xmin(),
           detection.location_data().relative_bounding_box().ymin() +
@@ -269,19 +300,18 @@ void DetectionsToRenderDataCalculator::AddLabels(
 void DetectionsToRenderDataCalculator::AddFeatureTag(
     const Detection& detection,
     const DetectionsToRenderDataCalculatorOptions& options,
-    float text_line_height, RenderData* render_data) {
-  auto* feature_tag_annotation = render_data->add_render_annotations();
-  feature_tag_annotation->set_scene_tag(kSceneFeatureLabel);
-  SetRenderAnnotationColorThickness(options, feature_tag_annotation);
-  auto* feature_tag_text = feature_tag_annotation->mutable_text();
-  feature_tag_text->set_display_text(detection.feature_tag());
+    float text_line_height, RenderCommandBuffer* commands) {
+  auto* feature_tag_text = commands->Add(RenderCommand::TEXT);
+  commands->SetSceneTag(feature_tag_text, kSceneFeatureLabel);
+  SetRenderAnnotationColorThickness(options, feature_tag_text);
+  commands->SetText(feature_tag_text, detection.feature_tag());
   if (detection.location_data().format() == LocationData::BOUNDING_BOX) {
     SetTextCoordinate(false, detection.location_data().bounding_box().xmin(),
                       detection.location_data().bounding_box().ymin() +
                           detection.location_data().bounding_box().height(),
                       feature_tag_text);
   } else {
-    feature_tag_text->set_font_height(text_line_height * 0.9);
+    feature_tag_text->font_height = text_line_height * 0.9;
     SetTextCoordinate(
         true, detection.location_data().relative_bounding_box().xmin(),
         detection.location_data().relative_bounding_box().ymin() +
@@ -293,11 +323,10 @@ void DetectionsToRenderDataCalculator::AddFeatureTag(
 void DetectionsToRenderDataCalculator::AddLocationData(
     const Detection& detection,
     const DetectionsToRenderDataCalculatorOptions& options,
-    RenderData* render_data) {
-  auto* location_data_annotation = render_data->add_render_annotations();
-  location_data_annotation->set_scene_tag(kSceneLocationLabel);
-  SetRenderAnnotationColorThickness(options, location_data_annotation);
-  auto* location_data_rect = location_data_annotation->mutable_rectangle();
+    RenderCommandBuffer* commands) {
+  auto* location_data_rect = commands->Add(RenderCommand::RECTANGLE);
+  commands->SetSceneTag(location_data_rect, kSceneLocationLabel);
+  SetRenderAnnotationColorThickness(options, location_data_rect);
   if (detection.location_data().format() == LocationData::BOUNDING_BOX) {
     SetRectCoordinate(false, detection.location_data().bounding_box().xmin(),
                       detection.location_data().bounding_box().ymin(),
@@ -315,16 +344,13 @@ void DetectionsToRenderDataCalculator::AddLocationData(
     if (detection.location_data().relative_keypoints_size()) {
       for (int i = 0; i < detection.location_data().relative_keypoints_size();
            ++i) {
-        auto* keypoint_data_annotation = render_data->add_render_annotations();
-        keypoint_data_annotation->set_scene_tag(kKeypointLabel);
-        SetRenderAnnotationColorThickness(options, keypoint_data_annotation);
-        auto* keypoint_data = keypoint_data_annotation->mutable_point();
-        keypoint_data->set_normalized(true);
+        auto* keypoint_data = commands->Add(RenderCommand::POINT);
+        commands->SetSceneTag(keypoint_data, kKeypointLabel);
+        SetRenderAnnotationColorThickness(options, keypoint_data);
+        keypoint_data->normalized = true;
         // See location_data.proto for detail.
-        keypoint_data->set_x(
-            detection.location_data().relative_keypoints(i).x());
-        keypoint_data->set_y(
-            detection.location_data().relative_keypoints(i).y());
+        keypoint_data->x0 = detection.location_data().relative_keypoints(i).x();
+        keypoint_data->y0 = detection.location_data().relative_keypoints(i).y();
       }
     }
   }
@@ -333,7 +359,7 @@ void DetectionsToRenderDataCalculator::AddLocationData(
 void DetectionsToRenderDataCalculator::AddDetectionToRenderData(
     const Detection& detection,
     const DetectionsToRenderDataCalculatorOptions& options,
-    RenderData* render_data) {
+    RenderCommandBuffer* commands) {
   CHECK(detection.location_data().format() == LocationData::BOUNDING_BOX ||
         detection.location_data().format() ==
             LocationData::RELATIVE_BOUNDING_BOX)
@@ -352,8 +378,8 @@ void DetectionsToRenderDataCalculator::AddDetectionToRenderData(
                                        detection.label_id_size()) +
                               1 /* for feature_tag */));
   }
-  AddLabels(detection, options, text_line_height, render_data);
-  AddFeatureTag(detection, options, text_line_height, render_data);
-  AddLocationData(detection, options, render_data);
+  AddLabels(detection, options, text_line_height, commands);
+  AddFeatureTag(detection, options, text_line_height, commands);
+  AddLocationData(detection, options, commands);
 }
 }  // namespace mediapipe
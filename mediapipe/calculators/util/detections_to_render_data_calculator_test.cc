@@ -26,6 +26,7 @@
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status_matchers.h"
 #include "mediapipe/util/color.pb.h"
+#include "mediapipe/util/render_commands.h"
 #include "mediapipe/util/render_data.pb.h"
 
 namespace mediapipe {
@@ -255,4 +256,52 @@ TEST(DetectionsToRenderDataCalculatorTest, ProduceEmptyPacket) {
   EXPECT_EQ(exact2[0].Get<RenderData>().render_annotations_size(), 0);
 }
 
+TEST(DetectionsToRenderDataCalculatorTest, RenderCommandsMatchRenderData) {
+  CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"(
+    calculator: "DetectionsToRenderDataCalculator"
+    input_stream: "DETECTION_VECTOR:detection_vector"
+    output_stream: "RENDER_DATA:render_data"
+    output_stream: "RENDER_COMMANDS:render_commands"
+    options {
+      [mediapipe.DetectionsToRenderDataCalculatorOptions.ext] {
+        color { r: 255 }
+        thickness: 2
+        text { font_face: 1 }
+      }
+    }
+  )"));
+
+  Detection detection = CreateDetection(
+      {}, {1, 2}, {0.5, 0.25}, CreateRelativeLocationData(0.1, 0.2, 0.3, 0.4),
+      "feature_tag");
+  auto* keypoint = detection.mutable_location_data()->add_relative_keypoints();
+  keypoint->set_x(0.2);
+  keypoint->set_y(0.3);
+  auto detections = absl::make_unique<std::vector<Detection>>();
+  detections->push_back(detection);
+  runner.MutableInputs()
+      ->Tag("DETECTION_VECTOR")
+      .packets.push_back(Adopt(detections.release()).At(Timestamp(0)));
+
+  MEDIAPIPE_ASSERT_OK(runner.Run()) << "Calculator execution failed.";
+  ASSERT_EQ(1, runner.Outputs().Tag("RENDER_COMMANDS").packets.size());
+  ASSERT_EQ(1, runner.Outputs().Tag("RENDER_DATA").packets.size());
+  const auto& commands = runner.Outputs()
+                             .Tag("RENDER_COMMANDS")
+                             .packets[0]
+                             .Get<RenderCommandBuffer>();
+  const auto& render_data =
+      runner.Outputs().Tag("RENDER_DATA").packets[0].Get<RenderData>();
+  // Label, feature tag, box and keypoint.
+  ASSERT_EQ(4, commands.size());
+  EXPECT_EQ("DETECTION", commands.scene_class());
+  EXPECT_EQ("1,0.5,2,0.25,", commands.text(commands.commands()[0]));
+  EXPECT_EQ(1, commands.commands()[0].font_face);
+  EXPECT_EQ("LOCATION", commands.scene_tag(commands.commands()[2]));
+  EXPECT_EQ(RenderCommand::POINT, commands.commands()[3].type);
+  EXPECT_THAT(RenderCommandsToRenderData(commands), EqualsProto(render_data));
+  EXPECT_EQ(255, commands.commands()[2].color_r);
+  EXPECT_EQ(2.0f, commands.commands()[2].thickness);
+}
+
 }  // namespace mediapipe
@@ -32,6 +32,7 @@
 #include "mediapipe/framework/formats/motion/optical_flow_field.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/util/parallel_for.h"
 
 namespace mediapipe {
 
@@ -98,13 +99,15 @@ class FlowToImageCalculator : public CalculatorBase {
       new ImageFrame(ImageFormat::SRGB, input.width(), input.height()));
   cv::Mat image = ::mediapipe::formats::MatView(output.get());
 
-  for (int j = 0; j != input.height(); ++j) {
-    for (int i = 0; i != input.width(); ++i) {
-      image.at<cv::Vec3b>(j, i) =
-          cv::Vec3b(model_.Apply(flow.at<cv::Point2f>(j, i).x, 0),
-                    model_.Apply(flow.at<cv::Point2f>(j, i).y, 1), 0);
+  ParallelFor(cc->GetExecutor(), input.height(), 16, [&](int begin, int end) {
+    for (int j = begin; j != end; ++j) {
+      for (int i = 0; i != input.width(); ++i) {
+        image.at<cv::Vec3b>(j, i) =
+            cv::Vec3b(model_.Apply(flow.at<cv::Point2f>(j, i).x, 0),
+                      model_.Apply(flow.at<cv::Point2f>(j, i).y, 1), 0);
+      }
     }
-  }
+  });
   cc->Outputs().Index(0).Add(output.release(), cc->InputTimestamp());
   return ::mediapipe::OkStatus();
 }
@@ -0,0 +1,343 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A main function to benchmark a MediaPipe graph. It runs the graph like
+// simple_run_graph_main, and reports:
+// - throughput, in packets per second on --output_stream,
+// - end-to-end latency percentiles, from the time a frame is added to
+//   --input_streams to the time its result reaches --output_stream,
+// - the Process() time of each calculator, when the framework is built with
+//   profiling enabled,
+// - the CPU utilization and the peak resident set size of the process.
+//
+// Graphs that read their own input from files (e.g. through
+// OpenCvVideoDecoderCalculator) are given their paths as input side packets,
+// and only report throughput. Graphs with input streams are fed synthetic
+// SRGB frames at --input_rate_hz.
+//
+// Examples:
+//   mediapipe_graph_benchmark \
+//     --calculator_graph_config_file=object_detection_desktop_tflite_graph.pbtxt \
+//     --input_side_packets=input_video_path=in.mp4,output_video_path=out.mp4 \
+//     --output_stream=output_video --output_json=/tmp/benchmark.json
+//
+//   mediapipe_graph_benchmark \
+//     --calculator_graph_config_file=my_graph.pbtxt \
+//     --input_streams=input_video --output_stream=output_video \
+//     --input_rate_hz=30 --num_frames=600 --output_json=/tmp/benchmark.json
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+#include "mediapipe/framework/formats/image_format.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/commandlineflags.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/map_util.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+
+DEFINE_string(
+    calculator_graph_config_file, "",
+    "Name of file containing text format CalculatorGraphConfig proto.");
+DEFINE_string(input_side_packets, "",
+              "Comma-separated list of key=value pairs specifying side packets "
+              "for the CalculatorGraph. All values are fed as strings. A value "
+              "of the form @path is replaced by the contents of that file.");
+DEFINE_string(input_streams, "",
+              "Comma-separated list of graph input streams to feed with "
+              "synthetic SRGB frames. Each frame is added to all of them.");
+DEFINE_int32(frame_width, 640, "Width of the synthetic frames.");
+DEFINE_int32(frame_height, 480, "Height of the synthetic frames.");
+DEFINE_int32(num_frames, 300, "Number of synthetic frames to measure.");
+DEFINE_int32(warmup_frames, 30,
+             "Number of synthetic frames fed before measurement starts.");
+DEFINE_double(input_rate_hz, 0,
+              "Rate at which synthetic frames are fed. If 0, frames are fed as "
+              "fast as the input streams accept them.");
+DEFINE_string(output_stream, "",
+              "Graph output stream whose packets are counted for throughput "
+              "and latency. If empty, only the run time is reported.");
+DEFINE_string(output_json, "",
+              "If set, the results are also written to this file as JSON.");
+
+namespace mediapipe {
+namespace {
+
+// Timestamp interval of the synthetic frames when no input rate is set.
+constexpr int64 kDefaultFrameIntervalUs = 33333;
+
+struct CalculatorTime {
+  std::string name;
+  int64 process_calls = 0;
+  int64 process_time_us = 0;
+};
+
+struct BenchmarkResult {
+  double wall_time_s = 0;
+  int64 output_packets = 0;
+  double throughput_per_s = 0;
+  // End-to-end latencies in microseconds, sorted. Empty without input streams.
+  std::vector<int64> latencies_us;
+  double cpu_utilization = 0;
+  int64 peak_rss_kb = 0;
+  std::vector<CalculatorTime> calculator_times;
+};
+
+// Returns the latency at "percentile" of the sorted "latencies_us", with the
+// nearest-rank method.
+int64 Percentile(const std::vector<int64>& latencies_us, double percentile) {
+  if (latencies_us.empty()) return 0;
+  int rank = static_cast<int>(percentile / 100 * latencies_us.size() + 0.5);
+  rank = std::min<int>(std::max(rank, 1), latencies_us.size());
+  return latencies_us[rank - 1];
+}
+
+absl::Duration CpuTime() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return absl::DurationFromTimeval(usage.ru_utime) +
+         absl::DurationFromTimeval(usage.ru_stime);
+}
+
+int64 PeakRssKb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+::mediapipe::StatusOr<std::map<std::string, Packet>> ParseInputSidePackets() {
+  std::map<std::string, Packet> input_side_packets;
+  if (FLAGS_input_side_packets.empty()) {
+    return input_side_packets;
+  }
+  std::vector<std::string> kv_pairs =
+      absl::StrSplit(FLAGS_input_side_packets, ',');
+  for (const std::string& kv_pair : kv_pairs) {
+    std::vector<std::string> name_and_value = absl::StrSplit(kv_pair, '=');
+    RET_CHECK(name_and_value.size() == 2);
+    RET_CHECK(!ContainsKey(input_side_packets, name_and_value[0]));
+    std::string value = name_and_value[1];
+    if (absl::StartsWith(value, "@")) {
+      RETURN_IF_ERROR(file::GetContents(value.substr(1), &value));
+    }
+    input_side_packets[name_and_value[0]] = MakePacket<std::string>(value);
+  }
+  return input_side_packets;
+}
+
+Packet MakeSyntheticFrame() {
+  auto frame = absl::make_unique<ImageFrame>(
+      ImageFormat::SRGB, FLAGS_frame_width, FLAGS_frame_height);
+  frame->SetToZero();
+  return Adopt(frame.release());
+}
+
+::mediapipe::Status RunBenchmark(BenchmarkResult* result) {
+  std::string calculator_graph_config_contents;
+  RETURN_IF_ERROR(file::GetContents(FLAGS_calculator_graph_config_file,
+                                    &calculator_graph_config_contents));
+  CalculatorGraphConfig config =
+      ParseTextProtoOrDie<CalculatorGraphConfig>(
+          calculator_graph_config_contents);
+  config.mutable_profiler_config()->set_enable_profiler(true);
+  ASSIGN_OR_RETURN(auto input_side_packets, ParseInputSidePackets());
+
+  std::vector<std::string> input_streams;
+  if (!FLAGS_input_streams.empty()) {
+    input_streams = absl::StrSplit(FLAGS_input_streams, ',');
+  }
+  const int64 frame_interval_us =
+      FLAGS_input_rate_hz > 0 ? static_cast<int64>(1e6 / FLAGS_input_rate_hz)
+                              : kDefaultFrameIntervalUs;
+  const int num_frames = FLAGS_warmup_frames + FLAGS_num_frames;
+
+  // The times at which each frame was added and its result came out, indexed
+  // by frame number.
+  absl::Mutex mutex;
+  std::vector<absl::Time> input_times(num_frames, absl::InfinitePast());
+  std::vector<absl::Time> output_times(num_frames, absl::InfinitePast());
+  absl::Time last_output = absl::InfinitePast();
+  int64 measured_outputs = 0;
+
+  CalculatorGraph graph;
+  RETURN_IF_ERROR(graph.Initialize(config, input_side_packets));
+  if (!FLAGS_output_stream.empty()) {
+    RETURN_IF_ERROR(graph.ObserveOutputStream(
+        FLAGS_output_stream, [&](const Packet& packet) {
+          const absl::Time now = absl::Now();
+          absl::MutexLock lock(&mutex);
+          int64 frame = -1;
+          if (!input_streams.empty() && packet.Timestamp().IsRangeValue()) {
+            frame = packet.Timestamp().Value() / frame_interval_us;
+            if (frame >= 0 && frame < num_frames) {
+              output_times[frame] = now;
+            }
+          }
+          // Without input streams, all packets are measured.
+          if (input_streams.empty() || frame >= FLAGS_warmup_frames) {
+            ++measured_outputs;
+          }
+          last_output = now;
+          return ::mediapipe::OkStatus();
+        }));
+  }
+
+  const absl::Duration start_cpu_time = CpuTime();
+  const absl::Time start_time = absl::Now();
+  absl::Time measure_start_time = start_time;
+  RETURN_IF_ERROR(graph.StartRun({}));
+  if (!input_streams.empty()) {
+    const absl::Duration frame_interval =
+        absl::Microseconds(frame_interval_us);
+    for (int i = 0; i < num_frames; ++i) {
+      if (FLAGS_input_rate_hz > 0) {
+        absl::SleepFor(start_time + i * frame_interval - absl::Now());
+      }
+      const Packet frame =
+          MakeSyntheticFrame().At(Timestamp(i * frame_interval_us));
+      const absl::Time now = absl::Now();
+      if (i == FLAGS_warmup_frames) {
+        measure_start_time = now;
+      }
+      {
+        absl::MutexLock lock(&mutex);
+        input_times[i] = now;
+      }
+      for (const std::string& stream : input_streams) {
+        RETURN_IF_ERROR(graph.AddPacketToInputStream(stream, frame));
+      }
+    }
+    RETURN_IF_ERROR(graph.CloseAllInputStreams());
+  }
+  RETURN_IF_ERROR(graph.WaitUntilDone());
+  const absl::Time end_time = absl::Now();
+
+  result->wall_time_s = absl::ToDoubleSeconds(end_time - start_time);
+  result->cpu_utilization =
+      absl::ToDoubleSeconds(CpuTime() - start_cpu_time) / result->wall_time_s;
+  result->peak_rss_kb = PeakRssKb();
+  result->output_packets = measured_outputs;
+  if (measured_outputs > 0) {
+    // Without input streams, the graph starts producing on StartRun().
+    const absl::Time begin =
+        input_streams.empty() ? start_time : measure_start_time;
+    result->throughput_per_s =
+        measured_outputs / absl::ToDoubleSeconds(last_output - begin);
+  }
+  for (int i = FLAGS_warmup_frames; i < num_frames; ++i) {
+    if (output_times[i] != absl::InfinitePast()) {
+      result->latencies_us.push_back(
+          absl::ToInt64Microseconds(output_times[i] - input_times[i]));
+    }
+  }
+  std::sort(result->latencies_us.begin(), result->latencies_us.end());
+
+  std::vector<CalculatorProfile> profiles;
+  RETURN_IF_ERROR(graph.profiler()->GetCalculatorProfiles(&profiles));
+  for (const CalculatorProfile& profile : profiles) {
+    CalculatorTime time;
+    time.name = profile.name();
+    for (const int64 count : profile.process_runtime().count()) {
+      time.process_calls += count;
+    }
+    time.process_time_us = profile.process_runtime().total();
+    result->calculator_times.push_back(time);
+  }
+  std::sort(result->calculator_times.begin(), result->calculator_times.end(),
+            [](const CalculatorTime& a, const CalculatorTime& b) {
+              return a.process_time_us > b.process_time_us;
+            });
+  return ::mediapipe::OkStatus();
+}
+
+void LogResult(const BenchmarkResult& result) {
+  LOG(INFO) << "Wall time: " << result.wall_time_s << " s";
+  LOG(INFO) << "Output packets: " << result.output_packets
+            << ", throughput: " << result.throughput_per_s << " /s";
+  if (!result.latencies_us.empty()) {
+    LOG(INFO) << "Latency (us): p50 " << Percentile(result.latencies_us, 50)
+              << ", p90 " << Percentile(result.latencies_us, 90) << ", p99 "
+              << Percentile(result.latencies_us, 99) << ", max "
+              << result.latencies_us.back();
+  }
+  LOG(INFO) << "CPU utilization: " << result.cpu_utilization
+            << " cores, peak RSS: " << result.peak_rss_kb << " KB";
+  for (const CalculatorTime& time : result.calculator_times) {
+    LOG(INFO) << time.name << ": " << time.process_calls << " calls, "
+              << time.process_time_us << " us";
+  }
+}
+
+std::string ResultToJson(const BenchmarkResult& result) {
+  std::string json = absl::StrCat(
+      "{\n  \"graph\": \"", FLAGS_calculator_graph_config_file, "\",\n",
+      "  \"wall_time_s\": ", result.wall_time_s, ",\n",
+      "  \"output_packets\": ", result.output_packets, ",\n",
+      "  \"throughput_per_s\": ", result.throughput_per_s, ",\n",
+      "  \"latency_us\": {\"count\": ", result.latencies_us.size(),
+      ", \"p50\": ", Percentile(result.latencies_us, 50),
+      ", \"p90\": ", Percentile(result.latencies_us, 90),
+      ", \"p99\": ", Percentile(result.latencies_us, 99), ", \"max\": ",
+      result.latencies_us.empty() ? 0 : result.latencies_us.back(), "},\n",
+      "  \"cpu_utilization\": ", result.cpu_utilization, ",\n",
+      "  \"peak_rss_kb\": ", result.peak_rss_kb, ",\n",
+      "  \"calculators\": [");
+  for (int i = 0; i < result.calculator_times.size(); ++i) {
+    const CalculatorTime& time = result.calculator_times[i];
+    absl::StrAppend(&json, i == 0 ? "\n" : ",\n", "    {\"name\": \"",
+                    time.name, "\", \"process_calls\": ", time.process_calls,
+                    ", \"process_time_us\": ", time.process_time_us, "}");
+  }
+  absl::StrAppend(&json, "\n  ]\n}\n");
+  return json;
+}
+
+}  // namespace
+}  // namespace mediapipe
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  mediapipe::BenchmarkResult result;
+  ::mediapipe::Status run_status = mediapipe::RunBenchmark(&result);
+  if (!run_status.ok()) {
+    LOG(ERROR) << "Failed to run the graph: " << run_status.message();
+    return 1;
+  }
+  mediapipe::LogResult(result);
+  if (!FLAGS_output_json.empty()) {
+    run_status = mediapipe::file::SetContents(FLAGS_output_json,
+                                              mediapipe::ResultToJson(result));
+    if (!run_status.ok()) {
+      LOG(ERROR) << "Failed to write the results: " << run_status.message();
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,161 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/calculator_benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
+
+namespace {
+
+// The number of calls to the global operator new, from any thread.
+std::atomic<int64> allocation_count(0);
+
+void* CountedAllocate(std::size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  void* ptr = CountedAllocate(size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](std::size_t size) {
+  void* ptr = CountedAllocate(size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return CountedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+  std::free(ptr);
+}
+
+namespace mediapipe {
+
+namespace {
+
+// Returns the value at quantile "q" of the sorted "values".
+double Percentile(const std::vector<double>& values, double q) {
+  if (values.empty()) return 0;
+  int index = static_cast<int>(q * values.size());
+  return values[std::min<int>(index, values.size() - 1)];
+}
+
+// Returns the lower bound, in microseconds, of the histogram interval holding
+// the call at quantile "q".
+double HistogramPercentile(const TimeHistogram& histogram, int64 num_calls,
+                           double q) {
+  const int64 rank =
+      std::min<int64>(static_cast<int64>(q * num_calls), num_calls - 1);
+  int64 num_seen = 0;
+  for (int i = 0; i < histogram.count_size(); ++i) {
+    num_seen += histogram.count(i);
+    if (num_seen > rank) {
+      return i * histogram.interval_size_usec();
+    }
+  }
+  return 0;
+}
+
+// Reports the Process() runtime recorded by the graph profiler, if available.
+void ReportProcessRuntime(benchmark::State& state, CalculatorRunner* runner) {
+  TimeHistogram histogram;
+  if (!runner->GetBenchmarkProcessRuntime(&histogram).ok()) return;
+  int64 num_calls = 0;
+  for (const int64 count : histogram.count()) {
+    num_calls += count;
+  }
+  if (num_calls == 0) return;
+  state.counters["process_mean_us"] =
+      static_cast<double>(histogram.total()) / num_calls;
+  state.counters["process_p50_us"] =
+      HistogramPercentile(histogram, num_calls, 0.5);
+  state.counters["process_p90_us"] =
+      HistogramPercentile(histogram, num_calls, 0.9);
+  state.counters["process_p99_us"] =
+      HistogramPercentile(histogram, num_calls, 0.99);
+  state.counters["process_max_us"] =
+      HistogramPercentile(histogram, num_calls, 1.0);
+}
+
+}  // namespace
+
+void RunCalculatorBenchmark(benchmark::State& state, CalculatorRunner* runner,
+                            const BenchmarkInputGenerator& generate_inputs) {
+  ::mediapipe::Status status = runner->StartBenchmark();
+  if (!status.ok()) {
+    state.SkipWithError(status.ToString().c_str());
+    return;
+  }
+  std::vector<double> latencies_us;
+  int64 allocations = 0;
+  int64 iteration = 0;
+  for (auto _ : state) {
+    std::vector<Packet> inputs = generate_inputs(iteration++);
+    const int64 start_allocations = allocation_count.load();
+    const absl::Time start = absl::Now();
+    status = runner->ProcessForBenchmark(std::move(inputs));
+    const absl::Duration latency = absl::Now() - start;
+    allocations += allocation_count.load() - start_allocations;
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+    state.SetIterationTime(absl::ToDoubleSeconds(latency));
+    latencies_us.push_back(absl::ToDoubleMicroseconds(latency));
+  }
+  ReportProcessRuntime(state, runner);
+  status = runner->FinishBenchmark();
+  if (!status.ok()) {
+    state.SkipWithError(status.ToString().c_str());
+    return;
+  }
+  if (latencies_us.empty()) return;
+  std::sort(latencies_us.begin(), latencies_us.end());
+  state.counters["round_trip_p50_us"] = Percentile(latencies_us, 0.5);
+  state.counters["round_trip_p90_us"] = Percentile(latencies_us, 0.9);
+  state.counters["round_trip_p99_us"] = Percentile(latencies_us, 0.99);
+  state.counters["round_trip_max_us"] = latencies_us.back();
+  state.counters["allocs_per_round_trip"] =
+      static_cast<double>(allocations) / latencies_us.size();
+  state.SetItemsProcessed(latencies_us.size());
+}
+
+}  // namespace mediapipe
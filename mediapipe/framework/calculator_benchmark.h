@@ -0,0 +1,76 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Helpers to benchmark a single calculator with google-benchmark, using the
+// benchmark mode of CalculatorRunner.
+//
+// Example:
+//   void BM_MyCalculator(benchmark::State& state) {
+//     CalculatorRunner runner(R"(
+//         calculator: "MyCalculator"
+//         input_stream: "input"
+//         output_stream: "output"
+//     )");
+//     RunCalculatorBenchmark(state, &runner, [](int64 iteration) {
+//       return std::vector<Packet>{MakePacket<int>(iteration)};
+//     });
+//   }
+//   BENCHMARK(BM_MyCalculator)->UseManualTime();
+//
+// The reported time is the round trip of one set of inputs: adding the packets
+// to the graph, scheduling the node, its Process() call, and propagating its
+// outputs until the graph is idle. Building the inputs is not timed. For cheap
+// calculators the round trip is mostly framework work, so the benchmark also
+// reports the following counters:
+//   process_mean_us, process_p50_us, process_p90_us, process_p99_us,
+//     process_max_us: the runtime of Process() alone, as recorded by the graph
+//     profiler. The percentiles are rounded down to whole microseconds. These
+//     are omitted if the profiler is not available in the build.
+//   round_trip_p50_us, round_trip_p90_us, round_trip_p99_us,
+//     round_trip_max_us: the distribution of the round trip time.
+//   allocs_per_round_trip: the average number of operator new calls, in any
+//     thread, during one round trip, including those of the framework.
+//
+// Linking this library replaces the global operator new and operator delete
+// to count allocations, so it must not be linked into binaries that replace
+// them too.
+
+#ifndef MEDIAPIPE_FRAMEWORK_CALCULATOR_BENCHMARK_H_
+#define MEDIAPIPE_FRAMEWORK_CALCULATOR_BENCHMARK_H_
+
+#include <functional>
+#include <vector>
+
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe {
+
+// Returns the input packets of the calculator for the given iteration, one
+// per input stream in the order of the input_stream fields of the node config.
+typedef std::function<std::vector<Packet>(int64 iteration)>
+    BenchmarkInputGenerator;
+
+// Runs one Process() call of the calculator of "runner" per benchmark
+// iteration. The benchmark must be registered with UseManualTime(). The
+// input stream headers and input side packets of "runner" must be set
+// beforehand.
+void RunCalculatorBenchmark(benchmark::State& state, CalculatorRunner* runner,
+                            const BenchmarkInputGenerator& generate_inputs);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_CALCULATOR_BENCHMARK_H_
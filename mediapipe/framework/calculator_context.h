@@ -109,6 +109,13 @@ class CalculatorContext {
     return calculator_state_->GetSharedProfilingContext().get();
   }
 
+  // Returns the executor that runs this calculator, or nullptr if it runs on
+  // the application thread. A calculator can schedule helper tasks on it to
+  // parallelize the work within one Process() call, see util/parallel_for.h.
+  // The helper tasks compete with other nodes for the executor's threads, so
+  // the calling thread must not block on tasks that have not started.
+  Executor* GetExecutor() const { return calculator_state_->GetExecutor(); }
+
   template <typename T>
   class ServiceBinding {
    public:
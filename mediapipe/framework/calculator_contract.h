@@ -100,6 +100,21 @@ class CalculatorContract {
     return input_stream_handler_options_;
   }
 
+  // Marks the calculator as cheap enough to run inline. When the node becomes
+  // ready on a thread that is running another node of the same executor, its
+  // Process() and Close() are called right away on that thread, rather than
+  // through a new executor task. This saves the scheduling round trip for
+  // calculators that do trivial work, such as forwarding packets, but holds
+  // up the producing node meanwhile, so it must not be set by calculators
+  // that can block or take long. Throttling, max_in_flight and the order of
+  // the invocations are unaffected. Has no effect on source calculators.
+  void SetProcessInline(bool process_inline) {
+    process_inline_ = process_inline;
+  }
+
+  // Returns true if the calculator is marked to run inline.
+  bool ProcessInline() const { return process_inline_; }
+
   class GraphServiceRequest {
    public:
     // APIs that should be used by calculators.
@@ -142,6 +157,7 @@ class CalculatorContract {
   std::string input_stream_handler_;
   MediaPipeOptions input_stream_handler_options_;
   std::map<std::string, GraphServiceRequest> service_requests_;
+  bool process_inline_ = false;
 };
 
 }  // namespace mediapipe
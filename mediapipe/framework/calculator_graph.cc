@@ -670,6 +670,15 @@ CalculatorGraph::PrepareGpu(const std::map<std::string, Packet>& side_packets) {
                   std::placeholders::_1, std::placeholders::_2);
     node.SetQueueSizeCallbacks(queue_size_callback, queue_size_callback);
     scheduler_.AssignNodeToSchedulerQueue(&node);
+    // Nodes on the application thread or on a reserved executor (such as the
+    // GPU executor) do not get to schedule their own helper tasks.
+    Executor* node_executor = nullptr;
+    if (!IsReservedExecutorName(node.Executor()) &&
+        !(node.Executor().empty() && use_application_thread_)) {
+      auto it = executors_.find(node.Executor());
+      if (it != executors_.end()) node_executor = it->second.get();
+    }
+    node.SetCalculatorExecutor(node_executor);
     const ::mediapipe::Status result = node.PrepareForRun(
         current_run_side_packets_, service_packets_,
         std::bind(&internal::Scheduler::ScheduleNodeForOpen, &scheduler_,
@@ -802,47 +811,9 @@ template <typename T>
   int node_id =
       ::mediapipe::FindOrDie(graph_input_stream_node_ids_, stream_name);
   CHECK_GE(node_id, validated_graph_->CalculatorInfos().size());
-  {
-    absl::MutexLock lock(&full_input_streams_mutex_);
-    if (graph_input_stream_add_mode_ ==
-        GraphInputStreamAddMode::ADD_IF_NOT_FULL) {
-      if (has_error_) {
-        ::mediapipe::Status error_status;
-        GetCombinedErrors("Graph has errors: ", &error_status);
-        return error_status;
-      }
-      // Return with StatusUnavailable if this stream is being throttled.
-      if (!full_input_streams_[node_id].empty()) {
-        return ::mediapipe::UnavailableErrorBuilder(MEDIAPIPE_LOC)
-               << "Graph is throttled.";
-      }
-    } else if (graph_input_stream_add_mode_ ==
-               GraphInputStreamAddMode::WAIT_TILL_NOT_FULL) {
-      // Wait until this stream is not being throttled.
-      // TODO: instead of checking has_error_, we could just check
-      // if the graph is done. That could also be indicated by returning an
-      // error from WaitUntilGraphInputStreamUnthrottled.
-      while (!has_error_ && !full_input_streams_[node_id].empty()) {
-        // TODO: allow waiting for a specific stream?
-        scheduler_.WaitUntilGraphInputStreamUnthrottled(
-            &full_input_streams_mutex_);
-      }
-      if (has_error_) {
-        ::mediapipe::Status error_status;
-        GetCombinedErrors("Graph has errors: ", &error_status);
-        return error_status;
-      }
-    }
-  }
+  RETURN_IF_ERROR(WaitForGraphInputStreamCapacity(node_id));
 
-  // Adding profiling info for a new packet entering the graph.
-  const std::string* stream_id = &(*stream)->GetManager()->Name();
-  profiler_->LogEvent(TraceEvent(TraceEvent::PROCESS)
-                          .set_is_finish(true)
-                          .set_input_ts(packet.Timestamp())
-                          .set_stream_id(stream_id)
-                          .set_packet_ts(packet.Timestamp())
-                          .set_packet_data_id(&packet));
+  LogGraphInputPacket(stream->get(), packet);
 
   // InputStreamManager is thread safe. GraphInputStream is not, so this method
   // should not be called by multiple threads concurrently. Note that this could
@@ -865,6 +836,95 @@ template <typename T>
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::StatusOr<CalculatorGraph::GraphInputStreamHandle>
+CalculatorGraph::GetInputStreamHandle(const std::string& stream_name) {
+  std::unique_ptr<GraphInputStream>* stream =
+      ::mediapipe::FindOrNull(graph_input_streams_, stream_name);
+  RET_CHECK(stream).SetNoLogging() << absl::Substitute(
+      "GetInputStreamHandle called on input stream \"$0\" which is not a "
+      "graph input stream.",
+      stream_name);
+  int node_id =
+      ::mediapipe::FindOrDie(graph_input_stream_node_ids_, stream_name);
+  return GraphInputStreamHandle(this, stream->get(), node_id);
+}
+
+::mediapipe::Status CalculatorGraph::AddPacketsToInputStream(
+    const GraphInputStreamHandle& handle, absl::Span<const Packet> packets) {
+  RET_CHECK(handle.graph_ == this && handle.IsValid())
+      << "AddPacketsToInputStream called with a handle which was not "
+         "returned by GetInputStreamHandle() of this graph.";
+  if (packets.empty()) {
+    return ::mediapipe::OkStatus();
+  }
+  RETURN_IF_ERROR(WaitForGraphInputStreamCapacity(handle.node_id_));
+
+  GraphInputStream* stream = handle.stream_;
+  for (const Packet& packet : packets) {
+    LogGraphInputPacket(stream, packet);
+    stream->AddPacket(packet);
+  }
+  if (has_error_) {
+    ::mediapipe::Status error_status;
+    GetCombinedErrors("Graph has errors: ", &error_status);
+    return error_status;
+  }
+  // All packets of the batch are propagated from the shard together.
+  stream->PropagateUpdatesToMirrors();
+
+  VLOG(2) << packets.size()
+          << " packets added directly to: " << stream->GetManager()->Name();
+  scheduler_.AddedPacketToGraphInputStream();
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status CalculatorGraph::WaitForGraphInputStreamCapacity(
+    int node_id) {
+  absl::MutexLock lock(&full_input_streams_mutex_);
+  if (graph_input_stream_add_mode_ ==
+      GraphInputStreamAddMode::ADD_IF_NOT_FULL) {
+    if (has_error_) {
+      ::mediapipe::Status error_status;
+      GetCombinedErrors("Graph has errors: ", &error_status);
+      return error_status;
+    }
+    // Return with StatusUnavailable if this stream is being throttled.
+    if (!full_input_streams_[node_id].empty()) {
+      return ::mediapipe::UnavailableErrorBuilder(MEDIAPIPE_LOC)
+             << "Graph is throttled.";
+    }
+  } else if (graph_input_stream_add_mode_ ==
+             GraphInputStreamAddMode::WAIT_TILL_NOT_FULL) {
+    // Wait until this stream is not being throttled.
+    // TODO: instead of checking has_error_, we could just check
+    // if the graph is done. That could also be indicated by returning an
+    // error from WaitUntilGraphInputStreamUnthrottled.
+    while (!has_error_ && !full_input_streams_[node_id].empty()) {
+      // TODO: allow waiting for a specific stream?
+      scheduler_.WaitUntilGraphInputStreamUnthrottled(
+          &full_input_streams_mutex_);
+    }
+    if (has_error_) {
+      ::mediapipe::Status error_status;
+      GetCombinedErrors("Graph has errors: ", &error_status);
+      return error_status;
+    }
+  }
+  return ::mediapipe::OkStatus();
+}
+
+void CalculatorGraph::LogGraphInputPacket(GraphInputStream* stream,
+                                          const Packet& packet) {
+  // Adding profiling info for a new packet entering the graph.
+  const std::string* stream_id = &stream->GetManager()->Name();
+  profiler_->LogEvent(TraceEvent(TraceEvent::PROCESS)
+                          .set_is_finish(true)
+                          .set_input_ts(packet.Timestamp())
+                          .set_stream_id(stream_id)
+                          .set_packet_ts(packet.Timestamp())
+                          .set_packet_data_id(&packet));
+}
+
 ::mediapipe::Status CalculatorGraph::SetInputStreamMaxQueueSize(
     const std::string& stream_name, int max_queue_size) {
   // graph_input_streams_ has not been filled in yet, so we'll check this when
@@ -31,6 +31,7 @@
 #include "absl/base/macros.h"
 #include "absl/container/fixed_array.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "mediapipe/framework/calculator.pb.h"
 #include "mediapipe/framework/calculator_base.h"
 #include "mediapipe/framework/calculator_node.h"
@@ -50,6 +51,7 @@
 #include "mediapipe/framework/port.h"
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
 #include "mediapipe/framework/scheduler.h"
 #include "mediapipe/framework/thread_pool_executor.pb.h"
 
@@ -252,6 +254,30 @@ class CalculatorGraph {
   ::mediapipe::Status AddPacketToInputStream(const std::string& stream_name,
                                              Packet&& packet);
 
+  // Identifies a graph input stream for AddPacketsToInputStream(). A handle is
+  // obtained once per stream with GetInputStreamHandle() and saves the stream
+  // name lookups of AddPacketToInputStream() on every call. It remains valid
+  // for the lifetime of the graph, across runs.
+  class GraphInputStreamHandle;
+
+  // Returns a handle to the graph input stream `stream_name`. Can be called
+  // any time after Initialize().
+  ::mediapipe::StatusOr<GraphInputStreamHandle> GetInputStreamHandle(
+      const std::string& stream_name);
+
+  // Adds a batch of packets to a graph input stream. This behaves like calling
+  // AddPacketToInputStream() for each packet, except that the batch is
+  // admitted and propagated as a unit: the graph input stream add mode is
+  // applied once for the whole batch, the packets reach the downstream input
+  // streams with one lock acquisition per stream, and the scheduler is
+  // notified once. In ADD_IF_NOT_FULL mode either all or none of the packets
+  // are added. A batch may exceed the max queue size by up to its size. The
+  // packet timestamps must increase within the batch. Like
+  // AddPacketToInputStream(), this must not be called concurrently for the
+  // same stream.
+  ::mediapipe::Status AddPacketsToInputStream(
+      const GraphInputStreamHandle& handle, absl::Span<const Packet> packets);
+
   // Sets the queue size of a graph input stream, overriding the graph default.
   ::mediapipe::Status SetInputStreamMaxQueueSize(const std::string& stream_name,
                                                  int max_queue_size);
@@ -447,6 +473,15 @@ class CalculatorGraph {
   ::mediapipe::Status AddPacketToInputStreamInternal(
       const std::string& stream_name, T&& packet);
 
+  // Waits until the graph input stream with node id `node_id` is not
+  // throttled, or returns StatusUnavailable if it is throttled in
+  // ADD_IF_NOT_FULL mode. Returns the graph errors if the graph has failed.
+  ::mediapipe::Status WaitForGraphInputStreamCapacity(int node_id)
+      LOCKS_EXCLUDED(full_input_streams_mutex_);
+
+  // Logs a profiler event for a packet entering the graph.
+  void LogGraphInputPacket(GraphInputStream* stream, const Packet& packet);
+
   // Sets the executor that will run the nodes assigned to the executor
   // named |name|.  If |name| is empty, this sets the default executor.
   // Does not check that the graph is uninitialized and |name| is not a
@@ -642,6 +677,25 @@ class CalculatorGraph {
   internal::Scheduler scheduler_;
 };
 
+class CalculatorGraph::GraphInputStreamHandle {
+ public:
+  // Creates an invalid handle.
+  GraphInputStreamHandle() = default;
+
+  bool IsValid() const { return stream_ != nullptr; }
+
+ private:
+  friend class CalculatorGraph;
+
+  GraphInputStreamHandle(const CalculatorGraph* graph,
+                         GraphInputStream* stream, int node_id)
+      : graph_(graph), stream_(stream), node_id_(node_id) {}
+
+  const CalculatorGraph* graph_ = nullptr;
+  GraphInputStream* stream_ = nullptr;
+  int node_id_ = -1;
+};
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_H_
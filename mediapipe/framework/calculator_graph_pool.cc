@@ -0,0 +1,86 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/calculator_graph_pool.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/framework/shared_executor.h"
+
+namespace mediapipe {
+
+// static
+::mediapipe::StatusOr<std::unique_ptr<CalculatorGraphPool>>
+CalculatorGraphPool::Create(const CalculatorGraphConfig& config,
+                            const Options& options) {
+  RET_CHECK_GT(options.max_tasks_per_graph, 0);
+  RET_CHECK_GE(options.max_idle_graphs, 0);
+  // The constructor is private, so absl::make_unique cannot be used.
+  std::unique_ptr<CalculatorGraphPool> pool(
+      new CalculatorGraphPool(config, options));
+  ASSIGN_OR_RETURN(std::unique_ptr<CalculatorGraph> graph, pool->CreateGraph());
+  pool->Release(std::move(graph));
+  return std::move(pool);
+}
+
+CalculatorGraphPool::CalculatorGraphPool(const CalculatorGraphConfig& config,
+                                         const Options& options)
+    : config_(config), options_(options) {
+  if (!options_.executor) {
+    options_.executor = GetSharedThreadPoolExecutor("calculator_graph_pool", 0);
+  }
+}
+
+::mediapipe::StatusOr<std::unique_ptr<CalculatorGraph>>
+CalculatorGraphPool::Acquire() {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (!idle_graphs_.empty()) {
+      std::unique_ptr<CalculatorGraph> graph = std::move(idle_graphs_.back());
+      idle_graphs_.pop_back();
+      return std::move(graph);
+    }
+  }
+  return CreateGraph();
+}
+
+void CalculatorGraphPool::Release(std::unique_ptr<CalculatorGraph> graph) {
+  if (!graph) return;
+  absl::MutexLock lock(&mutex_);
+  if (idle_graphs_.size() < options_.max_idle_graphs) {
+    idle_graphs_.push_back(std::move(graph));
+  }
+}
+
+int CalculatorGraphPool::num_idle_graphs() {
+  absl::MutexLock lock(&mutex_);
+  return idle_graphs_.size();
+}
+
+::mediapipe::StatusOr<std::unique_ptr<CalculatorGraph>>
+CalculatorGraphPool::CreateGraph() {
+  auto graph = absl::make_unique<CalculatorGraph>();
+  RETURN_IF_ERROR(graph->SetExecutor(
+      "", std::make_shared<FairShareExecutor>(options_.executor,
+                                              options_.max_tasks_per_graph)));
+  RETURN_IF_ERROR(graph->Initialize(config_));
+  if (options_.setup) {
+    RETURN_IF_ERROR(options_.setup(graph.get()));
+  }
+  return std::move(graph);
+}
+
+}  // namespace mediapipe
@@ -0,0 +1,109 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_POOL_H_
+#define MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_POOL_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator.pb.h"
+#include "mediapipe/framework/calculator_graph.h"
+#include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe {
+
+// Hands out initialized CalculatorGraphs for one config to many short
+// sessions, and runs all of them on one shared executor.
+//
+// A CalculatorGraph can be run any number of times, so a graph returned with
+// Release() is kept and handed to the next session instead of being validated
+// and initialized again. The calculators themselves are still created and
+// opened anew for each run.
+//
+// Every graph created by the pool runs its default executor as a
+// FairShareExecutor over the shared executor, so the thread count stays fixed
+// however many sessions are active, and a session with much ready work takes
+// at most "max_tasks_per_graph" slots of the shared queue at a time.
+//
+// Output observers and pollers stay attached to a graph across runs. Attach
+// them once in the "setup" callback, which is called for each new graph after
+// Initialize().
+//
+// Example:
+//   ASSIGN_OR_RETURN(auto pool, CalculatorGraphPool::Create(config, options));
+//   ...
+//   ASSIGN_OR_RETURN(std::unique_ptr<CalculatorGraph> graph, pool->Acquire());
+//   RETURN_IF_ERROR(graph->StartRun({}));
+//   ...
+//   RETURN_IF_ERROR(graph->CloseAllInputStreams());
+//   ::mediapipe::Status status = graph->WaitUntilDone();
+//   pool->Release(std::move(graph));
+class CalculatorGraphPool {
+ public:
+  struct Options {
+    // The executor shared by all graphs. If null, the process-wide shared
+    // thread pool with one thread per core is used.
+    std::shared_ptr<Executor> executor;
+    // The maximum number of tasks one graph has queued or running on the
+    // shared executor.
+    int max_tasks_per_graph = 2;
+    // The maximum number of idle graphs kept for reuse. Graphs released
+    // beyond this are destroyed.
+    int max_idle_graphs = 16;
+    // Called on each new graph after Initialize().
+    std::function<::mediapipe::Status(CalculatorGraph*)> setup;
+  };
+
+  // Validates "config" by initializing the first graph of the pool. The
+  // config must not declare a default ("") executor.
+  static ::mediapipe::StatusOr<std::unique_ptr<CalculatorGraphPool>> Create(
+      const CalculatorGraphConfig& config, const Options& options);
+
+  CalculatorGraphPool(const CalculatorGraphPool&) = delete;
+  CalculatorGraphPool& operator=(const CalculatorGraphPool&) = delete;
+
+  // Returns an idle graph, or a newly initialized one if none is idle.
+  ::mediapipe::StatusOr<std::unique_ptr<CalculatorGraph>> Acquire();
+
+  // Returns "graph" to the pool. The graph must have been acquired from this
+  // pool and must not be running, i.e. WaitUntilDone() has returned or
+  // StartRun() was never called.
+  void Release(std::unique_ptr<CalculatorGraph> graph);
+
+  // Returns the number of idle graphs.
+  int num_idle_graphs() LOCKS_EXCLUDED(mutex_);
+
+ private:
+  CalculatorGraphPool(const CalculatorGraphConfig& config,
+                      const Options& options);
+
+  // Creates and initializes a graph that runs on the shared executor.
+  ::mediapipe::StatusOr<std::unique_ptr<CalculatorGraph>> CreateGraph();
+
+  const CalculatorGraphConfig config_;
+  Options options_;
+  absl::Mutex mutex_;
+  std::vector<std::unique_ptr<CalculatorGraph>> idle_graphs_
+      GUARDED_BY(mutex_);
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_CALCULATOR_GRAPH_POOL_H_
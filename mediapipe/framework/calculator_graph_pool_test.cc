@@ -0,0 +1,204 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/calculator_graph_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/shared_executor.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kPacketsPerSession = 10;
+
+CalculatorGraphConfig MakeChainConfig() {
+  return ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+    input_stream: "in"
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "in"
+      output_stream: "mid"
+    }
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "mid"
+      output_stream: "out"
+    }
+  )");
+}
+
+// Runs one session of kPacketsPerSession packets on "graph".
+::mediapipe::Status RunSession(CalculatorGraph* graph) {
+  RETURN_IF_ERROR(graph->StartRun({}));
+  for (int i = 0; i < kPacketsPerSession; ++i) {
+    RETURN_IF_ERROR(graph->AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  RETURN_IF_ERROR(graph->CloseAllInputStreams());
+  return graph->WaitUntilDone();
+}
+
+TEST(FairShareExecutorTest, LimitsTasksInFlight) {
+  auto shared = std::make_shared<ThreadPoolExecutor>(4);
+  auto executor = std::make_shared<FairShareExecutor>(shared, 2);
+  absl::Mutex mutex;
+  int running = 0;
+  int max_running = 0;
+  constexpr int kNumTasks = 20;
+  absl::BlockingCounter done(kNumTasks);
+  for (int i = 0; i < kNumTasks; ++i) {
+    executor->Schedule([&]() {
+      {
+        absl::MutexLock lock(&mutex);
+        ++running;
+        max_running = std::max(max_running, running);
+      }
+      absl::SleepFor(absl::Milliseconds(1));
+      {
+        absl::MutexLock lock(&mutex);
+        --running;
+      }
+      done.DecrementCount();
+    });
+  }
+  done.Wait();
+  EXPECT_LE(max_running, 2);
+  EXPECT_GE(max_running, 1);
+}
+
+TEST(SharedExecutorTest, ReturnsSameExecutorForName) {
+  std::shared_ptr<Executor> a = GetSharedThreadPoolExecutor("test_a", 2);
+  std::shared_ptr<Executor> b = GetSharedThreadPoolExecutor("test_a", 4);
+  std::shared_ptr<Executor> c = GetSharedThreadPoolExecutor("test_b", 2);
+  EXPECT_EQ(a, b);
+  EXPECT_NE(a, c);
+}
+
+TEST(CalculatorGraphPoolTest, ReusesReleasedGraphs) {
+  std::atomic<int> num_outputs(0);
+  CalculatorGraphPool::Options options;
+  options.executor = std::make_shared<ThreadPoolExecutor>(2);
+  options.setup = [&num_outputs](CalculatorGraph* graph) {
+    return graph->ObserveOutputStream("out", [&num_outputs](const Packet&) {
+      ++num_outputs;
+      return ::mediapipe::OkStatus();
+    });
+  };
+  auto pool_or = CalculatorGraphPool::Create(MakeChainConfig(), options);
+  MEDIAPIPE_ASSERT_OK(pool_or.status());
+  std::unique_ptr<CalculatorGraphPool> pool = std::move(pool_or).ValueOrDie();
+  EXPECT_EQ(1, pool->num_idle_graphs());
+
+  for (int session = 0; session < 3; ++session) {
+    auto graph_or = pool->Acquire();
+    MEDIAPIPE_ASSERT_OK(graph_or.status());
+    std::unique_ptr<CalculatorGraph> graph = std::move(graph_or).ValueOrDie();
+    EXPECT_EQ(0, pool->num_idle_graphs());
+    MEDIAPIPE_ASSERT_OK(RunSession(graph.get()));
+    pool->Release(std::move(graph));
+    EXPECT_EQ(1, pool->num_idle_graphs());
+  }
+  EXPECT_EQ(3 * kPacketsPerSession, num_outputs);
+}
+
+TEST(CalculatorGraphPoolTest, RunsConcurrentSessionsOnSharedExecutor) {
+  CalculatorGraphPool::Options options;
+  options.executor = std::make_shared<ThreadPoolExecutor>(2);
+  options.max_idle_graphs = 2;
+  auto pool_or = CalculatorGraphPool::Create(MakeChainConfig(), options);
+  MEDIAPIPE_ASSERT_OK(pool_or.status());
+  std::unique_ptr<CalculatorGraphPool> pool = std::move(pool_or).ValueOrDie();
+
+  constexpr int kNumSessions = 8;
+  std::vector<std::unique_ptr<CalculatorGraph>> graphs;
+  for (int i = 0; i < kNumSessions; ++i) {
+    auto graph_or = pool->Acquire();
+    MEDIAPIPE_ASSERT_OK(graph_or.status());
+    graphs.push_back(std::move(graph_or).ValueOrDie());
+  }
+  std::vector<std::thread> threads;
+  std::vector<::mediapipe::Status> statuses(kNumSessions);
+  for (int i = 0; i < kNumSessions; ++i) {
+    threads.emplace_back([&graphs, &statuses, i]() {
+      statuses[i] = RunSession(graphs[i].get());
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < kNumSessions; ++i) {
+    MEDIAPIPE_EXPECT_OK(statuses[i]);
+    pool->Release(std::move(graphs[i]));
+  }
+  EXPECT_EQ(2, pool->num_idle_graphs());
+}
+
+TEST(CalculatorGraphPoolTest, RejectsInvalidConfig) {
+  CalculatorGraphConfig config = MakeChainConfig();
+  config.mutable_node(0)->set_calculator("NoSuchCalculator");
+  EXPECT_FALSE(
+      CalculatorGraphPool::Create(config, CalculatorGraphPool::Options())
+          .ok());
+}
+
+// Measures sessions per second with a new graph and default thread pool per
+// session. Run with several benchmark threads to simulate concurrent sessions.
+void BM_GraphPerSession(benchmark::State& state) {
+  const CalculatorGraphConfig config = MakeChainConfig();
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    CHECK(graph.Initialize(config).ok());
+    CHECK(RunSession(&graph).ok());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GraphPerSession)->ThreadRange(1, 16)->UseRealTime();
+
+// Measures sessions per second with pooled graphs on a shared executor with a
+// fixed number of threads.
+void BM_PooledSession(benchmark::State& state) {
+  static CalculatorGraphPool* pool = []() {
+    CalculatorGraphPool::Options options;
+    options.executor = std::make_shared<ThreadPoolExecutor>(4);
+    return CalculatorGraphPool::Create(MakeChainConfig(), options)
+        .ValueOrDie()
+        .release();
+  }();
+  for (auto _ : state) {
+    std::unique_ptr<CalculatorGraph> graph = pool->Acquire().ValueOrDie();
+    CHECK(RunSession(graph.get()).ok());
+    pool->Release(std::move(graph));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PooledSession)->ThreadRange(1, 16)->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
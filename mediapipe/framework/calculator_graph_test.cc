@@ -32,6 +32,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "absl/time/clock.h"
+#include "absl/types/span.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/collection_item_id.h"
 #include "mediapipe/framework/counter_factory.h"
@@ -42,6 +43,7 @@
 #include "mediapipe/framework/output_stream_poller.h"
 #include "mediapipe/framework/packet_set.h"
 #include "mediapipe/framework/packet_type.h"
+#include "mediapipe/framework/port/benchmark.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -1140,6 +1142,29 @@ class PthreadSelfSourceCalculator : public CalculatorBase {
 };
 REGISTER_CALCULATOR(PthreadSelfSourceCalculator);
 
+// Outputs the return value of pthread_self() for each input packet. The inline
+// flavor asks to run inline, see CalculatorContract::SetProcessInline().
+template <bool kProcessInline>
+class PthreadSelfCalculatorImpl : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).Set<pthread_t>();
+    cc->SetProcessInline(kProcessInline);
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    cc->Outputs().Index(0).AddPacket(
+        MakePacket<pthread_t>(pthread_self()).At(cc->InputTimestamp()));
+    return ::mediapipe::OkStatus();
+  }
+};
+typedef PthreadSelfCalculatorImpl<false> PthreadSelfCalculator;
+REGISTER_CALCULATOR(PthreadSelfCalculator);
+typedef PthreadSelfCalculatorImpl<true> InlinePthreadSelfCalculator;
+REGISTER_CALCULATOR(InlinePthreadSelfCalculator);
+
 // A source calculator for testing the Calculator::InputTimestamp() method.
 // It outputs five int packets with timestamps 0, 1, 2, 3, 4.
 class CheckInputTimestampSourceCalculator : public CalculatorBase {
@@ -1863,6 +1888,28 @@ TEST(CalculatorGraph, RunsCorrectlyWithMultipleExecutors) {
   RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
 }
 
+// Runs the graph on executors bound to NUMA node 0, with one thread per
+// processor. Binding is best effort, so this only checks that the graph runs.
+TEST(CalculatorGraph, RunsCorrectlyWithNumaNodeExecutors) {
+  CalculatorGraph graph;
+  CalculatorGraphConfig proto = GetConfig();
+  for (const std::string& name : {"second", "third"}) {
+    ExecutorConfig* executor = proto.add_executor();
+    executor->set_name(name);
+    executor->set_type("ThreadPoolExecutor");
+    ThreadPoolExecutorOptions* extension =
+        executor->mutable_options()->MutableExtension(
+            ThreadPoolExecutorOptions::ext);
+    extension->set_num_threads(2);
+    extension->set_numa_node(0);
+    extension->set_pin_threads_to_cores(true);
+  }
+  for (int i = 0; i < proto.node_size(); ++i) {
+    proto.mutable_node(i)->set_executor(i % 2 == 0 ? "second" : "third");
+  }
+  RunComprehensiveTest(&graph, proto, /*define_node_5=*/true);
+}
+
 // Packet generator for an arbitrary unit64 packet.
 class Uint64PacketGenerator : public PacketGenerator {
  public:
@@ -4920,6 +4967,134 @@ TEST(CalculatorGraph, RunWithNumThreadsInExecutorConfig) {
   }
 }
 
+// Verifies that a node that asks to run inline runs on the thread of the node
+// that made it ready, unless that node runs on another executor.
+TEST(CalculatorGraph, ProcessInlineRunsOnProducerThread) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        num_threads: 4
+        executor {
+          name: 'other'
+          type: 'ThreadPoolExecutor'
+          options {
+            [mediapipe.ThreadPoolExecutorOptions.ext] { num_threads: 1 }
+          }
+        }
+        node {
+          calculator: 'PthreadSelfCalculator'
+          input_stream: 'in'
+          output_stream: 'producer'
+        }
+        node {
+          calculator: 'InlinePthreadSelfCalculator'
+          input_stream: 'producer'
+          output_stream: 'consumer'
+        }
+        node {
+          calculator: 'InlinePthreadSelfCalculator'
+          input_stream: 'producer'
+          output_stream: 'other_consumer'
+          executor: 'other'
+        }
+      )");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  std::vector<Packet> producer, consumer, other_consumer;
+  MEDIAPIPE_ASSERT_OK(graph.ObserveOutputStream(
+      "producer", [&producer](const Packet& packet) {
+        producer.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MEDIAPIPE_ASSERT_OK(graph.ObserveOutputStream(
+      "consumer", [&consumer](const Packet& packet) {
+        consumer.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MEDIAPIPE_ASSERT_OK(graph.ObserveOutputStream(
+      "other_consumer", [&other_consumer](const Packet& packet) {
+        other_consumer.push_back(packet);
+        return ::mediapipe::OkStatus();
+      }));
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  const int kNumPackets = 20;
+  for (int i = 0; i < kNumPackets; ++i) {
+    MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+
+  ASSERT_EQ(kNumPackets, producer.size());
+  ASSERT_EQ(kNumPackets, consumer.size());
+  ASSERT_EQ(kNumPackets, other_consumer.size());
+  for (int i = 0; i < kNumPackets; ++i) {
+    EXPECT_EQ(Timestamp(i), consumer[i].Timestamp());
+    EXPECT_TRUE(pthread_equal(producer[i].Get<pthread_t>(),
+                              consumer[i].Get<pthread_t>()))
+        << "at timestamp " << i;
+    EXPECT_FALSE(pthread_equal(producer[i].Get<pthread_t>(),
+                               other_consumer[i].Get<pthread_t>()))
+        << "at timestamp " << i;
+  }
+}
+
+// Verifies that the calculators of a fused chain run on one thread.
+TEST(CalculatorGraph, FuseCalculatorChainsRunsChainOnOneThread) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: 'in'
+        num_threads: 4
+        fuse_calculator_chains: true
+        node {
+          calculator: 'PthreadSelfCalculator'
+          input_stream: 'in'
+          output_stream: 'thread_1'
+        }
+        node {
+          calculator: 'PthreadSelfCalculator'
+          input_stream: 'thread_1'
+          output_stream: 'thread_2'
+        }
+        node {
+          calculator: 'PthreadSelfCalculator'
+          input_stream: 'thread_2'
+          output_stream: 'thread_3'
+        }
+      )");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  std::vector<Packet> threads[3];
+  for (int i = 0; i < 3; ++i) {
+    std::vector<Packet>* packets = &threads[i];
+    MEDIAPIPE_ASSERT_OK(graph.ObserveOutputStream(
+        absl::StrCat("thread_", i + 1), [packets](const Packet& packet) {
+          packets->push_back(packet);
+          return ::mediapipe::OkStatus();
+        }));
+  }
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  const int kNumPackets = 20;
+  for (int i = 0; i < kNumPackets; ++i) {
+    MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+        "in", MakePacket<int>(i).At(Timestamp(i))));
+  }
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(kNumPackets, threads[i].size());
+  }
+  for (int i = 0; i < kNumPackets; ++i) {
+    EXPECT_TRUE(pthread_equal(threads[0][i].Get<pthread_t>(),
+                              threads[1][i].Get<pthread_t>()))
+        << "at timestamp " << i;
+    EXPECT_TRUE(pthread_equal(threads[0][i].Get<pthread_t>(),
+                              threads[2][i].Get<pthread_t>()))
+        << "at timestamp " << i;
+  }
+}
+
 TEST(CalculatorGraph, CalculatorGraphNotInitialized) {
   CalculatorGraph graph;
   EXPECT_FALSE(graph.Run().ok());
@@ -5187,6 +5362,77 @@ TEST(CalculatorGraph, GraphInputStreamWithTag) {
   ASSERT_EQ(5, packet_dump.size());
 }
 
+TEST(CalculatorGraph, AddPacketsToInputStreamWithHandle) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "in"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+      )");
+  std::vector<Packet> packet_dump;
+  tool::AddVectorSink("out", &config, &packet_dump);
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  EXPECT_FALSE(graph.GetInputStreamHandle("out").ok());
+  auto status_or_handle = graph.GetInputStreamHandle("in");
+  MEDIAPIPE_ASSERT_OK(status_or_handle.status());
+  const CalculatorGraph::GraphInputStreamHandle handle =
+      status_or_handle.ValueOrDie();
+  EXPECT_TRUE(handle.IsValid());
+
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  EXPECT_FALSE(graph
+                   .AddPacketsToInputStream(
+                       CalculatorGraph::GraphInputStreamHandle(),
+                       {MakePacket<int>(0).At(Timestamp(0))})
+                   .ok());
+  for (int batch = 0; batch < 3; ++batch) {
+    std::vector<Packet> packets;
+    for (int i = 0; i < 4; ++i) {
+      const int value = batch * 4 + i;
+      packets.push_back(MakePacket<int>(value).At(Timestamp(value)));
+    }
+    MEDIAPIPE_ASSERT_OK(graph.AddPacketsToInputStream(handle, packets));
+  }
+  MEDIAPIPE_ASSERT_OK(graph.AddPacketsToInputStream(handle, {}));
+  // The per-packet API can be mixed with batches.
+  MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+      "in", MakePacket<int>(12).At(Timestamp(12))));
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllPacketSources());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(13, packet_dump.size());
+  for (int i = 0; i < packet_dump.size(); ++i) {
+    EXPECT_EQ(i, packet_dump[i].Get<int>());
+    EXPECT_EQ(Timestamp(i), packet_dump[i].Timestamp());
+  }
+}
+
+TEST(CalculatorGraph, AddPacketsToInputStreamRejectsUnorderedBatch) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "in"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+      )");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  auto status_or_handle = graph.GetInputStreamHandle("in");
+  MEDIAPIPE_ASSERT_OK(status_or_handle.status());
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  const std::vector<Packet> packets = {MakePacket<int>(0).At(Timestamp(1)),
+                                       MakePacket<int>(1).At(Timestamp(0))};
+  graph.AddPacketsToInputStream(status_or_handle.ValueOrDie(), packets)
+      .IgnoreError();
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllPacketSources());
+  EXPECT_FALSE(graph.WaitUntilDone().ok());
+}
+
 // Returns the first packet of the input stream.
 class FirstPacketFilterCalculator : public CalculatorBase {
  public:
@@ -5554,6 +5800,75 @@ TEST(CalculatorGraph, TestPollPacketsFromMultipleStreams) {
   EXPECT_EQ(kDefaultMaxCount, num_packets2);
 }
 
+TEST(CalculatorGraph, TestPollPacketsInBatches) {
+  CalculatorGraphConfig config;
+  CalculatorGraphConfig::Node* node = config.add_node();
+  node->set_calculator("CountingSourceCalculator");
+  node->add_output_stream("output");
+  node->add_input_side_packet("MAX_COUNT:max_count");
+
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  auto status_or_poller = graph.AddOutputStreamPoller("output");
+  ASSERT_TRUE(status_or_poller.ok());
+  OutputStreamPoller poller = std::move(status_or_poller.ValueOrDie());
+  MEDIAPIPE_ASSERT_OK(
+      graph.StartRun({{"max_count", MakePacket<int>(kDefaultMaxCount)}}));
+  std::vector<Packet> packets;
+  while (poller.NextBatch(&packets, 3, absl::InfiniteDuration())) {
+    EXPECT_LE(packets.size(), kDefaultMaxCount);
+  }
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllPacketSources());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(kDefaultMaxCount, packets.size());
+  for (int i = 0; i < packets.size(); ++i) {
+    EXPECT_EQ(i, packets[i].Get<int>());
+  }
+}
+
+TEST(CalculatorGraph, TestTryNextWithReadyCallback) {
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "in"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+      )");
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  auto status_or_poller = graph.AddOutputStreamPoller("out");
+  ASSERT_TRUE(status_or_poller.ok());
+  OutputStreamPoller poller = std::move(status_or_poller.ValueOrDie());
+  std::atomic<int> num_ready_calls(0);
+  poller.SetReadyCallback([&num_ready_calls]() { ++num_ready_calls; });
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+
+  // Nothing is available yet.
+  Packet packet;
+  ASSERT_TRUE(poller.TryNext(&packet));
+  EXPECT_TRUE(packet.IsEmpty());
+  std::vector<Packet> packets;
+  ASSERT_TRUE(poller.NextBatch(&packets, 10, absl::Milliseconds(10)));
+  EXPECT_TRUE(packets.empty());
+
+  MEDIAPIPE_ASSERT_OK(
+      graph.AddPacketToInputStream("in", MakePacket<int>(7).At(Timestamp(0))));
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilIdle());
+  EXPECT_GT(num_ready_calls, 0);
+  ASSERT_TRUE(poller.TryNext(&packet));
+  ASSERT_FALSE(packet.IsEmpty());
+  EXPECT_EQ(7, packet.Get<int>());
+
+  const int num_ready_calls_before_close = num_ready_calls;
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllPacketSources());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  EXPECT_GT(num_ready_calls, num_ready_calls_before_close);
+  EXPECT_FALSE(poller.TryNext(&packet));
+  EXPECT_FALSE(poller.NextBatch(&packets, 10, absl::ZeroDuration()));
+}
+
 // Ensure that when a custom input stream handler is used to handle packets from
 // input streams, an error message is outputted with the appropriate link to
 // resolve the issue when the calculator doesn't handle inputs in monotonically
@@ -5614,5 +5929,58 @@ TEST(CalculatorGraph, SimpleMuxCalculatorWithCustomInputStreamHandler) {
           testing::HasSubstr("ImmediateInputStreamHandler class comment")));
 }
 
+// Measures the rate at which packets enter a graph input stream that feeds a
+// PassThroughCalculator. The argument is the batch size passed to
+// AddPacketsToInputStream(), or 0 for AddPacketToInputStream() by name.
+void BM_AddPacketsToInputStream(benchmark::State& state) {
+  constexpr int kNumPackets = 4096;
+  const int batch_size = state.range(0);
+  CalculatorGraphConfig config =
+      ::mediapipe::ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+        input_stream: "in"
+        node {
+          calculator: "PassThroughCalculator"
+          input_stream: "in"
+          output_stream: "out"
+        }
+      )");
+  std::vector<Packet> packets;
+  for (int i = 0; i < kNumPackets; ++i) {
+    packets.push_back(MakePacket<int>(i).At(Timestamp(i)));
+  }
+  for (auto _ : state) {
+    CalculatorGraph graph;
+    MEDIAPIPE_CHECK_OK(graph.Initialize(config));
+    int num_received = 0;
+    MEDIAPIPE_CHECK_OK(
+        graph.ObserveOutputStream("out", [&num_received](const Packet&) {
+          ++num_received;
+          return ::mediapipe::OkStatus();
+        }));
+    auto handle = graph.GetInputStreamHandle("in").ValueOrDie();
+    MEDIAPIPE_CHECK_OK(graph.StartRun({}));
+    if (batch_size == 0) {
+      for (const Packet& packet : packets) {
+        MEDIAPIPE_CHECK_OK(graph.AddPacketToInputStream("in", packet));
+      }
+    } else {
+      for (int begin = 0; begin < kNumPackets; begin += batch_size) {
+        MEDIAPIPE_CHECK_OK(graph.AddPacketsToInputStream(
+            handle, absl::MakeConstSpan(packets).subspan(begin, batch_size)));
+      }
+    }
+    MEDIAPIPE_CHECK_OK(graph.CloseAllPacketSources());
+    MEDIAPIPE_CHECK_OK(graph.WaitUntilDone());
+    CHECK_EQ(kNumPackets, num_received);
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPackets);
+}
+BENCHMARK(BM_AddPacketsToInputStream)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(16)
+    ->Arg(256)
+    ->UseRealTime();
+
 }  // namespace
 }  // namespace mediapipe
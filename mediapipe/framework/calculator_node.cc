@@ -100,6 +100,8 @@ Timestamp CalculatorNode::SourceProcessOrder(
   uses_gpu_ =
       node_type_info.InputSidePacketTypes().HasTag(kGpuSharedTagName) ||
       ContainsKey(node_type_info.Contract().ServiceRequests(), kGpuService.key);
+  process_inline_ = node_type_info.Contract().ProcessInline() ||
+                    node_type_info.FusedWithProducer();
 
   // TODO Propagate types between calculators when SetAny is used.
 
@@ -290,6 +292,10 @@ void CalculatorNode::SetExecutor(const std::string& executor) {
   executor_ = executor;
 }
 
+void CalculatorNode::SetCalculatorExecutor(::mediapipe::Executor* executor) {
+  calculator_state_->SetExecutor(executor);
+}
+
 bool CalculatorNode::Prepared() const {
   absl::MutexLock status_lock(&status_mutex_);
   return status_ >= kStatePrepared;
@@ -534,6 +540,9 @@ void CalculatorNode::CleanupAfterRun(const ::mediapipe::Status& graph_status) {
     CloseNode(graph_status, /*graph_run_ended=*/true).IgnoreError();
   }
   calculator_ = nullptr;
+  // Report the skipped notifications while the default context still exists,
+  // since the input streams are only closed after it has been destroyed.
+  input_stream_handler_->FlushSuppressedNotifications();
   // All pending output packets are automatically dropped when calculator
   // context manager destroys all calculator context objects.
   calculator_context_manager_.CleanupAfterRun();
@@ -94,6 +94,11 @@ class CalculatorNode {
   // Changes the executor a node is assigned to.
   void SetExecutor(const std::string& executor);
 
+  // Makes the executor that runs the node available to the calculator through
+  // CalculatorContext::GetExecutor(). Called by the CalculatorGraph when the
+  // node is assigned to a scheduler queue.
+  void SetCalculatorExecutor(::mediapipe::Executor* executor);
+
   // Calls Process() on the Calculator corresponding to this node.
   ::mediapipe::Status ProcessNode(CalculatorContext* calculator_context);
 
@@ -196,6 +201,10 @@ class CalculatorNode {
   // Returns whether this is a GPU calculator node.
   bool UsesGpu() const { return uses_gpu_; }
 
+  // Returns whether the calculator asked to run inline, see
+  // CalculatorContract::SetProcessInline().
+  bool ProcessInline() const { return process_inline_; }
+
   // Returns the scheduler queue the node is assigned to.
   internal::SchedulerQueue* GetSchedulerQueue() const {
     return scheduler_queue_;
@@ -360,6 +369,10 @@ class CalculatorNode {
   // Whether this is a GPU calculator.
   bool uses_gpu_ = false;
 
+  // Whether the calculator can run on the thread of the node that made it
+  // ready.
+  bool process_inline_ = false;
+
   // True if CleanupAfterRun() needs to call CloseNode().
   bool needs_to_close_ = false;
 
@@ -19,6 +19,7 @@
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status.h"
@@ -30,6 +31,10 @@ const char CalculatorRunner::kSinkPrefix[] = "sink_for_";
 
 namespace {
 
+// The number of 1 us intervals of the Process() runtime histogram in benchmark
+// mode. Longer calls fall into the last interval.
+constexpr int kBenchmarkHistogramIntervals = 10000;
+
 // Calculator generating a stream with the given contents.
 // Inputs: none
 // Outputs: 1, with the contents provided via the input side packet.
@@ -280,6 +285,26 @@ std::map<std::string, int64> CalculatorRunner::GetCountersValues() {
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status CalculatorRunner::AddCalculatorSidePackets(
+    std::map<std::string, Packet>* input_side_packets) {
+  int positional_index = -1;
+  for (int i = 0; i < node_config_.input_side_packet_size(); ++i) {
+    std::string name;
+    std::string tag;
+    int index;
+    RETURN_IF_ERROR(tool::ParseTagIndexName(node_config_.input_side_packet(i),
+                                            &tag, &index, &name));
+    const Packet* packet;
+    if (index == -1) {
+      packet = &input_side_packets_->Get(tag, ++positional_index);
+    } else {
+      packet = &input_side_packets_->Get(tag, index);
+    }
+    input_side_packets->emplace(name, *packet);
+  }
+  return ::mediapipe::OkStatus();
+}
+
 ::mediapipe::Status CalculatorRunner::Run() {
   RETURN_IF_ERROR(BuildGraph());
   // Set the input side packets for the sources.
@@ -304,22 +329,7 @@ std::map<std::string, int64> CalculatorRunner::GetCountersValues() {
     input_side_packets.emplace(absl::StrCat(kSourcePrefix, name),
                                Adopt(new auto(contents)));
   }
-  // Set the input side packets for the calculator.
-  positional_index = -1;
-  for (int i = 0; i < node_config_.input_side_packet_size(); ++i) {
-    std::string name;
-    std::string tag;
-    int index;
-    RETURN_IF_ERROR(tool::ParseTagIndexName(node_config_.input_side_packet(i),
-                                            &tag, &index, &name));
-    const Packet* packet;
-    if (index == -1) {
-      packet = &input_side_packets_->Get(tag, ++positional_index);
-    } else {
-      packet = &input_side_packets_->Get(tag, index);
-    }
-    input_side_packets.emplace(name, *packet);
-  }
+  RETURN_IF_ERROR(AddCalculatorSidePackets(&input_side_packets));
   // Set the input side packets for the sinks.
   positional_index = -1;
   for (int i = 0; i < node_config_.output_stream_size(); ++i) {
@@ -355,4 +365,81 @@ std::map<std::string, int64> CalculatorRunner::GetCountersValues() {
   return ::mediapipe::OkStatus();
 }
 
+::mediapipe::Status CalculatorRunner::StartBenchmark() {
+  RET_CHECK(!benchmark_graph_) << "StartBenchmark() was already called.";
+  RET_CHECK(inputs_) << "The inputs were not initialized.";
+  RET_CHECK(input_side_packets_)
+      << "The input side packets were not initialized.";
+
+  CalculatorGraphConfig config;
+  *config.add_node() = node_config_;
+  config.set_num_threads(1);
+  ProfilerConfig* profiler_config = config.mutable_profiler_config();
+  profiler_config->set_enable_profiler(true);
+  profiler_config->set_histogram_interval_size_usec(1);
+  profiler_config->set_num_histogram_intervals(kBenchmarkHistogramIntervals);
+  std::map<std::string, Packet> stream_headers;
+  benchmark_input_streams_.clear();
+  int positional_index = -1;
+  for (int i = 0; i < node_config_.input_stream_size(); ++i) {
+    std::string name;
+    std::string tag;
+    int index;
+    RETURN_IF_ERROR(tool::ParseTagIndexName(node_config_.input_stream(i), &tag,
+                                            &index, &name));
+    const StreamContents& contents =
+        inputs_->Get(tag, index == -1 ? ++positional_index : index);
+    config.add_input_stream(name);
+    benchmark_input_streams_.push_back(name);
+    if (!contents.header.IsEmpty()) {
+      stream_headers.emplace(name, contents.header);
+    }
+  }
+  std::map<std::string, Packet> input_side_packets;
+  RETURN_IF_ERROR(AddCalculatorSidePackets(&input_side_packets));
+
+  auto graph = absl::make_unique<CalculatorGraph>();
+  RETURN_IF_ERROR(graph->Initialize(config));
+  RETURN_IF_ERROR(graph->StartRun(input_side_packets, stream_headers));
+  // Wait for Open() so that it is not attributed to the first Process() call.
+  RETURN_IF_ERROR(graph->WaitUntilIdle());
+  benchmark_graph_ = std::move(graph);
+  benchmark_timestamp_ = 0;
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status CalculatorRunner::ProcessForBenchmark(
+    std::vector<Packet> inputs) {
+  RET_CHECK(benchmark_graph_) << "StartBenchmark() was not called.";
+  RET_CHECK_EQ(benchmark_input_streams_.size(), inputs.size());
+  const Timestamp timestamp(benchmark_timestamp_++);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    RETURN_IF_ERROR(benchmark_graph_->AddPacketToInputStream(
+        benchmark_input_streams_[i], std::move(inputs[i]).At(timestamp)));
+  }
+  return benchmark_graph_->WaitUntilIdle();
+}
+
+::mediapipe::Status CalculatorRunner::GetBenchmarkProcessRuntime(
+    TimeHistogram* histogram) {
+  RET_CHECK(benchmark_graph_) << "StartBenchmark() was not called.";
+  std::vector<CalculatorProfile> profiles;
+  RETURN_IF_ERROR(
+      benchmark_graph_->profiler()->GetCalculatorProfiles(&profiles));
+  if (profiles.empty()) {
+    return ::mediapipe::UnavailableError(
+        "The graph profiler is not available in this build.");
+  }
+  RET_CHECK_EQ(1, profiles.size());
+  *histogram = profiles[0].process_runtime();
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status CalculatorRunner::FinishBenchmark() {
+  RET_CHECK(benchmark_graph_) << "StartBenchmark() was not called.";
+  std::unique_ptr<CalculatorGraph> graph = std::move(benchmark_graph_);
+  RETURN_IF_ERROR(graph->CloseAllInputStreams());
+  return graph->WaitUntilDone();
+}
+
 }  // namespace mediapipe
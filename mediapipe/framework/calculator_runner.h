@@ -18,12 +18,14 @@
 #ifndef MEDIAPIPE_FRAMEWORK_CALCULATOR_RUNNER_H_
 #define MEDIAPIPE_FRAMEWORK_CALCULATOR_RUNNER_H_
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/base/macros.h"
 #include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_profile.pb.h"
 #include "mediapipe/framework/port/status.h"
 
 namespace mediapipe {
@@ -124,6 +126,34 @@ class CalculatorRunner {
   // Returns the access to the output side packets.
   const PacketSet& OutputSidePackets() { return *output_side_packets_.get(); }
 
+  // Benchmark mode. Unlike Run(), which replays prefilled inputs through a
+  // fresh run, these methods keep one opened calculator and feed it one
+  // timestamp at a time, so that each ProcessForBenchmark() call measures a
+  // single Process() call. See calculator_benchmark.h for the google-benchmark
+  // wrapper.
+  //
+  // StartBenchmark() builds a separate graph in which the node reads from
+  // graph input streams, with the headers from MutableInputs() and the input
+  // side packets from MutableSidePackets(), and opens the calculator. Output
+  // packets are discarded and Outputs() is not updated. The graph profiler is
+  // enabled, with a histogram of the Process() runtime in 1 us intervals.
+  ::mediapipe::Status StartBenchmark();
+
+  // Sends "inputs", one packet per input stream in the order of the
+  // input_stream fields of the node config, at the next timestamp, and waits
+  // until the calculator has processed them. The timestamps of "inputs" are
+  // ignored.
+  ::mediapipe::Status ProcessForBenchmark(std::vector<Packet> inputs);
+
+  // Returns the histogram of the runtime of the Process() calls made so far,
+  // as recorded by the graph profiler. This covers only the calculator, not
+  // the delivery of its inputs and outputs. Fails if the profiler is not
+  // available in this build.
+  ::mediapipe::Status GetBenchmarkProcessRuntime(TimeHistogram* histogram);
+
+  // Closes the calculator and releases the benchmark graph.
+  ::mediapipe::Status FinishBenchmark();
+
   // Returns a graph counter.
   mediapipe::Counter* GetCounter(const std::string& name);
 
@@ -141,6 +171,10 @@ class CalculatorRunner {
   // Builds the graph if one does not already exist.
   ::mediapipe::Status BuildGraph();
 
+  // Adds the input side packets of the calculator to "input_side_packets".
+  ::mediapipe::Status AddCalculatorSidePackets(
+      std::map<std::string, Packet>* input_side_packets);
+
   CalculatorGraphConfig::Node node_config_;
 
   // Log the calculator proto after it is created from the provided
@@ -153,6 +187,12 @@ class CalculatorRunner {
   std::unique_ptr<PacketSet> input_side_packets_;
   std::unique_ptr<PacketSet> output_side_packets_;
   std::unique_ptr<CalculatorGraph> graph_;
+
+  // The graph used in benchmark mode, its input stream names and the next
+  // input timestamp.
+  std::unique_ptr<CalculatorGraph> benchmark_graph_;
+  std::vector<std::string> benchmark_input_streams_;
+  int64 benchmark_timestamp_ = 0;
 };
 
 }  // namespace mediapipe
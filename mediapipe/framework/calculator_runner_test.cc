@@ -114,6 +114,33 @@ class CalculatorRunnerMultiTagTestCalculator : public CalculatorBase {
 };
 REGISTER_CALCULATOR(CalculatorRunnerMultiTagTestCalculator);
 
+// Inputs: any number of streams of integers.
+// Input side packets: 1, pointing to a std::vector<int>.
+// Appends the input integers of each Process() call to the vector, in the
+// order of the input streams.
+class CalculatorRunnerRecordingTestCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    for (CollectionItemId id = cc->Inputs().BeginId();
+         id < cc->Inputs().EndId(); ++id) {
+      cc->Inputs().Get(id).Set<int>();
+    }
+    cc->InputSidePackets().Index(0).Set<std::vector<int>*>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) override {
+    std::vector<int>* values =
+        cc->InputSidePackets().Index(0).Get<std::vector<int>*>();
+    for (CollectionItemId id = cc->Inputs().BeginId();
+         id < cc->Inputs().EndId(); ++id) {
+      values->push_back(cc->Inputs().Get(id).Get<int>());
+    }
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(CalculatorRunnerRecordingTestCalculator);
+
 TEST(CalculatorRunner, RunsCalculator) {
   CalculatorRunner runner(R"(
       calculator: "CalculatorRunnerTestCalculator"
@@ -235,5 +262,37 @@ TEST(CalculatorRunner, MultiTagTestInvalidStreamTagCrashes) {
                "\"a_0\" but is being reassigned a name \"a_1\"");
 }
 
+TEST(CalculatorRunner, ProcessesOneTimestampPerBenchmarkCall) {
+  CalculatorRunner runner(R"(
+      calculator: "CalculatorRunnerRecordingTestCalculator"
+      input_stream: "B:input_b"
+      input_stream: "A:input_a"
+      input_side_packet: "values"
+  )");
+  std::vector<int> values;
+  runner.MutableSidePackets()->Index(0) =
+      MakePacket<std::vector<int>*>(&values);
+  MEDIAPIPE_ASSERT_OK(runner.StartBenchmark());
+  // The packets follow the order of the input_stream fields, and each call
+  // returns once the calculator has processed them.
+  for (int i = 0; i < 3; ++i) {
+    MEDIAPIPE_ASSERT_OK(runner.ProcessForBenchmark(
+        {MakePacket<int>(2 * i), MakePacket<int>(2 * i + 1)}));
+    ASSERT_EQ(2 * i + 2, values.size());
+    // The calculator sees the inputs in tag order.
+    EXPECT_EQ(2 * i + 1, values[2 * i]);
+    EXPECT_EQ(2 * i, values[2 * i + 1]);
+  }
+  EXPECT_FALSE(runner.ProcessForBenchmark({MakePacket<int>(0)}).ok());
+  // The profiler records the runtime of each Process() call.
+  TimeHistogram process_runtime;
+  MEDIAPIPE_ASSERT_OK(runner.GetBenchmarkProcessRuntime(&process_runtime));
+  int64 num_calls = 0;
+  for (const int64 count : process_runtime.count()) num_calls += count;
+  EXPECT_EQ(3, num_calls);
+  MEDIAPIPE_ASSERT_OK(runner.FinishBenchmark());
+  EXPECT_FALSE(runner.ProcessForBenchmark({}).ok());
+}
+
 }  // namespace
 }  // namespace mediapipe
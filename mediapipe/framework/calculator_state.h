@@ -35,6 +35,7 @@
 
 namespace mediapipe {
 
+class Executor;
 class ProfilingContext;
 // Holds data that the Calculator needs access to.  This data is not
 // stored in Calculator directly since Calculator will be destroyed after
@@ -92,6 +93,10 @@ class CalculatorState {
     return profiling_context_;
   }
 
+  // Returns the executor that runs this calculator's node, or nullptr if the
+  // node runs on the application thread.
+  Executor* GetExecutor() const { return executor_; }
+
   ////////////////////////////////////////
   // Interface for CalculatorNode.
   ////////////////////////////////////////
@@ -104,6 +109,9 @@ class CalculatorState {
     counter_factory_ = counter_factory;
   }
 
+  // Sets the executor returned by GetExecutor().
+  void SetExecutor(Executor* executor) { executor_ = executor; }
+
   void SetServicePacket(const std::string& key, Packet packet);
 
   bool IsServiceAvailable(const GraphServiceBase& service) {
@@ -136,6 +144,9 @@ class CalculatorState {
 
   std::map<std::string, Packet> service_packets_;
 
+  // The executor of this calculator's node. Owned by the CalculatorGraph.
+  Executor* executor_ = nullptr;
+
   ////////////////////////////////////////
   // Variables which ARE cleared by ResetBetweenRuns().
   ////////////////////////////////////////
@@ -26,7 +26,8 @@ namespace mediapipe {
 // the field descriptions.
 class ThreadOptions {
  public:
-  ThreadOptions() : stack_size_(0), nice_priority_level_(0) {}
+  ThreadOptions()
+      : stack_size_(0), nice_priority_level_(0), one_cpu_per_thread_(false) {}
 
   // Set the thread stack size (in bytes).  Passing stack_size==0 resets
   // the stack size to the default value for the system. The system default
@@ -46,6 +47,13 @@ class ThreadOptions {
     return *this;
   }
 
+  // If true, each thread is pinned to a single CPU of cpu_set(), taken in turn,
+  // rather than to the whole set. Has no effect if cpu_set() is empty.
+  ThreadOptions& set_one_cpu_per_thread(bool one_cpu_per_thread) {
+    one_cpu_per_thread_ = one_cpu_per_thread;
+    return *this;
+  }
+
   ThreadOptions& set_name_prefix(const std::string& name_prefix) {
     name_prefix_ = name_prefix;
     return *this;
@@ -57,12 +65,15 @@ class ThreadOptions {
 
   const std::set<int>& cpu_set() const { return cpu_set_; }
 
+  bool one_cpu_per_thread() const { return one_cpu_per_thread_; }
+
   std::string name_prefix() const { return name_prefix_; }
 
  private:
   size_t stack_size_;        // Size of thread stack
   int nice_priority_level_;  // Nice priority level of the workers
   std::set<int> cpu_set_;    // CPU set for affinity setting
+  bool one_cpu_per_thread_;  // Whether each thread gets one CPU of cpu_set_
   std::string name_prefix_;  // Name of the thread
 };
 
@@ -20,6 +20,9 @@
 #include <sys/syscall.h>
 #include <unistd.h>
 
+#include <iterator>
+#include <set>
+
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "mediapipe/framework/port/logging.h"
@@ -28,8 +31,9 @@ namespace mediapipe {
 
 class ThreadPool::WorkerThread {
  public:
-  // Creates and starts a thread that runs pool->RunWorker().
-  WorkerThread(ThreadPool* pool, const std::string& name_prefix);
+  // Creates and starts a thread that runs pool->RunWorker(). "index" is the
+  // position of the thread in the pool.
+  WorkerThread(ThreadPool* pool, const std::string& name_prefix, int index);
 
   // REQUIRES: Join() must have been called.
   ~WorkerThread();
@@ -40,14 +44,20 @@ class ThreadPool::WorkerThread {
  private:
   static void* ThreadBody(void* arg);
 
+  // Returns the CPUs this thread should run on, or an empty set if the
+  // thread is not pinned.
+  std::set<int> SelectedCpus() const;
+
   ThreadPool* pool_;
   std::string name_prefix_;
+  int index_;
   pthread_t thread_;
 };
 
 ThreadPool::WorkerThread::WorkerThread(ThreadPool* pool,
-                                       const std::string& name_prefix)
-    : pool_(pool), name_prefix_(name_prefix) {
+                                       const std::string& name_prefix,
+                                       int index)
+    : pool_(pool), name_prefix_(name_prefix), index_(index) {
   pthread_create(&thread_, nullptr, ThreadBody, this);
 }
 
@@ -55,11 +65,22 @@ ThreadPool::WorkerThread::~WorkerThread() {}
 
 void ThreadPool::WorkerThread::Join() { pthread_join(thread_, nullptr); }
 
+std::set<int> ThreadPool::WorkerThread::SelectedCpus() const {
+  const ThreadOptions& thread_options = pool_->thread_options();
+  const std::set<int>& cpu_set = thread_options.cpu_set();
+  if (!thread_options.one_cpu_per_thread() || cpu_set.empty()) {
+    return cpu_set;
+  }
+  auto cpu = cpu_set.begin();
+  std::advance(cpu, index_ % cpu_set.size());
+  return {*cpu};
+}
+
 void* ThreadPool::WorkerThread::ThreadBody(void* arg) {
   auto thread = reinterpret_cast<WorkerThread*>(arg);
   int nice_priority_level =
       thread->pool_->thread_options().nice_priority_level();
-  const std::set<int> selected_cpus = thread->pool_->thread_options().cpu_set();
+  const std::set<int> selected_cpus = thread->SelectedCpus();
   const std::string name =
       internal::CreateThreadName(thread->name_prefix_, syscall(SYS_gettid));
 #if defined(__linux__)
@@ -140,7 +161,7 @@ ThreadPool::~ThreadPool() {
 
 void ThreadPool::StartWorkers() {
   for (int i = 0; i < num_threads_; ++i) {
-    threads_.push_back(new WorkerThread(this, name_prefix_));
+    threads_.push_back(new WorkerThread(this, name_prefix_, i));
   }
 }
 
@@ -14,6 +14,8 @@
 
 #include "mediapipe/framework/deps/threadpool.h"
 
+#include <sched.h>
+
 #include <set>
 
 #include "absl/synchronization/mutex.h"
@@ -91,6 +93,47 @@ TEST(ThreadPoolTest, CreateWithCPUAffinity) {
   thread_pool.StartWorkers();
 }
 
+#if defined(__linux__)
+TEST(ThreadPoolTest, PinsEachThreadToOneCpu) {
+  cpu_set_t process_cpus;
+  CPU_ZERO(&process_cpus);
+  ASSERT_EQ(0, sched_getaffinity(0, sizeof(cpu_set_t), &process_cpus));
+  std::set<int> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &process_cpus)) {
+      cpus.insert(cpu);
+    }
+  }
+  ThreadOptions thread_options =
+      ThreadOptions().set_cpu_set(cpus).set_one_cpu_per_thread(true);
+  absl::Mutex mu;
+  std::set<int> worker_cpus;
+  bool pinned = true;
+  {
+    ThreadPool thread_pool(thread_options, "testpool", cpus.size());
+    thread_pool.StartWorkers();
+    for (int i = 0; i < 100; ++i) {
+      thread_pool.Schedule([&mu, &worker_cpus, &pinned]() {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set);
+        absl::MutexLock l(&mu);
+        pinned = pinned && CPU_COUNT(&cpu_set) == 1;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+          if (CPU_ISSET(cpu, &cpu_set)) {
+            worker_cpus.insert(cpu);
+          }
+        }
+      });
+    }
+  }
+  EXPECT_TRUE(pinned);
+  for (int cpu : worker_cpus) {
+    EXPECT_EQ(1, cpus.count(cpu));
+  }
+}
+#endif  // defined(__linux__)
+
 TEST(ThreadPoolTest, CreateThreadName) {
   ASSERT_EQ("name_prefix/123", internal::CreateThreadName("name_prefix", 1234));
   ASSERT_EQ("name_prefix/123",
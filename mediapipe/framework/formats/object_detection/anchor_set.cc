@@ -0,0 +1,55 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/formats/object_detection/anchor_set.h"
+
+namespace mediapipe {
+
+void AnchorSet::Reserve(int size) {
+  x_center.reserve(size);
+  y_center.reserve(size);
+  h.reserve(size);
+  w.reserve(size);
+}
+
+void AnchorSet::Add(float anchor_x_center, float anchor_y_center,
+                    float anchor_h, float anchor_w) {
+  x_center.push_back(anchor_x_center);
+  y_center.push_back(anchor_y_center);
+  h.push_back(anchor_h);
+  w.push_back(anchor_w);
+}
+
+AnchorSet AnchorSetFromAnchors(const std::vector<Anchor>& anchors) {
+  AnchorSet anchor_set;
+  anchor_set.Reserve(anchors.size());
+  for (const Anchor& anchor : anchors) {
+    anchor_set.Add(anchor.x_center(), anchor.y_center(), anchor.h(),
+                   anchor.w());
+  }
+  return anchor_set;
+}
+
+std::vector<Anchor> AnchorsFromAnchorSet(const AnchorSet& anchor_set) {
+  std::vector<Anchor> anchors(anchor_set.size());
+  for (int i = 0; i < anchor_set.size(); ++i) {
+    anchors[i].set_x_center(anchor_set.x_center[i]);
+    anchors[i].set_y_center(anchor_set.y_center[i]);
+    anchors[i].set_h(anchor_set.h[i]);
+    anchors[i].set_w(anchor_set.w[i]);
+  }
+  return anchors;
+}
+
+}  // namespace mediapipe
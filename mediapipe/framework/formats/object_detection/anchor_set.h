@@ -0,0 +1,48 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// A set of object detection anchors stored as one array per field, so that
+// box decoding reads contiguous floats instead of one Anchor message per box.
+
+#ifndef MEDIAPIPE_FRAMEWORK_FORMATS_OBJECT_DETECTION_ANCHOR_SET_H_
+#define MEDIAPIPE_FRAMEWORK_FORMATS_OBJECT_DETECTION_ANCHOR_SET_H_
+
+#include <vector>
+
+#include "mediapipe/framework/formats/object_detection/anchor.pb.h"
+
+namespace mediapipe {
+
+struct AnchorSet {
+  // Encoded anchor box centers.
+  std::vector<float> x_center;
+  std::vector<float> y_center;
+  // Encoded anchor box heights and widths.
+  std::vector<float> h;
+  std::vector<float> w;
+
+  int size() const { return x_center.size(); }
+
+  void Reserve(int size);
+  void Add(float anchor_x_center, float anchor_y_center, float anchor_h,
+           float anchor_w);
+};
+
+// Converts between Anchor messages and an AnchorSet.
+AnchorSet AnchorSetFromAnchors(const std::vector<Anchor>& anchors);
+std::vector<Anchor> AnchorsFromAnchorSet(const AnchorSet& anchor_set);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_FORMATS_OBJECT_DETECTION_ANCHOR_SET_H_
@@ -0,0 +1,409 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Micro-benchmarks of the per-packet work of the framework: packets, input
+// stream queues, input stream handler readiness, output stream propagation,
+// and the scheduler, through graphs of PassThroughCalculators.
+//
+// Each benchmark reports one item per unit of framework work (a packet copy,
+// a queued packet, a readiness check, or a Process() call), so the time per
+// item is the framework overhead in ns.
+//
+// Run with:
+//   bazel run -c opt //mediapipe/framework:framework_benchmark -- \
+//     --benchmark_filter=BM_PassThroughGraph
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/input_stream_manager.h"
+#include "mediapipe/framework/input_stream_shard.h"
+#include "mediapipe/framework/mediapipe_options.pb.h"
+#include "mediapipe/framework/output_stream_manager.h"
+#include "mediapipe/framework/output_stream_shard.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/packet_type.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/stream_handler/default_input_stream_handler.h"
+#include "mediapipe/framework/tool/tag_map_helper.h"
+
+namespace mediapipe {
+namespace {
+
+// Gives the benchmarks access to GetNodeReadiness() and FillInputSet().
+class ReadinessInputStreamHandler : public DefaultInputStreamHandler {
+ public:
+  using DefaultInputStreamHandler::DefaultInputStreamHandler;
+  using DefaultInputStreamHandler::FillInputSet;
+  using DefaultInputStreamHandler::GetNodeReadiness;
+};
+
+// A DefaultInputStreamHandler over "num_streams" streams, with no node
+// behind it.
+class InputStreamHandlerFixture {
+ public:
+  explicit InputStreamHandlerFixture(int num_streams)
+      : managers_(new InputStreamManager[num_streams]) {
+    packet_type_.Set<int>();
+    handler_ = absl::make_unique<ReadinessInputStreamHandler>(
+        tool::CreateTagMap(num_streams).ValueOrDie(),
+        /*cc_manager=*/nullptr, MediaPipeOptions(),
+        /*calculator_run_in_parallel=*/false);
+    for (int i = 0; i < num_streams; ++i) {
+      MEDIAPIPE_CHECK_OK(managers_[i].Initialize(absl::StrCat("in", i),
+                                                 &packet_type_,
+                                                 /*back_edge=*/false));
+    }
+    MEDIAPIPE_CHECK_OK(
+        handler_->InitializeInputStreamManagers(managers_.get()));
+    handler_->PrepareForRun([]() {}, [this]() { ++num_notifications_; },
+                            [](CalculatorContext*) {},
+                            [](::mediapipe::Status status) {
+                              MEDIAPIPE_CHECK_OK(status);
+                            });
+  }
+
+  ReadinessInputStreamHandler* handler() { return handler_.get(); }
+  InputStreamManager* manager(int i) { return &managers_[i]; }
+  // The number of times the handler has notified the node.
+  int64 num_notifications() const { return num_notifications_; }
+
+ private:
+  int64 num_notifications_ = 0;
+  PacketType packet_type_;
+  std::unique_ptr<InputStreamManager[]> managers_;
+  std::unique_ptr<ReadinessInputStreamHandler> handler_;
+};
+
+void BM_PacketCopy(benchmark::State& state) {
+  const Packet packet = MakePacket<int>(0).At(Timestamp(0));
+  for (auto _ : state) {
+    Packet copy = packet;
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PacketCopy);
+
+void BM_PacketMove(benchmark::State& state) {
+  Packet packet = MakePacket<int>(0).At(Timestamp(0));
+  for (auto _ : state) {
+    Packet moved = std::move(packet);
+    benchmark::DoNotOptimize(moved);
+    packet = std::move(moved);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PacketMove);
+
+void BM_PacketAt(benchmark::State& state) {
+  const Packet packet = MakePacket<int>(0);
+  int64 t = 0;
+  for (auto _ : state) {
+    Packet stamped = packet.At(Timestamp(++t));
+    benchmark::DoNotOptimize(stamped);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PacketAt);
+
+// Adds batches of "state.range(0)" packets to an InputStreamManager, either
+// by copy or by move, and pops them one timestamp at a time, as
+// DefaultInputStreamHandler does.
+void RunInputStreamManagerBenchmark(benchmark::State& state, bool move) {
+  const int batch_size = state.range(0);
+  InputStreamHandlerFixture fixture(1);
+  InputStreamManager* manager = fixture.manager(0);
+  const Packet payload = MakePacket<int>(0);
+  int64 t = 0;
+  for (auto _ : state) {
+    std::list<Packet> packets;
+    for (int i = 0; i < batch_size; ++i) {
+      packets.push_back(payload.At(Timestamp(t + i)));
+    }
+    bool notify = false;
+    if (move) {
+      MEDIAPIPE_CHECK_OK(manager->MovePackets(&packets, &notify));
+    } else {
+      MEDIAPIPE_CHECK_OK(manager->AddPackets(packets, &notify));
+    }
+    for (int i = 0; i < batch_size; ++i, ++t) {
+      int num_packets_dropped = 0;
+      bool stream_is_done = false;
+      Packet packet = manager->PopPacketAtTimestamp(
+          Timestamp(t), &num_packets_dropped, &stream_is_done);
+      benchmark::DoNotOptimize(packet);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+void BM_InputStreamManagerAddAndPop(benchmark::State& state) {
+  RunInputStreamManagerBenchmark(state, false);
+}
+BENCHMARK(BM_InputStreamManagerAddAndPop)->Arg(1)->Arg(16)->Arg(256);
+
+void BM_InputStreamManagerMoveAndPop(benchmark::State& state) {
+  RunInputStreamManagerBenchmark(state, true);
+}
+BENCHMARK(BM_InputStreamManagerMoveAndPop)->Arg(1)->Arg(16)->Arg(256);
+
+// Checks the readiness of a node with "state.range(0)" input streams. If
+// "ready" is true, every stream holds a packet at the same timestamp;
+// otherwise the last stream is empty, as when one input of a node lags.
+void RunGetNodeReadinessBenchmark(benchmark::State& state, bool ready) {
+  const int num_streams = state.range(0);
+  InputStreamHandlerFixture fixture(num_streams);
+  const int num_filled = ready ? num_streams : num_streams - 1;
+  const CollectionItemId begin_id = fixture.handler()->InputTagMap()->BeginId();
+  for (int i = 0; i < num_filled; ++i) {
+    fixture.handler()->AddPackets(begin_id + i,
+                                  {MakePacket<int>(i).At(Timestamp(0))});
+  }
+  const NodeReadiness expected =
+      ready ? NodeReadiness::kReadyForProcess : NodeReadiness::kNotReady;
+  for (auto _ : state) {
+    Timestamp min_stream_timestamp;
+    const NodeReadiness readiness =
+        fixture.handler()->GetNodeReadiness(&min_stream_timestamp);
+    CHECK(readiness == expected);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_GetNodeReadinessReady(benchmark::State& state) {
+  RunGetNodeReadinessBenchmark(state, true);
+}
+BENCHMARK(BM_GetNodeReadinessReady)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+void BM_GetNodeReadinessNotReady(benchmark::State& state) {
+  RunGetNodeReadinessBenchmark(state, false);
+}
+BENCHMARK(BM_GetNodeReadinessNotReady)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+// Delivers one packet per timestamp to each of the "state.range(0)" input
+// streams of a node, checks the readiness of the node after every packet, as
+// the scheduler does, and fills the input set once the last packet of the
+// timestamp has arrived. Each item is one packet.
+void BM_WideFanIn(benchmark::State& state) {
+  const int num_streams = state.range(0);
+  InputStreamHandlerFixture fixture(num_streams);
+  ReadinessInputStreamHandler* handler = fixture.handler();
+  InputStreamShardSet input_set(handler->InputTagMap());
+  MEDIAPIPE_CHECK_OK(handler->SetupInputShards(&input_set));
+  const CollectionItemId begin_id = handler->InputTagMap()->BeginId();
+  const Packet payload = MakePacket<int>(0);
+  int64 t = 0;
+  for (auto _ : state) {
+    const Timestamp timestamp(t++);
+    NodeReadiness readiness = NodeReadiness::kNotReady;
+    Timestamp min_stream_timestamp;
+    for (int i = 0; i < num_streams; ++i) {
+      CHECK(readiness == NodeReadiness::kNotReady);
+      handler->AddPackets(begin_id + i, {payload.At(timestamp)});
+      readiness = handler->GetNodeReadiness(&min_stream_timestamp);
+    }
+    CHECK(readiness == NodeReadiness::kReadyForProcess);
+    handler->FillInputSet(min_stream_timestamp, &input_set);
+  }
+  state.SetItemsProcessed(state.iterations() * num_streams);
+}
+BENCHMARK(BM_WideFanIn)->Arg(1)->Arg(4)->Arg(8)->Arg(16)->Arg(64);
+
+// Advances the timestamp bounds of "state.range(0)" - 1 sparse input streams
+// of a node, while its first stream receives one packet per timestamp, as
+// when a node reads a dense stream alongside streams that rarely carry
+// packets. The readiness of the node is checked after every notification, as
+// the scheduler does. Each item is one stream update; "notifications" is the
+// number of notifications per item.
+void BM_SparseBoundUpdates(benchmark::State& state) {
+  const int num_streams = state.range(0);
+  InputStreamHandlerFixture fixture(num_streams);
+  ReadinessInputStreamHandler* handler = fixture.handler();
+  InputStreamShardSet input_set(handler->InputTagMap());
+  MEDIAPIPE_CHECK_OK(handler->SetupInputShards(&input_set));
+  const CollectionItemId begin_id = handler->InputTagMap()->BeginId();
+  const Packet payload = MakePacket<int>(0);
+  int64 t = 0;
+  Timestamp min_stream_timestamp;
+  for (auto _ : state) {
+    const Timestamp timestamp(t++);
+    for (int i = 1; i < num_streams; ++i) {
+      const int64 num_notifications = fixture.num_notifications();
+      handler->SetNextTimestampBound(begin_id + i,
+                                     timestamp.NextAllowedInStream());
+      if (fixture.num_notifications() != num_notifications) {
+        CHECK(handler->GetNodeReadiness(&min_stream_timestamp) ==
+              NodeReadiness::kNotReady);
+      }
+    }
+    handler->AddPackets(begin_id, {payload.At(timestamp)});
+    CHECK(handler->GetNodeReadiness(&min_stream_timestamp) ==
+          NodeReadiness::kReadyForProcess);
+    handler->FillInputSet(min_stream_timestamp, &input_set);
+  }
+  state.SetItemsProcessed(state.iterations() * num_streams);
+  state.counters["notifications"] =
+      static_cast<double>(fixture.num_notifications()) /
+      (state.iterations() * num_streams);
+}
+BENCHMARK(BM_SparseBoundUpdates)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(64);
+
+// Propagates one packet per iteration from an OutputStreamManager to
+// "state.range(0)" mirrors, each the only input stream of its own
+// DefaultInputStreamHandler, and drains the mirrors.
+void BM_PropagateUpdatesToMirrors(benchmark::State& state) {
+  const int num_mirrors = state.range(0);
+  PacketType packet_type;
+  packet_type.Set<int>();
+  OutputStreamManager output_stream_manager;
+  MEDIAPIPE_CHECK_OK(output_stream_manager.Initialize("out", &packet_type));
+  output_stream_manager.PrepareForRun(
+      [](::mediapipe::Status status) { MEDIAPIPE_CHECK_OK(status); });
+  OutputStreamShard output_stream_shard;
+  output_stream_shard.SetSpec(output_stream_manager.Spec());
+  output_stream_manager.ResetShard(&output_stream_shard);
+
+  std::vector<std::unique_ptr<InputStreamHandlerFixture>> mirrors;
+  for (int i = 0; i < num_mirrors; ++i) {
+    mirrors.push_back(absl::make_unique<InputStreamHandlerFixture>(1));
+    output_stream_manager.AddMirror(
+        mirrors.back()->handler(),
+        mirrors.back()->handler()->InputTagMap()->BeginId());
+  }
+
+  const Packet payload = MakePacket<int>(0);
+  int64 t = 0;
+  for (auto _ : state) {
+    output_stream_shard.AddPacket(payload.At(Timestamp(t)));
+    const Timestamp bound = output_stream_manager.ComputeOutputTimestampBound(
+        output_stream_shard, Timestamp(t));
+    output_stream_manager.PropagateUpdatesToMirrors(bound,
+                                                    &output_stream_shard);
+    output_stream_manager.ResetShard(&output_stream_shard);
+    for (const auto& mirror : mirrors) {
+      int num_packets_dropped = 0;
+      bool stream_is_done = false;
+      Packet packet = mirror->manager(0)->PopPacketAtTimestamp(
+          Timestamp(t), &num_packets_dropped, &stream_is_done);
+      benchmark::DoNotOptimize(packet);
+    }
+    ++t;
+  }
+  state.SetItemsProcessed(state.iterations() * num_mirrors);
+}
+BENCHMARK(BM_PropagateUpdatesToMirrors)->Arg(1)->Arg(4)->Arg(16);
+
+// Returns a graph of "width" independent chains of "depth"
+// PassThroughCalculators. Each stream of a chain is also read by
+// "fan_out" - 1 PassThroughCalculators whose outputs are not read. If
+// "fuse_chains" is true, the chains are run with fuse_calculator_chains.
+CalculatorGraphConfig MakePassThroughGraph(int width, int depth, int fan_out,
+                                           int num_threads, bool fuse_chains) {
+  CalculatorGraphConfig config;
+  config.set_num_threads(num_threads);
+  config.set_fuse_calculator_chains(fuse_chains);
+  for (int w = 0; w < width; ++w) {
+    std::string stream = absl::StrCat("in", w);
+    config.add_input_stream(stream);
+    for (int d = 0; d < depth; ++d) {
+      for (int f = 0; f < fan_out; ++f) {
+        CalculatorGraphConfig::Node* node = config.add_node();
+        node->set_calculator("PassThroughCalculator");
+        node->add_input_stream(stream);
+        node->add_output_stream(absl::StrCat("s", w, "_", d, "_", f));
+      }
+      stream = absl::StrCat("s", w, "_", d, "_0");
+    }
+  }
+  return config;
+}
+
+// Sends packets through the graph of MakePassThroughGraph() for the
+// arguments (width, depth, fan_out). One item is one Process() call.
+void RunPassThroughGraphBenchmark(benchmark::State& state, int num_threads,
+                                  bool fuse_chains) {
+  constexpr int kNumPackets = 1000;
+  const int width = state.range(0);
+  const int depth = state.range(1);
+  const int fan_out = state.range(2);
+  const CalculatorGraphConfig config =
+      MakePassThroughGraph(width, depth, fan_out, num_threads, fuse_chains);
+  std::vector<Packet> packets;
+  for (int i = 0; i < kNumPackets; ++i) {
+    packets.push_back(MakePacket<int>(i).At(Timestamp(i)));
+  }
+  for (auto _ : state) {
+    state.PauseTiming();
+    CalculatorGraph graph;
+    MEDIAPIPE_CHECK_OK(graph.Initialize(config));
+    MEDIAPIPE_CHECK_OK(graph.StartRun({}));
+    state.ResumeTiming();
+    for (const Packet& packet : packets) {
+      for (int w = 0; w < width; ++w) {
+        MEDIAPIPE_CHECK_OK(
+            graph.AddPacketToInputStream(absl::StrCat("in", w), packet));
+      }
+    }
+    MEDIAPIPE_CHECK_OK(graph.CloseAllInputStreams());
+    MEDIAPIPE_CHECK_OK(graph.WaitUntilDone());
+  }
+  state.SetItemsProcessed(state.iterations() * kNumPackets * width * depth *
+                          fan_out);
+}
+
+void PassThroughGraphArgs(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"width", "depth", "fan_out"});
+  benchmark->Args({1, 1, 1});
+  benchmark->Args({1, 8, 1});
+  benchmark->Args({1, 32, 1});
+  benchmark->Args({8, 1, 1});
+  benchmark->Args({8, 8, 1});
+  benchmark->Args({1, 8, 4});
+  benchmark->Args({4, 8, 4});
+}
+
+void BM_PassThroughGraph(benchmark::State& state) {
+  RunPassThroughGraphBenchmark(state, /*num_threads=*/0,
+                               /*fuse_chains=*/false);
+}
+BENCHMARK(BM_PassThroughGraph)->Apply(PassThroughGraphArgs)->UseRealTime();
+
+// The same graphs on a single thread, without contention on the scheduler.
+void BM_PassThroughGraphSingleThread(benchmark::State& state) {
+  RunPassThroughGraphBenchmark(state, /*num_threads=*/1,
+                               /*fuse_chains=*/false);
+}
+BENCHMARK(BM_PassThroughGraphSingleThread)
+    ->Apply(PassThroughGraphArgs)
+    ->UseRealTime();
+
+// The same graphs with fuse_calculator_chains, which runs each chain of
+// PassThroughCalculators as one scheduled unit when fan_out is 1.
+void BM_PassThroughGraphFused(benchmark::State& state) {
+  RunPassThroughGraphBenchmark(state, /*num_threads=*/0,
+                               /*fuse_chains=*/true);
+}
+BENCHMARK(BM_PassThroughGraphFused)
+    ->Apply(PassThroughGraphArgs)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
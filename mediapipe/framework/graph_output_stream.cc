@@ -120,6 +120,7 @@ int OutputStreamPollerImpl::QueueSize() { return input_stream_->QueueSize(); }
   mutex_.Lock();
   handler_condvar_.Signal();
   mutex_.Unlock();
+  InvokeReadyCallback();
   return ::mediapipe::OkStatus();
 }
 
@@ -128,30 +129,54 @@ void OutputStreamPollerImpl::NotifyError() {
   graph_has_error_ = true;
   handler_condvar_.Signal();
   mutex_.Unlock();
+  InvokeReadyCallback();
 }
 
-bool OutputStreamPollerImpl::Next(Packet* packet) {
-  CHECK(packet);
-  bool empty_queue = true;
-  Timestamp min_timestamp = Timestamp::Unset();
+void OutputStreamPollerImpl::SetReadyCallback(
+    std::function<void()> ready_callback) {
+  absl::MutexLock lock(&mutex_);
+  if (ready_callback) {
+    ready_callback_ =
+        std::make_shared<std::function<void()>>(std::move(ready_callback));
+  } else {
+    ready_callback_.reset();
+  }
+}
+
+void OutputStreamPollerImpl::InvokeReadyCallback() {
+  std::shared_ptr<std::function<void()>> ready_callback;
   mutex_.Lock();
+  ready_callback = ready_callback_;
+  mutex_.Unlock();
+  if (ready_callback) {
+    (*ready_callback)();
+  }
+}
+
+bool OutputStreamPollerImpl::WaitForPacket(absl::Time deadline,
+                                           Timestamp* min_timestamp,
+                                           bool* stream_done) {
+  bool empty_queue = true;
+  absl::MutexLock lock(&mutex_);
   while (true) {
-    min_timestamp = input_stream_->MinTimestampOrBound(&empty_queue);
+    *min_timestamp = input_stream_->MinTimestampOrBound(&empty_queue);
     if (graph_has_error_ || !empty_queue ||
-        min_timestamp == Timestamp::Done()) {
+        *min_timestamp == Timestamp::Done()) {
+      break;
+    }
+    // WaitWithDeadline returns true on timeout.
+    if (handler_condvar_.WaitWithDeadline(&mutex_, deadline)) {
+      *min_timestamp = input_stream_->MinTimestampOrBound(&empty_queue);
       break;
-    } else {
-      handler_condvar_.Wait(&mutex_);
     }
   }
-  if (graph_has_error_ && empty_queue) {
-    mutex_.Unlock();
-    return false;
-  }
-  mutex_.Unlock();
-  if (min_timestamp == Timestamp::Done()) {
-    return false;
-  }
+  *stream_done = empty_queue && (graph_has_error_ ||
+                                 *min_timestamp == Timestamp::Done());
+  return !empty_queue;
+}
+
+void OutputStreamPollerImpl::PopPacket(Timestamp min_timestamp,
+                                       Packet* packet) {
   int num_packets_dropped = 0;
   bool stream_is_done = false;
   *packet = input_stream_->PopPacketAtTimestamp(
@@ -159,6 +184,43 @@ bool OutputStreamPollerImpl::Next(Packet* packet) {
   CHECK_EQ(num_packets_dropped, 0)
       << absl::Substitute("Dropped $0 packet(s) on input stream \"$1\".",
                           num_packets_dropped, input_stream_->Name());
+}
+
+bool OutputStreamPollerImpl::Next(Packet* packet) {
+  CHECK(packet);
+  Timestamp min_timestamp = Timestamp::Unset();
+  bool stream_done = false;
+  if (!WaitForPacket(absl::InfiniteFuture(), &min_timestamp, &stream_done)) {
+    return false;
+  }
+  PopPacket(min_timestamp, packet);
+  return true;
+}
+
+bool OutputStreamPollerImpl::TryNext(Packet* packet) {
+  CHECK(packet);
+  Timestamp min_timestamp = Timestamp::Unset();
+  bool stream_done = false;
+  if (!WaitForPacket(absl::InfinitePast(), &min_timestamp, &stream_done)) {
+    *packet = Packet();
+    return !stream_done;
+  }
+  PopPacket(min_timestamp, packet);
+  return true;
+}
+
+bool OutputStreamPollerImpl::NextBatch(std::vector<Packet>* packets,
+                                       int max_packets,
+                                       absl::Duration timeout) {
+  CHECK(packets);
+  CHECK_GT(max_packets, 0);
+  Timestamp min_timestamp = Timestamp::Unset();
+  bool stream_done = false;
+  if (!WaitForPacket(absl::Now() + timeout, &min_timestamp, &stream_done)) {
+    return !stream_done;
+  }
+  bool stream_is_done = false;
+  input_stream_->PopPackets(max_packets, packets, &stream_is_done);
   return true;
 }
 
@@ -24,6 +24,7 @@
 #include "absl/base/thread_annotations.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "mediapipe/framework/input_stream_handler.h"
 #include "mediapipe/framework/input_stream_manager.h"
 #include "mediapipe/framework/output_stream_manager.h"
@@ -161,10 +162,39 @@ class OutputStreamPollerImpl : public GraphOutputStream {
   // done).  Returns true if successful.
   ABSL_MUST_USE_RESULT bool Next(Packet* packet);
 
+  // Gets the next packet without blocking. Returns false if the stream is
+  // done. Otherwise returns true and sets "packet" to the next packet, or to
+  // an empty packet if none is available yet.
+  ABSL_MUST_USE_RESULT bool TryNext(Packet* packet);
+
+  // Waits up to "timeout" for a packet, then appends up to "max_packets"
+  // available packets to "packets". Returns false if the stream is done.
+  // Otherwise returns true, and "packets" is unchanged if the timeout expired.
+  ABSL_MUST_USE_RESULT bool NextBatch(std::vector<Packet>* packets,
+                                      int max_packets, absl::Duration timeout);
+
+  // Sets a callback that is invoked whenever packets become available, the
+  // stream is done or the graph fails. See OutputStreamPoller.
+  void SetReadyCallback(std::function<void()> ready_callback);
+
  private:
+  // Waits until a packet is available, the stream is done, or "deadline".
+  // Returns true if a packet is available at "min_timestamp", and sets
+  // "stream_done" if there are no more packets to poll.
+  bool WaitForPacket(absl::Time deadline, Timestamp* min_timestamp,
+                     bool* stream_done);
+
+  // Pops the packet at "min_timestamp", the head of the queue.
+  void PopPacket(Timestamp min_timestamp, Packet* packet);
+
+  // Invokes the ready callback, if any.
+  void InvokeReadyCallback();
+
   absl::Mutex mutex_;
   absl::CondVar handler_condvar_ GUARDED_BY(mutex_);
   bool graph_has_error_ GUARDED_BY(mutex_);
+  // Held by shared_ptr so that it can be invoked outside of mutex_.
+  std::shared_ptr<std::function<void()>> ready_callback_ GUARDED_BY(mutex_);
 };
 
 }  // namespace internal
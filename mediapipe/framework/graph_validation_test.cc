@@ -208,5 +208,95 @@ TEST(ValidatedGraphConfigTest, InitilizeTemplateFromProtos) {
       )")));
 }
 
+// Shows which calculators are fused with their producers, including across
+// a subgraph boundary.
+TEST(ValidatedGraphConfigTest, FuseCalculatorChains) {
+  auto config_1 = ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+    type: "PassThroughGraph"
+    input_stream: "INPUT:stream_1"
+    output_stream: "OUTPUT:stream_2"
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "stream_1"
+      output_stream: "stream_2"
+    }
+  )");
+  auto config_2 = ParseTextProtoOrDie<CalculatorGraphConfig>(R"(
+    input_stream: "in"
+    fuse_calculator_chains: true
+    executor { name: "other" }
+    # Not fused, the input is a graph input stream.
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "in"
+      output_stream: "a"
+    }
+    # Fused.
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "a"
+      output_stream: "b"
+    }
+    # Fused, after subgraph expansion.
+    node {
+      calculator: "PassThroughGraph"
+      input_stream: "INPUT:b"
+      output_stream: "OUTPUT:c"
+    }
+    # Not fused, "c" has two consumers.
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "c"
+      output_stream: "d"
+    }
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "c"
+      output_stream: "e"
+    }
+    # Not fused, the producer runs on another executor.
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "d"
+      output_stream: "f"
+      executor: "other"
+    }
+    # Not fused, two input streams.
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "e"
+      input_stream: "f"
+      output_stream: "g"
+      output_stream: "h"
+    }
+    # Not fused, the producer has two output streams.
+    node {
+      calculator: "PassThroughCalculator"
+      input_stream: "g"
+      output_stream: "i"
+    }
+  )");
+
+  ValidatedGraphConfig validated_graph;
+  MEDIAPIPE_ASSERT_OK(validated_graph.Initialize({config_1, config_2}, {}));
+  std::vector<std::string> fused_outputs;
+  for (const NodeTypeInfo& node_type_info : validated_graph.CalculatorInfos()) {
+    if (node_type_info.FusedWithProducer()) {
+      fused_outputs.push_back(
+          validated_graph.Config()
+              .node(node_type_info.Node().index)
+              .output_stream(0));
+    }
+  }
+  EXPECT_THAT(fused_outputs, testing::UnorderedElementsAre("b", "c"));
+
+  config_2.set_fuse_calculator_chains(false);
+  ValidatedGraphConfig unfused_graph;
+  MEDIAPIPE_ASSERT_OK(unfused_graph.Initialize({config_1, config_2}, {}));
+  for (const NodeTypeInfo& node_type_info : unfused_graph.CalculatorInfos()) {
+    EXPECT_FALSE(node_type_info.FusedWithProducer());
+  }
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -79,6 +79,7 @@ void InputStreamHandler::PrepareForRun(
     stream->PrepareForRun();
   }
   unset_header_count_.store(unset_header_count, std::memory_order_relaxed);
+  suppressed_notifications_.store(0, std::memory_order_relaxed);
   prepared_context_for_close_ = false;
 }
 
@@ -236,6 +237,9 @@ void InputStreamHandler::AddPackets(CollectionItemId id,
   if (!result.ok()) {
     error_callback_(result);
   }
+  if (notify || !result.ok()) {
+    StreamUpdated(id);
+  }
   if (notify) {
     notification_();
   }
@@ -249,6 +253,9 @@ void InputStreamHandler::MovePackets(CollectionItemId id,
   if (!result.ok()) {
     error_callback_(result);
   }
+  if (notify || !result.ok()) {
+    StreamUpdated(id);
+  }
   if (notify) {
     notification_();
   }
@@ -262,6 +269,12 @@ void InputStreamHandler::SetNextTimestampBound(CollectionItemId id,
   if (!result.ok()) {
     error_callback_(result);
   }
+  if (notify || !result.ok()) {
+    if (!StreamUpdated(id) && notify) {
+      suppressed_notifications_.fetch_add(1, std::memory_order_relaxed);
+      notify = false;
+    }
+  }
   if (notify) {
     notification_();
   }
@@ -278,9 +291,31 @@ void InputStreamHandler::ClearCurrentInputs(
 }
 
 void InputStreamHandler::Close() {
-  for (auto& stream : input_stream_managers_) {
-    stream->Close();
+  for (CollectionItemId id = input_stream_managers_.BeginId();
+       id < input_stream_managers_.EndId(); ++id) {
+    input_stream_managers_.Get(id)->Close();
+    StreamUpdated(id);
+  }
+  FlushSuppressedNotifications();
+}
+
+void InputStreamHandler::FlushSuppressedNotifications() {
+  if (calculator_context_manager_ == nullptr ||
+      !calculator_context_manager_->HasDefaultCalculatorContext()) {
+    return;
+  }
+  int suppressed_notifications =
+      suppressed_notifications_.exchange(0, std::memory_order_relaxed);
+  if (suppressed_notifications == 0) {
+    return;
   }
+  CalculatorContext* default_context =
+      calculator_context_manager_->GetDefaultCalculatorContext();
+  default_context->GetCounter("SuppressedNotifications")
+      ->IncrementBy(suppressed_notifications);
+  ::mediapipe::AddSuppressedNotifications(
+      default_context->GetProfilingContext(), *default_context,
+      suppressed_notifications);
 }
 
 void InputStreamHandler::SetBatchSize(int batch_size) {
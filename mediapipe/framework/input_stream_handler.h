@@ -149,6 +149,11 @@ class InputStreamHandler {
 
   void Close();
 
+  // Adds the timestamp bound notifications skipped since the last flush to the
+  // node's "SuppressedNotifications" counter and calculator profile. Does
+  // nothing while the default calculator context does not exist.
+  void FlushSuppressedNotifications();
+
   // Returns a std::string that concatenates the stream names of all managed
   // streams.
   std::string DebugStreamNames() const;
@@ -215,6 +220,15 @@ class InputStreamHandler {
   virtual void FillInputSet(Timestamp input_timestamp,
                             InputStreamShardSet* input_set) = 0;
 
+  // Invoked when the packet queue or the timestamp bound of a stream may have
+  // changed through this handler, before the observer is notified. Subclasses
+  // that cache the state of the streams can override this to update it.
+  // Returns false if the update cannot change the readiness of the node, nor
+  // its minimum stream timestamp. The notification for a timestamp bound
+  // update is then skipped, since the node would only find itself not ready
+  // again. Packet updates are always notified.
+  virtual bool StreamUpdated(CollectionItemId id) { return true; }
+
   // Collection of InputStreamManager objects.
   InputStreamManagerSet input_stream_managers_;
   // A pointer to the calculator context manager of the calculator node.
@@ -251,6 +265,11 @@ class InputStreamHandler {
   std::function<void()> headers_ready_callback_;
 
   std::atomic<int> unset_header_count_{0};
+
+  // The number of timestamp bound notifications skipped in the current run.
+  // It is reported by FlushSuppressedNotifications(), rather than on every
+  // update.
+  std::atomic<int> suppressed_notifications_{0};
 };
 
 using InputStreamHandlerRegistry = GlobalFactoryRegistry<
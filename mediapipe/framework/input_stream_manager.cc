@@ -320,6 +320,43 @@ Packet InputStreamManager::PopQueueHead(bool* stream_is_done) {
   return packet;
 }
 
+int InputStreamManager::PopPackets(int max_packets,
+                                   std::vector<Packet>* packets,
+                                   bool* stream_is_done) {
+  CHECK(packets);
+  *stream_is_done = false;
+  bool queue_became_non_full = false;
+  int num_popped = 0;
+  {
+    absl::MutexLock stream_lock(&stream_mutex_);
+    bool was_queue_full =
+        (max_queue_size_ != -1 && queue_.size() >= max_queue_size_);
+    while (!queue_.empty() && num_popped < max_packets) {
+      packets->push_back(std::move(queue_.front()));
+      queue_.pop_front();
+      ++num_popped;
+    }
+    if (enable_timestamps_ && num_popped > 0) {
+      const Timestamp timestamp = packets->back().Timestamp();
+      CHECK_LE(last_select_timestamp_, timestamp);
+      last_select_timestamp_ = timestamp;
+      if (next_timestamp_bound_ <= timestamp) {
+        next_timestamp_bound_ = timestamp.NextAllowedInStream();
+      }
+    }
+
+    VLOG(2) << "Input stream removed " << num_popped << " packets:" << name_
+            << " Size:" << queue_.size();
+    queue_became_non_full = (was_queue_full && queue_.size() < max_queue_size_);
+    *stream_is_done = IsDone();
+  }
+  if (queue_became_non_full) {
+    VLOG(2) << "Queue became non-full: " << Name();
+    becomes_not_full_callback_(this, &last_reported_stream_full_);
+  }
+  return num_popped;
+}
+
 int InputStreamManager::QueueSize() const {
   absl::MutexLock lock(&stream_mutex_);
   return static_cast<int>(queue_.size());
@@ -19,6 +19,7 @@
 #include <functional>
 #include <list>
 #include <string>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
@@ -141,6 +142,15 @@ class InputStreamManager {
   // Timestamp::Done() after the pop.
   Packet PopQueueHead(bool* stream_is_done) LOCKS_EXCLUDED(stream_mutex_);
 
+  // Pops up to "max_packets" packets from the head of the queue and appends
+  // them to "packets", with a single lock acquisition. Returns the number of
+  // packets popped. If timestamps are enabled, this advances the selected
+  // timestamp like PopPacketAtTimestamp() does for each packet. Sets
+  // "stream_is_done" if the next timestamp bound reaches Timestamp::Done()
+  // after the pop.
+  int PopPackets(int max_packets, std::vector<Packet>* packets,
+                 bool* stream_is_done) LOCKS_EXCLUDED(stream_mutex_);
+
   // Returns the number of packets in the queue.
   int QueueSize() const LOCKS_EXCLUDED(stream_mutex_);
 
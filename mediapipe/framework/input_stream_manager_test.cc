@@ -15,6 +15,8 @@
 #include "mediapipe/framework/input_stream_manager.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "mediapipe/framework/input_stream_shard.h"
@@ -394,6 +396,34 @@ TEST_F(InputStreamManagerTest, PopQueueHead) {
   EXPECT_TRUE(stream_is_done_);
 }
 
+TEST_F(InputStreamManagerTest, PopPackets) {
+  std::list<Packet> packets;
+  for (int i = 1; i <= 3; ++i) {
+    packets.push_back(
+        MakePacket<std::string>("packet " + std::to_string(i))
+            .At(Timestamp(i)));
+  }
+  MEDIAPIPE_ASSERT_OK(input_stream_manager_->AddPackets(packets, &notify_));
+  EXPECT_TRUE(notify_);
+
+  std::vector<Packet> popped;
+  EXPECT_EQ(2, input_stream_manager_->PopPackets(2, &popped, &stream_is_done_));
+  EXPECT_FALSE(stream_is_done_);
+  ASSERT_EQ(2, popped.size());
+  EXPECT_EQ("packet 1", popped[0].Get<std::string>());
+  EXPECT_EQ(Timestamp(2), popped[1].Timestamp());
+  EXPECT_EQ(Timestamp(3), input_stream_manager_->QueueHead().Timestamp());
+
+  MEDIAPIPE_ASSERT_OK(input_stream_manager_->SetNextTimestampBound(
+      Timestamp::Done(), &notify_));
+  EXPECT_EQ(1, input_stream_manager_->PopPackets(2, &popped, &stream_is_done_));
+  EXPECT_TRUE(stream_is_done_);
+  ASSERT_EQ(3, popped.size());
+  EXPECT_EQ("packet 3", popped[2].Get<std::string>());
+  EXPECT_EQ(0, input_stream_manager_->PopPackets(2, &popped, &stream_is_done_));
+  EXPECT_TRUE(input_stream_manager_->IsEmpty());
+}
+
 TEST_F(InputStreamManagerTest, BadPacketType) {
   std::list<Packet> packets;
   packets.push_back(MakePacket<int>(10).At(Timestamp(10)));
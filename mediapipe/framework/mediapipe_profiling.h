@@ -16,6 +16,7 @@
 #define MEDIAPIPE_FRAMEWORK_MEDIAPIPE_PROFILING_H_
 
 #include "mediapipe/framework/platform_specific_profiling.h"
+#include "mediapipe/framework/port/integral_types.h"
 #ifdef MEDIAPIPE_PROFILER_AVAILABLE
 #include "mediapipe/framework/profiler/graph_profiler.h"
 #else
@@ -36,6 +37,8 @@
 
 namespace mediapipe {
 
+class CalculatorContext;
+
 // Log a TraceEvent to the GraphTracer.
 inline void LogEvent(ProfilingContext* context, TraceEvent event) {
 #ifdef MEDIAPIPE_PROFILER_AVAILABLE
@@ -44,6 +47,17 @@ inline void LogEvent(ProfilingContext* context, TraceEvent event) {
   }
 #endif
 }
+
+// Adds skipped timestamp bound notifications to the calculator profile.
+inline void AddSuppressedNotifications(
+    ProfilingContext* context, const CalculatorContext& calculator_context,
+    int64 count) {
+#ifdef MEDIAPIPE_PROFILER_AVAILABLE
+  if (context) {
+    context->AddSuppressedNotifications(calculator_context, count);
+  }
+#endif
+}
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_FRAMEWORK_MEDIAPIPE_PROFILING_H_
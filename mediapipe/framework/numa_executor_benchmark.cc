@@ -0,0 +1,182 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Compares the placement of memory-bound calculators on multi-socket
+// machines. Each chain of the benchmark graph passes large buffers from node
+// to node, and every node reads the buffer it receives and writes a new one.
+// With a single executor, consecutive nodes of a chain may run on different
+// sockets, so buffers are read across the socket interconnect. With one
+// executor per NUMA node, each chain stays on one socket.
+//
+// The difference shows in bytes_per_second. On a machine with a single NUMA
+// node both placements are equivalent.
+//
+// Run with:
+//   bazel run -c opt //mediapipe/framework:numa_executor_benchmark
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+#include "mediapipe/util/cpu_util.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kBufferSize = 4 << 20;
+constexpr int kNumPackets = 20;
+
+typedef std::vector<uint8> Buffer;
+
+// Reads the Buffer of each input packet and outputs a new Buffer of the same
+// size computed from it, allocated and written on the thread of this node. An
+// input packet of any other type starts a new Buffer.
+class TouchBufferCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    cc->Outputs().Index(0).Set<Buffer>();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) final {
+    const Packet& input = cc->Inputs().Index(0).Value();
+    auto output = absl::make_unique<Buffer>(kBufferSize);
+    if (input.ValidateAsType<Buffer>().ok()) {
+      const Buffer& buffer = input.Get<Buffer>();
+      for (int i = 0; i < kBufferSize; ++i) {
+        (*output)[i] = buffer[i] + 1;
+      }
+    } else {
+      for (int i = 0; i < kBufferSize; ++i) {
+        (*output)[i] = i;
+      }
+    }
+    cc->Outputs().Index(0).Add(output.release(), cc->InputTimestamp());
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(TouchBufferCalculator);
+
+// Returns the ids of the NUMA nodes that have processors, and their
+// processors in "cpus".
+std::vector<int> NumaNodesWithCpus(std::vector<std::set<int>>* cpus) {
+  *cpus = InferNumaNodeCoreIds();
+  std::vector<int> numa_nodes;
+  for (int n = 0; n < static_cast<int>(cpus->size()); ++n) {
+    if (!(*cpus)[n].empty()) {
+      numa_nodes.push_back(n);
+    }
+  }
+  return numa_nodes;
+}
+
+// Returns a graph of "width" chains of "depth" TouchBufferCalculators. If
+// "numa_local" is true, it defines one executor per NUMA node, with one thread
+// pinned to each processor of the node, and runs chain w on the executor
+// w % <number of executors>. Otherwise all chains share the default executor.
+CalculatorGraphConfig MakeChainGraph(int width, int depth, bool numa_local) {
+  CalculatorGraphConfig config;
+  std::vector<std::set<int>> cpus;
+  const std::vector<int> numa_nodes =
+      numa_local ? NumaNodesWithCpus(&cpus) : std::vector<int>();
+  for (int i = 0; i < static_cast<int>(numa_nodes.size()); ++i) {
+    ExecutorConfig* executor = config.add_executor();
+    executor->set_name(absl::StrCat("numa", i));
+    executor->set_type("ThreadPoolExecutor");
+    ThreadPoolExecutorOptions* options =
+        executor->mutable_options()->MutableExtension(
+            ThreadPoolExecutorOptions::ext);
+    options->set_num_threads(cpus[numa_nodes[i]].size());
+    options->set_numa_node(numa_nodes[i]);
+    options->set_pin_threads_to_cores(true);
+  }
+  for (int w = 0; w < width; ++w) {
+    std::string stream = absl::StrCat("in", w);
+    config.add_input_stream(stream);
+    for (int d = 0; d < depth; ++d) {
+      CalculatorGraphConfig::Node* node = config.add_node();
+      node->set_calculator("TouchBufferCalculator");
+      node->add_input_stream(stream);
+      stream = absl::StrCat("s", w, "_", d);
+      node->add_output_stream(stream);
+      if (!numa_nodes.empty()) {
+        node->set_executor(absl::StrCat("numa", w % numa_nodes.size()));
+      }
+    }
+  }
+  return config;
+}
+
+// Sends kNumPackets packets through each chain of MakeChainGraph() for the
+// arguments (width, depth). One byte processed is one byte read by a node.
+void RunChainGraphBenchmark(benchmark::State& state, bool numa_local) {
+  const int width = state.range(0);
+  const int depth = state.range(1);
+  std::vector<std::set<int>> cpus;
+  const int num_numa_nodes = NumaNodesWithCpus(&cpus).size();
+  if (numa_local && num_numa_nodes == 0) {
+    state.SkipWithError("The NUMA topology is not available.");
+    return;
+  }
+  const CalculatorGraphConfig config =
+      MakeChainGraph(width, depth, numa_local);
+  for (auto _ : state) {
+    state.PauseTiming();
+    CalculatorGraph graph;
+    MEDIAPIPE_CHECK_OK(graph.Initialize(config));
+    MEDIAPIPE_CHECK_OK(graph.StartRun({}));
+    state.ResumeTiming();
+    for (int i = 0; i < kNumPackets; ++i) {
+      for (int w = 0; w < width; ++w) {
+        MEDIAPIPE_CHECK_OK(graph.AddPacketToInputStream(
+            absl::StrCat("in", w), MakePacket<int>(i).At(Timestamp(i))));
+      }
+    }
+    MEDIAPIPE_CHECK_OK(graph.CloseAllInputStreams());
+    MEDIAPIPE_CHECK_OK(graph.WaitUntilDone());
+  }
+  state.SetBytesProcessed(state.iterations() * kNumPackets * width *
+                          (depth - 1) * kBufferSize);
+  state.SetLabel(absl::StrCat("numa_nodes=", num_numa_nodes));
+}
+
+void ChainGraphArgs(benchmark::internal::Benchmark* benchmark) {
+  benchmark->ArgNames({"width", "depth"});
+  benchmark->Args({2, 4});
+  benchmark->Args({8, 4});
+  benchmark->Args({8, 8});
+}
+
+void BM_ChainGraphSharedExecutor(benchmark::State& state) {
+  RunChainGraphBenchmark(state, /*numa_local=*/false);
+}
+BENCHMARK(BM_ChainGraphSharedExecutor)->Apply(ChainGraphArgs)->UseRealTime();
+
+void BM_ChainGraphNumaNodeExecutors(benchmark::State& state) {
+  RunChainGraphBenchmark(state, /*numa_local=*/true);
+}
+BENCHMARK(BM_ChainGraphNumaNodeExecutors)
+    ->Apply(ChainGraphArgs)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace mediapipe
@@ -15,8 +15,11 @@
 #ifndef MEDIAPIPE_FRAMEWORK_OUTPUT_STREAM_POLLER_H_
 #define MEDIAPIPE_FRAMEWORK_OUTPUT_STREAM_POLLER_H_
 
+#include <functional>
 #include <memory>
+#include <vector>
 
+#include "absl/time/time.h"
 #include "mediapipe/framework/graph_output_stream.h"
 
 namespace mediapipe {
@@ -45,6 +48,54 @@ class OutputStreamPoller {
     return poller->Next(packet);
   }
 
+  // Gets the next packet without blocking. Returns false once the stream is
+  // done. Otherwise returns true and sets "packet" to the next packet, or to
+  // an empty packet if none is available yet.
+  ABSL_MUST_USE_RESULT bool TryNext(Packet* packet) {
+    auto poller = internal_poller_impl_.lock();
+    if (!poller) {
+      return false;
+    }
+    return poller->TryNext(packet);
+  }
+
+  // Waits up to "timeout" for a packet to become available, then appends all
+  // available packets, up to "max_packets", to "packets" with a single lock
+  // acquisition on the stream. Returns false once the stream is done.
+  // Otherwise returns true; if the timeout expired no packets are appended.
+  ABSL_MUST_USE_RESULT bool NextBatch(std::vector<Packet>* packets,
+                                      int max_packets, absl::Duration timeout) {
+    auto poller = internal_poller_impl_.lock();
+    if (!poller) {
+      return false;
+    }
+    return poller->NextBatch(packets, max_packets, timeout);
+  }
+
+  // Sets a callback that is invoked when packets become available, when the
+  // stream is done and when the graph fails. This lets one thread serve many
+  // pollers with TryNext() or NextBatch() instead of blocking a thread in
+  // Next() for each of them. The callback runs on a graph thread, so it must
+  // be quick and must not block; typically it enqueues the poller on the
+  // serving thread's ready list or writes to an eventfd. It may be invoked
+  // again before the packets are polled. Pass nullptr to remove the callback.
+  //
+  // Example:
+  //   poller.SetReadyCallback([&ready, id]() { ready.Push(id); });
+  //   ...
+  //   while (ready.Pop(&id)) {
+  //     std::vector<Packet> packets;
+  //     if (!pollers[id].NextBatch(&packets, 64, absl::ZeroDuration())) {
+  //       // The stream is done.
+  //     }
+  //     ...
+  //   }
+  void SetReadyCallback(std::function<void()> ready_callback) {
+    auto poller = internal_poller_impl_.lock();
+    CHECK(poller) << "OutputStreamPollerImpl is already destroyed.";
+    poller->SetReadyCallback(std::move(ready_callback));
+  }
+
   void SetMaxQueueSize(int queue_size) {
     auto poller = internal_poller_impl_.lock();
     CHECK(poller) << "OutputStreamPollerImpl is already destroyed.";
@@ -186,6 +186,7 @@ void GraphProfiler::Reset() {
     ResetTimeHistogram(calculator_profile->mutable_process_runtime());
     ResetTimeHistogram(calculator_profile->mutable_process_input_latency());
     ResetTimeHistogram(calculator_profile->mutable_process_output_latency());
+    calculator_profile->set_suppressed_notifications(0);
     for (auto& input_stream_profile :
          *(calculator_profile->mutable_input_stream_profiles())) {
       ResetTimeHistogram(input_stream_profile.mutable_latency());
@@ -421,6 +422,22 @@ void GraphProfiler::SetCloseRuntime(const CalculatorContext& calculator_context,
   }
 }
 
+void GraphProfiler::AddSuppressedNotifications(
+    const CalculatorContext& calculator_context, int64 count) {
+  absl::ReaderMutexLock lock(&profiler_mutex_);
+  if (!IsProfilerEnabled(profiler_config_)) {
+    return;
+  }
+  const std::string& node_name = calculator_context.NodeName();
+  auto profile_iter = calculator_profiles_.find(node_name);
+  CHECK(profile_iter != calculator_profiles_.end()) << absl::Substitute(
+      "Calculator \"$0\" has not been added during initialization.",
+      calculator_context.NodeName());
+  CalculatorProfile* calculator_profile = &profile_iter->second;
+  calculator_profile->set_suppressed_notifications(
+      calculator_profile->suppressed_notifications() + count);
+}
+
 void GraphProfiler::AddTimeSample(int64 start_time_usec, int64 end_time_usec,
                                   TimeHistogram* histogram) {
   CHECK_GE(end_time_usec, start_time_usec);
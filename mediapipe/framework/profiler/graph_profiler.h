@@ -147,6 +147,12 @@ class GraphProfiler : public std::enable_shared_from_this<ProfilingContext> {
   // Record a tracing event.
   void LogEvent(const TraceEvent& event);
 
+  // Adds to the number of timestamp bound notifications skipped by the input
+  // stream handler of a calculator. Unlike the runtimes, these are also
+  // recorded while paused, since they are flushed when the run is cleaned up.
+  void AddSuppressedNotifications(const CalculatorContext& calculator_context,
+                                  int64 count) LOCKS_EXCLUDED(profiler_mutex_);
+
   // Collects the runtime profile for Open(), Process(), and Close() of each
   // calculator in the graph. May be called at any time after the graph has been
   // initialized.
@@ -30,6 +30,13 @@
 namespace mediapipe {
 namespace internal {
 
+namespace {
+
+// The scheduler queue whose task the current thread is running, if any.
+thread_local SchedulerQueue* current_task_queue = nullptr;
+
+}  // namespace
+
 SchedulerQueue::Item::Item(CalculatorNode* node, CalculatorContext* cc)
     : node_(node), cc_(cc) {
   CHECK(node);
@@ -116,9 +123,22 @@ void SchedulerQueue::AddNode(CalculatorNode* node, CalculatorContext* cc) {
     CHECK(node->IsSource()) << node->DebugName();
     return;
   }
+  if (node->ProcessInline() && !node->IsSource() && CanRunInline()) {
+    VLOG(4) << node->DebugName() << " is run inline.";
+    RunCalculatorNode(node, cc, /*is_inline=*/true);
+    return;
+  }
   AddItemToQueue(Item(node, cc));
 }
 
+bool SchedulerQueue::CanRunInline() {
+  if (current_task_queue != this) {
+    return false;
+  }
+  absl::MutexLock lock(&mutex_);
+  return running_count_ > 0;
+}
+
 void SchedulerQueue::AddNodeForOpen(CalculatorNode* node) {
   if (shared_->has_error) {
     return;
@@ -205,14 +225,17 @@ void SchedulerQueue::RunNextTask() {
   // want to rely on executors setting up an autorelease pool for us (e.g.
   // an executor creating standard pthread will not, by default), so we
   // do it here to ensure all executors are covered.
+  SchedulerQueue* const enclosing_task_queue = current_task_queue;
+  current_task_queue = this;
   AUTORELEASEPOOL {
     if (is_open_node) {
       DCHECK(!calculator_context);
       OpenCalculatorNode(node);
     } else {
-      RunCalculatorNode(node, calculator_context);
+      RunCalculatorNode(node, calculator_context, /*is_inline=*/false);
     }
   }
+  current_task_queue = enclosing_task_queue;
 
   bool is_idle;
   {
@@ -228,7 +251,7 @@ void SchedulerQueue::RunNextTask() {
 }
 
 void SchedulerQueue::RunCalculatorNode(CalculatorNode* node,
-                                       CalculatorContext* cc) {
+                                       CalculatorContext* cc, bool is_inline) {
   VLOG(3) << "Running " << node->DebugName();
 
   // If we are in the process of stopping the graph (due to tool::StatusStop()
@@ -252,9 +275,11 @@ void SchedulerQueue::RunCalculatorNode(CalculatorNode* node,
   } else {
     // Note that we don't need a lock because only one thread can execute this
     // due to the lock on running_nodes.
-    int64 start_time = shared_->timer.StartNode();
+    int64 start_time = is_inline ? 0 : shared_->timer.StartNode();
     const ::mediapipe::Status result = node->ProcessNode(cc);
-    shared_->timer.EndNode(start_time);
+    if (!is_inline) {
+      shared_->timer.EndNode(start_time);
+    }
 
     if (!result.ok()) {
       if (result == tool::StatusStop()) {
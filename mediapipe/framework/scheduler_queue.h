@@ -120,7 +120,8 @@ class SchedulerQueue : public TaskQueue {
   // Adds a node and a calculator context to the scheduler queue if the node is
   // not already running. Note that if the node was running, then it will be
   // rescheduled upon completion (after checking dependencies), so this call is
-  // not lost.
+  // not lost. A non-source node that asked to run inline is run right away
+  // instead, if the calling thread is running a task of this queue.
   void AddNode(CalculatorNode* node, CalculatorContext* cc)
       LOCKS_EXCLUDED(mutex_);
 
@@ -134,9 +135,14 @@ class SchedulerQueue : public TaskQueue {
 
  private:
   // Used internally by RunNextTask. Invokes ProcessNode or CloseNode, followed
-  // by EndScheduling.
-  void RunCalculatorNode(CalculatorNode* node, CalculatorContext* cc)
-      LOCKS_EXCLUDED(mutex_);
+  // by EndScheduling. An inline invocation is not timed separately, since it
+  // is part of the time of the enclosing task.
+  void RunCalculatorNode(CalculatorNode* node, CalculatorContext* cc,
+                         bool is_inline) LOCKS_EXCLUDED(mutex_);
+
+  // Returns true if a node can run inline on the calling thread: the thread
+  // is running a task of this queue, and the queue is running.
+  bool CanRunInline() LOCKS_EXCLUDED(mutex_);
 
   // Used internally by RunNextTask. Invokes OpenNode, followed by
   // CheckIfBecameReady.
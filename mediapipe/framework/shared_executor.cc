@@ -0,0 +1,80 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/framework/shared_executor.h"
+
+#include <map>
+#include <utility>
+
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+#include "mediapipe/util/cpu_util.h"
+
+namespace mediapipe {
+
+std::shared_ptr<Executor> GetSharedThreadPoolExecutor(const std::string& name,
+                                                      int num_threads) {
+  static absl::Mutex* mutex = new absl::Mutex;
+  static auto* executors =
+      new std::map<std::string, std::shared_ptr<Executor>>();
+  absl::MutexLock lock(mutex);
+  std::shared_ptr<Executor>& executor = (*executors)[name];
+  if (!executor) {
+    executor = std::make_shared<ThreadPoolExecutor>(
+        num_threads > 0 ? num_threads : NumCPUCores());
+  }
+  return executor;
+}
+
+FairShareExecutor::FairShareExecutor(std::shared_ptr<Executor> shared_executor,
+                                     int max_in_flight)
+    : shared_executor_(std::move(shared_executor)),
+      max_in_flight_(max_in_flight) {
+  CHECK(shared_executor_);
+  CHECK_GT(max_in_flight_, 0);
+}
+
+void FairShareExecutor::Schedule(std::function<void()> task) {
+  {
+    absl::MutexLock lock(&mutex_);
+    if (num_in_flight_ >= max_in_flight_) {
+      pending_.push_back(std::move(task));
+      return;
+    }
+    ++num_in_flight_;
+  }
+  Forward(std::move(task));
+}
+
+void FairShareExecutor::Forward(std::function<void()> task) {
+  std::shared_ptr<FairShareExecutor> self = shared_from_this();
+  shared_executor_->Schedule([self, task]() {
+    task();
+    std::function<void()> next;
+    {
+      absl::MutexLock lock(&self->mutex_);
+      if (self->pending_.empty()) {
+        --self->num_in_flight_;
+        return;
+      }
+      next = std::move(self->pending_.front());
+      self->pending_.pop_front();
+    }
+    // The next task goes to the back of the shared queue, behind the tasks
+    // of other executors.
+    self->Forward(std::move(next));
+  });
+}
+
+}  // namespace mediapipe
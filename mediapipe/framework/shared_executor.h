@@ -0,0 +1,75 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_FRAMEWORK_SHARED_EXECUTOR_H_
+#define MEDIAPIPE_FRAMEWORK_SHARED_EXECUTOR_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/executor.h"
+
+namespace mediapipe {
+
+// Returns the process-wide ThreadPoolExecutor registered under "name",
+// creating it with "num_threads" threads on the first call for that name. A
+// non-positive "num_threads" means one thread per core. Later calls return
+// the same executor whatever their "num_threads". The executors live until
+// the process exits.
+//
+// Graphs that each create their own default thread pool multiply the thread
+// count by the number of graph instances. Graphs given a shared executor with
+// CalculatorGraph::SetExecutor() run on a fixed set of threads instead.
+std::shared_ptr<Executor> GetSharedThreadPoolExecutor(const std::string& name,
+                                                      int num_threads);
+
+// An Executor that runs its tasks on a shared executor, keeping at most
+// "max_in_flight" of its tasks queued or running there at any time. The rest
+// wait in a local queue and are passed on as earlier tasks finish.
+//
+// Giving each graph its own FairShareExecutor over one shared executor bounds
+// how much of the shared queue one busy graph can occupy. Since the shared
+// queue is FIFO, the ready tasks of all graphs are interleaved and no graph
+// starves behind another.
+//
+// Must be created with std::make_shared, since queued tasks keep the executor
+// alive until they have run.
+class FairShareExecutor
+    : public Executor,
+      public std::enable_shared_from_this<FairShareExecutor> {
+ public:
+  FairShareExecutor(std::shared_ptr<Executor> shared_executor,
+                    int max_in_flight);
+
+  void Schedule(std::function<void()> task) override;
+
+ private:
+  // Passes "task" to the shared executor. When it finishes, the next local
+  // task, if any, takes its place.
+  void Forward(std::function<void()> task);
+
+  const std::shared_ptr<Executor> shared_executor_;
+  const int max_in_flight_;
+  absl::Mutex mutex_;
+  std::deque<std::function<void()>> pending_ GUARDED_BY(mutex_);
+  int num_in_flight_ GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_FRAMEWORK_SHARED_EXECUTOR_H_
@@ -31,11 +31,94 @@ DefaultInputStreamHandler::DefaultInputStreamHandler(
     SetBatchSize(options.GetExtension(DefaultInputStreamHandlerOptions::ext)
                      .batch_size());
   }
+  track_streams_ = NumInputStreams() > kMaxStreamsToScan;
+  if (track_streams_) {
+    while (num_leaves_ < NumInputStreams()) {
+      num_leaves_ *= 2;
+    }
+    tree_.assign(2 * num_leaves_, StreamState{Timestamp::Done(), false});
+  }
+}
+
+void DefaultInputStreamHandler::PrepareForRun(
+    std::function<void()> headers_ready_callback,
+    std::function<void()> notification_callback,
+    std::function<void(CalculatorContext*)> schedule_callback,
+    std::function<void(::mediapipe::Status)> error_callback) {
+  InputStreamHandler::PrepareForRun(
+      std::move(headers_ready_callback), std::move(notification_callback),
+      std::move(schedule_callback), std::move(error_callback));
+  UpdateAllStreams();
+}
+
+void DefaultInputStreamHandler::LoadStreamState(CollectionItemId id) {
+  StreamState& leaf = tree_[num_leaves_ + id.value()];
+  leaf.timestamp =
+      input_stream_managers_.Get(id)->MinTimestampOrBound(&leaf.empty);
+}
+
+bool DefaultInputStreamHandler::StreamUpdated(CollectionItemId id) {
+  if (!track_streams_) {
+    return true;
+  }
+  // The stream state is read under readiness_mutex_, so that concurrent
+  // updates of a stream cannot store an outdated state.
+  absl::MutexLock lock(&readiness_mutex_);
+  const StreamState old_root = tree_[1];
+  LoadStreamState(id);
+  for (int i = (num_leaves_ + id.value()) / 2; i >= 1; i /= 2) {
+    tree_[i] = MinState(tree_[2 * i], tree_[2 * i + 1]);
+  }
+  // Every other change of the root has either notified the node or, as in
+  // FillInputSet(), been made while the node was being scheduled, in which
+  // case the scheduling loop reads the root again.
+  return tree_[1].timestamp != old_root.timestamp ||
+         tree_[1].empty != old_root.empty;
+}
+
+void DefaultInputStreamHandler::UpdateAllStreams() {
+  if (!track_streams_) {
+    return;
+  }
+  absl::MutexLock lock(&readiness_mutex_);
+  for (CollectionItemId id = input_stream_managers_.BeginId();
+       id < input_stream_managers_.EndId(); ++id) {
+    LoadStreamState(id);
+  }
+  for (int i = num_leaves_ - 1; i >= 1; --i) {
+    tree_[i] = MinState(tree_[2 * i], tree_[2 * i + 1]);
+  }
 }
 
 NodeReadiness DefaultInputStreamHandler::GetNodeReadiness(
     Timestamp* min_stream_timestamp) {
   DCHECK(min_stream_timestamp);
+  if (!track_streams_) {
+    return ScanNodeReadiness(min_stream_timestamp);
+  }
+  StreamState min_state;
+  {
+    absl::MutexLock lock(&readiness_mutex_);
+    min_state = tree_[1];
+  }
+  *min_stream_timestamp = min_state.timestamp;
+
+  if (*min_stream_timestamp == Timestamp::Done()) {
+    return NodeReadiness::kReadyForClose;
+  }
+
+  // Since MinState() prefers empty streams on a tie, the minimum state is
+  // non-empty only if the bound of every empty stream is greater than the
+  // smallest timestamp of any stream.
+  if (!min_state.empty) {
+    return NodeReadiness::kReadyForProcess;
+  }
+
+  return NodeReadiness::kNotReady;
+}
+
+NodeReadiness DefaultInputStreamHandler::ScanNodeReadiness(
+    Timestamp* min_stream_timestamp) {
   *min_stream_timestamp = Timestamp::Done();
   Timestamp min_bound = Timestamp::Done();
   for (const auto& stream : input_stream_managers_) {
@@ -76,6 +159,7 @@ void DefaultInputStreamHandler::FillInputSet(Timestamp input_timestamp,
     AddPacketToShard(&input_set->Get(id), std::move(current_packet),
                      stream_is_done);
   }
+  UpdateAllStreams();
 }
 
 }  // namespace mediapipe
@@ -15,9 +15,11 @@
 #ifndef MEDIAPIPE_FRAMEWORK_STREAM_HANDLER_DEFAULT_INPUT_STREAM_HANDLER_H_
 #define MEDIAPIPE_FRAMEWORK_STREAM_HANDLER_DEFAULT_INPUT_STREAM_HANDLER_H_
 
+#include <functional>
 #include <memory>
 #include <vector>
 
+#include "absl/synchronization/mutex.h"
 // TODO: Move protos in another CL after the C++ code migration.
 #include "mediapipe/framework/input_stream_handler.h"
 #include "mediapipe/framework/stream_handler/default_input_stream_handler.pb.h"
@@ -34,17 +36,79 @@ class DefaultInputStreamHandler : public InputStreamHandler {
                             const MediaPipeOptions& options,
                             bool calculator_run_in_parallel);
 
+  // Also loads the initial state of the input streams.
+  void PrepareForRun(
+      std::function<void()> headers_ready_callback,
+      std::function<void()> notification_callback,
+      std::function<void(CalculatorContext*)> schedule_callback,
+      std::function<void(::mediapipe::Status)> error_callback) override;
+
  protected:
   // In DefaultInputStreamHandler, a node is "ready" if:
   // - all streams are done (need to call Close() in this case), or
   // - the minimum bound (over all empty streams) is greater than the smallest
   //   timestamp of any stream, which means we have received all the packets
   //   that will be available at the next timestamp.
+  // For nodes with many input streams, the state of each stream is updated as
+  // its packets and timestamp bounds arrive, so that this check takes
+  // constant time and no stream locks.
   NodeReadiness GetNodeReadiness(Timestamp* min_stream_timestamp) override;
 
   // Only invoked when associated GetNodeReadiness() returned kReadyForProcess.
   void FillInputSet(Timestamp input_timestamp,
                     InputStreamShardSet* input_set) override;
+
+  // Returns false if the minimum of the stream states is unchanged, since
+  // GetNodeReadiness() reads nothing else. This lets sparse streams advance
+  // their timestamp bounds without waking up the node each time.
+  bool StreamUpdated(CollectionItemId id) override;
+
+  // Reloads the state of every input stream. Subclasses that modify the
+  // streams directly, rather than through the InputStreamHandler methods,
+  // must call this afterwards.
+  void UpdateAllStreams();
+
+ private:
+  // Nodes with up to this many input streams scan the streams on every
+  // readiness check instead, which is cheaper than maintaining tree_.
+  static constexpr int kMaxStreamsToScan = 4;
+
+  // Computes the readiness by reading the state of every stream.
+  NodeReadiness ScanNodeReadiness(Timestamp* min_stream_timestamp);
+
+  // The state of a stream that determines the readiness of the node: its
+  // MinTimestampOrBound() and whether its queue is empty.
+  struct StreamState {
+    Timestamp timestamp;
+    bool empty;
+  };
+
+  // Returns the state that should be considered first: the one with the lower
+  // timestamp, and on a tie the empty one, since an empty stream at the
+  // minimum timestamp holds back the node.
+  static const StreamState& MinState(const StreamState& a,
+                                     const StreamState& b) {
+    if (a.timestamp != b.timestamp) {
+      return a.timestamp < b.timestamp ? a : b;
+    }
+    return a.empty ? a : b;
+  }
+
+  // Reads the state of a stream into its leaf of tree_.
+  void LoadStreamState(CollectionItemId id)
+      EXCLUSIVE_LOCKS_REQUIRED(readiness_mutex_);
+
+  // Whether the readiness is computed from tree_.
+  bool track_streams_ = false;
+  absl::Mutex readiness_mutex_;
+  // A tournament tree over the stream states, stored as an implicit binary
+  // tree: tree_[1] is the root, the children of tree_[i] are tree_[2 * i] and
+  // tree_[2 * i + 1], and the state of stream i is in tree_[num_leaves_ + i].
+  // Each inner node holds the MinState() of its children, so the root is the
+  // minimum over all streams, and updating a stream takes O(log n). Unused
+  // leaves hold a done, non-empty state, which never wins.
+  int num_leaves_ = 1;
+  std::vector<StreamState> tree_ GUARDED_BY(readiness_mutex_);
 };
 
 }  // namespace mediapipe
@@ -14,6 +14,7 @@
 
 #include <vector>
 
+#include "absl/strings/str_cat.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/gmock.h"
 #include "mediapipe/framework/port/gtest.h"
@@ -279,5 +280,170 @@ TEST(DefaultInputStreamHandlerTest, DoesntPropagateTimestampWhenBatching) {
   EXPECT_EQ(4, sink.size());
 }
 
+// Returns a graph with a PassThroughCalculator connecting "num_streams" graph
+// input streams "input<i>" to the output streams "output<i>", each with a
+// vector sink writing to "sinks". Nodes with more than four input streams
+// track the readiness of their streams incrementally.
+CalculatorGraphConfig WidePassThroughGraph(
+    int num_streams, std::vector<std::vector<Packet>>* sinks) {
+  CalculatorGraphConfig config;
+  auto* node = config.add_node();
+  node->set_calculator("PassThroughCalculator");
+  sinks->resize(num_streams);
+  for (int i = 0; i < num_streams; ++i) {
+    config.add_input_stream(absl::StrCat("input", i));
+    node->add_input_stream(absl::StrCat("input", i));
+    node->add_output_stream(absl::StrCat("output", i));
+  }
+  for (int i = 0; i < num_streams; ++i) {
+    tool::AddVectorSink(absl::StrCat("output", i), &config, &(*sinks)[i]);
+  }
+  return config;
+}
+
+// Checks that a node with many input streams is run only once every stream
+// has a packet or a higher timestamp bound.
+TEST(DefaultInputStreamHandlerTest, WideNodeWaitsForEveryStream) {
+  constexpr int kNumStreams = 8;
+  std::vector<std::vector<Packet>> sinks;
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(
+      graph.Initialize(WidePassThroughGraph(kNumStreams, &sinks)));
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+
+  for (int i = 0; i < kNumStreams - 1; ++i) {
+    MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+        absl::StrCat("input", i), MakePacket<int>(i).At(Timestamp(1))));
+    MEDIAPIPE_ASSERT_OK(graph.WaitUntilIdle());
+    for (int j = 0; j < kNumStreams; ++j) {
+      EXPECT_TRUE(sinks[j].empty());
+    }
+  }
+  // The last stream moves past timestamp 1, which releases the other streams.
+  MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+      absl::StrCat("input", kNumStreams - 1),
+      MakePacket<int>(kNumStreams - 1).At(Timestamp(2))));
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilIdle());
+  for (int i = 0; i < kNumStreams - 1; ++i) {
+    ASSERT_EQ(1, sinks[i].size());
+    EXPECT_EQ(Timestamp(1), sinks[i][0].Timestamp());
+  }
+  EXPECT_TRUE(sinks[kNumStreams - 1].empty());
+
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  ASSERT_EQ(1, sinks[kNumStreams - 1].size());
+  EXPECT_EQ(Timestamp(2), sinks[kNumStreams - 1][0].Timestamp());
+}
+
+// Fills the streams of a wide node one after another, each with packets at
+// different timestamps, and checks that every packet is delivered.
+TEST(DefaultInputStreamHandlerTest, WideNodeDeliversSparseStreams) {
+  constexpr int kNumStreams = 16;
+  constexpr int kNumTimestamps = 30;
+  std::vector<std::vector<Packet>> sinks;
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(
+      graph.Initialize(WidePassThroughGraph(kNumStreams, &sinks)));
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+  // Stream i has packets at the multiples of i + 1.
+  for (int i = kNumStreams - 1; i >= 0; --i) {
+    for (int t = 0; t < kNumTimestamps; t += i + 1) {
+      MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+          absl::StrCat("input", i), MakePacket<int>(t).At(Timestamp(t))));
+    }
+    MEDIAPIPE_ASSERT_OK(graph.CloseInputStream(absl::StrCat("input", i)));
+  }
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+
+  for (int i = 0; i < kNumStreams; ++i) {
+    std::vector<int> timestamps;
+    for (const Packet& packet : sinks[i]) {
+      EXPECT_EQ(packet.Timestamp().Value(), packet.Get<int>());
+      timestamps.push_back(packet.Get<int>());
+    }
+    std::vector<int> expected;
+    for (int t = 0; t < kNumTimestamps; t += i + 1) {
+      expected.push_back(t);
+    }
+    EXPECT_EQ(expected, timestamps) << "output" << i;
+  }
+}
+
+// Advances the timestamp bound of every output stream past each input packet,
+// without sending any packets.
+class BoundOnlyCalculator : public CalculatorBase {
+ public:
+  static ::mediapipe::Status GetContract(CalculatorContract* cc) {
+    cc->Inputs().Index(0).SetAny();
+    for (CollectionItemId id = cc->Outputs().BeginId();
+         id < cc->Outputs().EndId(); ++id) {
+      cc->Outputs().Get(id).SetAny();
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Process(CalculatorContext* cc) final {
+    for (CollectionItemId id = cc->Outputs().BeginId();
+         id < cc->Outputs().EndId(); ++id) {
+      cc->Outputs().Get(id).SetNextTimestampBound(
+          cc->InputTimestamp().NextAllowedInStream());
+    }
+    return ::mediapipe::OkStatus();
+  }
+};
+REGISTER_CALCULATOR(BoundOnlyCalculator);
+
+// Checks that timestamp bound updates which cannot make a wide node ready are
+// not notified, and that they are reported in the node's counters.
+TEST(DefaultInputStreamHandlerTest, WideNodeSkipsBoundOnlyNotifications) {
+  constexpr int kNumStreams = 8;
+  constexpr int kNumTicks = 10;
+  std::vector<std::vector<Packet>> sinks;
+  CalculatorGraphConfig config = WidePassThroughGraph(kNumStreams, &sinks);
+  // Streams 1 to kNumStreams - 1 only receive timestamp bounds, one for each
+  // packet on "tick", while stream 0 holds back the node.
+  config.add_input_stream("tick");
+  CalculatorGraphConfig::Node* bounds = config.add_node();
+  bounds->set_calculator("BoundOnlyCalculator");
+  bounds->add_input_stream("tick");
+  CalculatorGraphConfig::Node* wide = config.mutable_node(0);
+  wide->set_name("wide");
+  for (int i = 1; i < kNumStreams; ++i) {
+    bounds->add_output_stream(absl::StrCat("bound", i));
+    wide->set_input_stream(i, absl::StrCat("bound", i));
+  }
+  CalculatorGraph graph;
+  MEDIAPIPE_ASSERT_OK(graph.Initialize(config));
+  MEDIAPIPE_ASSERT_OK(graph.StartRun({}));
+
+  for (int t = 0; t < kNumTicks; ++t) {
+    MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+        "tick", MakePacket<int>(t).At(Timestamp(t))));
+  }
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilIdle());
+  MEDIAPIPE_ASSERT_OK(graph.AddPacketToInputStream(
+      "input0", MakePacket<int>(0).At(Timestamp(kNumTicks / 2))));
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilIdle());
+  ASSERT_EQ(1, sinks[0].size());
+  EXPECT_EQ(Timestamp(kNumTicks / 2), sinks[0][0].Timestamp());
+
+  // Closing "tick" moves the bounds of streams 1 to kNumStreams - 1 to
+  // Timestamp::Done(), which still leaves the node waiting for stream 0.
+  MEDIAPIPE_ASSERT_OK(graph.CloseInputStream("tick"));
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilIdle());
+  MEDIAPIPE_ASSERT_OK(graph.CloseInputStream("input0"));
+  MEDIAPIPE_ASSERT_OK(graph.CloseAllInputStreams());
+  MEDIAPIPE_ASSERT_OK(graph.WaitUntilDone());
+  for (int i = 1; i < kNumStreams; ++i) {
+    EXPECT_TRUE(sinks[i].empty());
+  }
+  // Only the notification for closing stream 0 was needed.
+  EXPECT_EQ((kNumStreams - 1) * (kNumTicks + 1),
+            graph.GetCounterFactory()
+                ->GetCounter("wide-SuppressedNotifications")
+                ->Get());
+}
+
 }  // namespace
 }  // namespace mediapipe
@@ -144,7 +144,10 @@ class FixedSizeInputStreamHandler : public DefaultInputStreamHandler {
 
   void EraseSurplusPackets(bool keep_one)
       EXCLUSIVE_LOCKS_REQUIRED(erase_mutex_) {
-    return (fixed_min_size_) ? EraseAllSurplus() : EraseAnySurplus(keep_one);
+    (fixed_min_size_) ? EraseAllSurplus() : EraseAnySurplus(keep_one);
+    // The packets are erased from the streams directly, so the readiness
+    // state of DefaultInputStreamHandler must be reloaded.
+    UpdateAllStreams();
   }
 
   NodeReadiness GetNodeReadiness(Timestamp* min_stream_timestamp) {
@@ -14,7 +14,13 @@
 
 #include "mediapipe/framework/thread_pool_executor.h"
 
+#if defined(__linux__)
+#include <sched.h>
+#endif  // defined(__linux__)
+
+#include <set>
 #include <utility>
+#include <vector>
 
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/logging.h"
@@ -24,6 +30,43 @@
 
 namespace mediapipe {
 
+#if defined(__linux__)
+namespace {
+
+// Returns the CPUs in both "cpus" and "numa_node_cpus", where an empty "cpus"
+// stands for all CPUs.
+std::set<int> IntersectCpuSets(const std::set<int>& cpus,
+                               const std::set<int>& numa_node_cpus) {
+  std::set<int> result;
+  for (int cpu : numa_node_cpus) {
+    if (cpus.empty() || cpus.count(cpu)) {
+      result.insert(cpu);
+    }
+  }
+  return result;
+}
+
+// Returns the CPUs the process is allowed to run on, or an empty set if the
+// affinity mask cannot be read.
+std::set<int> ProcessCpuSet() {
+  std::set<int> result;
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &cpu_set) != 0) {
+    LOG(WARNING) << "Cannot get the CPU affinity of the process.";
+    return result;
+  }
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &cpu_set)) {
+      result.insert(cpu);
+    }
+  }
+  return result;
+}
+
+}  // namespace
+#endif  // defined(__linux__)
+
 // static
 ::mediapipe::StatusOr<Executor*> ThreadPoolExecutor::Create(
     const MediaPipeOptions& extendable_options) {
@@ -70,6 +113,42 @@ namespace mediapipe {
     default:
       break;
   }
+  if (options.has_numa_node()) {
+    const std::vector<std::set<int>> numa_nodes = InferNumaNodeCoreIds();
+    const int node = options.numa_node();
+    if (node >= 0 && node < static_cast<int>(numa_nodes.size()) &&
+        !numa_nodes[node].empty()) {
+      // The threads can only run on the CPUs of the node that are also in the
+      // affinity mask of the process.
+      const std::set<int> node_cpus =
+          IntersectCpuSets(ProcessCpuSet(), numa_nodes[node]);
+      if (node_cpus.empty()) {
+        LOG(WARNING) << "The process is not allowed to run on NUMA node "
+                     << node << ". Ignore the numa_node setting.";
+      } else {
+        std::set<int> cpus =
+            IntersectCpuSets(thread_options.cpu_set(), node_cpus);
+        if (cpus.empty()) {
+          LOG(WARNING) << "NUMA node " << node
+                       << " has no CPU with the required processor "
+                          "performance. Use all the CPUs of the node.";
+          cpus = node_cpus;
+        }
+        thread_options.set_cpu_set(cpus);
+      }
+    } else {
+      LOG(WARNING) << "NUMA node " << node
+                   << " was not found. Ignore the numa_node setting.";
+    }
+  }
+  if (options.pin_threads_to_cores()) {
+    if (thread_options.cpu_set().empty()) {
+      // Pin to the CPUs in the affinity mask, which may be a sparse subset of
+      // the machine, e.g. under taskset or a container cpuset.
+      thread_options.set_cpu_set(ProcessCpuSet());
+    }
+    thread_options.set_one_cpu_per_thread(true);
+  }
 #endif
   return new ThreadPoolExecutor(thread_options, options.num_threads());
 }
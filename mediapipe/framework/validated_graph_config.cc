@@ -443,6 +443,10 @@ std::string NodeTypeInfo::NodeTypeToString(NodeType node_type) {
 
   RETURN_IF_ERROR(ValidateExecutors());
 
+  if (config_.fuse_calculator_chains()) {
+    FuseCalculatorChains();
+  }
+
 #if !defined(MEDIAPIPE_MOBILE)
   VLOG(1) << "ValidatedGraphConfig produced canonical config:\n"
           << config_.DebugString();
@@ -968,6 +972,44 @@ NodeTypeInfo::NodeRef ValidatedGraphConfig::NodeForSorterIndex(
   return ::mediapipe::OkStatus();
 }
 
+void ValidatedGraphConfig::FuseCalculatorChains() {
+  std::vector<int> num_consumers(output_streams_.size(), 0);
+  for (const EdgeInfo& input_stream : input_streams_) {
+    if (input_stream.upstream >= 0) {
+      ++num_consumers[input_stream.upstream];
+    }
+  }
+  for (NodeTypeInfo& node_type_info : calculators_) {
+    if (node_type_info.InputStreamTypes().NumEntries() != 1) {
+      continue;
+    }
+    const EdgeInfo& input_stream =
+        input_streams_[node_type_info.InputStreamBaseIndex()];
+    if (input_stream.back_edge || input_stream.upstream < 0 ||
+        num_consumers[input_stream.upstream] != 1) {
+      continue;
+    }
+    const NodeTypeInfo::NodeRef& producer =
+        output_streams_[input_stream.upstream].parent_node;
+    if (producer.type != NodeTypeInfo::NodeType::CALCULATOR ||
+        calculators_[producer.index].OutputStreamTypes().NumEntries() != 1) {
+      continue;
+    }
+    const CalculatorGraphConfig::Node& node_config =
+        config_.node(node_type_info.Node().index);
+    const CalculatorGraphConfig::Node& producer_config =
+        config_.node(producer.index);
+    if (node_config.executor() != producer_config.executor() ||
+        node_config.max_in_flight() > 1 ||
+        producer_config.max_in_flight() > 1) {
+      continue;
+    }
+    VLOG(1) << "Fusing " << DebugName(node_config) << " with its producer "
+            << DebugName(producer_config) << ".";
+    node_type_info.SetFusedWithProducer(true);
+  }
+}
+
 // static
 bool ValidatedGraphConfig::IsReservedExecutorName(const std::string& name) {
   return name == "default" || name == "gpu" || absl::StartsWith(name, "__");
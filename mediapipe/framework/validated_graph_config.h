@@ -176,6 +176,12 @@ class NodeTypeInfo {
   // This function is only valid for a NodeTypeInfo of NodeType CALCULATOR.
   bool AddSource(int index) { return ancestor_sources_.insert(index).second; }
 
+  // Returns true if the node is fused with the node producing its input
+  // stream, see CalculatorGraphConfig::fuse_calculator_chains.
+  // This function is only valid for a NodeTypeInfo of NodeType CALCULATOR.
+  bool FusedWithProducer() const { return fused_with_producer_; }
+  void SetFusedWithProducer(bool fused) { fused_with_producer_ = fused; }
+
   // Convert the NodeType enum into a std::string (generally for error
   // messaging).
   static std::string NodeTypeToString(NodeType node_type);
@@ -214,6 +220,9 @@ class NodeTypeInfo {
 
   // The set of sources which affect this node.
   std::unordered_set<int> ancestor_sources_;
+
+  // Whether the node is run in the task of the node producing its input.
+  bool fused_with_producer_ = false;
 };
 
 // Information for either the input or output side of an edge.  An edge
@@ -414,6 +423,10 @@ class ValidatedGraphConfig {
   // Compute the dependence of nodes on sources.
   ::mediapipe::Status ComputeSourceDependence();
 
+  // Marks the calculators that are fused with the calculator producing their
+  // input stream, see CalculatorGraphConfig::fuse_calculator_chains.
+  void FuseCalculatorChains();
+
   // Infer the type of types set to "Any" by what they are connected to.
   ::mediapipe::Status ResolveAnyTypes(std::vector<EdgeInfo>* input_edges,
                                       std::vector<EdgeInfo>* output_edges);
@@ -60,6 +60,25 @@ cv::Scalar MediapipeColorToOpenCVColor(const Color& color) {
                     static_cast<int32>(color.g() * 255.0f),
                     static_cast<int32>(color.b() * 255.0f));
 }
+
+cv::Scalar CommandColorToOpenCVColor(const RenderCommand& command) {
+  return cv::Scalar(static_cast<int32>(command.color_r * 255.0f),
+                    static_cast<int32>(command.color_g * 255.0f),
+                    static_cast<int32>(command.color_b * 255.0f));
+}
+
+bool HasSameColor(const RenderCommand& a, const RenderCommand& b) {
+  return a.color_r == b.color_r && a.color_g == b.color_g &&
+         a.color_b == b.color_b;
+}
+
+// Returns true if the command is drawn with antialiasing, which blends its
+// edges with the pixels below.
+bool IsAntialiased(const RenderCommand& command) {
+  return (command.type == RenderCommand::ROUNDED_RECTANGLE ||
+          command.type == RenderCommand::FILLED_ROUNDED_RECTANGLE) &&
+         command.line_type == cv::LINE_AA;
+}
 }  // namespace
 
 void AnnotationRenderer::RenderDataOnImage(const RenderData& render_data) {
@@ -91,16 +110,174 @@ void AnnotationRenderer::RenderDataOnImage(const RenderData& render_data) {
   }
 }
 
+void AnnotationRenderer::RenderCommandsOnImage(
+    const RenderCommandBuffer& commands) {
+  const std::vector<RenderCommand>& all_commands = commands.commands();
+  int begin = 0;
+  while (begin < all_commands.size()) {
+    // Commands of one color give the same image in any order unless one of
+    // them blends with the image. Within such a run the rectangle outlines are
+    // collected and drawn with one call per thickness at the end of the run.
+    const RenderCommand& first = all_commands[begin];
+    int end = begin + 1;
+    if (!IsAntialiased(first)) {
+      while (end < all_commands.size() &&
+             HasSameColor(first, all_commands[end]) &&
+             !IsAntialiased(all_commands[end])) {
+        ++end;
+      }
+    }
+    int num_batches = 0;
+    for (int i = begin; i < end; ++i) {
+      const RenderCommand& command = all_commands[i];
+      const int thickness = command.thickness;
+      if (command.type != RenderCommand::RECTANGLE || thickness <= 0) {
+        DrawCommand(commands, command);
+        continue;
+      }
+      const cv::Point p0 = ToPixel(command.normalized, command.x0, command.y0);
+      const cv::Point p1 = ToPixel(command.normalized, command.x1, command.y1);
+      const cv::Rect rect(p0.x, p0.y, p1.x - p0.x, p1.y - p0.y);
+      if (rect.width <= 0 || rect.height <= 0) {
+        // Left to cv::rectangle(), which skips or draws these depending on the
+        // OpenCV version.
+        DrawCommand(commands, command);
+        continue;
+      }
+      int batch = 0;
+      while (batch < num_batches &&
+             rectangle_batches_[batch].thickness != thickness) {
+        ++batch;
+      }
+      if (batch == num_batches) {
+        if (num_batches == rectangle_batches_.size()) {
+          rectangle_batches_.emplace_back();
+        }
+        rectangle_batches_[batch].thickness = thickness;
+        rectangle_batches_[batch].corners.clear();
+        ++num_batches;
+      }
+      // The outline cv::rectangle() draws for a cv::Rect.
+      const cv::Point first = rect.tl() - stripe_origin_;
+      const cv::Point last = rect.br() - cv::Point(1, 1) - stripe_origin_;
+      std::vector<cv::Point>& corners = rectangle_batches_[batch].corners;
+      corners.push_back(first);
+      corners.emplace_back(last.x, first.y);
+      corners.push_back(last);
+      corners.emplace_back(first.x, last.y);
+    }
+    for (int batch = 0; batch < num_batches; ++batch) {
+      DrawRectangles(rectangle_batches_[batch].corners,
+                     CommandColorToOpenCVColor(first),
+                     rectangle_batches_[batch].thickness);
+    }
+    begin = end;
+  }
+}
+
+void AnnotationRenderer::DrawCommand(const RenderCommandBuffer& commands,
+                                     const RenderCommand& command) {
+  const cv::Scalar color = CommandColorToOpenCVColor(command);
+  const int thickness = command.thickness;
+  const cv::Point p0 = ToPixel(command.normalized, command.x0, command.y0);
+  const cv::Point p1 = ToPixel(command.normalized, command.x1, command.y1);
+  switch (command.type) {
+    case RenderCommand::RECTANGLE:
+      cv::rectangle(mat_image_,
+                    cv::Rect(p0.x, p0.y, p1.x - p0.x, p1.y - p0.y) -
+                        stripe_origin_,
+                    color, thickness);
+      break;
+    case RenderCommand::FILLED_RECTANGLE:
+      cv::rectangle(mat_image_,
+                    cv::Rect(p0.x, p0.y, p1.x - p0.x, p1.y - p0.y) -
+                        stripe_origin_,
+                    color, -1);
+      break;
+    case RenderCommand::ROUNDED_RECTANGLE:
+      DrawRoundedRectangle(mat_image_, p0 - stripe_origin_,
+                           p1 - stripe_origin_, color, thickness,
+                           command.line_type, command.corner_radius);
+      break;
+    case RenderCommand::FILLED_ROUNDED_RECTANGLE:
+      DrawRoundedRectangle(mat_image_, p0 - stripe_origin_,
+                           p1 - stripe_origin_, color, -1, command.line_type,
+                           command.corner_radius);
+      break;
+    case RenderCommand::OVAL:
+    case RenderCommand::FILLED_OVAL: {
+      const cv::Point center((p0.x + p1.x) / 2, (p0.y + p1.y) / 2);
+      const cv::Size size((p1.x - p0.x) / 2, (p1.y - p0.y) / 2);
+      cv::ellipse(mat_image_, center - stripe_origin_, size, 0, 0, 360, color,
+                  command.type == RenderCommand::OVAL ? thickness : -1);
+      break;
+    }
+    case RenderCommand::POINT:
+      cv::circle(mat_image_, p0 - stripe_origin_, thickness, color, thickness);
+      break;
+    case RenderCommand::LINE:
+      cv::line(mat_image_, p0 - stripe_origin_, p1 - stripe_origin_, color,
+               thickness);
+      break;
+    case RenderCommand::ARROW:
+      DrawArrow(p0, p1, color, thickness);
+      break;
+    case RenderCommand::TEXT: {
+      const int font_size =
+          command.normalized
+              ? static_cast<int>(round(command.font_height * image_height_))
+              : static_cast<int>(command.font_height);
+      DrawText(commands.text(command), p0, command.font_face, font_size, color,
+               thickness);
+      break;
+    }
+  }
+}
+
+void AnnotationRenderer::DrawRectangles(const std::vector<cv::Point>& corners,
+                                        const cv::Scalar& color,
+                                        int thickness) {
+  const int num_rectangles = corners.size() / 4;
+  if (num_rectangles == 0) return;
+  std::vector<const cv::Point*> contours(num_rectangles);
+  const std::vector<int> num_points(num_rectangles, 4);
+  for (int i = 0; i < num_rectangles; ++i) {
+    contours[i] = &corners[i * 4];
+  }
+  cv::polylines(mat_image_, contours.data(), num_points.data(), num_rectangles,
+                /*isClosed=*/true, color, thickness);
+}
+
+cv::Point AnnotationRenderer::ToPixel(bool normalized, double x,
+                                      double y) const {
+  int x_px = static_cast<int>(x);
+  int y_px = static_cast<int>(y);
+  if (normalized) {
+    CHECK(NormalizedtoPixelCoordinates(x, y, image_width_, image_height_,
+                                       &x_px, &y_px));
+  }
+  return cv::Point(x_px, y_px);
+}
+
 void AnnotationRenderer::AdoptImage(cv::Mat* input_image) {
+  AdoptImageStripe(input_image, 0, input_image->rows);
+}
+
+void AnnotationRenderer::AdoptImageStripe(cv::Mat* input_image, int row_begin,
+                                          int row_end) {
+  CHECK_LE(0, row_begin);
+  CHECK_LE(row_begin, row_end);
+  CHECK_LE(row_end, input_image->rows);
   image_width_ = input_image->cols;
   image_height_ = input_image->rows;
 
   // No pixel data copy here, only headers are copied.
-  mat_image_ = *input_image;
+  mat_image_ = input_image->rowRange(row_begin, row_end);
+  stripe_origin_ = cv::Point(0, row_begin);
 }
 
-int AnnotationRenderer::GetImageWidth() const { return mat_image_.cols; }
-int AnnotationRenderer::GetImageHeight() const { return mat_image_.rows; }
+int AnnotationRenderer::GetImageWidth() const { return image_width_; }
+int AnnotationRenderer::GetImageHeight() const { return image_height_; }
 
 void AnnotationRenderer::SetFlipTextVertically(bool flip) {
   flip_text_vertically_ = flip;
@@ -129,7 +306,7 @@ void AnnotationRenderer::DrawRectangle(const RenderAnnotation& annotation) {
   cv::Rect rect(left, top, right - left, bottom - top);
   const cv::Scalar color = MediapipeColorToOpenCVColor(annotation.color());
   const int thickness = annotation.thickness();
-  cv::rectangle(mat_image_, rect, color, thickness);
+  cv::rectangle(mat_image_, rect - stripe_origin_, color, thickness);
 }
 
 void AnnotationRenderer::DrawFilledRectangle(
@@ -156,7 +333,7 @@ void AnnotationRenderer::DrawFilledRectangle(
 
   cv::Rect rect(left, top, right - left, bottom - top);
   const cv::Scalar color = MediapipeColorToOpenCVColor(annotation.color());
-  cv::rectangle(mat_image_, rect, color, -1);
+  cv::rectangle(mat_image_, rect - stripe_origin_, color, -1);
 }
 
 void AnnotationRenderer::DrawRoundedRectangle(
@@ -184,9 +361,9 @@ void AnnotationRenderer::DrawRoundedRectangle(
   const int thickness = annotation.thickness();
   const int corner_radius = annotation.rounded_rectangle().corner_radius();
   const int line_type = annotation.rounded_rectangle().line_type();
-  DrawRoundedRectangle(mat_image_, cv::Point(left, top),
-                       cv::Point(right, bottom), color, thickness, line_type,
-                       corner_radius);
+  DrawRoundedRectangle(mat_image_, cv::Point(left, top) - stripe_origin_,
+                       cv::Point(right, bottom) - stripe_origin_, color,
+                       thickness, line_type, corner_radius);
 }
 
 void AnnotationRenderer::DrawFilledRoundedRectangle(
@@ -212,11 +389,13 @@ void AnnotationRenderer::DrawFilledRoundedRectangle(
   }
 
   const cv::Scalar color = MediapipeColorToOpenCVColor(annotation.color());
-  const int corner_radius = annotation.rounded_rectangle().corner_radius();
-  const int line_type = annotation.rounded_rectangle().line_type();
-  DrawRoundedRectangle(mat_image_, cv::Point(left, top),
-                       cv::Point(right, bottom), color, -1, line_type,
-                       corner_radius);
+  const auto& rounded_rectangle =
+      annotation.filled_rounded_rectangle().rounded_rectangle();
+  const int corner_radius = rounded_rectangle.corner_radius();
+  const int line_type = rounded_rectangle.line_type();
+  DrawRoundedRectangle(mat_image_, cv::Point(left, top) - stripe_origin_,
+                       cv::Point(right, bottom) - stripe_origin_, color, -1,
+                       line_type, corner_radius);
 }
 
 void AnnotationRenderer::DrawRoundedRectangle(cv::Mat src, cv::Point top_left,
@@ -285,7 +464,8 @@ void AnnotationRenderer::DrawOval(const RenderAnnotation& annotation) {
   cv::Size size((right - left) / 2, (bottom - top) / 2);
   const cv::Scalar color = MediapipeColorToOpenCVColor(annotation.color());
   const int thickness = annotation.thickness();
-  cv::ellipse(mat_image_, center, size, 0, 0, 360, color, thickness);
+  cv::ellipse(mat_image_, center - stripe_origin_, size, 0, 0, 360, color,
+              thickness);
 }
 
 void AnnotationRenderer::DrawFilledOval(const RenderAnnotation& annotation) {
@@ -310,7 +490,7 @@ void AnnotationRenderer::DrawFilledOval(const RenderAnnotation& annotation) {
   cv::Point center((left + right) / 2, (top + bottom) / 2);
   cv::Size size((right - left) / 2, (bottom - top) / 2);
   const cv::Scalar color = MediapipeColorToOpenCVColor(annotation.color());
-  cv::ellipse(mat_image_, center, size, 0, 0, 360, color, -1);
+  cv::ellipse(mat_image_, center - stripe_origin_, size, 0, 0, 360, color, -1);
 }
 
 void AnnotationRenderer::DrawArrow(const RenderAnnotation& annotation) {
@@ -338,13 +518,21 @@ void AnnotationRenderer::DrawArrow(const RenderAnnotation& annotation) {
   cv::Point arrow_end(x_end, y_end);
   const cv::Scalar color = MediapipeColorToOpenCVColor(annotation.color());
   const int thickness = annotation.thickness();
+  DrawArrow(arrow_start, arrow_end, color, thickness);
+}
 
+void AnnotationRenderer::DrawArrow(const cv::Point& arrow_start,
+                                   const cv::Point& arrow_end,
+                                   const cv::Scalar& color, int thickness) {
   // Draw the main arrow line.
-  cv::line(mat_image_, arrow_start, arrow_end, color, thickness);
+  cv::line(mat_image_, arrow_start - stripe_origin_,
+           arrow_end - stripe_origin_, color, thickness);
 
   // Compute the arrowtip left and right vectors.
-  Vector2_d L_start(static_cast<double>(x_start), static_cast<double>(y_start));
-  Vector2_d L_end(static_cast<double>(x_end), static_cast<double>(y_end));
+  Vector2_d L_start(static_cast<double>(arrow_start.x),
+                    static_cast<double>(arrow_start.y));
+  Vector2_d L_end(static_cast<double>(arrow_end.x),
+                  static_cast<double>(arrow_end.y));
   Vector2_d U = (L_end - L_start).Normalize();
   Vector2_d V = U.Ortho();
   double line_length = (L_end - L_start).Norm();
@@ -358,8 +546,10 @@ void AnnotationRenderer::DrawArrow(const RenderAnnotation& annotation) {
                                 static_cast<int>(round(arrowtip_left[1])));
   cv::Point arrowtip_right_start(static_cast<int>(round(arrowtip_right[0])),
                                  static_cast<int>(round(arrowtip_right[1])));
-  cv::line(mat_image_, arrowtip_left_start, arrow_end, color, thickness);
-  cv::line(mat_image_, arrowtip_right_start, arrow_end, color, thickness);
+  cv::line(mat_image_, arrowtip_left_start - stripe_origin_,
+           arrow_end - stripe_origin_, color, thickness);
+  cv::line(mat_image_, arrowtip_right_start - stripe_origin_,
+           arrow_end - stripe_origin_, color, thickness);
 }
 
 void AnnotationRenderer::DrawPoint(const RenderAnnotation& annotation) {
@@ -376,7 +566,8 @@ void AnnotationRenderer::DrawPoint(const RenderAnnotation& annotation) {
   cv::Point point_to_draw(x, y);
   const cv::Scalar color = MediapipeColorToOpenCVColor(annotation.color());
   const int thickness = annotation.thickness();
-  cv::circle(mat_image_, point_to_draw, thickness, color, thickness);
+  cv::circle(mat_image_, point_to_draw - stripe_origin_, thickness, color,
+             thickness);
 }
 
 void AnnotationRenderer::DrawLine(const RenderAnnotation& annotation) {
@@ -402,7 +593,8 @@ void AnnotationRenderer::DrawLine(const RenderAnnotation& annotation) {
   cv::Point end(x_end, y_end);
   const cv::Scalar color = MediapipeColorToOpenCVColor(annotation.color());
   const int thickness = annotation.thickness();
-  cv::line(mat_image_, start, end, color, thickness);
+  cv::line(mat_image_, start - stripe_origin_, end - stripe_origin_, color,
+           thickness);
 }
 
 void AnnotationRenderer::DrawText(const RenderAnnotation& annotation) {
@@ -424,11 +616,18 @@ void AnnotationRenderer::DrawText(const RenderAnnotation& annotation) {
   cv::Point origin(left, baseline);
   const cv::Scalar color = MediapipeColorToOpenCVColor(annotation.color());
   const int thickness = annotation.thickness();
-  const int font_face = text.font_face();
+  DrawText(text.display_text(), origin, text.font_face(), font_size, color,
+           thickness);
+}
 
+void AnnotationRenderer::DrawText(absl::string_view text,
+                                  const cv::Point& origin, int font_face,
+                                  int font_size, const cv::Scalar& color,
+                                  int thickness) {
   const double font_scale = ComputeFontScale(font_face, font_size, thickness);
-  cv::putText(mat_image_, text.display_text(), origin, font_face, font_scale,
-              color, thickness, /*lineType=*/8,
+  text_.assign(text.data(), text.size());
+  cv::putText(mat_image_, text_, origin - stripe_origin_, font_face,
+              font_scale, color, thickness, /*lineType=*/8,
               /*bottomLeftOrigin=*/flip_text_vertically_);
 }
 
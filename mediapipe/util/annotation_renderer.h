@@ -16,9 +16,12 @@
 #define MEDIAPIPE_UTIL_ANNOTATION_RENDERER_H_
 
 #include <string>
+#include <vector>
 
+#include "absl/strings/string_view.h"
 #include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/util/render_commands.h"
 #include "mediapipe/util/render_data.pb.h"
 
 namespace mediapipe {
@@ -57,10 +60,24 @@ class AnnotationRenderer {
   // Renders the image with the input render data.
   void RenderDataOnImage(const RenderData& render_data);
 
+  // Renders the image with the input render commands. Produces the same image
+  // as RenderDataOnImage() with the equivalent RenderData. The rectangles
+  // among consecutive commands of one color are drawn with one OpenCV call per
+  // thickness.
+  void RenderCommandsOnImage(const RenderCommandBuffer& commands);
+
   // Resets the renderer with a new image. Does not own input_image. input_image
   // must not be modified by caller during rendering.
   void AdoptImage(cv::Mat* input_image);
 
+  // Like AdoptImage(), but only draws on rows [row_begin, row_end) of
+  // input_image. Coordinates remain relative to the whole image, so renderers
+  // that adopt disjoint stripes of one image can render the same data
+  // concurrently. Each shape is clipped to the stripe before it is rasterized,
+  // so thin or antialiased lines that cross a stripe boundary may differ by a
+  // pixel from a rendering of the whole image.
+  void AdoptImageStripe(cv::Mat* input_image, int row_begin, int row_end);
+
   // Gets image dimensions.
   int GetImageWidth() const;
   int GetImageHeight() const;
@@ -103,6 +120,26 @@ class AnnotationRenderer {
   // annotation.
   void DrawFilledRoundedRectangle(const RenderAnnotation& annotation);
 
+  // Draws one command of "commands".
+  void DrawCommand(const RenderCommandBuffer& commands,
+                   const RenderCommand& command);
+
+  // Draws the outlines of the rectangles in "corners", four corners each.
+  void DrawRectangles(const std::vector<cv::Point>& corners,
+                      const cv::Scalar& color, int thickness);
+
+  // Draws a line from "start" with an arrow tip at "end".
+  void DrawArrow(const cv::Point& start, const cv::Point& end,
+                 const cv::Scalar& color, int thickness);
+
+  // Draws "text" with its left end of the baseline at "origin".
+  void DrawText(absl::string_view text, const cv::Point& origin,
+                int font_face, int font_size, const cv::Scalar& color,
+                int thickness);
+
+  // Converts the coordinates of a command to pixels.
+  cv::Point ToPixel(bool normalized, double x, double y) const;
+
   // Helper function for drawing a rectangle with rounded corners. The
   // parameters are the same as in the OpenCV function rectangle().
   // corner_radius: A positive int value defining the radius of the round
@@ -119,11 +156,25 @@ class AnnotationRenderer {
   int image_width_ = -1;
   int image_height_ = -1;
 
-  // The image for rendering.
+  // The image for rendering, which is a stripe of the whole image after
+  // AdoptImageStripe().
   cv::Mat mat_image_;
 
+  // The position of mat_image_ in the whole image. It is subtracted from the
+  // pixel coordinates of each shape when drawing.
+  cv::Point stripe_origin_;
+
   // See SetFlipTextVertically(bool).
   bool flip_text_vertically_ = false;
+
+  // Rectangles of one thickness collected by RenderCommandsOnImage().
+  struct RectangleBatch {
+    int thickness = 0;
+    std::vector<cv::Point> corners;
+  };
+  // Scratch space reused across calls to RenderCommandsOnImage().
+  std::vector<RectangleBatch> rectangle_batches_;
+  std::string text_;
 };
 }  // namespace mediapipe
 
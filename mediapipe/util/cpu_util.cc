@@ -22,10 +22,13 @@
 #include <unistd.h>
 #endif
 #include <fstream>
+#include <string>
+#include <vector>
 
 #include "absl/algorithm/container.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/substitute.h"
 #include "mediapipe/framework/port/canonical_errors.h"
 #include "mediapipe/framework/port/integral_types.h"
@@ -41,6 +44,38 @@ constexpr uint32 kBufferLength = 64;
       "/sys/devices/system/cpu/cpu$0/cpufreq/cpuinfo_max_freq", cpu);
 }
 
+// Reads the first line of a sysfs file.
+::mediapipe::StatusOr<std::string> ReadFirstLine(const std::string& path) {
+  std::ifstream file;
+  file.open(path);
+  if (!file.is_open()) {
+    return mediapipe::NotFoundError(absl::StrCat("Couldn't read ", path));
+  }
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+// Parses a list of CPU or node ids in the sysfs format, such as "0-3,8,10-11".
+::mediapipe::StatusOr<std::set<int>> ParseIdList(const std::string& list) {
+  std::set<int> ids;
+  for (absl::string_view range :
+       absl::StrSplit(list, ',', absl::SkipWhitespace())) {
+    std::vector<absl::string_view> bounds = absl::StrSplit(range, '-');
+    int first;
+    int last;
+    if (bounds.size() > 2 || !absl::SimpleAtoi(bounds.front(), &first) ||
+        !absl::SimpleAtoi(bounds.back(), &last) || first > last) {
+      return mediapipe::InvalidArgumentError(
+          absl::StrCat("Invalid id list: ", list));
+    }
+    for (int id = first; id <= last; ++id) {
+      ids.insert(id);
+    }
+  }
+  return ids;
+}
+
 ::mediapipe::StatusOr<uint64> GetCpuMaxFrequency(int cpu) {
   auto path_or_status = GetFilePath(cpu);
   if (!path_or_status.ok()) {
@@ -119,4 +154,31 @@ std::set<int> InferHigherCoreIds() {
   return InferLowerOrHigherCoreIds(/* lower= */ false);
 }
 
+std::vector<std::set<int>> InferNumaNodeCoreIds() {
+  constexpr char kNodePath[] = "/sys/devices/system/node/";
+  auto nodes_or_status = ReadFirstLine(absl::StrCat(kNodePath, "online"));
+  if (!nodes_or_status.ok()) {
+    return {};
+  }
+  auto node_ids_or_status = ParseIdList(nodes_or_status.ValueOrDie());
+  if (!node_ids_or_status.ok() || node_ids_or_status.ValueOrDie().empty()) {
+    return {};
+  }
+  const std::set<int>& node_ids = node_ids_or_status.ValueOrDie();
+  std::vector<std::set<int>> node_cpus(*node_ids.rbegin() + 1);
+  for (int node : node_ids) {
+    auto cpus_or_status = ReadFirstLine(
+        absl::Substitute("$0node$1/cpulist", kNodePath, node));
+    if (!cpus_or_status.ok()) {
+      return {};
+    }
+    auto cpu_ids_or_status = ParseIdList(cpus_or_status.ValueOrDie());
+    if (!cpu_ids_or_status.ok()) {
+      return {};
+    }
+    node_cpus[node] = cpu_ids_or_status.ValueOrDie();
+  }
+  return node_cpus;
+}
+
 }  // namespace mediapipe.
@@ -16,6 +16,7 @@
 #define MEDIAPIPE_UTIL_CPU_UTIL_H_
 
 #include <set>
+#include <vector>
 
 namespace mediapipe {
 // Returns the number of CPU cores. Compatible with Android.
@@ -24,6 +25,10 @@ int NumCPUCores();
 std::set<int> InferLowerCoreIds();
 // Returns a set of inferred CPU ids of higher cores.
 std::set<int> InferHigherCoreIds();
+// Returns the CPU ids of each NUMA node, indexed by node id. The set of a node
+// without online CPUs is empty. Returns an empty vector if the NUMA topology
+// is not available.
+std::vector<std::set<int>> InferNumaNodeCoreIds();
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_UTIL_CPU_UTIL_H_
@@ -17,14 +17,19 @@
 #include <algorithm>
 #include <cmath>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 #include "libyuv/convert.h"
+#include "libyuv/convert_argb.h"
 #include "libyuv/convert_from.h"
+#include "libyuv/convert_from_argb.h"
+#include "libyuv/planar_functions.h"
 #include "libyuv/row.h"
 #include "libyuv/video_common.h"
 #include "mediapipe/framework/deps/mathutil.h"
@@ -34,16 +39,129 @@
 #include "mediapipe/framework/port/integral_types.h"
 #include "mediapipe/framework/port/logging.h"
 #include "mediapipe/framework/port/port.h"
+#include "mediapipe/framework/port/ret_check.h"
 #include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/util/parallel_for.h"
 
 namespace mediapipe {
 
 namespace image_frame_util {
 
+namespace {
+
+// Holds the chroma planes of an I420 image in one aligned allocation. Used to
+// go between I420 and the semi-planar NV12/NV21 layouts one chroma plane pass
+// at a time, without an intermediate copy of the luma plane.
+class ChromaPlanes {
+ public:
+  ChromaPlanes(int width, int height)
+      : width_((width + 1) / 2),
+        height_((height + 1) / 2),
+        stride_((width_ + 15) & ~15),
+        data_(reinterpret_cast<uint8*>(
+            aligned_malloc(stride_ * height_ * 2, 16))) {}
+  ~ChromaPlanes() { aligned_free(data_); }
+  ChromaPlanes(const ChromaPlanes&) = delete;
+  ChromaPlanes& operator=(const ChromaPlanes&) = delete;
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  int stride() const { return stride_; }
+  uint8* u() { return data_; }
+  uint8* v() { return data_ + stride_ * height_; }
+
+ private:
+  const int width_;
+  const int height_;
+  const int stride_;
+  uint8* const data_;
+};
+
+// Converts the SRGB or SRGBA image_frame to I420 planes.
+void ImageFrameToI420(const ImageFrame& image_frame,  //
+                      uint8* y, int y_stride,         //
+                      uint8* u, int u_stride,         //
+                      uint8* v, int v_stride) {
+  const int width = image_frame.Width();
+  const int height = image_frame.Height();
+  int rv;
+  switch (image_frame.Format()) {
+    case ImageFormat::SRGB:
+      // libyuv names formats by their little-endian word layout, so its RAW
+      // is R, G, B in memory order.
+      rv = libyuv::RAWToI420(image_frame.PixelData(), image_frame.WidthStep(),
+                             y, y_stride, u, u_stride, v, v_stride,  //
+                             width, height);
+      break;
+    case ImageFormat::SRGBA:
+      // Likewise, libyuv's ABGR is R, G, B, A in memory order.
+      rv = libyuv::ABGRToI420(image_frame.PixelData(), image_frame.WidthStep(),
+                              y, y_stride, u, u_stride, v, v_stride,  //
+                              width, height);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported ImageFrame format for YUV conversion: "
+                 << image_frame.Format();
+      return;
+  }
+  CHECK_EQ(0, rv);
+}
+
+}  // namespace
+
+::mediapipe::Status ConvertImageFrame(const ImageFrame& source,
+                                      ImageFrame* destination) {
+  RET_CHECK(destination);
+  RET_CHECK_EQ(source.Width(), destination->Width());
+  RET_CHECK_EQ(source.Height(), destination->Height());
+  const uint8* src = source.PixelData();
+  const int src_stride = source.WidthStep();
+  uint8* dst = destination->MutablePixelData();
+  const int dst_stride = destination->WidthStep();
+  const int width = source.Width();
+  const int height = source.Height();
+  const ImageFormat::Format from = source.Format();
+  const ImageFormat::Format to = destination->Format();
+
+  // As above, libyuv's channel names refer to little-endian words: RGB24 and
+  // ARGB are B, G, R and B, G, R, A in memory. Those functions only reorder
+  // bytes within a pixel, so they also preserve R, G, B order.
+  int rv = 0;
+  if (from == to) {
+    cv::Mat destination_mat = formats::MatView(destination);
+    formats::MatView(&source).copyTo(destination_mat);
+  } else if (from == ImageFormat::SRGB && to == ImageFormat::SRGBA) {
+    rv = libyuv::RGB24ToARGB(src, src_stride, dst, dst_stride, width, height);
+  } else if (from == ImageFormat::SRGBA && to == ImageFormat::SRGB) {
+    rv = libyuv::ARGBToRGB24(src, src_stride, dst, dst_stride, width, height);
+  } else if (from == ImageFormat::GRAY8 && to == ImageFormat::SRGBA) {
+    rv = libyuv::J400ToARGB(src, src_stride, dst, dst_stride, width, height);
+  } else {
+    int open_cv_convert_code;
+    if (from == ImageFormat::GRAY8 && to == ImageFormat::SRGB) {
+      open_cv_convert_code = cv::COLOR_GRAY2RGB;
+    } else if (from == ImageFormat::SRGB && to == ImageFormat::GRAY8) {
+      open_cv_convert_code = cv::COLOR_RGB2GRAY;
+    } else if (from == ImageFormat::SRGBA && to == ImageFormat::GRAY8) {
+      open_cv_convert_code = cv::COLOR_RGBA2GRAY;
+    } else {
+      return ::mediapipe::InvalidArgumentError(
+          absl::StrCat("Unsupported image format conversion from ", from,
+                       " to ", to, "."));
+    }
+    // OpenCV's weighted RGB to gray conversion is vectorized as well.
+    cv::Mat destination_mat = formats::MatView(destination);
+    cv::cvtColor(formats::MatView(&source), destination_mat,
+                 open_cv_convert_code);
+  }
+  RET_CHECK_EQ(0, rv);
+  return ::mediapipe::OkStatus();
+}
+
 void RescaleImageFrame(const ImageFrame& source_frame, const int width,
                        const int height, const int alignment_boundary,
                        const int open_cv_interpolation_algorithm,
-                       ImageFrame* destination_frame) {
+                       ImageFrame* destination_frame, Executor* executor) {
   CHECK(destination_frame);
   CHECK_EQ(ImageFormat::SRGB, source_frame.Format());
 
@@ -53,12 +171,12 @@ void RescaleImageFrame(const ImageFrame& source_frame, const int width,
   cv::Mat destination_mat = ::mediapipe::formats::MatView(destination_frame);
   image_frame_util::RescaleSrgbImage(source_mat, width, height,
                                      open_cv_interpolation_algorithm,
-                                     &destination_mat);
+                                     &destination_mat, executor);
 }
 
 void RescaleSrgbImage(const cv::Mat& source, const int width, const int height,
                       const int open_cv_interpolation_algorithm,
-                      cv::Mat* destination) {
+                      cv::Mat* destination, Executor* executor) {
   CHECK(destination);
 
   // Convert input_mat into 16 bit per channel linear RGB space.
@@ -66,15 +184,52 @@ void RescaleSrgbImage(const cv::Mat& source, const int width, const int height,
   image_frame_util::SrgbToLinearRgb16(source, &input_mat16);
 
   // Resize in 16 bit linear RGB space.
-  cv::Mat output_mat16;
+  cv::Mat output_mat16(height, width, input_mat16.type());
   // Notice that OpenCV assumes the image is in BGR pixel ordering.
   // However, in resizing, the channel ordering is irrelevant so there
   // is no need to convert the channel order.
-  cv::resize(input_mat16, output_mat16, cv::Size(width, height), 0.0, 0.0,
-             open_cv_interpolation_algorithm);
+  ResizeImage(input_mat16, open_cv_interpolation_algorithm, &output_mat16,
+              executor);
 
   // Convert back to SRGB colorspace.
-  image_frame_util::LinearRgb16ToSrgb(output_mat16, destination);
+  image_frame_util::LinearRgb16ToSrgb(output_mat16, destination, executor);
+}
+
+void ResizeImage(const cv::Mat& source,
+                 const int open_cv_interpolation_algorithm,
+                 cv::Mat* destination, Executor* executor) {
+  CHECK(destination);
+  CHECK_EQ(source.type(), destination->type());
+  if (source.size() == destination->size()) {
+    source.copyTo(*destination);
+    return;
+  }
+  // The interpolation algorithms of cv::resize() are separable, and with a
+  // scale of one along an axis they copy the pixels along it unchanged. So the
+  // horizontal pass can resize stripes of rows independently, and the vertical
+  // pass stripes of columns.
+  cv::Mat horizontal;
+  if (source.cols == destination->cols) {
+    horizontal = source;
+  } else {
+    if (source.rows == destination->rows) {
+      horizontal = *destination;
+    } else {
+      horizontal.create(source.rows, destination->cols, source.type());
+    }
+    ParallelFor(executor, source.rows, 16, [&](int begin, int end) {
+      cv::Mat stripe = horizontal.rowRange(begin, end);
+      cv::resize(source.rowRange(begin, end), stripe, stripe.size(), 0.0, 0.0,
+                 open_cv_interpolation_algorithm);
+    });
+  }
+  if (source.rows != destination->rows) {
+    ParallelFor(executor, destination->cols, 16, [&](int begin, int end) {
+      cv::Mat stripe = destination->colRange(begin, end);
+      cv::resize(horizontal.colRange(begin, end), stripe, stripe.size(), 0.0,
+                 0.0, open_cv_interpolation_algorithm);
+    });
+  }
 }
 
 void ImageFrameToYUVImage(const ImageFrame& image_frame, YUVImage* yuv_image) {
@@ -98,25 +253,14 @@ void ImageFrameToYUVImage(const ImageFrame& image_frame, YUVImage* yuv_image) {
                         u, uv_stride,                     //
                         v, uv_stride,                     //
                         width, height);
-  int rv =
-      libyuv::RAWToI420(image_frame.PixelData(), image_frame.WidthStep(),  //
-                        y, y_stride,                                       //
-                        u, uv_stride,                                      //
-                        v, uv_stride,                                      //
-                        width, height);
-  CHECK_EQ(0, rv);
+  ImageFrameToI420(image_frame, y, y_stride, u, uv_stride, v, uv_stride);
 }
 
 void ImageFrameToYUVNV12Image(const ImageFrame& image_frame,
                               YUVImage* yuv_nv12_image) {
-  // Create a YUV I420 image that will hold the converted RGBA image.
-  YUVImage yuv_i420_image;
-  ImageFrameToYUVImage(image_frame, &yuv_i420_image);
-
-  // Now create a YUV NV12 image and convert the I420 to NV12.
-  const int width = yuv_i420_image.width();
-  const int height = yuv_i420_image.height();
-  const int y_stride = yuv_i420_image.stride(0);
+  const int width = image_frame.Width();
+  const int height = image_frame.Height();
+  const int y_stride = (width + 15) & ~15;
   const int y_size = y_stride * height;
   const int uv_stride = y_stride;
   const int uv_height = (height + 1) / 2;
@@ -127,38 +271,60 @@ void ImageFrameToYUVNV12Image(const ImageFrame& image_frame,
   uint8* uv = y + y_size;
   yuv_nv12_image->Initialize(libyuv::FOURCC_NV12, deallocate, y, y_stride, uv,
                              uv_stride, nullptr, 0, width, height);
-  const int rv = libyuv::I420ToNV12(
-      yuv_i420_image.data(0), yuv_i420_image.stride(0), yuv_i420_image.data(1),
-      yuv_i420_image.stride(1), yuv_i420_image.data(2),
-      yuv_i420_image.stride(2), yuv_nv12_image->mutable_data(0),
-      yuv_nv12_image->stride(0), yuv_nv12_image->mutable_data(1),
-      yuv_nv12_image->stride(1), width, height);
-  CHECK_EQ(0, rv);
+  // The luma plane is written in place; only the chroma planes are staged and
+  // then interleaved.
+  ChromaPlanes chroma(width, height);
+  ImageFrameToI420(image_frame, y, y_stride, chroma.u(), chroma.stride(),
+                   chroma.v(), chroma.stride());
+  libyuv::MergeUVPlane(chroma.u(), chroma.stride(), chroma.v(),
+                       chroma.stride(), uv, uv_stride, chroma.width(),
+                       chroma.height());
 }
 
 void YUVImageToImageFrame(const YUVImage& yuv_image, ImageFrame* image_frame,
-                          bool use_bt709) {
+                          bool use_bt709, Executor* executor) {
   CHECK(image_frame);
   int width = yuv_image.width();
   int height = yuv_image.height();
   image_frame->Reset(ImageFormat::SRGB, width, height, 16);
-  int rv;
-
-  if (use_bt709) {
-    rv = libyuv::H420ToRAW(yuv_image.data(0), yuv_image.stride(0),  //
-                           yuv_image.data(1), yuv_image.stride(1),  //
-                           yuv_image.data(2), yuv_image.stride(2),  //
-                           image_frame->MutablePixelData(),
-                           image_frame->WidthStep(), width, height);
-
-  } else {
-    rv = libyuv::I420ToRAW(yuv_image.data(0), yuv_image.stride(0),  //
-                           yuv_image.data(1), yuv_image.stride(1),  //
-                           yuv_image.data(2), yuv_image.stride(2),  //
-                           image_frame->MutablePixelData(),
-                           image_frame->WidthStep(), width, height);
+  const uint8* u = yuv_image.data(1);
+  const uint8* v = yuv_image.data(2);
+  int u_stride = yuv_image.stride(1);
+  int v_stride = yuv_image.stride(2);
+  std::unique_ptr<ChromaPlanes> chroma;
+  if (yuv_image.fourcc() == libyuv::FOURCC_NV12 ||
+      yuv_image.fourcc() == libyuv::FOURCC_NV21) {
+    // Deinterleave the chroma plane so that both matrices share the I420 path.
+    chroma = absl::make_unique<ChromaPlanes>(width, height);
+    const bool is_nv12 = yuv_image.fourcc() == libyuv::FOURCC_NV12;
+    libyuv::SplitUVPlane(yuv_image.data(1), yuv_image.stride(1),
+                         is_nv12 ? chroma->u() : chroma->v(), chroma->stride(),
+                         is_nv12 ? chroma->v() : chroma->u(), chroma->stride(),
+                         chroma->width(), chroma->height());
+    u = chroma->u();
+    v = chroma->v();
+    u_stride = v_stride = chroma->stride();
   }
-  CHECK_EQ(0, rv);
+  // Stripes start at even rows so that each one covers whole chroma rows.
+  const int y_stride = yuv_image.stride(0);
+  const int rgb_stride = image_frame->WidthStep();
+  ParallelFor(executor, (height + 1) / 2, 8, [&](int begin, int end) {
+    const int row = begin * 2;
+    const int rows = std::min(end * 2, height) - row;
+    const uint8* y_row = yuv_image.data(0) + row * y_stride;
+    const uint8* u_row = u + begin * u_stride;
+    const uint8* v_row = v + begin * v_stride;
+    uint8* rgb_row = image_frame->MutablePixelData() + row * rgb_stride;
+    int rv;
+    if (use_bt709) {
+      rv = libyuv::H420ToRAW(y_row, y_stride, u_row, u_stride, v_row, v_stride,
+                             rgb_row, rgb_stride, width, rows);
+    } else {
+      rv = libyuv::I420ToRAW(y_row, y_stride, u_row, u_stride, v_row, v_stride,
+                             rgb_row, rgb_stride, width, rows);
+    }
+    CHECK_EQ(0, rv);
+  });
 }
 
 void SrgbToMpegYCbCr(const uint8 r, const uint8 g, const uint8 b,  //
@@ -252,23 +418,23 @@ void SrgbToLinearRgb16(const cv::Mat& source, cv::Mat* destination) {
   cv::LUT(source, kLut, *destination);
 }
 
-void LinearRgb16ToSrgb(const cv::Mat& source, cv::Mat* destination) {
+void LinearRgb16ToSrgb(const cv::Mat& source, cv::Mat* destination,
+                       Executor* executor) {
   // Ensure the destination is in the proper format (OpenCV style).
   destination->create(source.size(), CV_8UC(source.channels()));
 
   static const cv::Mat kLut = GetLinearRgb16ToSrgbLut();
   const uint8* lookup_table_ptr = kLut.ptr<uint8>();
-  const int num_channels = source.channels();
-  for (int row = 0; row < source.rows; ++row) {
-    for (int col = 0; col < source.cols; ++col) {
-      for (int channel = 0; channel < num_channels; ++channel) {
-        uint8* ptr = destination->ptr<uint8>(row);
-        const uint16* ptr16 = source.ptr<uint16>(row);
-        ptr[col * num_channels + channel] =
-            lookup_table_ptr[ptr16[col * num_channels + channel]];
+  const int row_size = source.cols * source.channels();
+  ParallelFor(executor, source.rows, 16, [&](int begin, int end) {
+    for (int row = begin; row < end; ++row) {
+      uint8* ptr = destination->ptr<uint8>(row);
+      const uint16* ptr16 = source.ptr<uint16>(row);
+      for (int i = 0; i < row_size; ++i) {
+        ptr[i] = lookup_table_ptr[ptr16[i]];
       }
     }
-  }
+  });
 }
 
 }  // namespace image_frame_util
@@ -25,6 +25,7 @@
 #include "mediapipe/framework/tool/status_util.h"
 
 namespace mediapipe {
+class Executor;
 class ImageFrame;
 class YUVImage;
 }  // namespace mediapipe
@@ -34,35 +35,62 @@ namespace image_frame_util {
 // Rescale an SRGB ImageFrame.  destination_frame will be Reset() by
 // this function (i.e. it will be deleted and reallocated if it already
 // contained data).  The rescaling is done in 16bit LinearRGB colorspace.
+// If executor is not null, the work is split across it (see
+// util/parallel_for.h).
 // TODO Implement for other formats.
 void RescaleImageFrame(const ImageFrame& source_frame, const int width,
                        const int height, const int alignment_boundary,
                        const int open_cv_interpolation_algorithm,
-                       ImageFrame* destination_frame);
+                       ImageFrame* destination_frame,
+                       Executor* executor = nullptr);
 
 // Rescale the source image to the destination.  Following OpenCV
 // conventions, destination will be reallocated only if it isn't
 // the correct width, height, and format (i.e. channel and depth).
-// The rescaling is done in 16bit LinearRGB colorspace.
+// The rescaling is done in 16bit LinearRGB colorspace, with ResizeImage().
 void RescaleSrgbImage(const cv::Mat& source, const int width, const int height,
                       const int open_cv_interpolation_algorithm,
-                      cv::Mat* destination);
+                      cv::Mat* destination, Executor* executor = nullptr);
 
-// Convert an SRGB ImageFrame to an I420 YUVImage.
+// Resize the source image to the size of the destination, which must already
+// be allocated with the type of the source, like cv::resize() with the given
+// interpolation algorithm. The image is resized horizontally and then
+// vertically, and each pass is split into stripes across executor if it is
+// not null. The intermediate image has the pixel type of the source, so pixels
+// can differ by one from those of a single cv::resize() call, and by more next
+// to edges where cubic or Lanczos interpolation overshoots the pixel range.
+// INTER_AREA chooses between area averaging and interpolation for each axis
+// separately.
+void ResizeImage(const cv::Mat& source,
+                 const int open_cv_interpolation_algorithm,
+                 cv::Mat* destination, Executor* executor = nullptr);
+
+// Convert between the 8-bit interleaved formats SRGB, SRGBA and GRAY8. The
+// destination must already be allocated with the dimensions of the source; its
+// format selects the conversion. Conversions to SRGBA set alpha to 255 in the
+// same pass. The SRGB <-> SRGBA and GRAY8 -> SRGBA conversions use the
+// vectorized libyuv row functions. Returns an error for other formats.
+::mediapipe::Status ConvertImageFrame(const ImageFrame& source,
+                                      ImageFrame* destination);
+
+// Convert an SRGB or SRGBA ImageFrame to an I420 YUVImage.
 void ImageFrameToYUVImage(const ImageFrame& image_frame, YUVImage* yuv_image);
 
-// Convert an SRGB ImageFrame to a 420p NV12 YUVImage.
+// Convert an SRGB or SRGBA ImageFrame to a 420p NV12 YUVImage.
 void ImageFrameToYUVNV12Image(const ImageFrame& image_frame,
                               YUVImage* yuv_nv12_image);
 
-// Convert a YUVImage to an SRGB ImageFrame. If use_bt709 is set to false, this
-// function will assume that the YUV is as defined in BT.601 (standard from the
-// 1980s). Most content is using BT.709 (as of 2019), but it's likely that this
-// will no longer the case in the future, when BT.2100 will likely be dominant.
-// This function needs to be changed significantly once YUVImage starts
-// supporting ICtCp.
+// Convert a YUVImage to an SRGB ImageFrame. NV12 and NV21 images are
+// supported, and any other fourcc is treated as I420.
+// If use_bt709 is set to false, this function will assume that the YUV is as
+// defined in BT.601 (standard from the 1980s). Most content is using BT.709
+// (as of 2019), but it's likely that this will no longer be the case in the
+// future, when BT.2100 will likely be dominant. This function needs to be
+// changed significantly once YUVImage starts supporting ICtCp.
+// If executor is not null, the conversion is split into stripes across it.
 void YUVImageToImageFrame(const YUVImage& yuv_image, ImageFrame* image_frame,
-                          bool use_bt709 = false);
+                          bool use_bt709 = false,
+                          Executor* executor = nullptr);
 
 // Convert sRGB values into MPEG YCbCr values.  Notice that MPEG YCbCr
 // values use a smaller range of values than JPEG YCbCr.  The conversion
@@ -81,7 +109,8 @@ void MpegYCbCrToSrgb(const uint8 y, const uint8 cb, const uint8 cr,  //
 // Conversion functions to and from srgb and linear RGB in 16 bits-per-pixel
 // channel.
 void SrgbToLinearRgb16(const cv::Mat& source, cv::Mat* destination);
-void LinearRgb16ToSrgb(const cv::Mat& source, cv::Mat* destination);
+void LinearRgb16ToSrgb(const cv::Mat& source, cv::Mat* destination,
+                       Executor* executor = nullptr);
 
 }  // namespace image_frame_util
 }  // namespace mediapipe
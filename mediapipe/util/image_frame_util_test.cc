@@ -0,0 +1,309 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/image_frame_util.h"
+
+#include <cstdlib>
+#include <vector>
+
+#include "libyuv/video_common.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+
+namespace mediapipe {
+namespace image_frame_util {
+namespace {
+
+// Odd dimensions exercise the row tails of the vectorized kernels and the
+// rounding up of chroma planes.
+constexpr int kWidth = 37;
+constexpr int kHeight = 21;
+
+ImageFrame MakeRandomFrame(ImageFormat::Format format, int width, int height) {
+  ImageFrame frame(format, width, height);
+  cv::Mat mat = formats::MatView(&frame);
+  cv::randu(mat, cv::Scalar::all(0), cv::Scalar::all(256));
+  return frame;
+}
+
+// The previous implementation: cv::cvtColor followed by an alpha fill pass.
+ImageFrame OpenCvConvert(const ImageFrame& source, ImageFormat::Format format,
+                         int open_cv_convert_code) {
+  ImageFrame destination(format, source.Width(), source.Height());
+  cv::Mat destination_mat = formats::MatView(&destination);
+  cv::cvtColor(formats::MatView(&source), destination_mat,
+               open_cv_convert_code);
+  if (format == ImageFormat::SRGBA) {
+    destination_mat.reshape(1, destination_mat.rows * destination_mat.cols)
+        .col(3)
+        .setTo(255);
+  }
+  return destination;
+}
+
+void ExpectSamePixels(const ImageFrame& expected, const ImageFrame& actual) {
+  ASSERT_EQ(expected.Format(), actual.Format());
+  cv::Mat diff;
+  cv::absdiff(formats::MatView(&expected), formats::MatView(&actual), diff);
+  EXPECT_EQ(0, cv::countNonZero(diff.reshape(1)));
+}
+
+TEST(ImageFrameUtilTest, ConvertImageFrameMatchesOpenCv) {
+  struct Conversion {
+    ImageFormat::Format from;
+    ImageFormat::Format to;
+    int open_cv_convert_code;
+  };
+  for (const Conversion& conversion : {
+           Conversion{ImageFormat::SRGB, ImageFormat::SRGBA,
+                      cv::COLOR_RGB2RGBA},
+           Conversion{ImageFormat::SRGBA, ImageFormat::SRGB,
+                      cv::COLOR_RGBA2RGB},
+           Conversion{ImageFormat::GRAY8, ImageFormat::SRGB,
+                      cv::COLOR_GRAY2RGB},
+           Conversion{ImageFormat::GRAY8, ImageFormat::SRGBA,
+                      cv::COLOR_GRAY2RGBA},
+           Conversion{ImageFormat::SRGB, ImageFormat::GRAY8,
+                      cv::COLOR_RGB2GRAY},
+           Conversion{ImageFormat::SRGBA, ImageFormat::GRAY8,
+                      cv::COLOR_RGBA2GRAY},
+       }) {
+    SCOPED_TRACE(testing::Message() << conversion.from << " -> "
+                                    << conversion.to);
+    const ImageFrame source = MakeRandomFrame(conversion.from, kWidth, kHeight);
+    ImageFrame destination(conversion.to, kWidth, kHeight);
+    MEDIAPIPE_ASSERT_OK(ConvertImageFrame(source, &destination));
+    ExpectSamePixels(
+        OpenCvConvert(source, conversion.to, conversion.open_cv_convert_code),
+        destination);
+  }
+}
+
+TEST(ImageFrameUtilTest, ConvertImageFrameRejectsMismatchedSize) {
+  const ImageFrame source = MakeRandomFrame(ImageFormat::SRGB, kWidth, kHeight);
+  ImageFrame destination(ImageFormat::SRGBA, kWidth + 1, kHeight);
+  EXPECT_FALSE(ConvertImageFrame(source, &destination).ok());
+}
+
+// Checks that the luma and the subsampled chroma of the YUV image match the
+// per-pixel reference conversion up to rounding.
+void ExpectMatchesReferenceYCbCr(const ImageFrame& frame,
+                                 const YUVImage& yuv_image, bool interleaved) {
+  const int channels = frame.NumberOfChannels();
+  for (int row = 0; row < frame.Height(); ++row) {
+    const uint8* pixels = frame.PixelData() + row * frame.WidthStep();
+    for (int col = 0; col < frame.Width(); ++col) {
+      uint8 y, cb, cr;
+      const uint8* pixel = pixels + col * channels;
+      SrgbToMpegYCbCr(pixel[0], pixel[1], pixel[2], &y, &cb, &cr);
+      const uint8 actual_y = yuv_image.data(0)[row * yuv_image.stride(0) + col];
+      EXPECT_LE(std::abs(y - actual_y), 1);
+    }
+  }
+  // Chroma is subsampled, so compare a flat region where all four source
+  // pixels agree.
+  uint8 y, cb, cr;
+  const uint8* pixel = frame.PixelData();
+  SrgbToMpegYCbCr(pixel[0], pixel[1], pixel[2], &y, &cb, &cr);
+  const uint8 actual_cb = yuv_image.data(1)[0];
+  const uint8 actual_cr =
+      interleaved ? yuv_image.data(1)[1] : yuv_image.data(2)[0];
+  EXPECT_LE(std::abs(cb - actual_cb), 2);
+  EXPECT_LE(std::abs(cr - actual_cr), 2);
+}
+
+ImageFrame MakeFlatTopLeftFrame(ImageFormat::Format format) {
+  ImageFrame frame = MakeRandomFrame(format, kWidth, kHeight);
+  cv::Mat mat = formats::MatView(&frame);
+  mat(cv::Rect(0, 0, 2, 2)).setTo(cv::Scalar(200, 80, 30, 255));
+  return frame;
+}
+
+TEST(ImageFrameUtilTest, ImageFrameToYUVImageMatchesReference) {
+  for (ImageFormat::Format format : {ImageFormat::SRGB, ImageFormat::SRGBA}) {
+    const ImageFrame frame = MakeFlatTopLeftFrame(format);
+    YUVImage yuv_image;
+    ImageFrameToYUVImage(frame, &yuv_image);
+    EXPECT_EQ(libyuv::FOURCC_I420, yuv_image.fourcc());
+    ExpectMatchesReferenceYCbCr(frame, yuv_image, /*interleaved=*/false);
+  }
+}
+
+TEST(ImageFrameUtilTest, ImageFrameToYUVNV12ImageMatchesReference) {
+  for (ImageFormat::Format format : {ImageFormat::SRGB, ImageFormat::SRGBA}) {
+    const ImageFrame frame = MakeFlatTopLeftFrame(format);
+    YUVImage yuv_image;
+    ImageFrameToYUVNV12Image(frame, &yuv_image);
+    EXPECT_EQ(libyuv::FOURCC_NV12, yuv_image.fourcc());
+    ExpectMatchesReferenceYCbCr(frame, yuv_image, /*interleaved=*/true);
+  }
+}
+
+TEST(ImageFrameUtilTest, NV12AndI420RoundTripToSameImageFrame) {
+  const ImageFrame frame = MakeRandomFrame(ImageFormat::SRGB, kWidth, kHeight);
+  YUVImage i420_image;
+  ImageFrameToYUVImage(frame, &i420_image);
+  YUVImage nv12_image;
+  ImageFrameToYUVNV12Image(frame, &nv12_image);
+  ImageFrame from_i420;
+  YUVImageToImageFrame(i420_image, &from_i420);
+  ImageFrame from_nv12;
+  YUVImageToImageFrame(nv12_image, &from_nv12);
+  ExpectSamePixels(from_i420, from_nv12);
+}
+
+TEST(ImageFrameUtilTest, ResizeImageMatchesOpenCv) {
+  const ImageFrame frame = MakeRandomFrame(ImageFormat::SRGB, kWidth, kHeight);
+  const cv::Mat source = formats::MatView(&frame);
+  // Upscaling, downscaling, and scaling along one axis only.
+  for (const cv::Size size : {cv::Size(2 * kWidth + 1, 3 * kHeight),
+                              cv::Size(kWidth / 2, kHeight / 3),
+                              cv::Size(kWidth / 2, kHeight)}) {
+    for (const int interpolation : {cv::INTER_LINEAR, cv::INTER_AREA}) {
+      SCOPED_TRACE(testing::Message() << size << " " << interpolation);
+      cv::Mat expected;
+      cv::resize(source, expected, size, 0.0, 0.0, interpolation);
+      cv::Mat actual(size, source.type());
+      ResizeImage(source, interpolation, &actual);
+      cv::Mat diff;
+      cv::absdiff(expected, actual, diff);
+      double max_diff = 0;
+      cv::minMaxLoc(diff.reshape(1), nullptr, &max_diff);
+      EXPECT_LE(max_diff, 1);
+    }
+  }
+}
+
+TEST(ImageFrameUtilTest, ResizeImageInStripesMatchesSerial) {
+  const ImageFrame frame =
+      MakeRandomFrame(ImageFormat::SRGB, 10 * kWidth, 10 * kHeight);
+  const cv::Mat source = formats::MatView(&frame);
+  ThreadPoolExecutor executor(4);
+  for (const int interpolation :
+       {cv::INTER_NEAREST, cv::INTER_LINEAR, cv::INTER_CUBIC, cv::INTER_AREA,
+        cv::INTER_LANCZOS4}) {
+    SCOPED_TRACE(interpolation);
+    cv::Mat serial(25 * kHeight, 15 * kWidth, source.type());
+    ResizeImage(source, interpolation, &serial);
+    cv::Mat striped(serial.size(), serial.type());
+    ResizeImage(source, interpolation, &striped, &executor);
+    cv::Mat diff;
+    cv::absdiff(serial, striped, diff);
+    EXPECT_EQ(0, cv::countNonZero(diff.reshape(1)));
+  }
+}
+
+// Benchmarks at 720p, 1080p and 4K.
+void ResolutionArgs(benchmark::internal::Benchmark* benchmark) {
+  benchmark->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+}
+
+void BM_RgbToRgbaOpenCv(benchmark::State& state) {
+  const ImageFrame source =
+      MakeRandomFrame(ImageFormat::SRGB, state.range(0), state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        OpenCvConvert(source, ImageFormat::SRGBA, cv::COLOR_RGB2RGBA));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          state.range(1));
+}
+BENCHMARK(BM_RgbToRgbaOpenCv)->Apply(ResolutionArgs);
+
+void BM_RgbToRgba(benchmark::State& state) {
+  const ImageFrame source =
+      MakeRandomFrame(ImageFormat::SRGB, state.range(0), state.range(1));
+  for (auto _ : state) {
+    ImageFrame destination(ImageFormat::SRGBA, source.Width(),
+                           source.Height());
+    CHECK(ConvertImageFrame(source, &destination).ok());
+    benchmark::DoNotOptimize(destination.PixelData());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          state.range(1));
+}
+BENCHMARK(BM_RgbToRgba)->Apply(ResolutionArgs);
+
+// The per-pixel reference conversion, for comparison with the libyuv path.
+void BM_RgbToI420PerPixel(benchmark::State& state) {
+  const ImageFrame source =
+      MakeRandomFrame(ImageFormat::SRGB, state.range(0), state.range(1));
+  std::vector<uint8> ycbcr(source.Width() * source.Height() * 3);
+  for (auto _ : state) {
+    uint8* out = ycbcr.data();
+    for (int row = 0; row < source.Height(); ++row) {
+      const uint8* pixel = source.PixelData() + row * source.WidthStep();
+      for (int col = 0; col < source.Width(); ++col, pixel += 3, out += 3) {
+        SrgbToMpegYCbCr(pixel[0], pixel[1], pixel[2], out, out + 1, out + 2);
+      }
+    }
+    benchmark::DoNotOptimize(ycbcr.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          state.range(1));
+}
+BENCHMARK(BM_RgbToI420PerPixel)->Apply(ResolutionArgs);
+
+void BM_RgbToI420(benchmark::State& state) {
+  const ImageFrame source =
+      MakeRandomFrame(ImageFormat::SRGB, state.range(0), state.range(1));
+  for (auto _ : state) {
+    YUVImage yuv_image;
+    ImageFrameToYUVImage(source, &yuv_image);
+    benchmark::DoNotOptimize(yuv_image.data(0));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          state.range(1));
+}
+BENCHMARK(BM_RgbToI420)->Apply(ResolutionArgs);
+
+void BM_RgbToNV12(benchmark::State& state) {
+  const ImageFrame source =
+      MakeRandomFrame(ImageFormat::SRGB, state.range(0), state.range(1));
+  for (auto _ : state) {
+    YUVImage yuv_image;
+    ImageFrameToYUVNV12Image(source, &yuv_image);
+    benchmark::DoNotOptimize(yuv_image.data(0));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          state.range(1));
+}
+BENCHMARK(BM_RgbToNV12)->Apply(ResolutionArgs);
+
+void BM_NV12ToRgb(benchmark::State& state) {
+  const ImageFrame source =
+      MakeRandomFrame(ImageFormat::SRGB, state.range(0), state.range(1));
+  YUVImage yuv_image;
+  ImageFrameToYUVNV12Image(source, &yuv_image);
+  for (auto _ : state) {
+    ImageFrame destination;
+    YUVImageToImageFrame(yuv_image, &destination);
+    benchmark::DoNotOptimize(destination.PixelData());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          state.range(1));
+}
+BENCHMARK(BM_NV12ToRgb)->Apply(ResolutionArgs);
+
+}  // namespace
+}  // namespace image_frame_util
+}  // namespace mediapipe
@@ -0,0 +1,136 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_ORDERED_TASK_QUEUE_H_
+#define MEDIAPIPE_UTIL_ORDERED_TASK_QUEUE_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/port/threadpool.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe {
+
+// Runs independent per-packet tasks on a worker pool and hands their results
+// back in submission order. A calculator uses it to overlap the work for
+// several input packets without raising max_in_flight: Process() submits the
+// task for the current packet and then emits whatever results are ready at the
+// front of the queue, and Close() emits the rest. Since results are emitted in
+// order, output timestamps stay monotonic.
+//
+// Submit() and Emit*() must be called from one thread at a time, which holds
+// for Open/Process/Close of a calculator.
+//
+// Example:
+//   queue_ = absl::make_unique<OrderedTaskQueue<ImageFrame>>("decoder", 4, 8);
+//   ...
+//   Packet input = cc->Inputs().Index(0).Value();
+//   queue_->Submit(cc->InputTimestamp(), [input]() { return Decode(input); });
+//   return queue_->EmitReady(
+//       [cc](std::unique_ptr<ImageFrame> frame, Timestamp timestamp) {
+//         cc->Outputs().Index(0).Add(frame.release(), timestamp);
+//       });
+template <typename T>
+class OrderedTaskQueue {
+ public:
+  using Task = std::function<::mediapipe::StatusOr<std::unique_ptr<T>>()>;
+  using EmitCallback = std::function<void(std::unique_ptr<T>, Timestamp)>;
+
+  // Creates a queue running tasks on `num_threads` workers. At most
+  // `max_pending` tasks are outstanding; EmitReady blocks on the oldest task
+  // beyond that.
+  OrderedTaskQueue(const std::string& name, int num_threads, int max_pending)
+      : max_pending_(max_pending),
+        pool_(absl::make_unique<ThreadPool>(name, num_threads)) {
+    pool_->StartWorkers();
+  }
+
+  // Waits for outstanding tasks; their results are dropped.
+  ~OrderedTaskQueue() { pool_.reset(); }
+
+  // Schedules `task` for the packet at `timestamp`.
+  void Submit(Timestamp timestamp, Task task) {
+    auto slot = std::make_shared<Slot>();
+    slot->timestamp = timestamp;
+    pending_.push_back(slot);
+    pool_->Schedule([this, slot, task]() {
+      auto result = task();
+      absl::MutexLock lock(&mutex_);
+      slot->result = std::move(result);
+      slot->done = true;
+    });
+  }
+
+  // Emits the completed results at the front of the queue, waiting as needed to
+  // keep at most max_pending tasks outstanding. Returns the first task error.
+  ::mediapipe::Status EmitReady(const EmitCallback& emit) {
+    return EmitWhile(emit, [this]() { return pending_.size() > max_pending_; });
+  }
+
+  // Waits for and emits all outstanding results.
+  ::mediapipe::Status EmitAll(const EmitCallback& emit) {
+    return EmitWhile(emit, [this]() { return !pending_.empty(); });
+  }
+
+  int num_pending() const { return pending_.size(); }
+
+ private:
+  struct Slot {
+    Timestamp timestamp;
+    bool done = false;
+    ::mediapipe::StatusOr<std::unique_ptr<T>> result =
+        ::mediapipe::UnknownError("Task has not run.");
+  };
+
+  // Emits ready results, and also waits for the front result while
+  // `must_wait()` holds.
+  ::mediapipe::Status EmitWhile(const EmitCallback& emit,
+                                const std::function<bool()>& must_wait) {
+    while (!pending_.empty()) {
+      std::shared_ptr<Slot> slot = pending_.front();
+      {
+        absl::MutexLock lock(&mutex_);
+        if (!slot->done) {
+          if (!must_wait()) break;
+          mutex_.Await(absl::Condition(&slot->done));
+        }
+      }
+      pending_.pop_front();
+      if (!slot->result.ok()) {
+        return slot->result.status();
+      }
+      emit(std::move(slot->result).ValueOrDie(), slot->timestamp);
+    }
+    return ::mediapipe::OkStatus();
+  }
+
+  const int max_pending_;
+  absl::Mutex mutex_;
+  // Accessed only by the calling thread; the workers only touch the slots.
+  std::deque<std::shared_ptr<Slot>> pending_;
+  // Declared last so that the workers are joined before the other members are
+  // destroyed.
+  std::unique_ptr<ThreadPool> pool_;
+};
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_ORDERED_TASK_QUEUE_H_
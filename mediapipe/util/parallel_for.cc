@@ -0,0 +1,84 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/util/cpu_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+// Shared by the calling thread and the helper tasks. Helper tasks may start
+// after ParallelFor() has returned, so they hold it by shared_ptr and must not
+// touch `fn` unless they claimed a stripe.
+struct ParallelForState {
+  ParallelForState(int size, int num_stripes,
+                   const std::function<void(int, int)>* fn)
+      : size(size), num_stripes(num_stripes), fn(fn) {}
+
+  const int size;
+  const int num_stripes;
+  const std::function<void(int, int)>* const fn;
+  bool AllDone() const EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+    return num_done == num_stripes;
+  }
+
+  std::atomic<int> next_stripe{0};
+  absl::Mutex mutex;
+  int num_done GUARDED_BY(mutex) = 0;
+};
+
+// Runs stripes until none are left.
+void RunStripes(ParallelForState* state) {
+  int stripe;
+  while ((stripe = state->next_stripe.fetch_add(1)) < state->num_stripes) {
+    const int64 size = state->size;
+    (*state->fn)(size * stripe / state->num_stripes,
+                 size * (stripe + 1) / state->num_stripes);
+    absl::MutexLock lock(&state->mutex);
+    ++state->num_done;
+  }
+}
+
+}  // namespace
+
+void ParallelFor(Executor* executor, int size, int min_stripe_size,
+                 const std::function<void(int begin, int end)>& fn) {
+  if (size <= 0) return;
+  const int max_stripes = size / std::max(min_stripe_size, 1);
+  const int num_stripes =
+      executor ? std::max(1, std::min(NumCPUCores(), max_stripes)) : 1;
+  if (num_stripes == 1) {
+    fn(0, size);
+    return;
+  }
+
+  auto state = std::make_shared<ParallelForState>(size, num_stripes, &fn);
+  for (int i = 1; i < num_stripes; ++i) {
+    executor->Schedule([state]() { RunStripes(state.get()); });
+  }
+  RunStripes(state.get());
+  absl::MutexLock lock(&state->mutex);
+  state->mutex.Await(
+      absl::Condition(state.get(), &ParallelForState::AllDone));
+}
+
+}  // namespace mediapipe
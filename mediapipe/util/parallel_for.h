@@ -0,0 +1,48 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_PARALLEL_FOR_H_
+#define MEDIAPIPE_UTIL_PARALLEL_FOR_H_
+
+#include <functional>
+
+#include "mediapipe/framework/executor.h"
+
+namespace mediapipe {
+
+// Splits [0, size) into contiguous stripes of at least min_stripe_size and
+// calls fn(begin, end) once for each stripe, in parallel. Returns after all
+// stripes have run.
+//
+// The work is shared between the calling thread and helper tasks scheduled on
+// `executor`, which is normally the executor running the calling calculator
+// (CalculatorContext::GetExecutor()). The calling thread works through the
+// stripes itself and only waits for stripes that a helper has already started,
+// so it never deadlocks on a busy executor; helpers that start late find no
+// work left. If `executor` is nullptr, all stripes run on the calling thread.
+//
+// Since the stripes of one Process() call finish before it returns, a
+// calculator can use this to speed up large frames without raising
+// max_in_flight or reordering its outputs.
+//
+// Example:
+//   ParallelFor(cc->GetExecutor(), image.rows, 16, [&](int begin, int end) {
+//     for (int row = begin; row < end; ++row) { ... }
+//   });
+void ParallelFor(Executor* executor, int size, int min_stripe_size,
+                 const std::function<void(int begin, int end)>& fn);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_PARALLEL_FOR_H_
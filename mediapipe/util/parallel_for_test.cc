@@ -0,0 +1,77 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/parallel_for.h"
+
+#include <atomic>
+#include <vector>
+
+#include "absl/synchronization/notification.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/thread_pool_executor.h"
+
+namespace mediapipe {
+namespace {
+
+// Runs ParallelFor over `size` elements and checks that each one was visited
+// exactly once.
+void ExpectEachIndexVisitedOnce(Executor* executor, int size,
+                                int min_stripe_size) {
+  std::vector<std::atomic<int>> visits(size);
+  for (auto& count : visits) count = 0;
+  ParallelFor(executor, size, min_stripe_size, [&](int begin, int end) {
+    ASSERT_LE(0, begin);
+    ASSERT_LT(begin, end);
+    ASSERT_LE(end, size);
+    for (int i = begin; i < end; ++i) ++visits[i];
+  });
+  for (int i = 0; i < size; ++i) {
+    EXPECT_EQ(1, visits[i]) << "index " << i;
+  }
+}
+
+TEST(ParallelForTest, VisitsEachIndexOnce) {
+  ThreadPoolExecutor executor(4);
+  ExpectEachIndexVisitedOnce(&executor, 1000, 1);
+  ExpectEachIndexVisitedOnce(&executor, 1001, 16);
+  ExpectEachIndexVisitedOnce(&executor, 3, 16);
+}
+
+TEST(ParallelForTest, RunsOnCallingThreadWithoutExecutor) {
+  int num_calls = 0;
+  ParallelFor(nullptr, 100, 1, [&](int begin, int end) {
+    EXPECT_EQ(0, begin);
+    EXPECT_EQ(100, end);
+    ++num_calls;
+  });
+  EXPECT_EQ(1, num_calls);
+}
+
+TEST(ParallelForTest, DoesNothingForEmptyRange) {
+  ThreadPoolExecutor executor(2);
+  ParallelFor(&executor, 0, 1, [](int begin, int end) { FAIL(); });
+}
+
+// The calling thread must finish the work alone when the executor is busy,
+// like when all of its threads run other calculators.
+TEST(ParallelForTest, CompletesWhileExecutorIsBusy) {
+  ThreadPoolExecutor executor(1);
+  absl::Notification release;
+  executor.Schedule([&release]() { release.WaitForNotification(); });
+  ExpectEachIndexVisitedOnce(&executor, 100, 1);
+  release.Notify();
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,285 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/render_commands.h"
+
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/util/color.pb.h"
+
+namespace mediapipe {
+namespace {
+
+void SetRectangle(const RenderAnnotation::Rectangle& rectangle,
+                  RenderCommand* command) {
+  command->normalized = rectangle.normalized();
+  command->x0 = rectangle.left();
+  command->y0 = rectangle.top();
+  command->x1 = rectangle.right();
+  command->y1 = rectangle.bottom();
+}
+
+void SetRoundedRectangle(
+    const RenderAnnotation::RoundedRectangle& rounded_rectangle,
+    RenderCommand* command) {
+  SetRectangle(rounded_rectangle.rectangle(), command);
+  command->corner_radius = rounded_rectangle.corner_radius();
+  command->line_type = rounded_rectangle.line_type();
+}
+
+void GetRectangle(const RenderCommand& command,
+                  RenderAnnotation::Rectangle* rectangle) {
+  rectangle->set_normalized(command.normalized);
+  rectangle->set_left(command.x0);
+  rectangle->set_top(command.y0);
+  rectangle->set_right(command.x1);
+  rectangle->set_bottom(command.y1);
+}
+
+void GetRoundedRectangle(const RenderCommand& command,
+                         RenderAnnotation::RoundedRectangle* rounded_rectangle) {
+  GetRectangle(command, rounded_rectangle->mutable_rectangle());
+  rounded_rectangle->set_corner_radius(command.corner_radius);
+  rounded_rectangle->set_line_type(command.line_type);
+}
+
+void SetFillColor(const Color& fill_color, RenderCommand* command) {
+  command->fill_color_r = fill_color.r();
+  command->fill_color_g = fill_color.g();
+  command->fill_color_b = fill_color.b();
+}
+
+void GetColor(const RenderCommand& command, Color* color) {
+  color->set_r(command.color_r);
+  color->set_g(command.color_g);
+  color->set_b(command.color_b);
+}
+
+void GetFillColor(const RenderCommand& command, Color* fill_color) {
+  fill_color->set_r(command.fill_color_r);
+  fill_color->set_g(command.fill_color_g);
+  fill_color->set_b(command.fill_color_b);
+}
+
+}  // namespace
+
+RenderCommand* RenderCommandBuffer::Add(RenderCommand::Type type) {
+  commands_.emplace_back();
+  RenderCommand* command = &commands_.back();
+  command->type = type;
+  return command;
+}
+
+void RenderCommandBuffer::SetText(RenderCommand* command,
+                                  absl::string_view text) {
+  command->text_begin = strings_.size();
+  strings_.append(text.data(), text.size());
+  command->text_end = strings_.size();
+}
+
+void RenderCommandBuffer::SetSceneTag(RenderCommand* command,
+                                      absl::string_view scene_tag) {
+  if (scene_tag != absl::string_view(strings_).substr(
+                       last_scene_tag_begin_,
+                       last_scene_tag_end_ - last_scene_tag_begin_)) {
+    last_scene_tag_begin_ = strings_.size();
+    strings_.append(scene_tag.data(), scene_tag.size());
+    last_scene_tag_end_ = strings_.size();
+  }
+  command->scene_tag_begin = last_scene_tag_begin_;
+  command->scene_tag_end = last_scene_tag_end_;
+}
+
+absl::string_view RenderCommandBuffer::text(
+    const RenderCommand& command) const {
+  return absl::string_view(strings_).substr(
+      command.text_begin, command.text_end - command.text_begin);
+}
+
+absl::string_view RenderCommandBuffer::scene_tag(
+    const RenderCommand& command) const {
+  return absl::string_view(strings_).substr(
+      command.scene_tag_begin, command.scene_tag_end - command.scene_tag_begin);
+}
+
+void RenderCommandBuffer::Clear() {
+  commands_.clear();
+  strings_.clear();
+  last_scene_tag_begin_ = 0;
+  last_scene_tag_end_ = 0;
+  scene_class_.clear();
+}
+
+void AppendRenderData(const RenderData& render_data,
+                      RenderCommandBuffer* commands) {
+  if (render_data.has_scene_class()) {
+    commands->set_scene_class(render_data.scene_class());
+  }
+  for (const auto& annotation : render_data.render_annotations()) {
+    RenderCommand* command;
+    switch (annotation.data_case()) {
+      case RenderAnnotation::kRectangle:
+        command = commands->Add(RenderCommand::RECTANGLE);
+        SetRectangle(annotation.rectangle(), command);
+        break;
+      case RenderAnnotation::kFilledRectangle:
+        command = commands->Add(RenderCommand::FILLED_RECTANGLE);
+        SetRectangle(annotation.filled_rectangle().rectangle(), command);
+        SetFillColor(annotation.filled_rectangle().fill_color(), command);
+        break;
+      case RenderAnnotation::kRoundedRectangle:
+        command = commands->Add(RenderCommand::ROUNDED_RECTANGLE);
+        SetRoundedRectangle(annotation.rounded_rectangle(), command);
+        break;
+      case RenderAnnotation::kFilledRoundedRectangle:
+        command = commands->Add(RenderCommand::FILLED_ROUNDED_RECTANGLE);
+        SetRoundedRectangle(
+            annotation.filled_rounded_rectangle().rounded_rectangle(), command);
+        SetFillColor(annotation.filled_rounded_rectangle().fill_color(),
+                     command);
+        break;
+      case RenderAnnotation::kOval:
+        command = commands->Add(RenderCommand::OVAL);
+        SetRectangle(annotation.oval().rectangle(), command);
+        break;
+      case RenderAnnotation::kFilledOval:
+        command = commands->Add(RenderCommand::FILLED_OVAL);
+        SetRectangle(annotation.filled_oval().oval().rectangle(), command);
+        SetFillColor(annotation.filled_oval().fill_color(), command);
+        break;
+      case RenderAnnotation::kPoint:
+        command = commands->Add(RenderCommand::POINT);
+        command->normalized = annotation.point().normalized();
+        command->x0 = annotation.point().x();
+        command->y0 = annotation.point().y();
+        break;
+      case RenderAnnotation::kLine:
+        command = commands->Add(RenderCommand::LINE);
+        command->normalized = annotation.line().normalized();
+        command->x0 = annotation.line().x_start();
+        command->y0 = annotation.line().y_start();
+        command->x1 = annotation.line().x_end();
+        command->y1 = annotation.line().y_end();
+        command->line_style = annotation.line().line_type();
+        break;
+      case RenderAnnotation::kArrow:
+        command = commands->Add(RenderCommand::ARROW);
+        command->normalized = annotation.arrow().normalized();
+        command->x0 = annotation.arrow().x_start();
+        command->y0 = annotation.arrow().y_start();
+        command->x1 = annotation.arrow().x_end();
+        command->y1 = annotation.arrow().y_end();
+        break;
+      case RenderAnnotation::kText:
+        command = commands->Add(RenderCommand::TEXT);
+        command->normalized = annotation.text().normalized();
+        command->x0 = annotation.text().left();
+        command->y0 = annotation.text().baseline();
+        command->font_height = annotation.text().font_height();
+        command->font_face = annotation.text().font_face();
+        commands->SetText(command, annotation.text().display_text());
+        break;
+      default:
+        LOG(FATAL) << "Unknown annotation type: " << annotation.data_case();
+    }
+    command->thickness = annotation.thickness();
+    command->color_r = annotation.color().r();
+    command->color_g = annotation.color().g();
+    command->color_b = annotation.color().b();
+    if (annotation.has_scene_tag()) {
+      commands->SetSceneTag(command, annotation.scene_tag());
+    }
+  }
+}
+
+RenderData RenderCommandsToRenderData(const RenderCommandBuffer& commands) {
+  RenderData render_data;
+  render_data.set_scene_class(commands.scene_class());
+  render_data.mutable_render_annotations()->Reserve(commands.size());
+  for (const RenderCommand& command : commands.commands()) {
+    RenderAnnotation* annotation = render_data.add_render_annotations();
+    switch (command.type) {
+      case RenderCommand::RECTANGLE:
+        GetRectangle(command, annotation->mutable_rectangle());
+        break;
+      case RenderCommand::FILLED_RECTANGLE:
+        GetRectangle(command,
+                     annotation->mutable_filled_rectangle()->mutable_rectangle());
+        GetFillColor(
+            command,
+            annotation->mutable_filled_rectangle()->mutable_fill_color());
+        break;
+      case RenderCommand::ROUNDED_RECTANGLE:
+        GetRoundedRectangle(command, annotation->mutable_rounded_rectangle());
+        break;
+      case RenderCommand::FILLED_ROUNDED_RECTANGLE:
+        GetRoundedRectangle(command,
+                            annotation->mutable_filled_rounded_rectangle()
+                                ->mutable_rounded_rectangle());
+        GetFillColor(command, annotation->mutable_filled_rounded_rectangle()
+                                  ->mutable_fill_color());
+        break;
+      case RenderCommand::OVAL:
+        GetRectangle(command,
+                     annotation->mutable_oval()->mutable_rectangle());
+        break;
+      case RenderCommand::FILLED_OVAL:
+        GetRectangle(command, annotation->mutable_filled_oval()
+                                  ->mutable_oval()
+                                  ->mutable_rectangle());
+        GetFillColor(command,
+                     annotation->mutable_filled_oval()->mutable_fill_color());
+        break;
+      case RenderCommand::POINT:
+        annotation->mutable_point()->set_normalized(command.normalized);
+        annotation->mutable_point()->set_x(command.x0);
+        annotation->mutable_point()->set_y(command.y0);
+        break;
+      case RenderCommand::LINE:
+        annotation->mutable_line()->set_normalized(command.normalized);
+        annotation->mutable_line()->set_x_start(command.x0);
+        annotation->mutable_line()->set_y_start(command.y0);
+        annotation->mutable_line()->set_x_end(command.x1);
+        annotation->mutable_line()->set_y_end(command.y1);
+        annotation->mutable_line()->set_line_type(command.line_style);
+        break;
+      case RenderCommand::ARROW:
+        annotation->mutable_arrow()->set_normalized(command.normalized);
+        annotation->mutable_arrow()->set_x_start(command.x0);
+        annotation->mutable_arrow()->set_y_start(command.y0);
+        annotation->mutable_arrow()->set_x_end(command.x1);
+        annotation->mutable_arrow()->set_y_end(command.y1);
+        break;
+      case RenderCommand::TEXT: {
+        RenderAnnotation::Text* text = annotation->mutable_text();
+        text->set_normalized(command.normalized);
+        text->set_left(command.x0);
+        text->set_baseline(command.y0);
+        text->set_font_height(command.font_height);
+        text->set_font_face(command.font_face);
+        const absl::string_view display_text = commands.text(command);
+        text->set_display_text(display_text.data(), display_text.size());
+        break;
+      }
+    }
+    annotation->set_thickness(command.thickness);
+    GetColor(command, annotation->mutable_color());
+    const absl::string_view scene_tag = commands.scene_tag(command);
+    if (!scene_tag.empty()) {
+      annotation->set_scene_tag(scene_tag.data(), scene_tag.size());
+    }
+  }
+  return render_data;
+}
+
+}  // namespace mediapipe
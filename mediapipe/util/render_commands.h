@@ -0,0 +1,145 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_RENDER_COMMANDS_H_
+#define MEDIAPIPE_UTIL_RENDER_COMMANDS_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/util/render_data.pb.h"
+
+namespace mediapipe {
+
+// One annotation of a RenderCommandBuffer. It holds the same data as a
+// RenderAnnotation in a fixed-size struct, with its strings stored in the
+// buffer.
+struct RenderCommand {
+  enum Type : uint8 {
+    RECTANGLE,
+    FILLED_RECTANGLE,
+    ROUNDED_RECTANGLE,
+    FILLED_ROUNDED_RECTANGLE,
+    OVAL,
+    FILLED_OVAL,
+    POINT,
+    LINE,
+    ARROW,
+    TEXT,
+  };
+
+  Type type = RECTANGLE;
+  bool normalized = false;
+  // The coordinates, as in the RenderAnnotation of the same type:
+  // - Rectangles and ovals: left, top, right, bottom.
+  // - Lines and arrows: x_start, y_start, x_end, y_end.
+  // - Points: x, y.
+  // - Text: left, baseline.
+  // They are doubles like in RenderAnnotation, so converting from and to
+  // RenderData keeps their values.
+  double x0 = 0.0;
+  double y0 = 0.0;
+  double x1 = 0.0;
+  double y1 = 0.0;
+  double thickness = 1.0;
+  int32 color_r = 0;
+  int32 color_g = 0;
+  int32 color_b = 0;
+  // Filled shapes only. The renderer draws filled shapes with the color above.
+  int32 fill_color_r = 0;
+  int32 fill_color_g = 0;
+  int32 fill_color_b = 0;
+  // Rounded rectangles only.
+  int32 corner_radius = 0;
+  int32 line_type = 4;
+  // Lines only.
+  RenderAnnotation::Line::LineType line_style = RenderAnnotation::Line::SOLID;
+  // Text only.
+  double font_height = 8.0;
+  int32 font_face = 0;
+  // The display text and the scene tag, as [begin, end) offsets into the
+  // strings of the buffer.
+  int32 text_begin = 0;
+  int32 text_end = 0;
+  int32 scene_tag_begin = 0;
+  int32 scene_tag_end = 0;
+};
+
+// A flat list of annotations to draw, used in place of RenderData on streams
+// with many annotations per frame. All commands live in one vector and all
+// strings in one contiguous string, so filling a buffer makes no allocation
+// per annotation, and a cleared buffer reuses its memory.
+//
+// AppendRenderData() and RenderCommandsToRenderData() convert from and to
+// RenderData for graphs that produce or consume the proto.
+//
+// Example:
+//   RenderCommandBuffer commands;
+//   RenderCommand* box = commands.Add(RenderCommand::RECTANGLE);
+//   box->x0 = 10;
+//   ...
+//   commands.SetText(commands.Add(RenderCommand::TEXT), "label");
+class RenderCommandBuffer {
+ public:
+  RenderCommandBuffer() = default;
+
+  // Appends a command of "type" with default values and returns it. The
+  // pointer is valid until the next call to Add() or Clear().
+  RenderCommand* Add(RenderCommand::Type type);
+
+  // Sets the display text or the scene tag of "command", which must be a
+  // command of this buffer.
+  void SetText(RenderCommand* command, absl::string_view text);
+  void SetSceneTag(RenderCommand* command, absl::string_view scene_tag);
+
+  absl::string_view text(const RenderCommand& command) const;
+  absl::string_view scene_tag(const RenderCommand& command) const;
+
+  const std::vector<RenderCommand>& commands() const { return commands_; }
+  int size() const { return commands_.size(); }
+  bool empty() const { return commands_.empty(); }
+
+  // See RenderData.scene_class.
+  const std::string& scene_class() const { return scene_class_; }
+  void set_scene_class(const std::string& scene_class) {
+    scene_class_ = scene_class;
+  }
+
+  // Removes all commands and strings, and keeps the allocated memory.
+  void Clear();
+
+ private:
+  std::vector<RenderCommand> commands_;
+  // The display texts and scene tags of all commands.
+  std::string strings_;
+  // The range of the last scene tag in "strings_", reused by consecutive
+  // commands with the same tag.
+  int32 last_scene_tag_begin_ = 0;
+  int32 last_scene_tag_end_ = 0;
+  std::string scene_class_;
+};
+
+// Appends the annotations of "render_data" to "commands". The scene viewport
+// is not kept.
+void AppendRenderData(const RenderData& render_data,
+                      RenderCommandBuffer* commands);
+
+// Returns the RenderData with the annotations of "commands".
+RenderData RenderCommandsToRenderData(const RenderCommandBuffer& commands);
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_RENDER_COMMANDS_H_
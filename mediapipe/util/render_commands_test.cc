@@ -0,0 +1,329 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/render_commands.h"
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/deps/message_matchers.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/util/annotation_renderer.h"
+#include "mediapipe/util/render_data.pb.h"
+
+namespace mediapipe {
+namespace {
+
+constexpr int kImageWidth = 640;
+constexpr int kImageHeight = 480;
+
+// One annotation of every type, with every field the renderer uses set. Some
+// values, such as 0.1 and 1/3, cannot be represented exactly as floats, and the
+// fill colors differ from the outline colors, so that round trips through
+// RenderCommandBuffer check that no field is truncated or mixed up.
+RenderData MakeRenderDataOfAllTypes() {
+  return ParseTextProtoOrDie<RenderData>(R"(
+    scene_class: "TEST"
+    render_annotations {
+      rectangle {
+        left: 0.1
+        top: 0.3333333333333333
+        right: 0.75
+        bottom: 1
+        normalized: true
+      }
+      thickness: 2
+      color { r: 1 g: 0 b: 0 }
+      scene_tag: "BOX"
+    }
+    render_annotations {
+      filled_rectangle {
+        rectangle { left: 10 top: 20 right: 30 bottom: 40 normalized: false }
+        fill_color { r: 0 g: 0 b: 255 }
+      }
+      thickness: 1
+      color { r: 0 g: 1 b: 0 }
+      scene_tag: "BOX"
+    }
+    render_annotations {
+      rounded_rectangle {
+        rectangle { left: 50 top: 60 right: 150 bottom: 160 normalized: false }
+        corner_radius: 8
+        line_type: 8
+      }
+      thickness: 3
+      color { r: 0 g: 0 b: 1 }
+    }
+    render_annotations {
+      filled_rounded_rectangle {
+        rounded_rectangle {
+          rectangle {
+            left: 200
+            top: 60
+            right: 300
+            bottom: 160
+            normalized: false
+          }
+          corner_radius: 4
+          line_type: 4
+        }
+        fill_color { r: 255 g: 0 b: 0 }
+      }
+      thickness: 1
+      color { r: 1 g: 1 b: 0 }
+    }
+    render_annotations {
+      oval {
+        rectangle { left: 0.5 top: 0.25 right: 0.75 bottom: 0.5 normalized: true }
+      }
+      thickness: 2
+      color { r: 0 g: 1 b: 1 }
+    }
+    render_annotations {
+      filled_oval {
+        oval {
+          rectangle {
+            left: 400
+            top: 300
+            right: 440
+            bottom: 320
+            normalized: false
+          }
+        }
+        fill_color { r: 0 g: 255 b: 0 }
+      }
+      thickness: 1
+      color { r: 1 g: 0 b: 1 }
+    }
+    render_annotations {
+      point { x: 0.1 y: 0.3333333333333333 normalized: true }
+      thickness: 4
+      color { r: 1 g: 1 b: 1 }
+      scene_tag: "KEYPOINT"
+    }
+    render_annotations {
+      line {
+        x_start: 10.1
+        y_start: 400
+        x_end: 300
+        y_end: 450.3
+        normalized: false
+        line_type: DASHED
+      }
+      thickness: 2
+      color { r: 1 g: 0 b: 0 }
+    }
+    render_annotations {
+      arrow { x_start: 500 y_start: 50 x_end: 600 y_end: 150 normalized: false }
+      thickness: 2
+      color { r: 0 g: 1 b: 0 }
+    }
+    render_annotations {
+      text {
+        display_text: "label,0.5,"
+        left: 0.125
+        baseline: 0.25
+        font_height: 0.1
+        normalized: true
+        font_face: 2
+      }
+      thickness: 1
+      color { r: 0 g: 0 b: 1 }
+      scene_tag: "LABEL"
+    }
+  )");
+}
+
+// Returns "num_detections" detections as drawn by
+// DetectionsToRenderDataCalculator: a box, a label and six keypoints each.
+RenderCommandBuffer MakeDetectionCommands(int num_detections) {
+  RenderCommandBuffer commands;
+  for (int i = 0; i < num_detections; ++i) {
+    const float x = (i % 20) / 20.0f;
+    const float y = (i / 20 % 20) / 20.0f;
+    RenderCommand* label = commands.Add(RenderCommand::TEXT);
+    commands.SetSceneTag(label, "LABEL");
+    commands.SetText(label, absl::StrCat(i, ",0.9,"));
+    label->normalized = true;
+    label->x0 = x;
+    label->y0 = y + 0.01f;
+    label->font_height = 0.01f;
+    label->color_r = 1;
+    RenderCommand* box = commands.Add(RenderCommand::RECTANGLE);
+    commands.SetSceneTag(box, "LOCATION");
+    box->normalized = true;
+    box->x0 = x;
+    box->y0 = y;
+    box->x1 = x + 0.04f;
+    box->y1 = y + 0.04f;
+    box->thickness = 2;
+    box->color_r = 1;
+    for (int k = 0; k < 6; ++k) {
+      RenderCommand* keypoint = commands.Add(RenderCommand::POINT);
+      commands.SetSceneTag(keypoint, "KEYPOINT");
+      keypoint->normalized = true;
+      keypoint->x0 = x + k * 0.005f;
+      keypoint->y0 = y + 0.02f;
+      keypoint->color_r = 1;
+    }
+  }
+  return commands;
+}
+
+TEST(RenderCommandsTest, RoundTripsRenderData) {
+  const RenderData render_data = MakeRenderDataOfAllTypes();
+  RenderCommandBuffer commands;
+  AppendRenderData(render_data, &commands);
+  ASSERT_EQ(render_data.render_annotations_size(), commands.size());
+  EXPECT_EQ("TEST", commands.scene_class());
+  EXPECT_EQ("label,0.5,", commands.text(commands.commands().back()));
+  EXPECT_THAT(RenderCommandsToRenderData(commands), EqualsProto(render_data));
+}
+
+TEST(RenderCommandsTest, StoresRepeatedSceneTagsOnce) {
+  RenderCommandBuffer commands;
+  for (int i = 0; i < 3; ++i) {
+    commands.SetSceneTag(commands.Add(RenderCommand::POINT), "KEYPOINT");
+  }
+  commands.SetSceneTag(commands.Add(RenderCommand::RECTANGLE), "LOCATION");
+  for (const RenderCommand& command : commands.commands()) {
+    EXPECT_EQ(command.type == RenderCommand::POINT ? "KEYPOINT" : "LOCATION",
+              commands.scene_tag(command));
+  }
+  EXPECT_EQ(commands.commands()[0].scene_tag_begin,
+            commands.commands()[2].scene_tag_begin);
+
+  commands.Clear();
+  EXPECT_TRUE(commands.empty());
+  RenderCommand* text = commands.Add(RenderCommand::TEXT);
+  commands.SetText(text, "a");
+  EXPECT_EQ("a", commands.text(commands.commands()[0]));
+  EXPECT_EQ("", commands.scene_tag(commands.commands()[0]));
+}
+
+// Checks that RenderCommandsOnImage() and RenderDataOnImage() draw the same
+// pixels for "commands".
+void ExpectSameImage(const RenderCommandBuffer& commands) {
+  cv::Mat from_commands(kImageHeight, kImageWidth, CV_8UC3, cv::Scalar(0));
+  cv::Mat from_render_data = from_commands.clone();
+  AnnotationRenderer renderer;
+  renderer.AdoptImage(&from_commands);
+  renderer.RenderCommandsOnImage(commands);
+  renderer.AdoptImage(&from_render_data);
+  renderer.RenderDataOnImage(RenderCommandsToRenderData(commands));
+  cv::Mat difference;
+  cv::absdiff(from_commands, from_render_data, difference);
+  EXPECT_EQ(0, cv::countNonZero(difference.reshape(1)));
+  EXPECT_GT(cv::countNonZero(from_commands.reshape(1)), 0);
+}
+
+TEST(RenderCommandsTest, RendersSameImageAsRenderData) {
+  RenderCommandBuffer commands;
+  AppendRenderData(MakeRenderDataOfAllTypes(), &commands);
+  ExpectSameImage(commands);
+}
+
+TEST(RenderCommandsTest, RendersBatchedRectanglesAsRenderData) {
+  RenderCommandBuffer commands = MakeDetectionCommands(100);
+  // Empty and inverted rectangles are handled as by cv::rectangle().
+  RenderCommand* empty = commands.Add(RenderCommand::RECTANGLE);
+  empty->x0 = empty->x1 = 100;
+  empty->y1 = 50;
+  empty->color_r = 1;
+  empty->thickness = 2;
+  RenderCommand* inverted = commands.Add(RenderCommand::RECTANGLE);
+  inverted->x0 = 300;
+  inverted->y0 = 300;
+  inverted->x1 = 200;
+  inverted->y1 = 250;
+  inverted->color_r = 1;
+  inverted->thickness = 2;
+  ExpectSameImage(commands);
+}
+
+TEST(RenderCommandsTest, RendersStripesAsWholeImage) {
+  // Boxes that cross the stripe boundaries with vertical edges only, which
+  // clipping does not change.
+  RenderCommandBuffer commands;
+  for (int i = 0; i < 8; ++i) {
+    RenderCommand* box = commands.Add(i % 2 ? RenderCommand::RECTANGLE
+                                            : RenderCommand::FILLED_RECTANGLE);
+    box->x0 = 20 + i * 70;
+    box->y0 = 30 + i * 5;
+    box->x1 = box->x0 + 50;
+    box->y1 = box->y0 + 320;
+    box->thickness = 3;
+    box->color_g = 1;
+  }
+  RenderCommand* frame = commands.Add(RenderCommand::RECTANGLE);
+  frame->normalized = true;
+  frame->x0 = 0.1;
+  frame->y0 = 0.1;
+  frame->x1 = 0.9;
+  frame->y1 = 0.95;
+  frame->thickness = 2;
+  frame->color_b = 1;
+
+  cv::Mat whole(kImageHeight, kImageWidth, CV_8UC3, cv::Scalar(0));
+  cv::Mat striped = whole.clone();
+  AnnotationRenderer renderer;
+  renderer.AdoptImage(&whole);
+  renderer.RenderCommandsOnImage(commands);
+  int begin = 0;
+  for (const int end : {100, 250, 400, kImageHeight}) {
+    AnnotationRenderer stripe_renderer;
+    stripe_renderer.AdoptImageStripe(&striped, begin, end);
+    EXPECT_EQ(kImageHeight, stripe_renderer.GetImageHeight());
+    stripe_renderer.RenderCommandsOnImage(commands);
+    begin = end;
+  }
+  cv::Mat difference;
+  cv::absdiff(whole, striped, difference);
+  EXPECT_EQ(0, cv::countNonZero(difference.reshape(1)));
+  EXPECT_GT(cv::countNonZero(whole.reshape(1)), 0);
+}
+
+// Builds the annotations of "num_detections" detections and draws them on a
+// VGA frame, either through RenderData or through a RenderCommandBuffer.
+void RunRenderBenchmark(benchmark::State& state, bool use_commands) {
+  const RenderCommandBuffer detections = MakeDetectionCommands(state.range(0));
+  cv::Mat image(kImageHeight, kImageWidth, CV_8UC3, cv::Scalar(0));
+  AnnotationRenderer renderer;
+  renderer.AdoptImage(&image);
+  for (auto _ : state) {
+    // Each frame builds its annotations anew, as a calculator does.
+    if (use_commands) {
+      RenderCommandBuffer commands(detections);
+      renderer.RenderCommandsOnImage(commands);
+    } else {
+      renderer.RenderDataOnImage(RenderCommandsToRenderData(detections));
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_RenderData(benchmark::State& state) {
+  RunRenderBenchmark(state, false);
+}
+BENCHMARK(BM_RenderData)->Arg(10)->Arg(100)->Arg(400);
+
+void BM_RenderCommands(benchmark::State& state) {
+  RunRenderBenchmark(state, true);
+}
+BENCHMARK(BM_RenderCommands)->Arg(10)->Arg(100)->Arg(400);
+
+}  // namespace
+}  // namespace mediapipe
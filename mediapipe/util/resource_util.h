@@ -15,8 +15,11 @@
 #ifndef MEDIAPIPE_UTIL_RESOURCE_UTIL_H_
 #define MEDIAPIPE_UTIL_RESOURCE_UTIL_H_
 
+#include <cstddef>
+#include <memory>
 #include <string>
 
+#include "absl/strings/string_view.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/port/statusor.h"
 
@@ -47,6 +50,36 @@ namespace mediapipe {
 ::mediapipe::Status GetResourceContents(const std::string& path,
                                         std::string* output);
 
+// A read-only view of the contents of a resource, see GetResourceView().
+class ResourceView {
+ public:
+  virtual ~ResourceView() = default;
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  absl::string_view contents() const { return absl::string_view(data_, size_); }
+
+ protected:
+  ResourceView(const char* data, size_t size) : data_(data), size_(size) {}
+
+ private:
+  const char* const data_;
+  const size_t size_;
+};
+
+// Returns a view of the entire contents of a resource, without copying them.
+// The search path is as in PathToResourceAsFile. The resource file is
+// memory-mapped, so all views of it share the same pages of the page cache,
+// in this process and in others. The view can be shared by any number of
+// users, and the file is unmapped when the last reference is released.
+::mediapipe::StatusOr<std::shared_ptr<const ResourceView>> GetResourceView(
+    const std::string& path);
+
+// Like GetResourceView, but maps the file at "file_path" as is, without
+// searching for it as a resource.
+::mediapipe::StatusOr<std::shared_ptr<const ResourceView>> GetFileView(
+    const std::string& file_path);
+
 }  // namespace mediapipe
 
 #endif  // MEDIAPIPE_UTIL_RESOURCE_UTIL_H_
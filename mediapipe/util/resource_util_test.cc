@@ -0,0 +1,78 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/resource_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe {
+namespace {
+
+TEST(ResourceUtilTest, GetResourceViewMapsContents) {
+  const std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/resource_view_contents");
+  const std::string contents = "label_0\nlabel_1\n";
+  MEDIAPIPE_ASSERT_OK(file::SetContents(path, contents));
+
+  auto status_or_view = GetResourceView(path);
+  MEDIAPIPE_ASSERT_OK(status_or_view);
+  std::shared_ptr<const ResourceView> view = status_or_view.ValueOrDie();
+  EXPECT_EQ(contents.size(), view->size());
+  EXPECT_EQ(contents, view->contents());
+
+  // The mapping outlives the file.
+  ASSERT_EQ(0, remove(path.c_str()));
+  EXPECT_EQ(contents, view->contents());
+}
+
+TEST(ResourceUtilTest, GetResourceViewOfEmptyFile) {
+  const std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/resource_view_empty");
+  MEDIAPIPE_ASSERT_OK(file::SetContents(path, ""));
+
+  auto status_or_view = GetResourceView(path);
+  MEDIAPIPE_ASSERT_OK(status_or_view);
+  EXPECT_EQ(0, status_or_view.ValueOrDie()->size());
+  EXPECT_TRUE(status_or_view.ValueOrDie()->contents().empty());
+}
+
+TEST(ResourceUtilTest, GetResourceViewOfMissingFile) {
+  const std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/resource_view_missing");
+  EXPECT_EQ(::mediapipe::StatusCode::kNotFound,
+            GetResourceView(path).status().code());
+}
+
+TEST(ResourceUtilTest, GetFileViewMapsContents) {
+  const std::string path =
+      absl::StrCat(getenv("TEST_TMPDIR"), "/file_view_contents");
+  const std::string contents = "graph_def";
+  MEDIAPIPE_ASSERT_OK(file::SetContents(path, contents));
+
+  auto status_or_view = GetFileView(path);
+  MEDIAPIPE_ASSERT_OK(status_or_view);
+  EXPECT_EQ(contents, status_or_view.ValueOrDie()->contents());
+  EXPECT_EQ(::mediapipe::StatusCode::kNotFound,
+            GetFileView(absl::StrCat(path, "_missing")).status().code());
+}
+
+}  // namespace
+}  // namespace mediapipe
@@ -0,0 +1,91 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/port/canonical_errors.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/util/resource_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+// A ResourceView of a memory-mapped file.
+class MappedResourceView : public ResourceView {
+ public:
+  // Takes ownership of the mapping of "size" bytes at "address". An empty
+  // file has no mapping, and "address" is null.
+  MappedResourceView(void* address, size_t size)
+      : ResourceView(static_cast<const char*>(address), size),
+        address_(address) {}
+
+  ~MappedResourceView() override {
+    if (address_ != nullptr) {
+      munmap(address_, size());
+    }
+  }
+
+ private:
+  void* const address_;
+};
+
+}  // namespace
+
+::mediapipe::StatusOr<std::shared_ptr<const ResourceView>> GetFileView(
+    const std::string& file_path) {
+  const int fd = open(file_path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return ::mediapipe::NotFoundError(
+        absl::StrCat("Could not open ", file_path, ": ", strerror(errno)));
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    const int error = errno;
+    close(fd);
+    return ::mediapipe::InternalError(
+        absl::StrCat("Could not stat ", file_path, ": ", strerror(error)));
+  }
+  const size_t size = file_stat.st_size;
+  void* address = nullptr;
+  if (size > 0) {
+    address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  // The mapping stays valid after the file is closed.
+  const int error = errno;
+  close(fd);
+  if (address == MAP_FAILED) {
+    return ::mediapipe::InternalError(
+        absl::StrCat("Could not map ", file_path, ": ", strerror(error)));
+  }
+  return std::shared_ptr<const ResourceView>(
+      std::make_shared<MappedResourceView>(address, size));
+}
+
+// On Android, PathToResourceAsFile() copies an asset to the file system the
+// first time it is requested, so assets are mapped from that copy.
+::mediapipe::StatusOr<std::shared_ptr<const ResourceView>> GetResourceView(
+    const std::string& path) {
+  std::string file_path;
+  ASSIGN_OR_RETURN(file_path, PathToResourceAsFile(path));
+  return GetFileView(file_path);
+}
+
+}  // namespace mediapipe
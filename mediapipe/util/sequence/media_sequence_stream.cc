@@ -0,0 +1,323 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/sequence/media_sequence_stream.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/advanced_proto_lite_inc.h"
+#include "mediapipe/framework/port/ret_check.h"
+#include "mediapipe/util/sequence/media_sequence_util.h"
+#include "tensorflow/core/lib/core/errors.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+
+namespace mediapipe {
+namespace mediasequence {
+
+namespace {
+
+namespace tf = ::tensorflow;
+
+using proto_ns::io::CodedInputStream;
+using proto_ns::io::CodedOutputStream;
+using proto_ns::io::StringOutputStream;
+using WireFormatLite = proto_ns::internal::WireFormatLite;
+
+// Field numbers of the key and value in a serialized proto map entry.
+constexpr int kMapEntryKeyField = 1;
+constexpr int kMapEntryValueField = 2;
+
+// Calls `callback(field_number, payload)` for each length-delimited field of a
+// serialized message and skips fields of other wire types. The payload points
+// into `message` and is not copied.
+template <typename Callback>
+::mediapipe::Status ForEachLengthDelimitedField(absl::string_view message,
+                                                Callback callback) {
+  CodedInputStream in(reinterpret_cast<const uint8*>(message.data()),
+                      message.size());
+  uint32 tag;
+  while ((tag = in.ReadTag()) != 0) {
+    if (WireFormatLite::GetTagWireType(tag) !=
+        WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      RET_CHECK(WireFormatLite::SkipField(&in, tag));
+      continue;
+    }
+    uint32 length;
+    RET_CHECK(in.ReadVarint32(&length));
+    const int offset = in.CurrentPosition();
+    RET_CHECK_LE(offset + length, message.size()) << "Truncated message.";
+    RETURN_IF_ERROR(callback(WireFormatLite::GetTagFieldNumber(tag),
+                             message.substr(offset, length)));
+    RET_CHECK(in.Skip(length));
+  }
+  return ::mediapipe::OkStatus();
+}
+
+// Splits a serialized map entry into its serialized key and value.
+::mediapipe::Status ParseMapEntry(absl::string_view entry,
+                                  absl::string_view* key,
+                                  absl::string_view* value) {
+  return ForEachLengthDelimitedField(
+      entry, [&](int field, absl::string_view payload) -> ::mediapipe::Status {
+        if (field == kMapEntryKeyField) {
+          *key = payload;
+        } else if (field == kMapEntryValueField) {
+          *value = payload;
+        }
+        return ::mediapipe::OkStatus();
+      });
+}
+
+// Finds the serialized FeatureList for each of `keys` in a serialized
+// SequenceExample. Missing feature lists are returned as empty views.
+::mediapipe::Status FindFeatureLists(
+    absl::string_view serialized, const std::vector<std::string>& keys,
+    std::vector<absl::string_view>* feature_lists) {
+  feature_lists->assign(keys.size(), absl::string_view());
+  return ForEachLengthDelimitedField(
+      serialized,
+      [&](int field, absl::string_view lists) -> ::mediapipe::Status {
+        if (field != tf::SequenceExample::kFeatureListsFieldNumber) {
+          return ::mediapipe::OkStatus();
+        }
+        return ForEachLengthDelimitedField(
+            lists,
+            [&](int field, absl::string_view entry) -> ::mediapipe::Status {
+              if (field != tf::FeatureLists::kFeatureListFieldNumber) {
+                return ::mediapipe::OkStatus();
+              }
+              absl::string_view key;
+              absl::string_view value;
+              RETURN_IF_ERROR(ParseMapEntry(entry, &key, &value));
+              for (int i = 0; i < keys.size(); ++i) {
+                if (keys[i] == key) {
+                  (*feature_lists)[i] = value;
+                }
+              }
+              return ::mediapipe::OkStatus();
+            });
+      });
+}
+
+// Appends the features with index in [begin, end) of a serialized FeatureList
+// to `output`. Only those features are decoded.
+::mediapipe::Status AppendFeatures(absl::string_view feature_list, int begin,
+                                   int end, tf::FeatureList* output) {
+  int index = 0;
+  return ForEachLengthDelimitedField(
+      feature_list,
+      [&](int field, absl::string_view feature) -> ::mediapipe::Status {
+        if (field != tf::FeatureList::kFeatureFieldNumber) {
+          return ::mediapipe::OkStatus();
+        }
+        if (index >= begin && index < end) {
+          RET_CHECK(
+              output->add_feature()->ParseFromArray(feature.data(),
+                                                    feature.size()));
+        }
+        ++index;
+        return ::mediapipe::OkStatus();
+      });
+}
+
+// Writes records to a file in the TFRecord format.
+class TfRecordSink : public SequenceExampleRecordSink {
+ public:
+  explicit TfRecordSink(std::unique_ptr<tf::WritableFile> file)
+      : file_(std::move(file)),
+        writer_(absl::make_unique<tf::io::RecordWriter>(file_.get())) {}
+
+  ::mediapipe::Status WriteRecord(absl::string_view record) override {
+    const tf::Status status =
+        writer_->WriteRecord(tf::StringPiece(record.data(), record.size()));
+    RET_CHECK(status.ok()) << status.ToString();
+    return ::mediapipe::OkStatus();
+  }
+
+  ::mediapipe::Status Close() override {
+    tf::Status status = writer_->Close();
+    RET_CHECK(status.ok()) << status.ToString();
+    status = file_->Close();
+    RET_CHECK(status.ok()) << status.ToString();
+    return ::mediapipe::OkStatus();
+  }
+
+ private:
+  std::unique_ptr<tf::WritableFile> file_;
+  std::unique_ptr<tf::io::RecordWriter> writer_;
+};
+
+}  // namespace
+
+::mediapipe::StatusOr<std::unique_ptr<SequenceExampleRecordSink>>
+CreateTfRecordSink(const std::string& path) {
+  std::unique_ptr<tf::WritableFile> file;
+  const tf::Status status = tf::Env::Default()->NewWritableFile(path, &file);
+  RET_CHECK(status.ok()) << status.ToString();
+  return std::unique_ptr<SequenceExampleRecordSink>(
+      absl::make_unique<TfRecordSink>(std::move(file)));
+}
+
+SequenceExampleStreamWriter::SequenceExampleStreamWriter(
+    std::unique_ptr<SequenceExampleRecordSink> sink)
+    : sink_(std::move(sink)) {}
+
+::mediapipe::Status SequenceExampleStreamWriter::WriteAndClearFeatureLists(
+    tf::SequenceExample* sequence) {
+  std::string record;
+  if (!context_written_) {
+    RET_CHECK(sequence->SerializeToString(&record));
+    context_written_ = true;
+  } else {
+    const tf::FeatureLists& feature_lists = sequence->feature_lists();
+    if (feature_lists.feature_list().empty()) {
+      return ::mediapipe::OkStatus();
+    }
+    // Serializes only the feature_lists field, so the context is not repeated.
+    const size_t size = feature_lists.ByteSizeLong();
+    StringOutputStream sos(&record);
+    CodedOutputStream out(&sos);
+    WireFormatLite::WriteTag(tf::SequenceExample::kFeatureListsFieldNumber,
+                             WireFormatLite::WIRETYPE_LENGTH_DELIMITED, &out);
+    out.WriteVarint32(size);
+    feature_lists.SerializeWithCachedSizes(&out);
+    out.Trim();
+    RET_CHECK(!out.HadError());
+  }
+  RETURN_IF_ERROR(sink_->WriteRecord(record));
+  ++num_records_written_;
+  sequence->mutable_feature_lists()->Clear();
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status SequenceExampleStreamWriter::Close(
+    tf::SequenceExample* sequence) {
+  // Context set after the first record would otherwise be lost, so the last
+  // record always repeats it.
+  std::string record;
+  RET_CHECK(sequence->SerializeToString(&record));
+  RETURN_IF_ERROR(sink_->WriteRecord(record));
+  ++num_records_written_;
+  context_written_ = true;
+  sequence->mutable_feature_lists()->Clear();
+  return sink_->Close();
+}
+
+::mediapipe::Status ParseContext(absl::string_view serialized,
+                                 tf::SequenceExample* sequence) {
+  return ForEachLengthDelimitedField(
+      serialized,
+      [&](int field, absl::string_view context) -> ::mediapipe::Status {
+        if (field != tf::SequenceExample::kContextFieldNumber) {
+          return ::mediapipe::OkStatus();
+        }
+        tf::Features features;
+        RET_CHECK(features.ParseFromArray(context.data(), context.size()));
+        sequence->mutable_context()->MergeFrom(features);
+        return ::mediapipe::OkStatus();
+      });
+}
+
+::mediapipe::Status ParseFeatureLists(absl::string_view serialized,
+                                      const std::vector<std::string>& keys,
+                                      tf::SequenceExample* sequence) {
+  std::vector<absl::string_view> feature_lists;
+  RETURN_IF_ERROR(FindFeatureLists(serialized, keys, &feature_lists));
+  for (int i = 0; i < keys.size(); ++i) {
+    if (feature_lists[i].empty()) continue;
+    RETURN_IF_ERROR(AppendFeatures(feature_lists[i], 0,
+                                   std::numeric_limits<int>::max(),
+                                   MutableFeatureList(keys[i], sequence)));
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status ParseFeatureListsInRange(
+    absl::string_view serialized, const std::string& timestamp_key,
+    const std::vector<std::string>& keys, int64 start_timestamp,
+    int64 end_timestamp, tf::SequenceExample* sequence) {
+  std::vector<std::string> all_keys(keys);
+  all_keys.push_back(timestamp_key);
+  std::vector<absl::string_view> feature_lists;
+  RETURN_IF_ERROR(FindFeatureLists(serialized, all_keys, &feature_lists));
+  if (feature_lists.back().empty()) {
+    return ::mediapipe::OkStatus();
+  }
+
+  // Timestamps are one int64 per feature and cheap to decode in full.
+  std::vector<int64> timestamps;
+  RETURN_IF_ERROR(ForEachLengthDelimitedField(
+      feature_lists.back(),
+      [&](int field, absl::string_view payload) -> ::mediapipe::Status {
+        if (field != tf::FeatureList::kFeatureFieldNumber) {
+          return ::mediapipe::OkStatus();
+        }
+        tf::Feature feature;
+        RET_CHECK(feature.ParseFromArray(payload.data(), payload.size()));
+        RET_CHECK_EQ(feature.int64_list().value_size(), 1)
+            << "Expected a single timestamp per feature in " << timestamp_key;
+        timestamps.push_back(feature.int64_list().value(0));
+        return ::mediapipe::OkStatus();
+      }));
+  const int begin =
+      std::lower_bound(timestamps.begin(), timestamps.end(), start_timestamp) -
+      timestamps.begin();
+  const int end =
+      std::lower_bound(timestamps.begin(), timestamps.end(), end_timestamp) -
+      timestamps.begin();
+  if (begin >= end) {
+    return ::mediapipe::OkStatus();
+  }
+
+  tf::FeatureList* timestamp_list = MutableFeatureList(timestamp_key, sequence);
+  for (int i = begin; i < end; ++i) {
+    timestamp_list->add_feature()->mutable_int64_list()->add_value(
+        timestamps[i]);
+  }
+  for (int i = 0; i < keys.size(); ++i) {
+    if (feature_lists[i].empty()) continue;
+    RETURN_IF_ERROR(AppendFeatures(feature_lists[i], begin, end,
+                                   MutableFeatureList(keys[i], sequence)));
+  }
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status ForEachSequenceExampleRecord(
+    const std::string& path,
+    const std::function<::mediapipe::Status(absl::string_view)>& callback) {
+  std::unique_ptr<tf::RandomAccessFile> file;
+  tf::Status status = tf::Env::Default()->NewRandomAccessFile(path, &file);
+  RET_CHECK(status.ok()) << status.ToString();
+  tf::io::RecordReader reader(file.get());
+  uint64 offset = 0;
+  std::string record;
+  while ((status = reader.ReadRecord(&offset, &record)).ok()) {
+    RETURN_IF_ERROR(callback(record));
+  }
+  RET_CHECK(tf::errors::IsOutOfRange(status)) << status.ToString();
+  return ::mediapipe::OkStatus();
+}
+
+::mediapipe::Status DeleteSequenceExampleRecords(const std::string& path) {
+  const tf::Status status = tf::Env::Default()->DeleteFile(path);
+  RET_CHECK(status.ok()) << status.ToString();
+  return ::mediapipe::OkStatus();
+}
+
+}  // namespace mediasequence
+}  // namespace mediapipe
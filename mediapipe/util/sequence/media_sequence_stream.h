@@ -0,0 +1,131 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Streaming access to SequenceExamples in the media_sequence.h format.
+//
+// Long clips produce SequenceExamples that are too large to hold in memory.
+// Instead of one serialized SequenceExample, a stream is a series of records,
+// each a valid serialized SequenceExample:
+//   - The first record holds the context and the first chunk of feature lists.
+//   - Each following record holds only the feature lists of the next chunk.
+//   - The last record holds the final context and the last chunk, so that
+//     context set while the sequence is written is not lost.
+// Protobuf merging replaces map entries with duplicate keys, so records must be
+// combined with the readers below: ParseContext() lets the context of a later
+// record replace the same keys of an earlier one, and the feature list readers
+// append the features of each record to the feature lists already present.
+//
+// The writer builds on the media_sequence_util.h accessors: callers keep adding
+// data to a regular SequenceExample and periodically hand it to the writer,
+// which serializes and clears its feature lists while keeping the context.
+// Records are read back one at a time with ForEachSequenceExampleRecord().
+//
+// The readers operate directly on the serialized records. Feature lists that
+// are not requested, and features outside the requested time range, are
+// skipped at the wire format level and never decoded.
+
+#ifndef MEDIAPIPE_UTIL_SEQUENCE_MEDIA_SEQUENCE_STREAM_H_
+#define MEDIAPIPE_UTIL_SEQUENCE_MEDIA_SEQUENCE_STREAM_H_
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "tensorflow/core/example/example.pb.h"
+
+namespace mediapipe {
+namespace mediasequence {
+
+// Destination for serialized SequenceExample records.
+class SequenceExampleRecordSink {
+ public:
+  virtual ~SequenceExampleRecordSink() = default;
+  virtual ::mediapipe::Status WriteRecord(absl::string_view record) = 0;
+  virtual ::mediapipe::Status Close() = 0;
+};
+
+// Returns a sink writing records to a file in the TFRecord format, readable by
+// tf.data.TFRecordDataset and ForEachSequenceExampleRecord below.
+::mediapipe::StatusOr<std::unique_ptr<SequenceExampleRecordSink>>
+CreateTfRecordSink(const std::string& path);
+
+// Writes the feature lists of a SequenceExample incrementally to a sink.
+class SequenceExampleStreamWriter {
+ public:
+  explicit SequenceExampleStreamWriter(
+      std::unique_ptr<SequenceExampleRecordSink> sink);
+
+  // Writes the feature lists in `sequence` as one record and clears them. The
+  // context is kept in `sequence` so metadata accessors keep working, but it is
+  // only serialized into the first record and by Close(). Does nothing if the
+  // context was already written and there are no feature lists.
+  ::mediapipe::Status WriteAndClearFeatureLists(
+      tensorflow::SequenceExample* sequence);
+
+  // Writes the context and any remaining feature lists as the last record and
+  // closes the sink. The context in the last record replaces the one in the
+  // first record on read, so it may be changed until Close() is called.
+  ::mediapipe::Status Close(tensorflow::SequenceExample* sequence);
+
+  int64 num_records_written() const { return num_records_written_; }
+
+ private:
+  std::unique_ptr<SequenceExampleRecordSink> sink_;
+  bool context_written_ = false;
+  int64 num_records_written_ = 0;
+};
+
+// Merges the context of a serialized SequenceExample into `sequence` without
+// decoding its feature lists.
+::mediapipe::Status ParseContext(absl::string_view serialized,
+                                 tensorflow::SequenceExample* sequence);
+
+// Appends the feature lists named in `keys` from a serialized SequenceExample
+// to `sequence`. Other feature lists are skipped without being decoded.
+::mediapipe::Status ParseFeatureLists(absl::string_view serialized,
+                                      const std::vector<std::string>& keys,
+                                      tensorflow::SequenceExample* sequence);
+
+// Appends the timesteps with a timestamp in [start_timestamp, end_timestamp)
+// from a serialized SequenceExample to `sequence`. The timestamps are read from
+// the int64 feature list `timestamp_key` (e.g. GetImageTimestampKey()), which
+// must be sorted, and are appended along with the matching entries of the
+// feature lists named in `keys` (e.g. GetImageEncodedKey()). Entries outside
+// the range are skipped without being decoded.
+::mediapipe::Status ParseFeatureListsInRange(
+    absl::string_view serialized, const std::string& timestamp_key,
+    const std::vector<std::string>& keys, int64 start_timestamp,
+    int64 end_timestamp, tensorflow::SequenceExample* sequence);
+
+// Calls `callback` with each record of a TFRecord file written by
+// CreateTfRecordSink, in order. Records are read one at a time, and the record
+// passed to `callback` is only valid during the call. Stops at the first error
+// returned by `callback`.
+::mediapipe::Status ForEachSequenceExampleRecord(
+    const std::string& path,
+    const std::function<::mediapipe::Status(absl::string_view)>& callback);
+
+// Deletes a TFRecord file written by CreateTfRecordSink, e.g. to discard an
+// incomplete sequence. The sink writing it must be destroyed first.
+::mediapipe::Status DeleteSequenceExampleRecords(const std::string& path);
+
+}  // namespace mediasequence
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_SEQUENCE_MEDIA_SEQUENCE_STREAM_H_
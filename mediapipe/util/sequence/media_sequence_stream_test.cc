@@ -0,0 +1,149 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/sequence/media_sequence_stream.h"
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/port/gmock.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "mediapipe/util/sequence/media_sequence.h"
+#include "tensorflow/core/example/example.pb.h"
+
+namespace mediapipe {
+namespace mediasequence {
+namespace {
+
+// Collects records in memory.
+class VectorSink : public SequenceExampleRecordSink {
+ public:
+  explicit VectorSink(std::vector<std::string>* records) : records_(records) {}
+  ::mediapipe::Status WriteRecord(absl::string_view record) override {
+    records_->emplace_back(record);
+    return ::mediapipe::OkStatus();
+  }
+  ::mediapipe::Status Close() override { return ::mediapipe::OkStatus(); }
+
+ private:
+  std::vector<std::string>* records_;
+};
+
+// Writes kNumFrames images and float features in chunks of kChunkSize.
+constexpr int kNumFrames = 10;
+constexpr int kChunkSize = 4;
+
+std::vector<std::string> WriteTestStream() {
+  std::vector<std::string> records;
+  SequenceExampleStreamWriter writer(absl::make_unique<VectorSink>(&records));
+  tensorflow::SequenceExample sequence;
+  SetImageHeight(480, &sequence);
+  for (int i = 0; i < kNumFrames; ++i) {
+    AddImageTimestamp(i * 100, &sequence);
+    AddImageEncoded(absl::StrCat("frame", i), &sequence);
+    AddFeatureTimestamp("audio", i * 100, &sequence);
+    AddFeatureFloats("audio", std::vector<float>{static_cast<float>(i)},
+                     &sequence);
+    if ((i + 1) % kChunkSize == 0) {
+      MEDIAPIPE_EXPECT_OK(writer.WriteAndClearFeatureLists(&sequence));
+      EXPECT_EQ(0, GetImageEncodedSize(sequence));
+      EXPECT_EQ(480, GetImageHeight(sequence));
+    }
+  }
+  MEDIAPIPE_EXPECT_OK(writer.Close(&sequence));
+  return records;
+}
+
+TEST(MediaSequenceStreamTest, WritesContextInFirstAndLastRecords) {
+  std::vector<std::string> records = WriteTestStream();
+  ASSERT_EQ(3, records.size());
+  for (int i = 0; i < records.size(); ++i) {
+    tensorflow::SequenceExample record;
+    ASSERT_TRUE(record.ParseFromString(records[i]));
+    EXPECT_EQ(i != 1, HasImageHeight(record));
+    EXPECT_EQ(i < 2 ? kChunkSize : kNumFrames - 2 * kChunkSize,
+              GetImageEncodedSize(record));
+  }
+}
+
+TEST(MediaSequenceStreamTest, ParsesAllRecordsBackIntoOneSequence) {
+  std::vector<std::string> records = WriteTestStream();
+  tensorflow::SequenceExample sequence;
+  const std::vector<std::string> keys = {
+      GetImageTimestampKey(), GetImageEncodedKey(),
+      GetFeatureTimestampKey("audio"), GetFeatureFloatsKey("audio")};
+  for (const auto& record : records) {
+    MEDIAPIPE_ASSERT_OK(ParseContext(record, &sequence));
+    MEDIAPIPE_ASSERT_OK(ParseFeatureLists(record, keys, &sequence));
+  }
+  EXPECT_EQ(480, GetImageHeight(sequence));
+  ASSERT_EQ(kNumFrames, GetImageEncodedSize(sequence));
+  ASSERT_EQ(kNumFrames, GetFeatureFloatsSize("audio", sequence));
+  for (int i = 0; i < kNumFrames; ++i) {
+    EXPECT_EQ(i * 100, GetImageTimestampAt(sequence, i));
+    EXPECT_EQ(absl::StrCat("frame", i), GetImageEncodedAt(sequence, i));
+    EXPECT_FLOAT_EQ(i, GetFeatureFloatsAt("audio", sequence, i).Get(0));
+  }
+}
+
+TEST(MediaSequenceStreamTest, KeepsContextSetAfterFirstRecord) {
+  std::vector<std::string> records;
+  SequenceExampleStreamWriter writer(absl::make_unique<VectorSink>(&records));
+  tensorflow::SequenceExample sequence;
+  SetImageHeight(480, &sequence);
+  AddImageTimestamp(0, &sequence);
+  MEDIAPIPE_ASSERT_OK(writer.WriteAndClearFeatureLists(&sequence));
+  SetImageHeight(720, &sequence);
+  SetClipLabelString({"label"}, &sequence);
+  AddImageTimestamp(100, &sequence);
+  MEDIAPIPE_ASSERT_OK(writer.WriteAndClearFeatureLists(&sequence));
+  MEDIAPIPE_ASSERT_OK(writer.Close(&sequence));
+
+  tensorflow::SequenceExample parsed;
+  for (const auto& record : records) {
+    MEDIAPIPE_ASSERT_OK(ParseContext(record, &parsed));
+  }
+  EXPECT_EQ(720, GetImageHeight(parsed));
+  ASSERT_EQ(1, GetClipLabelString(parsed).size());
+  EXPECT_EQ("label", GetClipLabelString(parsed)[0]);
+}
+
+TEST(MediaSequenceStreamTest, ParsesOnlyRequestedKeysAndTimeRange) {
+  std::vector<std::string> records = WriteTestStream();
+  tensorflow::SequenceExample sequence;
+  for (const auto& record : records) {
+    MEDIAPIPE_ASSERT_OK(ParseFeatureListsInRange(record, GetImageTimestampKey(),
+                                                 {GetImageEncodedKey()}, 300,
+                                                 700, &sequence));
+  }
+  EXPECT_FALSE(HasFeatureFloats("audio", sequence));
+  ASSERT_EQ(4, GetImageTimestampSize(sequence));
+  ASSERT_EQ(4, GetImageEncodedSize(sequence));
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ((i + 3) * 100, GetImageTimestampAt(sequence, i));
+    EXPECT_EQ(absl::StrCat("frame", i + 3), GetImageEncodedAt(sequence, i));
+  }
+}
+
+TEST(MediaSequenceStreamTest, FailsOnTruncatedRecord) {
+  std::vector<std::string> records = WriteTestStream();
+  tensorflow::SequenceExample sequence;
+  const std::string truncated = records[1].substr(0, records[1].size() / 2);
+  EXPECT_FALSE(
+      ParseFeatureLists(truncated, {GetImageEncodedKey()}, &sequence).ok());
+}
+
+}  // namespace
+}  // namespace mediasequence
+}  // namespace mediapipe
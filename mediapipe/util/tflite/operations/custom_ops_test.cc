@@ -0,0 +1,292 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/port/benchmark.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/util/tflite/operations/max_pool_argmax.h"
+#include "mediapipe/util/tflite/operations/max_unpooling.h"
+#include "mediapipe/util/tflite/operations/transpose_conv_bias.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace mediapipe {
+namespace tflite_operations {
+namespace {
+
+using ::tflite::Interpreter;
+
+// Runs a single custom op on float tensors. The op parameters are passed as
+// custom initial data, like the op resolver does for a model.
+class CustomOpRunner {
+ public:
+  // `input_shapes` are NHWC shapes for tensors 0..n-1; the op writes
+  // `num_outputs` tensors after them. `params` must outlive the runner.
+  CustomOpRunner(TfLiteRegistration* registration,
+                 const std::vector<std::vector<int>>& input_shapes,
+                 int num_outputs, const void* params, size_t params_size,
+                 int num_threads)
+      : registration_(*registration),
+        interpreter_(absl::make_unique<Interpreter>()) {
+    registration_.builtin_code = ::tflite::BuiltinOperator_CUSTOM;
+    const int num_inputs = input_shapes.size();
+    std::vector<int> inputs;
+    std::vector<int> outputs;
+    interpreter_->AddTensors(num_inputs + num_outputs);
+    for (int i = 0; i < num_inputs + num_outputs; ++i) {
+      (i < num_inputs ? inputs : outputs).push_back(i);
+      // The op resizes its outputs in Prepare().
+      const std::vector<int> shape =
+          i < num_inputs ? input_shapes[i] : std::vector<int>{1};
+      interpreter_->SetTensorParametersReadWrite(i, kTfLiteFloat32, "", shape,
+                                                 TfLiteQuantization());
+    }
+    interpreter_->SetInputs(inputs);
+    interpreter_->SetOutputs(outputs);
+    interpreter_->AddNodeWithParameters(
+        inputs, outputs, reinterpret_cast<const char*>(params), params_size,
+        nullptr, &registration_);
+    interpreter_->SetNumThreads(num_threads);
+    CHECK_EQ(interpreter_->AllocateTensors(), kTfLiteOk);
+  }
+
+  float* input(int index) { return interpreter_->typed_tensor<float>(index); }
+
+  void Invoke() { CHECK_EQ(interpreter_->Invoke(), kTfLiteOk); }
+
+  std::vector<float> output(int index) const {
+    const TfLiteTensor* tensor =
+        interpreter_->tensor(interpreter_->outputs()[index]);
+    return std::vector<float>(tensor->data.f,
+                              tensor->data.f + tensor->bytes / sizeof(float));
+  }
+
+  std::vector<int> output_shape(int index) const {
+    const TfLiteIntArray* dims =
+        interpreter_->tensor(interpreter_->outputs()[index])->dims;
+    return std::vector<int>(dims->data, dims->data + dims->size);
+  }
+
+ private:
+  TfLiteRegistration registration_;
+  std::unique_ptr<Interpreter> interpreter_;
+};
+
+void FillRandom(float* data, int size, int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  for (int i = 0; i < size; ++i) {
+    data[i] = distribution(rng);
+  }
+}
+
+int FlatSize(const std::vector<int>& shape) {
+  int size = 1;
+  for (int dim : shape) size *= dim;
+  return size;
+}
+
+TfLitePoolParams MakePoolParams(int filter_size, int stride) {
+  TfLitePoolParams params = {};
+  params.padding = kTfLitePaddingValid;
+  params.stride_width = stride;
+  params.stride_height = stride;
+  params.filter_width = filter_size;
+  params.filter_height = filter_size;
+  params.activation = kTfLiteActNone;
+  return params;
+}
+
+TEST(CustomOpsTest, MaxPoolingWithArgmax2D) {
+  const TfLitePoolParams params = MakePoolParams(2, 2);
+  CustomOpRunner runner(RegisterMaxPoolingWithArgmax2D(), {{1, 2, 4, 2}}, 2,
+                        &params, sizeof(params), 2);
+  const std::vector<float> input = {
+      1, 8, 2, 7, 3, 0, 4, 0,  // Row 0.
+      0, 6, 5, 0, 9, 0, 9, 1,  // Row 1.
+  };
+  std::copy(input.begin(), input.end(), runner.input(0));
+  runner.Invoke();
+  EXPECT_EQ(std::vector<int>({1, 1, 2, 2}), runner.output_shape(0));
+  EXPECT_EQ(std::vector<float>({5, 8, 9, 1}), runner.output(0));
+  const std::vector<float> indices = runner.output(1);
+  // Taps are numbered in row-major window order; ties keep the first tap.
+  const std::vector<int> expected_taps = {3, 0, 2, 3};
+  ASSERT_EQ(expected_taps.size(), indices.size());
+  for (int i = 0; i < indices.size(); ++i) {
+    EXPECT_EQ(expected_taps[i], static_cast<int>(indices[i])) << i;
+  }
+}
+
+TEST(CustomOpsTest, MaxUnpooling2DInvertsMaxPooling) {
+  const TfLitePoolParams params = MakePoolParams(2, 2);
+  const std::vector<int> shape = {1, 6, 8, 3};
+  CustomOpRunner pool(RegisterMaxPoolingWithArgmax2D(), {shape}, 2, &params,
+                      sizeof(params), 2);
+  FillRandom(pool.input(0), FlatSize(shape), 1);
+  pool.Invoke();
+  const std::vector<int> pooled_shape = pool.output_shape(0);
+  CustomOpRunner unpool(RegisterMaxUnpooling2D(), {pooled_shape, pooled_shape},
+                        1, &params, sizeof(params), 2);
+  const std::vector<float> pooled = pool.output(0);
+  const std::vector<float> indices = pool.output(1);
+  std::copy(pooled.begin(), pooled.end(), unpool.input(0));
+  std::copy(indices.begin(), indices.end(), unpool.input(1));
+  unpool.Invoke();
+  ASSERT_EQ(shape, unpool.output_shape(0));
+
+  // Every window keeps its maximum at its original position and zeros
+  // elsewhere.
+  const float* input = pool.input(0);
+  const std::vector<float> output = unpool.output(0);
+  for (int i = 0; i < output.size(); ++i) {
+    const int channel = i % 3;
+    const int x = i / 3 % 8;
+    const int y = i / 3 / 8;
+    const float max = pooled[((y / 2) * 4 + x / 2) * 3 + channel];
+    EXPECT_EQ(input[i] == max ? max : 0.0f, output[i]) << i;
+  }
+}
+
+// Computes the transposed convolution by scattering every input pixel.
+std::vector<float> ReferenceTransposeConv(const float* input, int height,
+                                          int width, int input_depth,
+                                          const float* filter, int filter_size,
+                                          int output_depth, const float* bias,
+                                          int stride) {
+  const int output_height = stride * (height - 1) + filter_size;
+  const int output_width = stride * (width - 1) + filter_size;
+  std::vector<float> output(output_height * output_width * output_depth);
+  for (int i = 0; i < output.size(); ++i) {
+    output[i] = bias[i % output_depth];
+  }
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      for (int fy = 0; fy < filter_size; ++fy) {
+        for (int fx = 0; fx < filter_size; ++fx) {
+          for (int o = 0; o < output_depth; ++o) {
+            float* out = &output[(((y * stride + fy) * output_width) +
+                                  x * stride + fx) *
+                                     output_depth +
+                                 o];
+            for (int i = 0; i < input_depth; ++i) {
+              *out += input[(y * width + x) * input_depth + i] *
+                      filter[((o * filter_size + fy) * filter_size + fx) *
+                                 input_depth +
+                             i];
+            }
+          }
+        }
+      }
+    }
+  }
+  return output;
+}
+
+class TransposeConvBiasTest : public ::testing::TestWithParam<int> {};
+
+TEST_P(TransposeConvBiasTest, MatchesReference) {
+  constexpr int kHeight = 9;
+  constexpr int kWidth = 7;
+  constexpr int kInputDepth = 5;
+  constexpr int kOutputDepth = 3;
+  constexpr int kFilterSize = 3;
+  constexpr int kStride = 2;
+  TfLiteTransposeConvParams params = {};
+  params.padding = kTfLitePaddingValid;
+  params.stride_width = kStride;
+  params.stride_height = kStride;
+  const std::vector<int> input_shape = {1, kHeight, kWidth, kInputDepth};
+  const std::vector<int> filter_shape = {kOutputDepth, kFilterSize,
+                                         kFilterSize, kInputDepth};
+  CustomOpRunner runner(RegisterConvolution2DTransposeBias(),
+                        {input_shape, filter_shape, {kOutputDepth}}, 1,
+                        &params, sizeof(params), GetParam());
+  FillRandom(runner.input(0), FlatSize(input_shape), 1);
+  FillRandom(runner.input(1), FlatSize(filter_shape), 2);
+  FillRandom(runner.input(2), kOutputDepth, 3);
+  runner.Invoke();
+
+  const std::vector<float> expected = ReferenceTransposeConv(
+      runner.input(0), kHeight, kWidth, kInputDepth, runner.input(1),
+      kFilterSize, kOutputDepth, runner.input(2), kStride);
+  const std::vector<float> output = runner.output(0);
+  ASSERT_EQ(expected.size(), output.size());
+  for (int i = 0; i < output.size(); ++i) {
+    EXPECT_NEAR(expected[i], output[i], 1e-4) << i;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(NumThreads, TransposeConvBiasTest,
+                         ::testing::Values(1, 4));
+
+// The benchmarks use layer sizes typical of a segmentation decoder and run with
+// the number of threads given as the argument.
+
+void BM_MaxPoolingWithArgmax2D(benchmark::State& state) {
+  const TfLitePoolParams params = MakePoolParams(2, 2);
+  const std::vector<int> shape = {1, 256, 256, 32};
+  CustomOpRunner runner(RegisterMaxPoolingWithArgmax2D(), {shape}, 2, &params,
+                        sizeof(params), state.range(0));
+  FillRandom(runner.input(0), FlatSize(shape), 1);
+  for (auto _ : state) {
+    runner.Invoke();
+  }
+}
+BENCHMARK(BM_MaxPoolingWithArgmax2D)->Arg(1)->Arg(4)->UseRealTime();
+
+void BM_MaxUnpooling2D(benchmark::State& state) {
+  const TfLitePoolParams params = MakePoolParams(2, 2);
+  const std::vector<int> shape = {1, 128, 128, 32};
+  CustomOpRunner runner(RegisterMaxUnpooling2D(), {shape, shape}, 1, &params,
+                        sizeof(params), state.range(0));
+  FillRandom(runner.input(0), FlatSize(shape), 1);
+  float* indices = runner.input(1);
+  for (int i = 0; i < FlatSize(shape); ++i) {
+    indices[i] = i % 4 + 0.1f;
+  }
+  for (auto _ : state) {
+    runner.Invoke();
+  }
+}
+BENCHMARK(BM_MaxUnpooling2D)->Arg(1)->Arg(4)->UseRealTime();
+
+void BM_Convolution2DTransposeBias(benchmark::State& state) {
+  TfLiteTransposeConvParams params = {};
+  params.padding = kTfLitePaddingSame;
+  params.stride_width = 2;
+  params.stride_height = 2;
+  const std::vector<int> input_shape = {1, 64, 64, 32};
+  const std::vector<int> filter_shape = {16, 4, 4, 32};
+  CustomOpRunner runner(RegisterConvolution2DTransposeBias(),
+                        {input_shape, filter_shape, {16}}, 1, &params,
+                        sizeof(params), state.range(0));
+  FillRandom(runner.input(0), FlatSize(input_shape), 1);
+  FillRandom(runner.input(1), FlatSize(filter_shape), 2);
+  FillRandom(runner.input(2), 16, 3);
+  for (auto _ : state) {
+    runner.Invoke();
+  }
+}
+BENCHMARK(BM_Convolution2DTransposeBias)->Arg(1)->Arg(4)->UseRealTime();
+
+}  // namespace
+}  // namespace tflite_operations
+}  // namespace mediapipe
@@ -14,9 +14,16 @@
 // limitations under the License.
 //
 // This version has been modified by MediaPipe authors to support argmax
-// indices. Details of the modification is marked below in the code.
+// indices. Details of the modification is marked below in the code. The
+// pooling kernel itself is a MediaPipe implementation that vectorizes over
+// channels and splits the output rows across threads.
 #include "mediapipe/util/tflite/operations/max_pool_argmax.h"
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "mediapipe/util/tflite/operations/op_threading.h"
 #include "tensorflow/lite/kernels/internal/common.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/padding.h"
@@ -29,76 +36,92 @@ constexpr int kDataInputTensor = 0;
 constexpr int kOutputTensor = 0;
 constexpr int kIndicesTensor = 1;
 
-// These functions were copied from the following places:
-// https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/kernels/internal/reference/reference_ops.h
-// https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/kernels/pooling.cc
-
-inline void MaxPoolArgmax(const ::tflite::PoolParams& params,
-                          const ::tflite::RuntimeShape& input_shape,
-                          const float* input_data,
-                          const ::tflite::RuntimeShape& output_shape,
-                          float* output_data, float* indices_data) {
-  // Start of copy from
-  // https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/kernels/internal/reference/reference_ops.h
-  // Start of MediaPipe modificiation.
-  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
-  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
-  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+// Number of output rows per stripe when the op runs on several threads.
+constexpr int kMinRowsPerStripe = 4;
+
+// Computes rows [row_begin, row_end) of the flattened batch x height output.
+// The window maximum is taken for all channels of a pixel at once, so the inner
+// loop runs over contiguous NHWC channels and is vectorized by the compiler.
+// Ties keep the first tap in row-major window order, as in the reference op.
+void MaxPoolArgmaxRows(const ::tflite::PoolParams& params,
+                       const ::tflite::RuntimeShape& input_shape,
+                       const float* input_data,
+                       const ::tflite::RuntimeShape& output_shape,
+                       float* output_data, float* indices_data, int row_begin,
+                       int row_end) {
   const int depth = MatchingDim(input_shape, 3, output_shape, 3);
   const int input_height = input_shape.Dims(1);
   const int input_width = input_shape.Dims(2);
   const int output_height = output_shape.Dims(1);
   const int output_width = output_shape.Dims(2);
-  const int stride_height = params.stride_height;
-  const int stride_width = params.stride_width;
-  for (int batch = 0; batch < batches; ++batch) {
-    for (int out_y = 0; out_y < output_height; ++out_y) {
-      for (int out_x = 0; out_x < output_width; ++out_x) {
-        for (int channel = 0; channel < depth; ++channel) {
-          const int in_x_origin =
-              (out_x * stride_width) - params.padding_values.width;
-          const int in_y_origin =
-              (out_y * stride_height) - params.padding_values.height;
-          // Compute the boundaries of the filter region clamped so as to
-          // ensure that the filter window fits in the input array.
-          const int filter_x_start = std::max(0, -in_x_origin);
-          const int filter_x_end =
-              std::min(params.filter_width, input_width - in_x_origin);
-          const int filter_y_start = std::max(0, -in_y_origin);
-          const int filter_y_end =
-              std::min(params.filter_height, input_height - in_y_origin);
-          float max = std::numeric_limits<float>::lowest();
-          int max_x = 0;
-          int max_y = 0;
-          for (int filter_y = filter_y_start; filter_y < filter_y_end;
-               ++filter_y) {
-            for (int filter_x = filter_x_start; filter_x < filter_x_end;
-                 ++filter_x) {
-              const int in_x = in_x_origin + filter_x;
-              const int in_y = in_y_origin + filter_y;
-              float cur =
-                  input_data[Offset(input_shape, batch, in_y, in_x, channel)];
-              if (cur > max) {
-                max = cur;
-                max_x = filter_x;
-                max_y = filter_y;
-              }
-            }
-          }
-          output_data[Offset(output_shape, batch, out_y, out_x, channel)] =
-              ::tflite::ActivationFunctionWithMinMax(
-                  max, params.float_activation_min,
-                  params.float_activation_max);
-          if (indices_data) {
-            indices_data[Offset(output_shape, batch, out_y, out_x, channel)] =
-                max_y * params.filter_width + max_x + 0.1f;
+  std::vector<float> max_taps(indices_data ? 0 : depth);
+  for (int row = row_begin; row < row_end; ++row) {
+    const int batch = row / output_height;
+    const int out_y = row % output_height;
+    const int in_y_origin =
+        (out_y * params.stride_height) - params.padding_values.height;
+    const int filter_y_start = std::max(0, -in_y_origin);
+    const int filter_y_end =
+        std::min(params.filter_height, input_height - in_y_origin);
+    for (int out_x = 0; out_x < output_width; ++out_x) {
+      const int in_x_origin =
+          (out_x * params.stride_width) - params.padding_values.width;
+      const int filter_x_start = std::max(0, -in_x_origin);
+      const int filter_x_end =
+          std::min(params.filter_width, input_width - in_x_origin);
+      const int output_offset = Offset(output_shape, batch, out_y, out_x, 0);
+      float* max = output_data + output_offset;
+      // Tap indices are accumulated as floats directly in the output tensor.
+      float* max_tap =
+          indices_data ? indices_data + output_offset : max_taps.data();
+      std::fill(max, max + depth, std::numeric_limits<float>::lowest());
+      std::fill(max_tap, max_tap + depth, 0.0f);
+      for (int filter_y = filter_y_start; filter_y < filter_y_end;
+           ++filter_y) {
+        for (int filter_x = filter_x_start; filter_x < filter_x_end;
+             ++filter_x) {
+          const float* in =
+              input_data + Offset(input_shape, batch, in_y_origin + filter_y,
+                                  in_x_origin + filter_x, 0);
+          const float tap =
+              static_cast<float>(filter_y * params.filter_width + filter_x);
+          for (int channel = 0; channel < depth; ++channel) {
+            const bool greater = in[channel] > max[channel];
+            max[channel] = greater ? in[channel] : max[channel];
+            max_tap[channel] = greater ? tap : max_tap[channel];
           }
         }
       }
+      for (int channel = 0; channel < depth; ++channel) {
+        max[channel] = ::tflite::ActivationFunctionWithMinMax(
+            max[channel], params.float_activation_min,
+            params.float_activation_max);
+      }
+      if (indices_data) {
+        // The offset keeps the index exact when it is truncated to an int.
+        for (int channel = 0; channel < depth; ++channel) {
+          max_tap[channel] += 0.1f;
+        }
+      }
     }
   }
-  // End of MediaPipe modification.
-  // End of copy.
+}
+
+void MaxPoolArgmax(TfLiteContext* context, const ::tflite::PoolParams& params,
+                   const ::tflite::RuntimeShape& input_shape,
+                   const float* input_data,
+                   const ::tflite::RuntimeShape& output_shape,
+                   float* output_data, float* indices_data) {
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int num_rows = batches * output_shape.Dims(1);
+  ParallelForOp(context, num_rows, kMinRowsPerStripe,
+                [&](int row_begin, int row_end) {
+                  MaxPoolArgmaxRows(params, input_shape, input_data,
+                                    output_shape, output_data, indices_data,
+                                    row_begin, row_end);
+                });
 }
 
 // Start of copy from
@@ -185,7 +208,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   op_params.padding_values.width = data_padding->width;
   op_params.float_activation_min = activation_min;
   op_params.float_activation_max = activation_max;
-  MaxPoolArgmax(op_params, ::tflite::GetTensorShape(input),
+  MaxPoolArgmax(context, op_params, ::tflite::GetTensorShape(input),
                 ::tflite::GetTensorData<float>(input),
                 ::tflite::GetTensorShape(output),
                 ::tflite::GetTensorData<float>(output),
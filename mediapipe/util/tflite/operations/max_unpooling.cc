@@ -14,6 +14,10 @@
 
 #include "mediapipe/util/tflite/operations/max_unpooling.h"
 
+#include <cstring>
+#include <vector>
+
+#include "mediapipe/util/tflite/operations/op_threading.h"
 #include "tensorflow/lite/kernels/internal/common.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/padding.h"
@@ -26,41 +30,76 @@ constexpr int kDataInputTensor = 0;
 constexpr int kIndicesTensor = 1;
 constexpr int kOutputTensor = 0;
 
-inline void MaxUnpooling(const ::tflite::PoolParams& params,
-                         const ::tflite::RuntimeShape& input_shape,
-                         const float* input_data, const float* indices_data,
-                         const ::tflite::RuntimeShape& output_shape,
-                         float* output_data) {
-  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
-  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
-  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+// Number of input rows per stripe when the op runs on several threads.
+constexpr int kMinRowsPerStripe = 4;
+
+// Scatters rows [row_begin, row_end) of the flattened batch x height input.
+// `tap_offsets` maps a window tap index to its offset in the output relative to
+// the window origin, which replaces the per-element index division.
+void MaxUnpoolingRows(const ::tflite::PoolParams& params,
+                      const ::tflite::RuntimeShape& input_shape,
+                      const float* input_data, const float* indices_data,
+                      const ::tflite::RuntimeShape& output_shape,
+                      float* output_data, const std::vector<int>& tap_offsets,
+                      int row_begin, int row_end) {
   const int depth = MatchingDim(input_shape, 3, output_shape, 3);
   const int input_height = input_shape.Dims(1);
   const int input_width = input_shape.Dims(2);
-  const int stride_height = params.stride_height;
-  const int stride_width = params.stride_width;
-  std::memset(output_data, 0, output_shape.FlatSize() * sizeof(float));
-  for (int batch = 0; batch < batches; ++batch) {
-    for (int in_y = 0; in_y < input_height; ++in_y) {
-      for (int in_x = 0; in_x < input_width; ++in_x) {
-        for (int channel = 0; channel < depth; ++channel) {
-          const auto input_offset =
-              Offset(input_shape, batch, in_y, in_x, channel);
-          int idx = indices_data[input_offset];
-          const int max_x = idx % params.filter_width;
-          const int max_y = idx / params.filter_width;
-          const int out_x =
-              in_x * stride_width - params.padding_values.width + max_x;
-          const int out_y =
-              in_y * stride_height - params.padding_values.height + max_y;
-          output_data[Offset(output_shape, batch, out_y, out_x, channel)] =
-              input_data[input_offset];
-        }
+  for (int row = row_begin; row < row_end; ++row) {
+    const int batch = row / input_height;
+    const int in_y = row % input_height;
+    const int out_y =
+        in_y * params.stride_height - params.padding_values.height;
+    for (int in_x = 0; in_x < input_width; ++in_x) {
+      const int out_x =
+          in_x * params.stride_width - params.padding_values.width;
+      const int input_offset = Offset(input_shape, batch, in_y, in_x, 0);
+      const float* in = input_data + input_offset;
+      const float* indices = indices_data + input_offset;
+      // The window origin lies outside the output when it is in the padding,
+      // so only the complete index of each tap is used to address the output.
+      const int window_offset = Offset(output_shape, batch, 0, 0, 0) +
+                                (out_y * output_shape.Dims(2) + out_x) * depth;
+      for (int channel = 0; channel < depth; ++channel) {
+        const int tap = static_cast<int>(indices[channel]);
+        output_data[window_offset + tap_offsets[tap] + channel] = in[channel];
       }
     }
   }
 }
 
+void MaxUnpooling(TfLiteContext* context, const ::tflite::PoolParams& params,
+                  const ::tflite::RuntimeShape& input_shape,
+                  const float* input_data, const float* indices_data,
+                  const ::tflite::RuntimeShape& output_shape,
+                  float* output_data) {
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int depth = MatchingDim(input_shape, 3, output_shape, 3);
+  std::vector<int> tap_offsets(params.filter_height * params.filter_width);
+  for (int tap = 0; tap < static_cast<int>(tap_offsets.size()); ++tap) {
+    const int max_x = tap % params.filter_width;
+    const int max_y = tap / params.filter_width;
+    tap_offsets[tap] = (max_y * output_shape.Dims(2) + max_x) * depth;
+  }
+  std::memset(output_data, 0, output_shape.FlatSize() * sizeof(float));
+  const int num_rows = batches * input_shape.Dims(1);
+  auto unpool_rows = [&](int row_begin, int row_end) {
+    MaxUnpoolingRows(params, input_shape, input_data, indices_data,
+                     output_shape, output_data, tap_offsets, row_begin,
+                     row_end);
+  };
+  // Windows of neighboring input rows overlap in the output when the filter
+  // is taller than the stride. The rows then run in order, so that the last
+  // write wins as in a single-threaded scatter.
+  if (params.filter_height > params.stride_height) {
+    unpool_rows(0, num_rows);
+  } else {
+    ParallelForOp(context, num_rows, kMinRowsPerStripe, unpool_rows);
+  }
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   auto* params =
       reinterpret_cast<const TfLitePoolParams*>(node->custom_initial_data);
@@ -124,7 +163,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   op_params.padding_values.width = data_padding->width;
   op_params.float_activation_min = activation_min;
   op_params.float_activation_max = activation_max;
-  MaxUnpooling(op_params, ::tflite::GetTensorShape(input),
+  MaxUnpooling(context, op_params, ::tflite::GetTensorShape(input),
                ::tflite::GetTensorData<float>(input),
                ::tflite::GetTensorData<float>(indices),
                ::tflite::GetTensorShape(output),
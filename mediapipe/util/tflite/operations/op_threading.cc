@@ -0,0 +1,60 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tflite/operations/op_threading.h"
+
+#include <algorithm>
+
+#include "mediapipe/framework/thread_pool_executor.h"
+#include "mediapipe/util/cpu_util.h"
+#include "mediapipe/util/parallel_for.h"
+
+namespace mediapipe {
+namespace tflite_operations {
+
+namespace {
+
+// Shared by all interpreters in the process. ParallelFor runs the stripes on
+// the calling thread when the helpers are busy, so sharing never stalls an op.
+//
+// Custom ops only see the TfLiteContext. It has no public way to schedule work
+// on the interpreter's own threads (the Eigen and gemmlowp contexts are
+// internal to the builtin kernels), and the interpreter does not know which
+// graph executor runs it, so the ops keep their own pool. Like other
+// process-wide singletons, the pool is never destroyed, so that no op can
+// outlive it during static destruction at exit.
+Executor* GetOpExecutor() {
+  static Executor* executor = new ThreadPoolExecutor(NumCPUCores());
+  return executor;
+}
+
+}  // namespace
+
+void ParallelForOp(TfLiteContext* context, int size, int min_stripe_size,
+                   const std::function<void(int begin, int end)>& fn) {
+  // TFLite leaves recommended_num_threads unset (-1) unless the interpreter
+  // was given a thread count, and the ops then stay on the calling thread.
+  const int num_threads = context->recommended_num_threads;
+  if (num_threads <= 1) {
+    fn(0, size);
+    return;
+  }
+  // ParallelFor makes at most size / min_stripe_size stripes.
+  const int stripe_size =
+      std::max(min_stripe_size, (size + num_threads - 1) / num_threads);
+  ParallelFor(GetOpExecutor(), size, stripe_size, fn);
+}
+
+}  // namespace tflite_operations
+}  // namespace mediapipe
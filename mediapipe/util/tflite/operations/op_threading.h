@@ -0,0 +1,38 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_TFLITE_OPERATIONS_OP_THREADING_H_
+#define MEDIAPIPE_UTIL_TFLITE_OPERATIONS_OP_THREADING_H_
+
+#include <functional>
+
+#include "tensorflow/lite/kernels/kernel_util.h"
+
+namespace mediapipe {
+namespace tflite_operations {
+
+// Splits [0, size) into stripes of at least min_stripe_size and calls
+// fn(begin, end) for each stripe on up to context->recommended_num_threads
+// threads, counting the calling thread. If the interpreter has no thread count
+// set, all stripes run on the calling thread. Helper threads come from a pool shared by the MediaPipe
+// custom ops, not from the executor of the calculator running the
+// interpreter, which ops cannot reach (see op_threading.cc). Returns after all
+// stripes have run.
+void ParallelForOp(TfLiteContext* context, int size, int min_stripe_size,
+                   const std::function<void(int begin, int end)>& fn);
+
+}  // namespace tflite_operations
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_TFLITE_OPERATIONS_OP_THREADING_H_
@@ -14,10 +14,17 @@
 // limitations under the License.
 //
 // This version has been modified by MediaPipe authors to support bias. Details
-// of the modification is marked below in the code.
+// of the modification is marked below in the code. The convolution kernel
+// itself is a MediaPipe implementation based on a GEMM and a scatter, split
+// across threads by output rows.
 
 #include "mediapipe/util/tflite/operations/transpose_conv_bias.h"
 
+#include <algorithm>
+#include <vector>
+
+#include "Eigen/Core"
+#include "mediapipe/util/tflite/operations/op_threading.h"
 #include "tensorflow/lite/kernels/internal/tensor.h"
 #include "tensorflow/lite/kernels/padding.h"
 
@@ -30,87 +37,178 @@ constexpr int kBiasTensor = 2;
 constexpr int kDataInputTensor = 0;
 constexpr int kOutputTensor = 0;
 
-// These functions were copied from the following places:
-// https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/kernels/internal/reference/reference_ops.h
-// https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/kernels/transpose_conv.cc
+using RowMajorMatrix =
+    Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
 
-inline void TransposeConvBias(
-    const ::tflite::ConvParams& params,
-    const ::tflite::RuntimeShape& input_shape, const float* input_data,
-    const ::tflite::RuntimeShape& filter_shape, const float* filter_data,
-    const ::tflite::RuntimeShape& bias_shape, const float* bias_data,
-    const ::tflite::RuntimeShape& output_shape, float* output_data,
-    const ::tflite::RuntimeShape& im2col_shape, float* im2col_data) {
-  // Start of copy from
-  // https://github.com/tensorflow/tensorflow/blob/master/tensorflow/lite/kernels/internal/reference/reference_ops.h
+// Number of output rows per stripe when the op runs on several threads.
+constexpr int kMinRowsPerStripe = 8;
+// Upper bound on the number of floats in the GEMM result of one stripe step.
+constexpr int kMaxColumnBufferSize = 1 << 18;
+
+// Computes output rows [out_y_begin, out_y_end) of one batch.
+//
+// The op is computed as a GEMM followed by a scatter (col2im): each input pixel
+// is multiplied with the filter packed as a [taps * output_depth, input_depth]
+// matrix, which gives its contribution to every output pixel of its window,
+// and the contributions are added to the output rows of this stripe. Input
+// rows whose windows straddle two stripes are multiplied by both of them,
+// which keeps the stripes independent.
+void TransposeConvBiasRows(const ::tflite::ConvParams& params,
+                           const ::tflite::RuntimeShape& input_shape,
+                           const float* input_data, int filter_height,
+                           int filter_width, const float* packed_filter_data,
+                           const float* bias_data,
+                           const ::tflite::RuntimeShape& output_shape,
+                           float* output_data, int batch, int out_y_begin,
+                           int out_y_end) {
   const int stride_width = params.stride_width;
   const int stride_height = params.stride_height;
   const int pad_width = params.padding_values.width;
   const int pad_height = params.padding_values.height;
+  const int input_depth = input_shape.Dims(3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int output_depth = output_shape.Dims(3);
+  const int output_width = output_shape.Dims(2);
+  const int num_taps = filter_height * filter_width;
+
+  for (int out_y = out_y_begin; out_y < out_y_end; ++out_y) {
+    float* out = output_data + Offset(output_shape, batch, out_y, 0, 0);
+    for (int out_x = 0; out_x < output_width; ++out_x) {
+      std::copy(bias_data, bias_data + output_depth,
+                out + out_x * output_depth);
+    }
+  }
+
+  // Input rows that contribute to the output rows of this stripe.
+  const int first_row = out_y_begin + pad_height - filter_height + 1;
+  const int in_y_begin =
+      first_row <= 0 ? 0 : (first_row + stride_height - 1) / stride_height;
+  const int in_y_end = std::min(
+      input_height, (out_y_end - 1 + pad_height) / stride_height + 1);
+  if (in_y_begin >= in_y_end) return;
+
+  const int column_size = num_taps * output_depth;
+  const int rows_per_step =
+      std::max(1, kMaxColumnBufferSize / (input_width * column_size));
+  std::vector<float> column_buffer(
+      std::min(rows_per_step, in_y_end - in_y_begin) * input_width *
+      column_size);
+  const Eigen::Map<const RowMajorMatrix> packed_filter(
+      packed_filter_data, column_size, input_depth);
+
+  for (int step_begin = in_y_begin; step_begin < in_y_end;
+       step_begin += rows_per_step) {
+    const int step_end = std::min(in_y_end, step_begin + rows_per_step);
+    const int num_pixels = (step_end - step_begin) * input_width;
+    const Eigen::Map<const RowMajorMatrix> input(
+        input_data + Offset(input_shape, batch, step_begin, 0, 0), num_pixels,
+        input_depth);
+    Eigen::Map<RowMajorMatrix> columns(column_buffer.data(), num_pixels,
+                                       column_size);
+    columns.noalias() = input * packed_filter.transpose();
+
+    for (int in_y = step_begin; in_y < step_end; ++in_y) {
+      for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+        const int out_y = in_y * stride_height - pad_height + filter_y;
+        if (out_y < out_y_begin || out_y >= out_y_end) continue;
+        float* out_row = output_data + Offset(output_shape, batch, out_y, 0, 0);
+        for (int in_x = 0; in_x < input_width; ++in_x) {
+          const float* column =
+              column_buffer.data() +
+              ((in_y - step_begin) * input_width + in_x) * column_size +
+              filter_y * filter_width * output_depth;
+          const int out_x_origin = in_x * stride_width - pad_width;
+          for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+            const int out_x = out_x_origin + filter_x;
+            if (out_x < 0 || out_x >= output_width) continue;
+            float* out = out_row + out_x * output_depth;
+            const float* contribution = column + filter_x * output_depth;
+            for (int out_channel = 0; out_channel < output_depth;
+                 ++out_channel) {
+              out[out_channel] += contribution[out_channel];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// Repacks the OHWI filter as HWOI, so that the GEMM result of one input pixel
+// lists the output channels of each tap contiguously.
+void PackFilter(const ::tflite::RuntimeShape& filter_shape,
+                const float* filter_data, std::vector<float>* packed_filter) {
+  const int output_depth = filter_shape.Dims(0);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int input_depth = filter_shape.Dims(3);
+  packed_filter->resize(filter_shape.FlatSize());
+  for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
+    for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+      for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+        const float* src =
+            filter_data +
+            Offset(filter_shape, out_channel, filter_y, filter_x, 0);
+        float* dst = packed_filter->data() +
+                     ((filter_y * filter_width + filter_x) * output_depth +
+                      out_channel) *
+                         input_depth;
+        std::copy(src, src + input_depth, dst);
+      }
+    }
+  }
+}
 
+// Computes the op with a filter packed by PackFilter().
+void TransposeConvBias(TfLiteContext* context,
+                       const ::tflite::ConvParams& params,
+                       const ::tflite::RuntimeShape& input_shape,
+                       const float* input_data,
+                       const ::tflite::RuntimeShape& filter_shape,
+                       const float* packed_filter_data,
+                       const ::tflite::RuntimeShape& bias_shape,
+                       const float* bias_data,
+                       const ::tflite::RuntimeShape& output_shape,
+                       float* output_data) {
   TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
   TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
   TFLITE_DCHECK_EQ(bias_shape.DimensionsCount(), 1);
   TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
-  (void)im2col_data;   // only used in optimized code.
-  (void)im2col_shape;  // only used in optimized code.
 
   const int batches = MatchingDim(input_shape, 0, output_shape, 0);
-  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
-  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
-  const int input_height = input_shape.Dims(1);
-  const int input_width = input_shape.Dims(2);
+  TFLITE_DCHECK_EQ(input_shape.Dims(3), filter_shape.Dims(3));
+  TFLITE_DCHECK_EQ(filter_shape.Dims(0), output_shape.Dims(3));
   const int filter_height = filter_shape.Dims(1);
   const int filter_width = filter_shape.Dims(2);
   const int output_height = output_shape.Dims(1);
-  const int output_width = output_shape.Dims(2);
-
-  // Start of MediaPipe modificiation.
 
   for (int batch = 0; batch < batches; ++batch) {
-    for (int out_y = 0; out_y < output_height; out_y++) {
-      for (int out_x = 0; out_x < output_width; out_x++) {
-        for (int out_channel = 0; out_channel < output_depth; out_channel++) {
-          output_data[Offset(output_shape, batch, out_y, out_x, out_channel)] =
-              bias_data[out_channel];
-        }
-      }
-    }
-
-    for (int in_y = 0; in_y < input_height; ++in_y) {
-      for (int in_x = 0; in_x < input_width; ++in_x) {
-        for (int in_channel = 0; in_channel < input_depth; ++in_channel) {
-          // Loop through the output elements it will influence
-          const int out_x_origin = (in_x * stride_width) - pad_width;
-          const int out_y_origin = (in_y * stride_height) - pad_height;
-          for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
-            for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
-              for (int out_channel = 0; out_channel < output_depth;
-                   ++out_channel) {
-                // Compute output element location
-                const int out_x = out_x_origin + filter_x;
-                const int out_y = out_y_origin + filter_y;
-                // We cannot accumulate out of bounds
-                if ((out_x >= 0) && (out_x < output_width) && (out_y >= 0) &&
-                    (out_y < output_height)) {
-                  float input_value = input_data[Offset(
-                      input_shape, batch, in_y, in_x, in_channel)];
-                  float filter_value =
-                      filter_data[Offset(filter_shape, out_channel, filter_y,
-                                         filter_x, in_channel)];
-                  output_data[Offset(output_shape, batch, out_y, out_x,
-                                     out_channel)] +=
-                      input_value * filter_value;
-                }
-              }
-            }
-          }
-        }
-      }
-    }
+    ParallelForOp(context, output_height, kMinRowsPerStripe,
+                  [&](int out_y_begin, int out_y_end) {
+                    TransposeConvBiasRows(
+                        params, input_shape, input_data, filter_height,
+                        filter_width, packed_filter_data, bias_data,
+                        output_shape, output_data, batch, out_y_begin,
+                        out_y_end);
+                  });
   }
-  // End of MediaPipe modification.
-  // End of copy.
+}
+
+// The state of one node of the op.
+struct OpData {
+  // The filter packed by PackFilter(). Constant filters are packed once in
+  // Prepare(), other filters in every Eval().
+  std::vector<float> packed_filter;
+  bool filter_is_constant = false;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  return new OpData();
+}
+
+void Free(TfLiteContext* context, void* buffer) {
+  delete reinterpret_cast<OpData*>(buffer);
 }
 
 // Start of copy from
@@ -177,6 +275,14 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       stride_width * (in_width - 1) + filter_width - padding_size.width;
   TF_LITE_ENSURE_OK(context,
                     context->ResizeTensor(context, output, output_shape_array));
+
+  auto* op_data = reinterpret_cast<OpData*>(node->user_data);
+  op_data->filter_is_constant = ::tflite::IsConstantTensor(weights);
+  if (op_data->filter_is_constant) {
+    PackFilter(::tflite::GetTensorShape(weights),
+               ::tflite::GetTensorData<float>(weights),
+               &op_data->packed_filter);
+  }
   return kTfLiteOk;
   // End of MediaPipe modification.
 }
@@ -219,20 +325,18 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       op_params.stride_width = stride_width;
       op_params.stride_height = stride_height;
 
+      auto* op_data = reinterpret_cast<OpData*>(node->user_data);
+      if (!op_data->filter_is_constant) {
+        PackFilter(::tflite::GetTensorShape(weights),
+                   ::tflite::GetTensorData<float>(weights),
+                   &op_data->packed_filter);
+      }
       TransposeConvBias(
-          op_params, ::tflite::GetTensorShape(input),
+          context, op_params, ::tflite::GetTensorShape(input),
           ::tflite::GetTensorData<float>(input),
-          ::tflite::GetTensorShape(weights),
-          ::tflite::GetTensorData<float>(weights),
+          ::tflite::GetTensorShape(weights), op_data->packed_filter.data(),
           ::tflite::GetTensorShape(bias), ::tflite::GetTensorData<float>(bias),
           ::tflite::GetTensorShape(output),
-          ::tflite::GetTensorData<float>(output),
-          // Last two args specify im2col which reference_ops ignores.
-          // (Note this does not lead to a performance regression, as the
-          // previous optimized version was just a copy of the reference code.)
-          // TODO: Allocate im2col tensors and switch to
-          // optimized_ops.
-          ::tflite::GetTensorShape(output),
           ::tflite::GetTensorData<float>(output));
       break;
     }
@@ -251,7 +355,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace
 
 TfLiteRegistration* RegisterConvolution2DTransposeBias() {
-  static TfLiteRegistration reg = {nullptr, nullptr, Prepare, Eval};
+  static TfLiteRegistration reg = {Init, Free, Prepare, Eval};
   return &reg;
 }
 
@@ -0,0 +1,107 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mediapipe/util/tflite/tflite_model_cache.h"
+
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/port/canonical_errors.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status_macros.h"
+#include "mediapipe/util/resource_util.h"
+
+namespace mediapipe {
+
+namespace {
+
+// A model together with the ResourceView that holds its data.
+struct MappedTfLiteModel {
+  std::shared_ptr<const ResourceView> view;
+  std::unique_ptr<tflite::FlatBufferModel> model;
+};
+
+}  // namespace
+
+::mediapipe::StatusOr<std::shared_ptr<const tflite::FlatBufferModel>>
+LoadTfLiteModel(const std::string& path) {
+  auto mapped_model = std::make_shared<MappedTfLiteModel>();
+  ASSIGN_OR_RETURN(mapped_model->view, GetFileView(path));
+  mapped_model->model = tflite::FlatBufferModel::BuildFromBuffer(
+      mapped_model->view->data(), mapped_model->view->size());
+  if (!mapped_model->model) {
+    return ::mediapipe::InternalError(
+        absl::StrCat("Could not load the TFLite model ", path));
+  }
+  // The returned pointer shares ownership of the view with the model.
+  return std::shared_ptr<const tflite::FlatBufferModel>(
+      mapped_model, mapped_model->model.get());
+}
+
+const GraphService<TfLiteModelCache> kTfLiteModelCacheService(
+    "kTfLiteModelCacheService");
+
+// static
+std::shared_ptr<TfLiteModelCache> TfLiteModelCache::GetProcessCache() {
+  static auto* cache = new std::shared_ptr<TfLiteModelCache>(
+      std::make_shared<TfLiteModelCache>());
+  return *cache;
+}
+
+::mediapipe::StatusOr<std::shared_ptr<const tflite::FlatBufferModel>>
+TfLiteModelCache::GetModel(const std::string& path, bool* cache_hit) {
+  // The mutex is held while loading, so that concurrent callers wait for the
+  // model instead of loading it again.
+  absl::MutexLock lock(&mutex_);
+  std::weak_ptr<const tflite::FlatBufferModel>& entry = models_[path];
+  std::shared_ptr<const tflite::FlatBufferModel> model = entry.lock();
+  if (cache_hit) {
+    *cache_hit = model != nullptr;
+  }
+  if (model) {
+    ++num_cache_hits_;
+    return model;
+  }
+  // The model is memory-mapped, so its pages are also shared with any other
+  // process using it.
+  ::mediapipe::StatusOr<std::shared_ptr<const tflite::FlatBufferModel>>
+      status_or_model = LoadTfLiteModel(path);
+  if (!status_or_model.ok()) {
+    models_.erase(path);
+    return status_or_model.status();
+  }
+  model = status_or_model.ValueOrDie();
+  VLOG(1) << "Loaded the TFLite model " << path;
+  ++num_loads_;
+  entry = model;
+  // Drop the entries of the models that have been unloaded since.
+  for (auto it = models_.begin(); it != models_.end();) {
+    if (it->second.expired()) {
+      it = models_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return model;
+}
+
+int64 TfLiteModelCache::num_loads() const {
+  absl::MutexLock lock(&mutex_);
+  return num_loads_;
+}
+
+int64 TfLiteModelCache::num_cache_hits() const {
+  absl::MutexLock lock(&mutex_);
+  return num_cache_hits_;
+}
+
+}  // namespace mediapipe
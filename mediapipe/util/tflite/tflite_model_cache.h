@@ -0,0 +1,95 @@
+// Copyright 2019 The MediaPipe Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MEDIAPIPE_UTIL_TFLITE_TFLITE_MODEL_CACHE_H_
+#define MEDIAPIPE_UTIL_TFLITE_TFLITE_MODEL_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/graph_service.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model.h"
+
+namespace mediapipe {
+
+// Loads the TFLite model stored in the file at "path", which must already be
+// resolved, e.g. with PathToResourceAsFile(). The model is built directly on a
+// ResourceView of the file, which it keeps alive, so the model data is never
+// copied.
+::mediapipe::StatusOr<std::shared_ptr<const tflite::FlatBufferModel>>
+LoadTfLiteModel(const std::string& path);
+
+// Shares TFLite models among the calculators of any number of graphs. Each
+// model file is memory-mapped and parsed once, by the first caller of
+// GetModel(), and the same tflite::FlatBufferModel is returned to all other
+// callers while the first one is still in use. A model is unloaded when the
+// last pointer returned for it is destroyed. To keep a model loaded between
+// graph runs, hold on to a pointer returned by GetModel().
+//
+// Calculators obtain the cache through kTfLiteModelCacheService. To share
+// models across all graphs of the process, set the same cache on each graph:
+//
+//   RETURN_IF_ERROR(graph.SetServiceObject(
+//       kTfLiteModelCacheService, TfLiteModelCache::GetProcessCache()));
+//
+// This class is thread-safe.
+class TfLiteModelCache {
+ public:
+  TfLiteModelCache() = default;
+  TfLiteModelCache(const TfLiteModelCache&) = delete;
+  TfLiteModelCache& operator=(const TfLiteModelCache&) = delete;
+
+  // Returns the cache shared by all users in the process.
+  static std::shared_ptr<TfLiteModelCache> GetProcessCache();
+
+  // Returns the model stored in the file at "path", loading it if it is not
+  // loaded yet. If "cache_hit" is not null, it is set to true if the model was
+  // already loaded. Concurrent calls for the same path load the model once.
+  ::mediapipe::StatusOr<std::shared_ptr<const tflite::FlatBufferModel>>
+  GetModel(const std::string& path, bool* cache_hit = nullptr);
+
+  // Returns a resolver for the builtin TFLite operations, shared by all users
+  // of the cache, which saves registering the operations for every
+  // interpreter.
+  const tflite::ops::builtin::BuiltinOpResolver& BuiltinOpResolver() const {
+    return builtin_op_resolver_;
+  }
+
+  // The number of models loaded, and the number of GetModel() calls that
+  // returned a loaded model, since the cache was created.
+  int64 num_loads() const LOCKS_EXCLUDED(mutex_);
+  int64 num_cache_hits() const LOCKS_EXCLUDED(mutex_);
+
+ private:
+  const tflite::ops::builtin::BuiltinOpResolver builtin_op_resolver_;
+
+  mutable absl::Mutex mutex_;
+  // The models, by path. An entry expires when its model is unloaded.
+  std::map<std::string, std::weak_ptr<const tflite::FlatBufferModel>> models_
+      GUARDED_BY(mutex_);
+  int64 num_loads_ GUARDED_BY(mutex_) = 0;
+  int64 num_cache_hits_ GUARDED_BY(mutex_) = 0;
+};
+
+// The graph service through which calculators use a TfLiteModelCache.
+extern const GraphService<TfLiteModelCache> kTfLiteModelCacheService;
+
+}  // namespace mediapipe
+
+#endif  // MEDIAPIPE_UTIL_TFLITE_TFLITE_MODEL_CACHE_H_